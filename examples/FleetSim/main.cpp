@@ -0,0 +1,172 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+/*
+ * Fleet simulation: runs N independent charge points in one process. Each charge point talks to its own
+ * LoopbackConnection, has its own Configurations and stores its files under the prefix "cpXXXXX-".
+ *
+ * Build with cmake -DMO_BUILD_FLEET_SIM=ON and run
+ *     ./mo_fleet_sim [number of charge points] [number of loop iterations]
+ *
+ * Heap usage is tracked per instance by accounting every allocation to the instance which is currently
+ * selected.
+ */
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Model/Model.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+#include <vector>
+#include <sys/stat.h>
+
+#define SIM_BASE_TIME "2024-01-01T00:00:00.000Z"
+#define SIM_MAX_INSTANCES 100000
+
+namespace {
+
+//heap accounting: each block has a header with its size and the index of the owning instance
+struct AllocHeader {
+    size_t size;
+    size_t owner;
+    size_t pad; //keep 16-byte alignment of the payload on 64-bit hosts
+};
+
+const size_t NO_OWNER = SIM_MAX_INSTANCES;
+size_t currentOwner = NO_OWNER;
+size_t heapLive [SIM_MAX_INSTANCES + 1];
+
+struct SimChargePoint {
+    MicroOcpp::LoopbackConnection connection;
+    MicroOcpp::Instance *instance = nullptr;
+    int energy = 0;
+    bool plugged = false;
+};
+
+} //end anonymous namespace
+
+void *operator new(size_t size) {
+    auto header = static_cast<AllocHeader*>(malloc(sizeof(AllocHeader) + size));
+    if (!header) {
+        throw std::bad_alloc();
+    }
+    header->size = size;
+    header->owner = currentOwner;
+    heapLive[currentOwner] += size;
+    return header + 1;
+}
+
+void operator delete(void *ptr) noexcept {
+    if (!ptr) {
+        return;
+    }
+    auto header = static_cast<AllocHeader*>(ptr) - 1;
+    heapLive[header->owner] -= header->size;
+    free(header);
+}
+
+void *operator new[](size_t size) {
+    return operator new(size);
+}
+
+void operator delete[](void *ptr) noexcept {
+    operator delete(ptr);
+}
+
+int main(int argc, char **argv) {
+
+    size_t nInstances = argc > 1 ? (size_t) strtoul(argv[1], nullptr, 10) : 100;
+    unsigned long nIterations = argc > 2 ? strtoul(argv[2], nullptr, 10) : 1000;
+
+    if (nInstances == 0 || nInstances > SIM_MAX_INSTANCES) {
+        printf("number of charge points must be between 1 and %u\n", SIM_MAX_INSTANCES);
+        return 1;
+    }
+
+    mkdir(MO_FILENAME_PREFIX, 0755);
+
+    auto filesystem = MicroOcpp::makeDefaultFilesystemAdapter(MicroOcpp::FilesystemOpt::Use_Mount_FormatOnFail);
+
+    std::vector<SimChargePoint> chargePoints (nInstances);
+
+    for (size_t i = 0; i < nInstances; i++) {
+        auto& cp = chargePoints[i];
+
+        char prefix [16];
+        snprintf(prefix, sizeof(prefix), "cp%05zu-", i);
+
+        char serial [16];
+        snprintf(serial, sizeof(serial), "SIM%05zu", i);
+
+        currentOwner = i;
+
+        cp.instance = mocpp_instance_create(cp.connection, ChargerCredentials("FleetSim", "MicroOcpp", nullptr, serial), prefix, filesystem);
+        if (!cp.instance) {
+            printf("failed to create charge point %zu\n", i);
+            return 1;
+        }
+
+        getOcppContext()->getModel().getClock().setTime(SIM_BASE_TIME);
+
+        setEnergyMeterInput([&cp] () {return cp.energy;});
+        setConnectorPluggedInput([&cp] () {return cp.plugged;});
+
+        currentOwner = NO_OWNER;
+    }
+
+    printf("[fleet-sim] created %zu charge points\n", nInstances);
+
+    for (unsigned long it = 0; it < nIterations; it++) {
+        for (size_t i = 0; i < nInstances; i++) {
+            auto& cp = chargePoints[i];
+
+            currentOwner = i;
+            mocpp_instance_select(cp.instance);
+
+            //each charge point runs a charging session with a different phase
+            unsigned long phase = (it + i) % 200;
+            if (phase == 10) {
+                cp.plugged = true;
+                beginTransaction("SIMTAG");
+            } else if (phase == 150) {
+                endTransaction();
+            } else if (phase == 160) {
+                cp.plugged = false;
+            }
+            if (cp.plugged) {
+                cp.energy += 10;
+            }
+
+            mocpp_loop();
+
+            currentOwner = NO_OWNER;
+        }
+    }
+
+    size_t heapMin = (size_t) -1, heapMax = 0, heapSum = 0;
+    for (size_t i = 0; i < nInstances; i++) {
+        heapMin = std::min(heapMin, heapLive[i]);
+        heapMax = std::max(heapMax, heapLive[i]);
+        heapSum += heapLive[i];
+        if (i < 10) {
+            printf("[fleet-sim] cp%05zu: %zu B heap\n", i, heapLive[i]);
+        }
+    }
+
+    printf("[fleet-sim] %zu charge points, %lu loop iterations\n", nInstances, nIterations);
+    printf("[fleet-sim] heap per charge point: min %zu B, avg %zu B, max %zu B\n", heapMin, heapSum / nInstances, heapMax);
+    printf("[fleet-sim] heap total: %zu B (+ %zu B shared)\n", heapSum, heapLive[NO_OWNER]);
+
+    for (size_t i = 0; i < nInstances; i++) {
+        currentOwner = i;
+        mocpp_instance_free(chargePoints[i].instance);
+        currentOwner = NO_OWNER;
+    }
+
+    return 0;
+}
@@ -23,10 +23,12 @@
 #include <MicroOcpp/Model/Certificates/CertificateMbedTLS.h>
 #include <MicroOcpp/Core/Request.h>
 #include <MicroOcpp/Core/OperationRegistry.h>
+#include <MicroOcpp/Core/Configuration.h>
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Core/Ftp.h>
 #include <MicroOcpp/Core/FtpMbedTLS.h>
+#include <MicroOcpp/Core/HttpMbedTLS.h>
 
 #include <MicroOcpp/Operations/Authorize.h>
 #include <MicroOcpp/Operations/StartTransaction.h>
@@ -36,6 +38,20 @@
 #include <MicroOcpp/Debug.h>
 
 namespace MicroOcpp {
+
+class Instance {
+public:
+#ifndef MO_CUSTOM_WS
+    WebSocketsClient *webSocket {nullptr};
+    Connection *connection {nullptr};
+#endif
+
+    Context *context {nullptr};
+    std::shared_ptr<FilesystemAdapter> filesystem;
+
+    ConfigurationRegistry *configurationRegistry {nullptr}; //nullptr for the default registry
+};
+
 namespace Facade {
 
 #ifndef MO_CUSTOM_WS
@@ -46,6 +62,13 @@ Connection *connection {nullptr};
 Context *context {nullptr};
 std::shared_ptr<FilesystemAdapter> filesystem;
 
+/*
+ * The globals above belong to the selected instance. mocpp_instance_select() parks them in the Instance
+ * object of the previously selected instance and loads the globals of the new instance
+ */
+Instance defaultInstance;
+Instance *selectedInstance = &defaultInstance;
+
 #ifndef MO_NUMCONNECTORS
 #define MO_NUMCONNECTORS 2
 #endif
@@ -277,6 +300,7 @@ void mocpp_initialize(Connection& connection, const char *bootNotificationCreden
 
 #if MO_ENABLE_MBEDTLS
     context->setFtpClient(makeFtpClientMbedTLS());
+    context->setHttpClient(makeHttpClientMbedTLS());
 #endif //MO_ENABLE_MBEDTLS
 
     auto& model = context->getModel();
@@ -309,7 +333,7 @@ void mocpp_initialize(Connection& connection, const char *bootNotificationCreden
 
 #if MO_ENABLE_V201
     model.setTransactionService(std::unique_ptr<TransactionService>(
-        new TransactionService(*context)));
+        new TransactionService(*context, filesystem)));
 #endif
 
 #if MO_ENABLE_CERT_MGMT && MO_ENABLE_CERT_STORE_MBEDTLS
@@ -411,6 +435,94 @@ void mocpp_deinitialize() {
     MO_DBG_DEBUG("deinitialized OCPP\n");
 }
 
+void mocpp_instance_select(Instance *instance) {
+    if (!instance) {
+        instance = &defaultInstance;
+    }
+
+    if (instance == selectedInstance) {
+        return;
+    }
+
+    //park globals of the previous instance
+#ifndef MO_CUSTOM_WS
+    selectedInstance->webSocket = webSocket;
+    selectedInstance->connection = connection;
+#endif
+    selectedInstance->context = context;
+    selectedInstance->filesystem = std::move(filesystem);
+
+    //load globals of the new instance
+#ifndef MO_CUSTOM_WS
+    webSocket = instance->webSocket;
+    connection = instance->connection;
+#endif
+    context = instance->context;
+    filesystem = std::move(instance->filesystem);
+    configuration_registry_select(instance->configurationRegistry);
+
+    selectedInstance = instance;
+}
+
+Instance *mocpp_instance_get_selected() {
+    return selectedInstance == &defaultInstance ? nullptr : selectedInstance;
+}
+
+Instance *mocpp_instance_create(Connection& connection, const char *bootNotificationCredentials, const char *filenamePrefix, std::shared_ptr<FilesystemAdapter> filesystem, ProtocolVersion version) {
+
+    auto instance = new Instance();
+    if (!instance) {
+        MO_DBG_ERR("OOM");
+        return nullptr;
+    }
+
+    instance->configurationRegistry = configuration_registry_create();
+    if (!instance->configurationRegistry) {
+        delete instance;
+        return nullptr;
+    }
+
+    auto prevSelected = mocpp_instance_get_selected();
+
+    mocpp_instance_select(instance);
+
+    mocpp_initialize(connection, bootNotificationCredentials, makePrefixedFilesystemAdapter(std::move(filesystem), filenamePrefix), false, version);
+
+    if (!context) {
+        MO_DBG_ERR("initialization failure");
+        mocpp_instance_free(instance);
+        mocpp_instance_select(prevSelected);
+        return nullptr;
+    }
+
+    return instance;
+}
+
+void mocpp_instance_free(Instance *instance) {
+    if (!instance || instance == &defaultInstance) {
+        MO_DBG_ERR("invalid arg");
+        return;
+    }
+
+    //keep the selection of the caller unless it is the instance to be freed
+    auto prevSelected = mocpp_instance_get_selected();
+    if (prevSelected == instance) {
+        prevSelected = nullptr;
+    }
+
+    mocpp_instance_select(instance);
+    mocpp_deinitialize();
+    mocpp_instance_select(prevSelected);
+
+    configuration_registry_free(instance->configurationRegistry);
+    delete instance;
+}
+
+void mocpp_instance_loop(Instance *instance) {
+    mocpp_instance_select(instance);
+    mocpp_loop();
+}
+
 void mocpp_loop() {
     if (!context) {
         MO_DBG_WARN("need to call mocpp_initialize before");
@@ -420,6 +532,24 @@ void mocpp_loop() {
     context->loop();
 }
 
+unsigned long mocpp_next_wakeup_ms() {
+    if (!context) {
+        MO_DBG_WARN("need to call mocpp_initialize before");
+        return 0;
+    }
+
+    return context->getNextWakeupMs();
+}
+
+unsigned long mocpp_next_deadline_ms() {
+    if (!context) {
+        MO_DBG_WARN("need to call mocpp_initialize before");
+        return 0;
+    }
+
+    return context->getNextDeadlineMs();
+}
+
 std::shared_ptr<ITransaction> beginTransaction(const char *idTag, unsigned int connectorId) {
     if (!context) {
         MO_DBG_ERR("OCPP uninitialized"); //need to call mocpp_initialize before
@@ -973,6 +1103,22 @@ bool isOperative(unsigned int connectorId) {
     return chargePoint->isOperative() && connector->isOperative();
 }
 
+ConnectivityState getConnectivityState() {
+    if (!context) {
+        MO_DBG_WARN("OCPP uninitialized");
+        return ConnectivityState_Offline;
+    }
+    return context->getRequestQueue().getConnectivityState();
+}
+
+bool setDrainRateLimit(const char *operationTypes, unsigned int burst, unsigned long refillIntervalMs) {
+    if (!context) {
+        MO_DBG_ERR("OCPP uninitialized"); //need to call mocpp_initialize before
+        return false;
+    }
+    return context->getRequestQueue().setDrainRateLimit(operationTypes, burst, refillIntervalMs);
+}
+
 void setOnResetNotify(std::function<bool(bool)> onResetNotify) {
     if (!context) {
         MO_DBG_ERR("OCPP uninitialized"); //need to call mocpp_initialize before
@@ -1152,6 +1298,7 @@ void authorize(const char *idTag, OnReceiveConfListener onConf, OnAbortListener
         authorize->setTimeout(timeout);
     else
         authorize->setTimeout(20000);
+    authorize->setTimeoutFreezable(false); //the caller waits for the result. Let the timeout also elapse while offline
     context->initiateRequest(std::move(authorize));
 }
 
@@ -1208,10 +1355,12 @@ bool startTransaction(const char *idTag, OnReceiveConfListener onConf, OnAbortLi
         startTransaction->setOnTimeoutListener(onTimeout);
     if (onError)
         startTransaction->setOnReceiveErrorListener(onError);
-    if (timeout)
+    if (timeout) {
         startTransaction->setTimeout(timeout);
-    else
+        startTransaction->setTimeoutFreezable(false); //explicit timeout set by the caller. Let it also elapse while offline
+    } else {
         startTransaction->setTimeout(0);
+    }
     context->initiateRequest(std::move(startTransaction));
 
     return true;
@@ -1264,10 +1413,12 @@ bool stopTransaction(OnReceiveConfListener onConf, OnAbortListener onAbort, OnTi
         stopTransaction->setOnTimeoutListener(onTimeout);
     if (onError)
         stopTransaction->setOnReceiveErrorListener(onError);
-    if (timeout)
+    if (timeout) {
         stopTransaction->setTimeout(timeout);
-    else
+        stopTransaction->setTimeoutFreezable(false); //explicit timeout set by the caller. Let it also elapse while offline
+    } else {
         stopTransaction->setTimeout(0);
+    }
     context->initiateRequest(std::move(stopTransaction));
 
     return true;
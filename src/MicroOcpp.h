@@ -13,6 +13,7 @@
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Core/RequestCallbacks.h>
 #include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/ConnectivityState.h>
 #include <MicroOcpp/Model/Metering/SampledValue.h>
 #include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MicroOcpp/Model/ConnectorBase/Notification.h>
@@ -125,6 +126,72 @@ void mocpp_deinitialize();
  */
 void mocpp_loop();
 
+/*
+ * Time in ms until mocpp_loop() needs to be called again at the latest. Hosts which can sleep (e.g. battery-backed
+ * controllers or RTOS tasks) can block for this time instead of calling mocpp_loop() continuously. The result is
+ * capped at MO_WAKEUP_MAX_MS.
+ *
+ * The timers of MicroOcpp are covered, but changes of the hardware inputs (connectorPlugged, evReady, error codes, etc.)
+ * and incoming network data are not predictable. Call mocpp_loop() early whenever one of those changes. Returns 0
+ * if mocpp_loop() should be called again immediately, e.g. while a transaction is running or a message is pending.
+ */
+unsigned long mocpp_next_wakeup_ms();
+
+/*
+ * Like mocpp_next_wakeup_ms(), but for hosts which call mocpp_loop() whenever one of the inputs changes, e.g. simulations
+ * with scripted inputs. A running transaction doesn't keep the result at 0. Only the timers of MicroOcpp count, so the
+ * host can skip forward to the next deadline
+ */
+unsigned long mocpp_next_deadline_ms();
+
+/*
+ * Multiple OCPP instances in one process (e.g. for simulating a fleet of charge points)
+ *
+ * Each instance has its own Context, Configurations, filesystem prefix and clock. The functions of this
+ * header (mocpp_loop(), beginTransaction(), setConnectorPluggedInput(), ...) operate on the selected instance.
+ * The default instance is selected initially and is the one which mocpp_initialize() sets up, so single-
+ * instance hosts don't need this API.
+ *
+ * Instances are not thread-safe: drive all instances from the same thread and select an instance before
+ * calling into it.
+ *
+ * Example:
+ *     LoopbackConnection loopback [2];
+ *     auto cp1 = mocpp_instance_create(loopback[0], ChargerCredentials(), "cp1-");
+ *     setConnectorPluggedInput([] () {return cp1Plugged;}); //applies to cp1 (newly created instance is selected)
+ *     auto cp2 = mocpp_instance_create(loopback[1], ChargerCredentials(), "cp2-");
+ *     ...
+ *     mocpp_instance_loop(cp1);
+ *     mocpp_instance_loop(cp2);
+ */
+
+namespace MicroOcpp {
+class Instance;
+}
+
+/*
+ * Create and initialize a new instance and select it. filenamePrefix is prepended to all files of this instance
+ * (see makePrefixedFilesystemAdapter()) and should be unique per instance. Returns nullptr on failure
+ */
+MicroOcpp::Instance *mocpp_instance_create(
+            MicroOcpp::Connection& connection,
+            const char *bootNotificationCredentials = ChargerCredentials("Demo Charger", "My Company Ltd."),
+            const char *filenamePrefix = nullptr,
+            std::shared_ptr<MicroOcpp::FilesystemAdapter> filesystem =
+                MicroOcpp::makeDefaultFilesystemAdapter(MicroOcpp::FilesystemOpt::Use_Mount_FormatOnFail),
+            MicroOcpp::ProtocolVersion version = MicroOcpp::ProtocolVersion(1,6));
+
+/*
+ * Deinitialize instance and release its resources. Selects the default instance if instance was selected,
+ * otherwise the selection is kept
+ */
+void mocpp_instance_free(MicroOcpp::Instance *instance);
+
+void mocpp_instance_select(MicroOcpp::Instance *instance); //nullptr selects the default instance
+MicroOcpp::Instance *mocpp_instance_get_selected(); //nullptr if the default instance is selected
+
+void mocpp_instance_loop(MicroOcpp::Instance *instance); //select instance and execute mocpp_loop()
+
 /*
  * Transaction management.
  * 
@@ -329,6 +396,16 @@ void setOnUnlockConnectorInOut(std::function<UnlockConnectorResult()> onUnlockCo
 
 bool isOperative(unsigned int connectorId = 1); //if the charge point is operative (see OCPP1.6 Edit2, p. 45) and ready for transactions
 
+ConnectivityState getConnectivityState(); //Offline, Backoff after a reconnect, Draining the accumulated requests or Online
+
+/*
+ * Rate limit for sending the requests which have accumulated while offline, see RequestQueue::setDrainRateLimit. E.g.
+ *
+ *     setDrainRateLimit("StartTransaction,StopTransaction,MeterValues", 5, 2000); //burst of 5, then one message per 2s
+ *     setDrainRateLimit(nullptr, 10, 500); //all other operations
+ */
+bool setDrainRateLimit(const char *operationTypes, unsigned int burst, unsigned long refillIntervalMs);
+
 /*
  * Configure the device management
  */
@@ -523,7 +600,9 @@ void setRequestHandler(const char *operationType,
  * - `onAbortListener`: will be called whenever the engine stops trying to finish an operation
  *           normally which was initiated by this device.
  * - `onTimeoutListener`: will be executed when the operation is not answered until the timeout
- *           expires. Note that timeouts also trigger the `onAbortListener`.
+ *           expires. Note that timeouts also trigger the `onAbortListener`. Request timeouts are
+ *           frozen while the connection is down, except for `authorize()` and when the caller sets
+ *           an explicit `timeout`: these also elapse while offline.
  * - `onReceiveErrorListener`: will be called when the Central System returns a CallError.
  *           Again, each error also triggers the `onAbortListener`.
  * 
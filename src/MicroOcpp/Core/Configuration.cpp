@@ -11,6 +11,8 @@
 #include <algorithm>
 #include <ArduinoJson.h>
 
+#define MO_CONFIG_INDEX_NIL 0xFFFF
+
 namespace MicroOcpp {
 
 struct Validator {
@@ -21,11 +23,185 @@ struct Validator {
     }
 };
 
+struct ConfigurationIndexEntry {
+    std::shared_ptr<Configuration> config;
+    ConfigurationContainer *container;
+    uint32_t hash;
+};
+
+struct ConfigurationRegistry {
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    std::vector<std::shared_ptr<ConfigurationContainer>> configurationContainers;
+    std::vector<std::unique_ptr<Validator>> validators; //heap-allocated because configs point to the validator functions
+
+    //hash index over the configs of all indexable containers. Dense entries + open addressing table of entry positions
+    std::vector<ConfigurationIndexEntry> index;
+    std::vector<uint16_t> indexBuckets;
+    unsigned int indexedGeneration = 0; //sum of the container generations when the index was built. Detects changes made by other modules
+    bool indexValid = false;
+
+    //interned keys of configs which are loaded from flash before being declared
+    std::vector<std::unique_ptr<char[]>> keys;
+    std::vector<uint16_t> keyBuckets;
+};
+
 namespace ConfigurationLocal {
 
-std::shared_ptr<FilesystemAdapter> filesystem;
-std::vector<std::shared_ptr<ConfigurationContainer>> configurationContainers;
-std::vector<Validator> validators;
+ConfigurationRegistry defaultRegistry;
+ConfigurationRegistry *registry = &defaultRegistry;
+
+uint32_t hashKey(const char *key) {
+    //FNV-1a
+    uint32_t hash = 2166136261UL;
+    for (; *key; key++) {
+        hash ^= (uint8_t) *key;
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+void bucketsPut(std::vector<uint16_t>& buckets, size_t pos, uint32_t hash) {
+    size_t mask = buckets.size() - 1;
+    size_t i = hash & mask;
+    while (buckets[i] != MO_CONFIG_INDEX_NIL) {
+        i = (i + 1) & mask;
+    }
+    buckets[i] = (uint16_t) pos;
+}
+
+//make space for one more position in buckets. Keeps the load factor at most 1/2 and rehashes if necessary
+bool bucketsReserve(std::vector<uint16_t>& buckets, size_t size, std::function<uint32_t(size_t)> hashAt) {
+    if (size + 1 >= MO_CONFIG_INDEX_NIL) {
+        MO_DBG_ERR("exceed max number of configs");
+        return false;
+    }
+    if ((size + 1) * 2 <= buckets.size()) {
+        return true;
+    }
+    buckets.assign(buckets.empty() ? 32 : 2 * buckets.size(), MO_CONFIG_INDEX_NIL);
+    for (size_t i = 0; i < size; i++) {
+        bucketsPut(buckets, i, hashAt(i));
+    }
+    return true;
+}
+
+bool indexInsert(std::shared_ptr<Configuration> config, ConfigurationContainer *container) {
+    if (!config->getKey()) {
+        return true; //cannot be looked up
+    }
+
+    auto& index = registry->index;
+    if (!bucketsReserve(registry->indexBuckets, index.size(), [&index] (size_t i) {return index[i].hash;})) {
+        return false;
+    }
+
+    uint32_t hash = hashKey(config->getKey());
+    index.push_back(ConfigurationIndexEntry{std::move(config), container, hash});
+    bucketsPut(registry->indexBuckets, index.size() - 1, hash);
+    return true;
+}
+
+unsigned int indexGeneration() {
+    unsigned int generation = 0;
+    for (auto& container : registry->configurationContainers) {
+        if (container->isIndexable()) {
+            generation += container->getGeneration();
+        }
+    }
+    return generation;
+}
+
+bool indexBuild() {
+    registry->index.clear();
+    registry->indexBuckets.clear();
+    registry->indexedGeneration = indexGeneration();
+    registry->indexValid = false;
+
+    for (auto& container : registry->configurationContainers) {
+        if (!container->isIndexable()) {
+            continue;
+        }
+        for (size_t i = 0; i < container->size(); i++) {
+            auto config = container->getConfigurationShared(i);
+            if (config && !indexInsert(std::move(config), container.get())) {
+                return false;
+            }
+        }
+    }
+
+    registry->indexValid = true;
+    return true;
+}
+
+bool indexUpToDate() {
+    //generations only increase, so any add or remove since the index build changes the sum
+    return registry->indexValid && indexGeneration() == registry->indexedGeneration;
+}
+
+//returns the first config with this key in the order of the containers and its container. Indexable containers are
+//searched via the hash index, the others linearly
+std::shared_ptr<Configuration> lookupConfiguration(const char *key, bool accessibleOnly, ConfigurationContainer **containerOut = nullptr) {
+
+    auto& containers = registry->configurationContainers;
+
+    bool indexed = indexUpToDate() || indexBuild();
+
+    //first match in the index. Entries are ordered like the containers, except for configs which have been declared
+    //after the index build. Those keys didn't exist before, so the lowest entry position wins
+    ConfigurationIndexEntry *match = nullptr;
+    size_t matchPos = 0;
+
+    if (indexed && !registry->indexBuckets.empty()) {
+        auto& buckets = registry->indexBuckets;
+        size_t mask = buckets.size() - 1;
+        uint32_t hash = hashKey(key);
+        for (size_t i = hash & mask; buckets[i] != MO_CONFIG_INDEX_NIL; i = (i + 1) & mask) {
+            auto& entry = registry->index[buckets[i]];
+            if (entry.hash == hash &&
+                    entry.config->getKey() && !strcmp(entry.config->getKey(), key) &&
+                    (!accessibleOnly || entry.container->isAccessible()) &&
+                    (!match || buckets[i] < matchPos)) {
+                match = &entry;
+                matchPos = buckets[i];
+            }
+        }
+    }
+
+    //containers before the container of the match take precedence
+    for (auto& container : containers) {
+        if (match && container.get() == match->container) {
+            break;
+        }
+        if ((indexed && container->isIndexable()) ||
+                (accessibleOnly && !container->isAccessible())) {
+            continue;
+        }
+        if (auto config = container->getConfiguration(key)) {
+            if (containerOut) {
+                *containerOut = container.get();
+            }
+            return config;
+        }
+    }
+
+    if (match) {
+        if (containerOut) {
+            *containerOut = match->container;
+        }
+        return match->config;
+    }
+
+    return nullptr;
+}
+
+std::function<bool(const char*)> *findValidator(const char *key) {
+    for (auto& v : registry->validators) {
+        if (!strcmp(v->key, key)) {
+            return &v->checkValue;
+        }
+    }
+    return nullptr;
+}
 
 }
 
@@ -35,27 +211,27 @@ std::unique_ptr<ConfigurationContainer> createConfigurationContainer(const char
     //create non-persistent Configuration store (i.e. lives only in RAM) if
     //     - Flash FS usage is switched off OR
     //     - Filename starts with "/volatile"
-    if (!filesystem ||
+    if (!registry->filesystem ||
                  !strncmp(filename, CONFIGURATION_VOLATILE, strlen(CONFIGURATION_VOLATILE))) {
         return makeConfigurationContainerVolatile(filename, accessible);
     } else {
         //create persistent Configuration store. This is the normal case
-        return makeConfigurationContainerFlash(filesystem, filename, accessible);
+        return makeConfigurationContainerFlash(registry->filesystem, filename, accessible);
     }
 }
 
 
 void addConfigurationContainer(std::shared_ptr<ConfigurationContainer> container) {
-    configurationContainers.push_back(container);
+    registry->configurationContainers.push_back(container);
 }
 
 std::shared_ptr<ConfigurationContainer> getContainer(const char *filename) {
-    std::vector<std::shared_ptr<ConfigurationContainer>>::iterator container = std::find_if(configurationContainers.begin(), configurationContainers.end(),
+    std::vector<std::shared_ptr<ConfigurationContainer>>::iterator container = std::find_if(registry->configurationContainers.begin(), registry->configurationContainers.end(),
         [filename](std::shared_ptr<ConfigurationContainer> &elem) {
             return !strcmp(elem->getFilename(), filename);
         });
 
-    if (container != configurationContainers.end()) {
+    if (container != registry->configurationContainers.end()) {
         return *container;
     } else {
         return nullptr;
@@ -74,7 +250,7 @@ ConfigurationContainer *declareContainer(const char *filename, bool accessible)
             MO_DBG_ERR("OOM");
             return nullptr;
         }
-        configurationContainers.push_back(container);
+        registry->configurationContainers.push_back(container);
     }
 
     if (container->isAccessible() != accessible) {
@@ -85,21 +261,22 @@ ConfigurationContainer *declareContainer(const char *filename, bool accessible)
 }
 
 std::shared_ptr<Configuration> loadConfiguration(TConfig type, const char *key, bool accessible) {
-    for (auto& container : configurationContainers) {
-        if (auto config = container->getConfiguration(key)) {
-            if (config->getType() != type) {
-                MO_DBG_ERR("conflicting type for %s - remove old config", key);
-                container->remove(config.get());
-                continue;
-            }
-            if (container->isAccessible() != accessible) {
-                MO_DBG_ERR("conflicting accessibility for %s", key);
-            }
-            container->loadStaticKey(*config.get(), key);
-            return config;
-        }
+    ConfigurationContainer *container = nullptr;
+    auto config = lookupConfiguration(key, false, &container);
+    if (!config) {
+        return nullptr;
     }
-    return nullptr;
+    if (config->getType() != type) {
+        MO_DBG_ERR("conflicting type for %s - remove old config", key);
+        container->remove(config.get());
+        registry->indexValid = false;
+        return nullptr;
+    }
+    if (container->isAccessible() != accessible) {
+        MO_DBG_ERR("conflicting accessibility for %s", key);
+    }
+    container->loadStaticKey(*config.get(), key);
+    return config;
 }
 
 template<class T>
@@ -151,6 +328,19 @@ std::shared_ptr<Configuration> declareConfiguration(const char *key, T factoryDe
             container->remove(res.get());
             return nullptr;
         }
+
+        if (registry->indexValid && container->isIndexable()) {
+            //keep index up-to-date without rebuilding it for every declared config. The lookup above has brought the
+            //index up-to-date, so the new config is the only change since then
+            registry->indexedGeneration = indexGeneration();
+            if (!indexInsert(res, container)) {
+                registry->indexValid = false;
+            }
+        }
+    }
+
+    if (auto validator = findValidator(key)) {
+        res->setValidator(validator);
     }
 
     loadPermissions(*res.get(), readonly, rebootRequired);
@@ -162,40 +352,39 @@ template std::shared_ptr<Configuration> declareConfiguration<bool>(const char *k
 template std::shared_ptr<Configuration> declareConfiguration<const char*>(const char *key, const char *factoryDef, const char *filename, bool readonly, bool rebootRequired, bool accessible);
 
 std::function<bool(const char*)> *getConfigurationValidator(const char *key) {
-    for (auto& v : validators) {
-        if (!strcmp(v.key, key)) {
-            return &v.checkValue;
-        }
+    ConfigurationContainer *container = nullptr;
+    auto config = lookupConfiguration(key, false, &container);
+    if (config && container->isIndexable() && config->getValidator()) {
+        //validator is attached to the config
+        return config->getValidator();
     }
-    return nullptr;
+    return findValidator(key); //configs which have been loaded from flash but not declared have no validator attached
 }
 
 void registerConfigurationValidator(const char *key, std::function<bool(const char*)> validator) {
-    for (auto& v : validators) {
-        if (!strcmp(v.key, key)) {
-            v.checkValue = validator;
-            return;
-        }
+    auto checkValue = findValidator(key);
+    if (checkValue) {
+        *checkValue = validator;
+    } else {
+        registry->validators.emplace_back(new Validator(key, validator));
+        checkValue = &registry->validators.back()->checkValue;
     }
-    validators.push_back(Validator{key, validator});
-}
 
-Configuration *getConfigurationPublic(const char *key) {
-    for (auto& container : configurationContainers) {
-        if (container->isAccessible()) {
-            if (auto res = container->getConfiguration(key)) {
-                return res.get();
-            }
-        }
+    ConfigurationContainer *container = nullptr;
+    auto config = lookupConfiguration(key, false, &container);
+    if (config && container->isIndexable()) {
+        config->setValidator(checkValue);
     }
+}
 
-    return nullptr;
+Configuration *getConfigurationPublic(const char *key) {
+    return lookupConfiguration(key, true).get();
 }
 
 std::vector<ConfigurationContainer*> getConfigurationContainersPublic() {
     std::vector<ConfigurationContainer*> res;
 
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry->configurationContainers) {
         if (container->isAccessible()) {
             res.push_back(container.get());
         }
@@ -204,33 +393,109 @@ std::vector<ConfigurationContainer*> getConfigurationContainersPublic() {
     return res;
 }
 
+ConfigurationContainer *getConfigurationContainerPublic(size_t index) {
+    for (auto& container : registry->configurationContainers) {
+        if (container->isAccessible()) {
+            if (index == 0) {
+                return container.get();
+            }
+            index--;
+        }
+    }
+
+    return nullptr;
+}
+
+ConfigurationRegistry *configuration_registry_create() {
+    auto res = new ConfigurationRegistry();
+    if (!res) {
+        MO_DBG_ERR("OOM");
+    }
+    return res;
+}
+
+void configuration_registry_free(ConfigurationRegistry *reg) {
+    if (reg == registry) {
+        registry = &defaultRegistry;
+    }
+    delete reg;
+}
+
+ConfigurationRegistry *configuration_registry_select(ConfigurationRegistry *reg) {
+    auto prev = registry;
+    registry = reg ? reg : &defaultRegistry;
+    return prev == &defaultRegistry ? nullptr : prev;
+}
+
 bool configuration_init(std::shared_ptr<FilesystemAdapter> _filesystem) {
-    filesystem = _filesystem;
+    registry->filesystem = _filesystem;
     return true;
 }
 
+const char *configuration_intern_key(const char *key) {
+    auto& keys = registry->keys;
+    auto& buckets = registry->keyBuckets;
+    uint32_t hash = hashKey(key);
+
+    if (!buckets.empty()) {
+        size_t mask = buckets.size() - 1;
+        for (size_t i = hash & mask; buckets[i] != MO_CONFIG_INDEX_NIL; i = (i + 1) & mask) {
+            if (!strcmp(keys[buckets[i]].get(), key)) {
+                return keys[buckets[i]].get();
+            }
+        }
+    }
+
+    if (!bucketsReserve(buckets, keys.size(), [&keys] (size_t i) {return hashKey(keys[i].get());})) {
+        return nullptr;
+    }
+
+    std::unique_ptr<char[]> interned {new char[strlen(key) + 1]};
+    strcpy(interned.get(), key);
+    keys.push_back(std::move(interned));
+    bucketsPut(buckets, keys.size() - 1, hash);
+    return keys.back().get();
+}
+
 void configuration_deinit() {
-    configurationContainers.clear();
-    validators.clear();
-    filesystem.reset();
+    //configs can outlive the registry. Detach validators before destroying them
+    for (auto& container : registry->configurationContainers) {
+        if (container->isIndexable()) {
+            for (size_t i = 0; i < container->size(); i++) {
+                container->getConfiguration(i)->setValidator(nullptr);
+            }
+        }
+    }
+
+    registry->index.clear();
+    registry->indexBuckets.clear();
+    registry->indexedGeneration = 0;
+    registry->indexValid = false;
+    registry->configurationContainers.clear();
+    registry->validators.clear();
+    registry->keys.clear();
+    registry->keyBuckets.clear();
+    registry->filesystem.reset();
 }
 
 bool configuration_load(const char *filename) {
     bool success = true;
 
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry->configurationContainers) {
         if ((!filename || !strcmp(filename, container->getFilename())) && !container->load()) {
             success = false;
         }
     }
 
+    registry->indexValid = false; //loading can replace configs
+
     return success;
 }
 
 bool configuration_save() {
     bool success = true;
 
-    for (auto& container : configurationContainers) {
+    for (auto& container : registry->configurationContainers) {
         if (!container->save()) {
             success = false;
         }
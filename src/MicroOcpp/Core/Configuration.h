@@ -28,6 +28,18 @@ void addConfigurationContainer(std::shared_ptr<ConfigurationContainer> container
 
 Configuration *getConfigurationPublic(const char *key);
 std::vector<ConfigurationContainer*> getConfigurationContainersPublic();
+ConfigurationContainer *getConfigurationContainerPublic(size_t index); //index-based access to the same list without copying. nullptr if out of range
+
+/*
+ * Configuration containers, validators and the filesystem of one OCPP instance. All functions in this file operate
+ * on the selected registry. By default, a process-wide registry is selected, so single-instance hosts never need to
+ * deal with registries. Multi-instance hosts create one registry per instance and select it before calling into the
+ * instance (see mocpp_instance_select())
+ */
+struct ConfigurationRegistry;
+ConfigurationRegistry *configuration_registry_create();
+void configuration_registry_free(ConfigurationRegistry *registry);
+ConfigurationRegistry *configuration_registry_select(ConfigurationRegistry *registry); //nullptr selects the default registry. Returns the previously selected registry (nullptr if default)
 
 bool configuration_init(std::shared_ptr<FilesystemAdapter> filesytem);
 void configuration_deinit();
@@ -36,5 +48,8 @@ bool configuration_load(const char *filename = nullptr);
 
 bool configuration_save();
 
+//returns a copy of key which is owned by the selected registry. Equal keys share one copy. Valid until configuration_deinit()
+const char *configuration_intern_key(const char *key);
+
 } //end namespace MicroOcpp
 #endif
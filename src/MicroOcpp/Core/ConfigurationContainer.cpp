@@ -32,6 +32,7 @@ std::shared_ptr<Configuration> ConfigurationContainerVolatile::createConfigurati
         return nullptr;
     }
     configurations.push_back(res);
+    incGeneration();
     return res;
 }
 
@@ -39,6 +40,7 @@ void ConfigurationContainerVolatile::remove(Configuration *config) {
     for (auto entry = configurations.begin(); entry != configurations.end();) {
         if (entry->get() == config) {
             entry = configurations.erase(entry);
+            incGeneration();
         } else {
             entry++;
         }
@@ -62,8 +64,17 @@ std::shared_ptr<Configuration> ConfigurationContainerVolatile::getConfiguration(
     return nullptr;
 }
 
+bool ConfigurationContainerVolatile::isIndexable() {
+    return true;
+}
+
+std::shared_ptr<Configuration> ConfigurationContainerVolatile::getConfigurationShared(size_t i) {
+    return configurations[i];
+}
+
 void ConfigurationContainerVolatile::add(std::shared_ptr<Configuration> c) {
     configurations.push_back(std::move(c));
+    incGeneration();
 }
 
 namespace MicroOcpp {
@@ -16,6 +16,9 @@ class ConfigurationContainer {
 private:
     const char *filename;
     bool accessible;
+    unsigned int generation = 0;
+protected:
+    void incGeneration() {generation++;}
 public:
     ConfigurationContainer(const char *filename, bool accessible) : filename(filename), accessible(accessible) { }
 
@@ -35,6 +38,13 @@ public:
     virtual std::shared_ptr<Configuration> getConfiguration(const char *key) = 0;
 
     virtual void loadStaticKey(Configuration& config, const char *key) { } //possible optimization: can replace internal key with passed static key
+
+    //optional: containers which own their configs as shared_ptrs can expose them to the key index of the configuration
+    //registry. The configs of other containers are looked up with getConfiguration(key). Indexable containers must call
+    //incGeneration() whenever they add or remove a config, so that the registry can detect a stale index
+    virtual bool isIndexable() {return false;}
+    virtual std::shared_ptr<Configuration> getConfigurationShared(size_t i) {return nullptr;}
+    unsigned int getGeneration() {return generation;}
 };
 
 class ConfigurationContainerVolatile : public ConfigurationContainer {
@@ -51,6 +61,8 @@ public:
     size_t size() override;
     Configuration *getConfiguration(size_t i) override;
     std::shared_ptr<Configuration> getConfiguration(const char *key) override;
+    bool isIndexable() override;
+    std::shared_ptr<Configuration> getConfigurationShared(size_t i) override;
 
     //add custom Configuration object
     void add(std::shared_ptr<Configuration> c);
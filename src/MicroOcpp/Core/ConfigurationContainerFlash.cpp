@@ -3,6 +3,7 @@
 // MIT License
 
 #include <MicroOcpp/Core/ConfigurationContainerFlash.h>
+#include <MicroOcpp/Core/Configuration.h>
 
 #include <algorithm>
 #include <MicroOcpp/Core/FilesystemUtils.h>
@@ -20,20 +21,6 @@ private:
 
     bool loaded = false;
 
-    std::vector<std::unique_ptr<char[]>> keyPool;
-    
-    void clearKeyPool(const char *key) {
-        keyPool.erase(std::remove_if(keyPool.begin(), keyPool.end(), 
-            [key] (const std::unique_ptr<char[]>& k) {
-                #if MO_DBG_LEVEL >= MO_DL_VERBOSE
-                if (!strcmp(k.get(), key)) {
-                    MO_DBG_VERBOSE("clear key %s", key);
-                }
-                #endif
-                return !strcmp(k.get(), key);
-            }), keyPool.end());
-    }
-
     bool configurationsUpdated() {
         auto revisionSum_old = revisionSum;
 
@@ -93,6 +80,19 @@ public:
             return false;
         }
 
+        //configs which have been declared before loading, sorted by key. Avoids a linear search per stored config
+        std::vector<std::pair<const char*, Configuration*>> declared;
+        declared.reserve(configurations.size());
+        for (auto& config : configurations) {
+            if (config->getKey()) {
+                declared.emplace_back(config->getKey(), config.get());
+            }
+        }
+        auto keyLess = [] (const std::pair<const char*, Configuration*>& a, const std::pair<const char*, Configuration*>& b) {
+            return strcmp(a.first, b.first) < 0;
+        };
+        std::sort(declared.begin(), declared.end(), keyLess);
+
         for (JsonObject stored : configurationsArray) {
             TConfig type;
             if (!deserializeTConfig(stored["type"] | "_Undefined", type)) {
@@ -111,17 +111,25 @@ public:
                 continue;
             }
             
-            std::unique_ptr<char[]> key_pooled;
+            const char *key_pooled = nullptr;
 
-            auto config = getConfiguration(key).get();
+            Configuration *config = nullptr;
+            auto found = std::lower_bound(declared.begin(), declared.end(), std::make_pair(key, (Configuration*) nullptr), keyLess);
+            if (found != declared.end() && !strcmp(found->first, key)) {
+                config = found->second;
+            }
             if (config && config->getType() != type) {
                 MO_DBG_ERR("conflicting type for %s - remove old config", key);
                 remove(config);
+                found = declared.erase(found);
                 config = nullptr;
             }
             if (!config) {
-                key_pooled.reset(new char[strlen(key) + 1]);
-                strcpy(key_pooled.get(), key);
+                key_pooled = configuration_intern_key(key);
+                if (!key_pooled) {
+                    MO_DBG_ERR("OOM: %s", key);
+                    continue;
+                }
             }
 
             switch (type) {
@@ -133,7 +141,7 @@ public:
                     int value = stored["value"] | 0;
                     if (!config) {
                         //create new config
-                        config = createConfiguration(TConfig::Int, key_pooled.get()).get();
+                        config = createConfiguration(TConfig::Int, key_pooled).get();
                     }
                     if (config) {
                         config->setInt(value);
@@ -148,7 +156,7 @@ public:
                     bool value = stored["value"] | false;
                     if (!config) {
                         //create new config
-                        config = createConfiguration(TConfig::Bool, key_pooled.get()).get();
+                        config = createConfiguration(TConfig::Bool, key_pooled).get();
                     }
                     if (config) {
                         config->setBool(value);
@@ -163,7 +171,7 @@ public:
                     const char *value = stored["value"] | "";
                     if (!config) {
                         //create new config
-                        config = createConfiguration(TConfig::String, key_pooled.get()).get();
+                        config = createConfiguration(TConfig::String, key_pooled).get();
                     }
                     if (config) {
                         config->setString(value);
@@ -172,15 +180,11 @@ public:
                 }
             }
 
-            if (config) {
-                //success
-
-                if (key_pooled) {
-                    //allocated key, need to store
-                    keyPool.push_back(std::move(key_pooled));
-                }
-            } else {
+            if (!config) {
                 MO_DBG_ERR("OOM: %s", key);
+            } else if (key_pooled) {
+                //keep the lookup table in sync for duplicate keys further down in the file
+                declared.insert(found, std::make_pair(key_pooled, config));
             }
         }
 
@@ -274,17 +278,18 @@ public:
             return nullptr;
         }
         configurations.push_back(res);
+        incGeneration();
         return res;
     }
 
     void remove(Configuration *config) override {
-        const char *key = config->getKey();
+        auto size = configurations.size();
         configurations.erase(std::remove_if(configurations.begin(), configurations.end(),
             [config] (std::shared_ptr<Configuration>& entry) {
                 return entry.get() == config;
             }), configurations.end());
-        if (key) {
-            clearKeyPool(key);
+        if (configurations.size() != size) {
+            incGeneration();
         }
     }
 
@@ -306,8 +311,15 @@ public:
     }
 
     void loadStaticKey(Configuration& config, const char *key) override {
-        config.setKey(key);
-        clearKeyPool(key);
+        config.setKey(key); //interned key remains in the registry for the next load
+    }
+
+    bool isIndexable() override {
+        return true;
+    }
+
+    std::shared_ptr<Configuration> getConfigurationShared(size_t i) override {
+        return configurations[i];
     }
 };
 
@@ -82,6 +82,14 @@ bool Configuration::isReadOnly() {
     return readOnly;
 }
 
+void Configuration::setValidator(std::function<bool(const char*)> *validator) {
+    this->validator = validator;
+}
+
+std::function<bool(const char*)> *Configuration::getValidator() {
+    return validator;
+}
+
 /*
  * Default implementations of the Configuration interface.
  *
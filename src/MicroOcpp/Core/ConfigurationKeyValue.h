@@ -7,6 +7,7 @@
 
 #include <ArduinoJson.h>
 #include <memory>
+#include <functional>
 
 #define MO_CONFIG_MAX_VALSTRSIZE 128
 
@@ -49,6 +50,7 @@ protected:
 private:
     bool rebootRequired = false;
     bool readOnly = false;
+    std::function<bool(const char*)> *validator = nullptr; //owned by the configuration registry
 public:
     virtual ~Configuration();
 
@@ -72,6 +74,9 @@ public:
 
     void setReadOnly();
     bool isReadOnly();
+
+    void setValidator(std::function<bool(const char*)> *validator); //attached by registerConfigurationValidator()
+    std::function<bool(const char*)> *getValidator(); //nullptr if values don't need validation
 };
 
 /*
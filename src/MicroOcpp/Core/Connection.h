@@ -69,6 +69,15 @@ public:
      * connection status is uncertain, it's best to return true by default.
      */
     virtual bool isConnected() {return true;} //MO ignores true. This default implementation keeps backwards-compatibility
+
+    /*
+     * NEW IN v1.2
+     *
+     * Returns the time in ms until loop() needs to be called again. Sockets which wake up the host by themselves
+     * (e.g. via a select() or an interrupt) can keep the default. Sockets which rely on frequent polling should
+     * return 0
+     */
+    virtual unsigned long getNextWakeupMs() {return MO_WAKEUP_MAX_MS;}
 };
 
 class LoopbackConnection : public Connection {
@@ -120,6 +129,8 @@ public:
     unsigned long getLastConnected() override; //get last connection creation in millis
 
     bool isConnected() override;
+
+    unsigned long getNextWakeupMs() override {return 0;} //arduinoWebSockets needs to be polled
 };
 
 } //end namespace EspWiFi
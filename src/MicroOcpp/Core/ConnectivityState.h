@@ -0,0 +1,23 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_CONNECTIVITYSTATE_H
+#define MO_CONNECTIVITYSTATE_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum ConnectivityState {
+    ConnectivityState_Offline,  //no connection to the server. The timeouts of the queued requests are frozen
+    ConnectivityState_Backoff,  //reconnected, but waiting for the randomized backoff delay before sending queued requests
+    ConnectivityState_Draining, //sending the requests which have accumulated while offline at a limited rate
+    ConnectivityState_Online
+}   ConnectivityState;
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
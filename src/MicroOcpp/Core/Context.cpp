@@ -2,6 +2,10 @@
 // Copyright Matthias Akstaller 2019 - 2024
 // MIT License
 
+#include <algorithm>
+#include <string.h>
+#include <ctype.h>
+
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Core/Request.h>
 #include <MicroOcpp/Core/Connection.h>
@@ -26,6 +30,20 @@ void Context::loop() {
     model.loop();
 }
 
+unsigned long Context::getNextWakeupMs() {
+    unsigned long res = connection.getNextWakeupMs();
+    res = std::min(res, reqQueue.getNextWakeupMs());
+    res = std::min(res, model.getNextWakeupMs());
+    return res;
+}
+
+unsigned long Context::getNextDeadlineMs() {
+    unsigned long res = connection.getNextWakeupMs();
+    res = std::min(res, reqQueue.getNextWakeupMs());
+    res = std::min(res, model.getNextDeadlineMs());
+    return res;
+}
+
 void Context::initiateRequest(std::unique_ptr<Request> op) {
     if (!op) {
         MO_DBG_ERR("invalid arg");
@@ -61,3 +79,38 @@ void Context::setFtpClient(std::unique_ptr<FtpClient> ftpClient) {
 FtpClient *Context::getFtpClient() {
     return ftpClient.get();
 }
+
+void Context::setHttpClient(std::unique_ptr<FtpClient> httpClient) {
+    this->httpClient = std::move(httpClient);
+}
+
+FtpClient *Context::getHttpClient() {
+    return httpClient.get();
+}
+
+FtpClient *Context::getTransferClient(const char *url) {
+    if (!url) {
+        return nullptr;
+    }
+
+    //compare protocol specifier case-insensitively
+    const char *http = "http";
+    size_t i = 0;
+    for (; http[i]; i++) {
+        if (tolower(url[i]) != http[i]) {
+            return ftpClient.get();
+        }
+    }
+    if (tolower(url[i]) == 's') {
+        i++;
+    }
+    if (strncmp(url + i, "://", 3)) {
+        return ftpClient.get();
+    }
+
+    if (!httpClient) {
+        //no HTTP client registered. Leave the URL to the FTP client which may be a custom client supporting HTTP
+        return ftpClient.get();
+    }
+    return httpClient.get();
+}
@@ -26,6 +26,7 @@ private:
     RequestQueue reqQueue;
 
     std::unique_ptr<FtpClient> ftpClient;
+    std::unique_ptr<FtpClient> httpClient;
 
 public:
     Context(Connection& connection, std::shared_ptr<FilesystemAdapter> filesystem, uint16_t bootNr, ProtocolVersion version);
@@ -33,6 +34,9 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs(); //time until loop() needs to be called again at the latest
+    unsigned long getNextDeadlineMs(); //same, but assumes that loop() is also called when an input changes
+
     void initiateRequest(std::unique_ptr<Request> op);
 
     Model& getModel();
@@ -47,6 +51,16 @@ public:
 
     void setFtpClient(std::unique_ptr<FtpClient> ftpClient);
     FtpClient *getFtpClient();
+
+    /*
+     * The HTTP client downloads and uploads files with http:// and https:// URLs. With MbedTLS, mocpp_initialize()
+     * installs the built-in HTTP client. A custom HTTP client must be registered here after mocpp_initialize(),
+     * otherwise the built-in client takes all http(s) URLs. Without HTTP client, all URLs go to the FTP client
+     */
+    void setHttpClient(std::unique_ptr<FtpClient> httpClient);
+    FtpClient *getHttpClient();
+
+    FtpClient *getTransferClient(const char *url); //HTTP client for http:// and https:// URLs if set, FTP client otherwise
 };
 
 } //end namespace MicroOcpp
@@ -19,6 +19,76 @@
  * You can add support for other file systems by passing a custom adapter to mocpp_initialize(...)
  */
 
+#include <string>
+
+namespace MicroOcpp {
+
+class FilesystemAdapterPrefix : public FilesystemAdapter {
+private:
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    std::string prefix;
+
+    //translate MO_FILENAME_PREFIX "fn" into MO_FILENAME_PREFIX "<prefix>fn"
+    bool mapPath(const char *path, char *out, size_t size) {
+        if (strncmp(path, MO_FILENAME_PREFIX, sizeof(MO_FILENAME_PREFIX) - 1)) {
+            MO_DBG_ERR("invalid fn: %s", path);
+            return false;
+        }
+        const char *fn = path + sizeof(MO_FILENAME_PREFIX) - 1;
+        auto ret = snprintf(out, size, MO_FILENAME_PREFIX "%s%s", prefix.c_str(), fn);
+        if (ret < 0 || (size_t)ret >= size) {
+            MO_DBG_ERR("fn error: %i", ret);
+            return false;
+        }
+        return true;
+    }
+public:
+    FilesystemAdapterPrefix(std::shared_ptr<FilesystemAdapter> filesystem, const char *prefix) : filesystem(std::move(filesystem)), prefix(prefix) { }
+
+    int stat(const char *path, size_t *size) override {
+        char mapped [MO_MAX_PATH_SIZE];
+        if (!mapPath(path, mapped, sizeof(mapped))) {
+            return -1;
+        }
+        return filesystem->stat(mapped, size);
+    }
+
+    std::unique_ptr<FileAdapter> open(const char *path, const char *mode) override {
+        char mapped [MO_MAX_PATH_SIZE];
+        if (!mapPath(path, mapped, sizeof(mapped))) {
+            return nullptr;
+        }
+        return filesystem->open(mapped, mode);
+    }
+
+    bool remove(const char *path) override {
+        char mapped [MO_MAX_PATH_SIZE];
+        if (!mapPath(path, mapped, sizeof(mapped))) {
+            return false;
+        }
+        return filesystem->remove(mapped);
+    }
+
+    int ftw_root(std::function<int(const char *fpath)> fn) override {
+        return filesystem->ftw_root([this, &fn] (const char *fpath) -> int {
+            if (strncmp(fpath, prefix.c_str(), prefix.length())) {
+                return 0; //file of other instance
+            }
+            return fn(fpath + prefix.length());
+        });
+    }
+};
+
+std::shared_ptr<FilesystemAdapter> makePrefixedFilesystemAdapter(std::shared_ptr<FilesystemAdapter> filesystem, const char *prefix) {
+    if (!filesystem || !prefix || !*prefix) {
+        return filesystem;
+    }
+
+    return std::make_shared<FilesystemAdapterPrefix>(std::move(filesystem), prefix);
+}
+
+} //end namespace MicroOcpp
+
 #if MO_ENABLE_FILE_INDEX
 
 #include <vector>
@@ -89,6 +89,15 @@ public:
  */
 std::shared_ptr<FilesystemAdapter> makeDefaultFilesystemAdapter(FilesystemOpt config);
 
+/*
+ * Decorator which stores all files under an additional filename prefix in the mo_store root folder, e.g.
+ * MO_FILENAME_PREFIX "cp0001-bootstats.jsn". Multiple OCPP instances can share one filesystem this way. ftw_root
+ * only enumerates the files with the prefix and strips it.
+ *
+ * Returns the passed filesystem if prefix is null or empty
+ */
+std::shared_ptr<FilesystemAdapter> makePrefixedFilesystemAdapter(std::shared_ptr<FilesystemAdapter> filesystem, const char *prefix);
+
 } //end namespace MicroOcpp
 
 #endif
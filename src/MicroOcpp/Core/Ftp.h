@@ -87,6 +87,19 @@ public:
                 std::function<void(MO_FtpCloseReason reason)> onClose,
                 const char *ca_cert = nullptr) = 0; // nullptr to disable cert check; will be ignored for non-TLS connections
 
+    /*
+     * Like getFile, but resumes the download at byte `offset` of the remote file (FTP command REST). Returns nullptr
+     * if the client doesn't support resuming
+     */
+    virtual std::unique_ptr<FtpDownload> getFileFromOffset(
+                const char *ftp_url, // ftp[s]://[user[:pass]@]host[:port][/directory]/filename
+                size_t offset,
+                std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+                std::function<void(MO_FtpCloseReason reason)> onClose,
+                const char *ca_cert = nullptr) { // nullptr to disable cert check; will be ignored for non-TLS connections
+        return nullptr;
+    }
+
     virtual std::unique_ptr<FtpUpload> postFile(
                 const char *ftp_url, // ftp[s]://[user[:pass]@]host[:port][/directory]/filename
                 std::function<size_t(unsigned char *out, size_t buffsize)> fileReader, //write at most buffsize bytes into out-buffer. Return number of bytes written
@@ -39,7 +39,10 @@ private:
     mbedtls_net_context ctrl_fd;
     mbedtls_ssl_context ctrl_ssl;
     bool ctrl_opened = false;
+    bool ctrl_ssl_handshake = false; //TLS handshake in progress
     bool ctrl_ssl_established = false;
+    unsigned char ctrl_buf [MO_FTP_CTRL_BUFSIZE]; //received data which doesn't form a complete line yet
+    size_t ctrl_buf_len = 0;
 
     //data connection specific
     mbedtls_net_context data_fd;
@@ -47,6 +50,8 @@ private:
     bool data_opened = false;
     bool data_ssl_established = false;
     bool data_conn_accepted = false; //Server sent okay to upload / download data
+    bool transfer_started = false; //RETR / STOR accepted. Subsequent replies refer to the file transfer
+    MO_FtpCloseReason transfer_reply = MO_FtpCloseReason_Undefined; //result of the file transfer according to the server reply
 
     //FTP URL
     std::string user;
@@ -59,6 +64,8 @@ private:
     std::string data_host;
     std::string data_port;
 
+    size_t rest_offset = 0; //resume download at this byte offset
+
     bool read_url_ctrl(const char *ftp_url);
     bool read_url_data(const char *data_url);
     
@@ -78,17 +85,21 @@ private:
     int connect_ctrl();
     int connect_data();
     void close_ctrl();
+    void close_data_conn();
     void close_data(MO_FtpCloseReason reason);
+    void complete_data(); //data connection ended regularly. Report the result if the server has replied already
 
     int handshake_tls();
 
     void send_cmd(const char *cmd, const char *arg = nullptr, bool disable_tls_policy = false);
 
-    void process_ctrl();
-    void process_data();
+    //process_ctrl() and process_data() return true if they made progress, i.e. more data may be ready
+    bool process_ctrl();
+    void process_ctrl_line(char *line);
+    bool process_data();
 
     unsigned char *data_buf = nullptr;
-    size_t data_buf_size = 4096;
+    size_t data_buf_size = MO_FTP_DATA_BUFSIZE;
     size_t data_buf_avail = 0;
     size_t data_buf_offs = 0;
 
@@ -103,7 +114,8 @@ public:
     bool getFile(const char *ftp_url, // ftp[s]://[user[:pass]@]host[:port][/directory]/filename
             std::function<size_t(unsigned char *data, size_t len)> fileWriter,
             std::function<void(MO_FtpCloseReason)> onClose,
-            const char *ca_cert = nullptr); // nullptr to disable cert check; will be ignored for non-TLS connections
+            const char *ca_cert = nullptr, // nullptr to disable cert check; will be ignored for non-TLS connections
+            size_t offset = 0); //resume download at offset
 
     bool postFile(const char *ftp_url, // ftp[s]://[user[:pass]@]host[:port][/directory]/filename
             std::function<size_t(unsigned char *out, size_t buffsize)> fileReader, //write at most buffsize bytes into out-buffer. Return number of bytes written
@@ -125,6 +137,12 @@ public:
             std::function<void(MO_FtpCloseReason)> onClose,
             const char *ca_cert = nullptr) override; // nullptr to disable cert check; will be ignored for non-TLS connections
 
+    std::unique_ptr<FtpDownload> getFileFromOffset(const char *ftp_url, // ftp[s]://[user[:pass]@]host[:port][/directory]/filename
+            size_t offset,
+            std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+            std::function<void(MO_FtpCloseReason)> onClose,
+            const char *ca_cert = nullptr) override; // nullptr to disable cert check; will be ignored for non-TLS connections
+
     std::unique_ptr<FtpUpload> postFile(const char *ftp_url, // ftp[s]://[user[:pass]@]host[:port][/directory]/filename
             std::function<size_t(unsigned char *out, size_t buffsize)> fileReader, //write at most buffsize bytes into out-buffer. Return number of bytes written
             std::function<void(MO_FtpCloseReason)> onClose,
@@ -347,7 +365,7 @@ void FtpTransferMbedTLS::close_ctrl() {
     }
 }
 
-void FtpTransferMbedTLS::close_data(MO_FtpCloseReason reason) {
+void FtpTransferMbedTLS::close_data_conn() {
     if (!data_opened) {
         return;
     }
@@ -362,6 +380,10 @@ void FtpTransferMbedTLS::close_data(MO_FtpCloseReason reason) {
     mbedtls_net_free(&data_fd);
     data_opened = false;
     data_conn_accepted = false;
+}
+
+void FtpTransferMbedTLS::close_data(MO_FtpCloseReason reason) {
+    close_data_conn();
 
     if (onClose) {
         onClose(reason);
@@ -369,16 +391,27 @@ void FtpTransferMbedTLS::close_data(MO_FtpCloseReason reason) {
     }
 }
 
+void FtpTransferMbedTLS::complete_data() {
+    close_data_conn();
+
+    if (transfer_reply != MO_FtpCloseReason_Undefined) {
+        close_data(transfer_reply);
+    } else if (!ctrl_opened) {
+        close_data(MO_FtpCloseReason_Failure); //no reply anymore
+    } //otherwise wait for the reply on the ctrl connection. If the ctrl connection closes without reply, the transfer fails
+}
+
 int FtpTransferMbedTLS::handshake_tls() {
 
-    int ret;
-    while ((ret = mbedtls_ssl_handshake(&ctrl_ssl)) != 0) {
-        if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE && ret != 1) {
-            char buf [1024];
-            mbedtls_strerror(ret, (char *) buf, 1024);
-            MO_DBG_ERR("mbedtls_ssl_handshake: %i, %s", ret, buf);
-            return ret;
-        }
+    //one handshake step. Returns MBEDTLS_ERR_SSL_WANT_READ / _WRITE until the handshake is complete
+    int ret = mbedtls_ssl_handshake(&ctrl_ssl);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return ret;
+    } else if (ret != 0) {
+        char buf [1024];
+        mbedtls_strerror(ret, (char *) buf, 1024);
+        MO_DBG_ERR("mbedtls_ssl_handshake: %i, %s", ret, buf);
+        return ret;
     }
 
     if (ca_cert) {
@@ -439,7 +472,7 @@ void FtpTransferMbedTLS::send_cmd(const char *cmd, const char *arg, bool disable
     }
 }
 
-bool FtpTransferMbedTLS::getFile(const char *ftp_url_raw, std::function<size_t(unsigned char *data, size_t len)> fileWriter, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert) {
+bool FtpTransferMbedTLS::getFile(const char *ftp_url_raw, std::function<size_t(unsigned char *data, size_t len)> fileWriter, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert, size_t offset) {
 
     if (method != Method::UNDEFINED) {
         MO_DBG_ERR("FTP Client reuse not supported");
@@ -455,6 +488,7 @@ bool FtpTransferMbedTLS::getFile(const char *ftp_url_raw, std::function<size_t(u
     this->method = Method::Retrieve;
     this->fileWriter = fileWriter;
     this->onClose = onClose;
+    this->rest_offset = offset;
 
     if (!read_url_ctrl(ftp_url_raw)) {
         MO_DBG_ERR("could not parse URL");
@@ -513,157 +547,222 @@ bool FtpTransferMbedTLS::postFile(const char *ftp_url_raw, std::function<size_t(
     return true;
 }
 
-void FtpTransferMbedTLS::process_ctrl() {
-    // read input (if available)
+bool FtpTransferMbedTLS::process_ctrl() {
 
-    const size_t INBUF_SIZE = 128;
-    unsigned char inbuf [INBUF_SIZE];
-    memset(inbuf, 0, INBUF_SIZE);
+    if (ctrl_ssl_handshake) {
+        auto ret = handshake_tls();
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            //handshake continues when the server has responded
+            return false;
+        }
+
+        ctrl_ssl_handshake = false;
+
+        if (ret) {
+            MO_DBG_ERR("handshake: %i", ret);
+            send_cmd("QUIT", nullptr, true);
+            return false;
+        }
+
+        //secure channel established, log in
+        MO_DBG_DEBUG("select user %s", user.empty() ? "anonymous" : user.c_str());
+        send_cmd("USER", user.empty() ? "anonymous" : user.c_str());
+        return true;
+    }
+
+    if (ctrl_buf_len >= sizeof(ctrl_buf) - 1) {
+        MO_DBG_ERR("reply exceeds MO_FTP_CTRL_BUFSIZE");
+        send_cmd("QUIT");
+        close_ctrl();
+        return false;
+    }
+
+    // read input (if available)
 
     int ret = -1;
 
     if (ctrl_ssl_established) {
-        ret = mbedtls_ssl_read(&ctrl_ssl, inbuf, INBUF_SIZE - 1);
+        ret = mbedtls_ssl_read(&ctrl_ssl, ctrl_buf + ctrl_buf_len, sizeof(ctrl_buf) - 1 - ctrl_buf_len);
     } else {
-        ret = mbedtls_net_recv(&ctrl_fd, inbuf, INBUF_SIZE - 1);
+        ret = mbedtls_net_recv(&ctrl_fd, ctrl_buf + ctrl_buf_len, sizeof(ctrl_buf) - 1 - ctrl_buf_len);
     }
 
     if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
         //no new input data to be processed
-        return;
+        return false;
     } else if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY || ret == 0) {
         MO_DBG_ERR("FTP transfer aborted");
         close_ctrl();
-        return;
+        return false;
     } else if (ret < 0) {
         MO_DBG_ERR("mbedtls_net_recv: %i", ret);
         send_cmd("QUIT");
         close_ctrl();
-        return;
+        return false;
     }
 
-    size_t inbuf_len = ret;
-
-    // read multi-line command
-    char *line_next = (char*) inbuf;
-    while (line_next < (char*) inbuf + inbuf_len) {
-
-        // take current line
-        char *line = line_next;
+    ctrl_buf_len += (size_t) ret;
 
-        // null-terminate current line and find begin of next line
-        while (line_next + 1 < (char*) inbuf + inbuf_len && *line_next != '\n') {
-            line_next++;
+    // process all complete lines. A partial line remains in ctrl_buf until its remainder arrives
+    size_t line_begin = 0;
+    for (size_t i = 0; i < ctrl_buf_len && ctrl_opened && !ctrl_ssl_handshake; i++) {
+        if (ctrl_buf[i] != '\n') {
+            continue;
         }
-        *line_next = '\0';
-        line_next++;
-
-        MO_DBG_DEBUG("RECV: %s", line);
-
-        if (isSecure && !ctrl_ssl_established) { //tls not established yet, set up according to RFC 4217
-            if (!strncmp("220", line, 3)) {
-                MO_DBG_DEBUG("start TLS negotiation");
-                send_cmd("AUTH TLS", nullptr, true);
-                return;
-            } else if (!strncmp("234", line, 3)) { // Proceed with TLS negotiation
-                MO_DBG_DEBUG("upgrade to TLS");
-
-                if (auto ret = handshake_tls()) {
-                    MO_DBG_ERR("handshake: %i", ret);
-                    send_cmd("QUIT", nullptr, true);
-                    return;
-                }
-            } else {
-                MO_DBG_ERR("cannot proceed without TLS");
-                send_cmd("QUIT", nullptr, true);
-                return;
-            }
+
+        ctrl_buf[i] = '\0';
+        if (i > line_begin && ctrl_buf[i - 1] == '\r') {
+            ctrl_buf[i - 1] = '\0';
         }
 
-        if (isSecure && !ctrl_ssl_established) {
-            //failure to establish security policy
-            MO_DBG_ERR("internal error");
+        process_ctrl_line((char*) ctrl_buf + line_begin);
+        line_begin = i + 1;
+    }
+
+    if (!ctrl_opened || ctrl_ssl_handshake) {
+        //connection closed or switched to TLS. Discard remaining plaintext
+        ctrl_buf_len = 0;
+    } else if (line_begin > 0) {
+        memmove(ctrl_buf, ctrl_buf + line_begin, ctrl_buf_len - line_begin);
+        ctrl_buf_len -= line_begin;
+    }
+
+    return true;
+}
+
+void FtpTransferMbedTLS::process_ctrl_line(char *line) {
+
+    MO_DBG_DEBUG("RECV: %s", line);
+
+    if (strlen(line) < 3 || line[0] < '0' || line[0] > '9' || line[3] == '-') {
+        //intermediate line of a multi-line reply. Only the last line "xyz text" completes the reply
+        return;
+    }
+
+    if (isSecure && !ctrl_ssl_established) { //tls not established yet, set up according to RFC 4217
+        if (!strncmp("220", line, 3)) {
+            MO_DBG_DEBUG("start TLS negotiation");
+            send_cmd("AUTH TLS", nullptr, true);
+            return;
+        } else if (!strncmp("234", line, 3)) { // Proceed with TLS negotiation
+            MO_DBG_DEBUG("upgrade to TLS");
+            ctrl_ssl_handshake = true; //continue in process_ctrl() without blocking
+            return;
+        } else {
+            MO_DBG_ERR("cannot proceed without TLS");
             send_cmd("QUIT", nullptr, true);
             return;
         }
+    }
 
-        //security policy met
-                
-        if (!strncmp("530", line, 3)            // Not logged in
-                || !strncmp("220", line, 3)     // Service ready for new user
-                || !strncmp("234", line, 3)) {  // Just completed AUTH TLS handshake
-            MO_DBG_DEBUG("select user %s", user.empty() ? "anonymous" : user.c_str());
-            send_cmd("USER", user.empty() ? "anonymous" : user.c_str());
-        } else if (!strncmp("331", line, 3)) { // User name okay, need password
-            MO_DBG_DEBUG("enter pass %.2s***", pass.empty() ? "-" : pass.c_str());
-            send_cmd("PASS", pass.c_str());
-        } else if (!strncmp("230", line, 3)) { // User logged in, proceed
-            MO_DBG_DEBUG("select directory %s", dir.empty() ? "/" : dir.c_str());
-            send_cmd("CWD", dir.empty() ? "/" : dir.c_str());
-        } else if (!strncmp("250", line, 3)) { // Requested file action okay, completed
-            MO_DBG_DEBUG("enter passive mode");
-            if (isSecure) {
-                send_cmd("PBSZ 0\r\n"
-                         "PROT P\r\n" //RFC 4217: set FTP session Private
-                         "PASV");
-            } else {
-                send_cmd("PASV");
-            }
-        } else if (!strncmp("227", line, 3)) { // Entering Passive Mode (h1,h2,h3,h4,p1,p2)
-
-            if (!read_url_data(line + 3)) { //trim leading response code
-                MO_DBG_ERR("could not process data url. Expect format: (h1,h2,h3,h4,p1,p2)");
-                send_cmd("QUIT");
-                return;
-            }
-
-            if (auto ret = connect_data()) {
-                MO_DBG_ERR("data connection failure: %i", ret);
-                send_cmd("QUIT");
-                return;
-            }
+    if (isSecure && !ctrl_ssl_established) {
+        //failure to establish security policy
+        MO_DBG_ERR("internal error");
+        send_cmd("QUIT", nullptr, true);
+        return;
+    }
 
-            if (method == Method::Retrieve) {
-                MO_DBG_DEBUG("request download for %s", fname.c_str());
-                send_cmd("RETR", fname.c_str());
-            } else if (method == Method::Store) {
-                MO_DBG_DEBUG("request upload for %s", fname.c_str());
-                send_cmd("STOR", fname.c_str());
-            } else {
-                MO_DBG_ERR("internal error");
-                send_cmd("QUIT");
-                return;
-            }
+    //security policy met
+            
+    if (transfer_started && (!strncmp("226", line, 3)      // Closing data connection. Requested file action successful
+                          || !strncmp("250", line, 3))) {  // Requested file action okay, completed
+        MO_DBG_INFO("FTP success: %s", line);
+        transfer_reply = MO_FtpCloseReason_Success;
+        if (!data_opened) {
+            close_data(MO_FtpCloseReason_Success);
+        } //otherwise the data connection still needs to be drained
+        send_cmd("QUIT");
+        return;
+    } else if ((transfer_started || data_opened) && (line[0] == '4' || line[0] == '5')) { // Transfer aborted or refused, e.g. 426 Connection closed, 451 Local error or 550 File unavailable
+        MO_DBG_WARN("FTP failure: %s", line);
+        transfer_reply = MO_FtpCloseReason_Failure; //even if the data connection ends regularly, the file may be incomplete
+        if (!data_conn_accepted || method != Method::Retrieve) {
+            close_data(MO_FtpCloseReason_Failure);
+        } //otherwise keep the data which has arrived already. A resumed download can continue from there
+        send_cmd("QUIT");
+        return;
+    } else if (!strncmp("530", line, 3)            // Not logged in
+            || !strncmp("220", line, 3)) {  // Service ready for new user
+        MO_DBG_DEBUG("select user %s", user.empty() ? "anonymous" : user.c_str());
+        send_cmd("USER", user.empty() ? "anonymous" : user.c_str());
+    } else if (!strncmp("331", line, 3)) { // User name okay, need password
+        MO_DBG_DEBUG("enter pass %.2s***", pass.empty() ? "-" : pass.c_str());
+        send_cmd("PASS", pass.c_str());
+    } else if (!strncmp("230", line, 3)) { // User logged in, proceed
+        MO_DBG_DEBUG("select directory %s", dir.empty() ? "/" : dir.c_str());
+        send_cmd("CWD", dir.empty() ? "/" : dir.c_str());
+    } else if (!strncmp("250", line, 3)) { // Requested file action okay, completed (CWD)
+        MO_DBG_DEBUG("enter passive mode");
+        if (isSecure) {
+            send_cmd("PBSZ 0\r\n"
+                     "PROT P\r\n" //RFC 4217: set FTP session Private
+                     "PASV");
+        } else {
+            send_cmd("PASV");
+        }
+    } else if (!strncmp("227", line, 3)) { // Entering Passive Mode (h1,h2,h3,h4,p1,p2)
 
-        } else if (!strncmp("150", line, 3)    // File status okay; about to open data connection
-                || !strncmp("125", line, 3)) { // Data connection already open
-            MO_DBG_DEBUG("data connection accepted");
-            data_conn_accepted = true;
-        } else if (!strncmp("226", line, 3)) { // Closing data connection. Requested file action successful (for example, file transfer or file abort)
-            MO_DBG_INFO("FTP success: %s", line);
+        if (!read_url_data(line + 3)) { //trim leading response code
+            MO_DBG_ERR("could not process data url. Expect format: (h1,h2,h3,h4,p1,p2)");
             send_cmd("QUIT");
             return;
-        } else if (!strncmp("55", line, 2)) { // Requested action not taken / aborted
-            MO_DBG_WARN("FTP failure: %s", line);
+        }
+
+        if (auto ret = connect_data()) {
+            MO_DBG_ERR("data connection failure: %i", ret);
             send_cmd("QUIT");
             return;
-        } else if (!strncmp("200", line, 3)) { //PBSZ -> 0 and PROT -> P accepted
-            MO_DBG_INFO("PBSZ/PROT success: %s", line);
-        } else if (!strncmp("221", line, 3)) { // Server Goodbye
-            MO_DBG_DEBUG("closing ctrl connection");
-            close_ctrl();
-            return;
+        }
+
+        if (method == Method::Retrieve && rest_offset > 0) {
+            MO_DBG_DEBUG("resume download at %zu", rest_offset);
+            char offset_str [24];
+            snprintf(offset_str, sizeof(offset_str), "%zu", rest_offset);
+            send_cmd("REST", offset_str); //continue with RETR after 350
+        } else if (method == Method::Retrieve) {
+            MO_DBG_DEBUG("request download for %s", fname.c_str());
+            send_cmd("RETR", fname.c_str());
+        } else if (method == Method::Store) {
+            MO_DBG_DEBUG("request upload for %s", fname.c_str());
+            send_cmd("STOR", fname.c_str());
         } else {
-            MO_DBG_WARN("unkown commad (close connection): %s", line);
+            MO_DBG_ERR("internal error");
             send_cmd("QUIT");
             return;
         }
+
+    } else if (!strncmp("350", line, 3) && method == Method::Retrieve) { // Restarting at offset. Send RETR now
+        MO_DBG_DEBUG("request download for %s from %zu", fname.c_str(), rest_offset);
+        send_cmd("RETR", fname.c_str());
+    } else if (!strncmp("150", line, 3)    // File status okay; about to open data connection
+            || !strncmp("125", line, 3)) { // Data connection already open
+        MO_DBG_DEBUG("data connection accepted");
+        data_conn_accepted = true;
+        transfer_started = true;
+    } else if (!strncmp("226", line, 3)) { // Closing data connection. Requested file action successful (for example, file transfer or file abort)
+        MO_DBG_INFO("FTP success: %s", line);
+        send_cmd("QUIT");
+        return;
+    } else if (!strncmp("55", line, 2)) { // Requested action not taken / aborted
+        MO_DBG_WARN("FTP failure: %s", line);
+        send_cmd("QUIT");
+        return;
+    } else if (!strncmp("200", line, 3)) { //PBSZ -> 0 and PROT -> P accepted
+        MO_DBG_INFO("PBSZ/PROT success: %s", line);
+    } else if (!strncmp("221", line, 3)) { // Server Goodbye
+        MO_DBG_DEBUG("closing ctrl connection");
+        close_ctrl();
+        return;
+    } else {
+        MO_DBG_WARN("unkown commad (close connection): %s", line);
+        send_cmd("QUIT");
+        return;
     }
 }
 
-void FtpTransferMbedTLS::process_data() {
+bool FtpTransferMbedTLS::process_data() {
     if (!data_conn_accepted) {
-        return;
+        return false;
     }
 
     if (isSecure && !data_ssl_established) {
@@ -671,7 +770,7 @@ void FtpTransferMbedTLS::process_data() {
         MO_DBG_ERR("internal error");
         close_data(MO_FtpCloseReason_Failure);
         send_cmd("QUIT", nullptr, true);
-        return;
+        return false;
     }
 
     if (method == Method::Retrieve) {
@@ -690,16 +789,17 @@ void FtpTransferMbedTLS::process_data() {
 
             if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
                 //no new input data to be processed
-                return;
+                return false;
             } else if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY || ret == 0) {
-                //download finished
-                close_data(MO_FtpCloseReason_Success);
-                return;
+                //server closed the data connection. The reply on the ctrl connection tells if the file is complete
+                MO_DBG_DEBUG("data connection closed by server");
+                complete_data();
+                return false;
             } else if (ret < 0) {
                 MO_DBG_ERR("mbedtls_net_recv: %i", ret);
                 close_data(MO_FtpCloseReason_Failure);
                 send_cmd("QUIT");
-                return;
+                return false;
             }
 
             data_buf_avail = ret;
@@ -711,7 +811,7 @@ void FtpTransferMbedTLS::process_data() {
             MO_DBG_ERR("fileWriter aborted download");
             close_data(MO_FtpCloseReason_Failure);
             send_cmd("QUIT");
-            return;
+            return false;
         } else if (ret <= data_buf_avail) {
             data_buf_avail -= ret;
             data_buf_offs += ret;
@@ -719,10 +819,11 @@ void FtpTransferMbedTLS::process_data() {
             MO_DBG_ERR("write error");
             close_data(MO_FtpCloseReason_Failure);
             send_cmd("QUIT");
-            return;
+            return false;
         }
 
         //success
+        return true;
     } else if (method == Method::Store) {
 
         if (data_buf_avail == 0) {
@@ -744,33 +845,49 @@ void FtpTransferMbedTLS::process_data() {
 
             if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
                 //no data sent, wait
-                return;
+                return false;
             } else if (ret <= 0) {
                 MO_DBG_ERR("mbedtls_ssl_write: %i", ret);
                 close_data(MO_FtpCloseReason_Failure);
                 send_cmd("QUIT");
-                return;
+                return false;
             }
 
             //successful write
             data_buf_avail -= ret;
             data_buf_offs += ret;
+            return true;
         } else {
             //no data in fileReader anymore
             MO_DBG_DEBUG("finished file reading");
-            close_data(MO_FtpCloseReason_Success);
+            complete_data(); //success when the server confirms the upload
         }
     }
+
+    return false;
 }
 
 void FtpTransferMbedTLS::loop() {
 
-    if (ctrl_opened) {
-        process_ctrl();
-    }
+    //drain the sockets until no more data is ready or the time budget is used up. Without this, the throughput
+    //would be limited to one chunk per loop() call
+    auto t_start = mocpp_tick_ms();
+
+    bool progress = true;
+    while (progress) {
+        progress = false;
+
+        if (ctrl_opened && process_ctrl()) {
+            progress = true;
+        }
+
+        if (data_opened && process_data()) {
+            progress = true;
+        }
 
-    if (data_opened) {
-        process_data();
+        if (mocpp_tick_ms() - t_start >= MO_FTP_LOOP_BUDGET_MS) {
+            break;
+        }
     }
 }
 
@@ -920,6 +1037,23 @@ std::unique_ptr<FtpDownload> FtpClientMbedTLS::getFile(const char *ftp_url_raw,
     }
 }
 
+std::unique_ptr<FtpDownload> FtpClientMbedTLS::getFileFromOffset(const char *ftp_url_raw, size_t offset, std::function<size_t(unsigned char *data, size_t len)> fileWriter, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert) {
+
+    auto ftp_handle = std::unique_ptr<FtpTransferMbedTLS>(new FtpTransferMbedTLS(tls_only, client_cert, client_key));
+    if (!ftp_handle) {
+        MO_DBG_ERR("OOM");
+        return nullptr;
+    }
+
+    bool success = ftp_handle->getFile(ftp_url_raw, fileWriter, onClose, ca_cert, offset);
+
+    if (success) {
+        return ftp_handle;
+    } else {
+        return nullptr;
+    }
+}
+
 std::unique_ptr<FtpUpload> FtpClientMbedTLS::postFile(const char *ftp_url_raw, std::function<size_t(unsigned char *out, size_t buffsize)> fileReader, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert) {
     
     auto ftp_handle = std::unique_ptr<FtpTransferMbedTLS>(new FtpTransferMbedTLS(tls_only, client_cert, client_key));
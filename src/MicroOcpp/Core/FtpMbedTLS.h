@@ -25,6 +25,18 @@
 
 #if MO_ENABLE_MBEDTLS
 
+#ifndef MO_FTP_DATA_BUFSIZE
+#define MO_FTP_DATA_BUFSIZE 4096 //chunk size of the data connection, i.e. max. size of one fileWriter / fileReader call
+#endif
+
+#ifndef MO_FTP_CTRL_BUFSIZE
+#define MO_FTP_CTRL_BUFSIZE 256 //receive buffer of the control connection. Must hold at least one server reply line
+#endif
+
+#ifndef MO_FTP_LOOP_BUDGET_MS
+#define MO_FTP_LOOP_BUDGET_MS 20 //max. time per loop() call to drain the sockets. 0 processes one chunk per loop() call
+#endif
+
 #include <memory>
 
 #include <MicroOcpp/Core/Ftp.h>
@@ -0,0 +1,1210 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/HttpMbedTLS.h>
+
+#if MO_ENABLE_MBEDTLS
+
+#include <string>
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <functional>
+#include <algorithm>
+
+#include "mbedtls/net_sockets.h"
+#include "mbedtls/ssl.h"
+#include "mbedtls/entropy.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/x509.h"
+#include "mbedtls/error.h"
+#include "mbedtls/base64.h"
+
+#include <MicroOcpp/Version.h>
+#include <MicroOcpp/Debug.h>
+
+namespace MicroOcpp {
+
+/*
+ * Socket and TLS context of one HTTP connection. The connection is owned by a transfer and returned to the
+ * HttpSessionCache after a completed keep-alive request
+ */
+class HttpConnectionMbedTLS {
+private:
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt cacert;
+    mbedtls_x509_crt clicert;
+    mbedtls_pk_context pkey;
+    mbedtls_net_context fd;
+    mbedtls_ssl_context ssl;
+
+    int setup_tls(const char *client_cert, const char *client_key);
+public:
+    std::string host;
+    std::string port;
+    bool isSecure = false;
+    const char *ca_cert = nullptr;
+    bool handshakeDone = false;
+
+    HttpConnectionMbedTLS();
+    ~HttpConnectionMbedTLS();
+
+    int open(const char *host, const char *port, bool isSecure, const char *ca_cert, const char *client_cert, const char *client_key, const mbedtls_ssl_session *session);
+    int handshake(); //one handshake step. Returns MBEDTLS_ERR_SSL_WANT_READ / _WRITE until the handshake is complete
+    int send(const unsigned char *buf, size_t len);
+    int recv(unsigned char *buf, size_t len);
+
+    bool matches(const std::string& host, const std::string& port, bool isSecure, const char *ca_cert);
+    bool storeSession(mbedtls_ssl_session *session);
+};
+
+/*
+ * Shared between the HTTP client and its transfers, so that a transfer may outlive the client
+ */
+struct HttpSessionCache {
+    std::unique_ptr<HttpConnectionMbedTLS> idle; //keep-alive connection of the last transfer
+
+    //TLS session of the last handshake
+    std::string sessionHost;
+    std::string sessionPort;
+    mbedtls_ssl_session session;
+    bool sessionValid = false;
+
+    HttpSessionCache() {
+        mbedtls_ssl_session_init(&session);
+    }
+
+    ~HttpSessionCache() {
+        mbedtls_ssl_session_free(&session);
+    }
+};
+
+class HttpTransferMbedTLS : public FtpUpload, public FtpDownload {
+private:
+    std::shared_ptr<HttpSessionCache> cache;
+    const char *client_cert = nullptr;
+    const char *client_key = nullptr;
+    const char *ca_cert = nullptr;
+
+    std::unique_ptr<HttpConnectionMbedTLS> conn;
+    bool connReused = false; //keep-alive connection from the cache. May have been closed by the server meanwhile
+
+    //URL
+    bool isSecure = false;
+    std::string host;
+    std::string port;
+    std::string path;
+    std::string auth; //Base64 of user:pass, or empty
+
+    bool read_url(const char *url);
+
+    std::function<size_t(unsigned char *data, size_t len)> fileWriter;
+    std::function<size_t(unsigned char *out, size_t bufsize)> fileReader;
+    std::function<void(MO_FtpCloseReason)> onClose;
+
+    enum class Method {
+        Get,   //download file
+        Post,  //upload file
+        UNDEFINED
+    };
+    Method method = Method::UNDEFINED;
+
+    enum class State {
+        Handshake,
+        SendRequest,
+        SendBody,
+        RecvHeaders,
+        RecvBody,
+        Closed
+    };
+    State state = State::Closed;
+
+    size_t offset = 0; //resume download at this byte offset
+    unsigned int redirects = 0;
+
+    unsigned char *buf = nullptr;
+    size_t buf_len = 0; //valid bytes in buf
+    size_t buf_offs = 0; //processed bytes in buf
+    bool bodySent = false; //upload: last chunk is in buf
+
+    //response
+    int status = 0;
+    bool keepAlive = true;
+    bool chunked = false;
+    bool hasContentLength = false;
+    size_t contentLength = 0;
+    size_t bodyReceived = 0;
+    size_t skip = 0; //bytes to drop because the server ignored the Range header
+    bool responseBegun = false;
+    std::string redirectUrl;
+
+    enum class ChunkState {
+        Size,
+        Data,
+        DataEnd,
+        Trailer
+    };
+    ChunkState chunkState = ChunkState::Size;
+    size_t chunkRemaining = 0;
+
+    bool openConnection();
+    bool beginRequest();
+    void resetResponse();
+
+    bool process(); //returns true if progress has been made, i.e. more data may be ready
+    bool processSend();
+    bool processRecvHeaders();
+    bool processRecvBody();
+    void processHeaderLine(char *line);
+    bool completeHeaders();
+
+    bool readSocket(); //appends to buf
+    char *takeLine(); //returns next complete line in buf or nullptr
+    size_t deliver(unsigned char *data, size_t len); //passes body data to the fileWriter. Returns the consumed bytes, 0 on error
+
+    void connFailure(const char *msg, int ret);
+    void finish(MO_FtpCloseReason reason);
+
+public:
+    HttpTransferMbedTLS(std::shared_ptr<HttpSessionCache> cache, const char *client_cert, const char *client_key);
+    ~HttpTransferMbedTLS();
+
+    void loop() override;
+
+    bool isActive() override;
+
+    bool getFile(const char *url, // http[s]://[user[:pass]@]host[:port][/path]
+            std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+            std::function<void(MO_FtpCloseReason)> onClose,
+            const char *ca_cert = nullptr, // nullptr to disable cert check; will be ignored for non-TLS connections
+            size_t offset = 0); //resume download at offset
+
+    bool postFile(const char *url, // http[s]://[user[:pass]@]host[:port][/path]
+            std::function<size_t(unsigned char *out, size_t buffsize)> fileReader, //write at most buffsize bytes into out-buffer. Return number of bytes written
+            std::function<void(MO_FtpCloseReason)> onClose,
+            const char *ca_cert = nullptr); // nullptr to disable cert check; will be ignored for non-TLS connections
+};
+
+class HttpClientMbedTLS : public FtpClient {
+private:
+    std::shared_ptr<HttpSessionCache> cache;
+    const char *client_cert = nullptr;
+    const char *client_key = nullptr;
+public:
+
+    HttpClientMbedTLS(const char *client_cert = nullptr, const char *client_key = nullptr);
+
+    std::unique_ptr<FtpDownload> getFile(const char *url,
+            std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+            std::function<void(MO_FtpCloseReason)> onClose,
+            const char *ca_cert = nullptr) override;
+
+    std::unique_ptr<FtpDownload> getFileFromOffset(const char *url,
+            size_t offset,
+            std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+            std::function<void(MO_FtpCloseReason)> onClose,
+            const char *ca_cert = nullptr) override;
+
+    std::unique_ptr<FtpUpload> postFile(const char *url,
+            std::function<size_t(unsigned char *out, size_t buffsize)> fileReader,
+            std::function<void(MO_FtpCloseReason)> onClose,
+            const char *ca_cert = nullptr) override;
+};
+
+std::unique_ptr<FtpClient> makeHttpClientMbedTLS(const char *client_cert, const char *client_key) {
+    return std::unique_ptr<FtpClient>(new HttpClientMbedTLS(client_cert, client_key));
+}
+
+void mo_mbedtls_log(void *user, int level, const char *file, int line, const char *str); //defined in FtpMbedTLS.cpp
+
+/*
+ * HTTP connection
+ */
+
+HttpConnectionMbedTLS::HttpConnectionMbedTLS() {
+    mbedtls_net_init(&fd);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_x509_crt_init(&cacert);
+    mbedtls_x509_crt_init(&clicert);
+    mbedtls_pk_init(&pkey);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+    mbedtls_entropy_init(&entropy);
+}
+
+HttpConnectionMbedTLS::~HttpConnectionMbedTLS() {
+    if (handshakeDone) {
+        mbedtls_ssl_close_notify(&ssl);
+    }
+    mbedtls_net_free(&fd);
+    mbedtls_ssl_free(&ssl);
+    mbedtls_x509_crt_free(&clicert);
+    mbedtls_x509_crt_free(&cacert);
+    mbedtls_pk_free(&pkey);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+}
+
+int HttpConnectionMbedTLS::setup_tls(const char *client_cert, const char *client_key) {
+
+    int ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
+                                     (const unsigned char*) __FILE__,
+                                     strlen(__FILE__));
+    if (ret != 0) {
+        MO_DBG_ERR("mbedtls_ctr_drbg_seed: %i", ret);
+        return ret;
+    }
+
+    if (ca_cert) {
+        ret = mbedtls_x509_crt_parse(&cacert, (const unsigned char *) ca_cert,
+                                    strlen(ca_cert) + 1);
+        if (ret < 0) {
+            MO_DBG_ERR("mbedtls_x509_crt_parse(ca_cert): %i", ret);
+            return ret;
+        }
+    }
+
+    if (client_cert) {
+        ret = mbedtls_x509_crt_parse(&clicert, (const unsigned char *) client_cert,
+                                    strlen(client_cert) + 1);
+        if (ret != 0) {
+            MO_DBG_ERR("mbedtls_x509_crt_parse(client_cert): %i", ret);
+            return ret;
+        }
+    }
+
+    if (client_key) {
+        ret = mbedtls_pk_parse_key(&pkey,
+                                    (const unsigned char *) client_key,
+                                    strlen(client_key) + 1,
+                                    NULL,
+                                    0);
+        if (ret != 0) {
+            MO_DBG_ERR("mbedtls_pk_parse_key: %i", ret);
+            return ret;
+        }
+    }
+
+    ret = mbedtls_ssl_config_defaults(&conf,
+                                           MBEDTLS_SSL_IS_CLIENT,
+                                           MBEDTLS_SSL_TRANSPORT_STREAM,
+                                           MBEDTLS_SSL_PRESET_DEFAULT);
+    if (ret != 0) {
+        MO_DBG_ERR("mbedtls_ssl_config_defaults: %i", ret);
+        return ret;
+    }
+
+    mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_OPTIONAL); //certificate check result manually handled after handshake
+
+    mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+    mbedtls_ssl_conf_dbg(&conf, mo_mbedtls_log, NULL);
+
+    if (ca_cert) {
+        mbedtls_ssl_conf_ca_chain(&conf, &cacert, NULL);
+    }
+
+    if (client_cert || client_key) {
+        ret = mbedtls_ssl_conf_own_cert(&conf, &clicert, &pkey);
+        if (ret != 0) {
+            MO_DBG_ERR("mbedtls_ssl_conf_own_cert: %i", ret);
+            return ret;
+        }
+    }
+
+    return 0; //success
+}
+
+int HttpConnectionMbedTLS::open(const char *host, const char *port, bool isSecure, const char *ca_cert, const char *client_cert, const char *client_key, const mbedtls_ssl_session *session) {
+
+    this->host = host;
+    this->port = port;
+    this->isSecure = isSecure;
+    this->ca_cert = ca_cert;
+
+    int ret = mbedtls_net_connect(&fd, host, port, MBEDTLS_NET_PROTO_TCP);
+    if (ret != 0) {
+        MO_DBG_ERR("mbedtls_net_connect: %i", ret);
+        return ret;
+    }
+
+    ret = mbedtls_net_set_nonblock(&fd);
+    if (ret != 0) {
+        MO_DBG_ERR("mbedtls_net_set_nonblock: %i", ret);
+        return ret;
+    }
+
+    if (!isSecure) {
+        return 0; //success
+    }
+
+    ret = setup_tls(client_cert, client_key);
+    if (ret != 0) {
+        MO_DBG_ERR("could not setup MbedTLS: %i", ret);
+        return ret;
+    }
+
+    ret = mbedtls_ssl_setup(&ssl, &conf);
+    if (ret != 0) {
+        MO_DBG_ERR("mbedtls_ssl_setup: %i", ret);
+        return ret;
+    }
+
+    ret = mbedtls_ssl_set_hostname(&ssl, host);
+    if (ret != 0) {
+        MO_DBG_ERR("mbedtls_ssl_set_hostname: %i", ret);
+        return ret;
+    }
+
+    mbedtls_ssl_set_bio(&ssl, &fd, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    if (session) {
+        //resume TLS session of the last connection to this host. If the server refuses, MbedTLS falls back to a full handshake
+        ret = mbedtls_ssl_set_session(&ssl, session);
+        if (ret != 0) {
+            MO_DBG_WARN("session reuse failure: %i", ret);
+        }
+    }
+
+    return 0; //success
+}
+
+int HttpConnectionMbedTLS::handshake() {
+
+    int ret = mbedtls_ssl_handshake(&ssl);
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        return ret;
+    } else if (ret != 0) {
+        char buf [1024];
+        mbedtls_strerror(ret, (char *) buf, 1024);
+        MO_DBG_ERR("mbedtls_ssl_handshake: %i, %s", ret, buf);
+        return ret;
+    }
+
+    if (ca_cert) {
+        //certificate validation enabled
+
+        if ((ret = mbedtls_ssl_get_verify_result(&ssl)) != 0) {
+            char vrfy_buf[512];
+            mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "   > ", ret);
+            MO_DBG_ERR("mbedtls_ssl_get_verify_result: %i, %s", ret, vrfy_buf);
+            return ret;
+        }
+    }
+
+    handshakeDone = true;
+
+    return 0; //success
+}
+
+int HttpConnectionMbedTLS::send(const unsigned char *buf, size_t len) {
+    if (isSecure) {
+        return mbedtls_ssl_write(&ssl, buf, len);
+    } else {
+        return mbedtls_net_send(&fd, buf, len);
+    }
+}
+
+int HttpConnectionMbedTLS::recv(unsigned char *buf, size_t len) {
+    if (isSecure) {
+        return mbedtls_ssl_read(&ssl, buf, len);
+    } else {
+        return mbedtls_net_recv(&fd, buf, len);
+    }
+}
+
+bool HttpConnectionMbedTLS::matches(const std::string& host, const std::string& port, bool isSecure, const char *ca_cert) {
+    return this->host == host && this->port == port && this->isSecure == isSecure && this->ca_cert == ca_cert;
+}
+
+bool HttpConnectionMbedTLS::storeSession(mbedtls_ssl_session *session) {
+    if (!isSecure || !handshakeDone) {
+        return false;
+    }
+
+    mbedtls_ssl_session_free(session);
+    mbedtls_ssl_session_init(session);
+
+    if (auto ret = mbedtls_ssl_get_session(&ssl, session)) {
+        MO_DBG_WARN("mbedtls_ssl_get_session: %i", ret);
+        return false;
+    }
+
+    return true;
+}
+
+/*
+ * HTTP transfer
+ */
+
+HttpTransferMbedTLS::HttpTransferMbedTLS(std::shared_ptr<HttpSessionCache> cache, const char *client_cert, const char *client_key)
+        : cache(cache), client_cert(client_cert), client_key(client_key) {
+
+}
+
+HttpTransferMbedTLS::~HttpTransferMbedTLS() {
+    if (onClose) {
+        onClose(MO_FtpCloseReason_Failure); //transfer not completed
+        onClose = nullptr;
+    }
+    delete[] buf;
+}
+
+bool HttpTransferMbedTLS::getFile(const char *url, std::function<size_t(unsigned char *data, size_t len)> fileWriter, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert, size_t offset) {
+
+    if (method != Method::UNDEFINED) {
+        MO_DBG_ERR("HTTP transfer reuse not supported");
+        return false;
+    }
+
+    if (!url || !fileWriter) {
+        MO_DBG_ERR("invalid args");
+        return false;
+    }
+
+    this->ca_cert = ca_cert;
+    this->method = Method::Get;
+    this->fileWriter = fileWriter;
+    this->onClose = onClose;
+    this->offset = offset;
+
+    if (!read_url(url)) {
+        MO_DBG_ERR("could not parse URL");
+        return false;
+    }
+
+    MO_DBG_DEBUG("init download from %s: %s", host.c_str(), path.c_str());
+
+    return openConnection() && beginRequest();
+}
+
+bool HttpTransferMbedTLS::postFile(const char *url, std::function<size_t(unsigned char *out, size_t buffsize)> fileReader, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert) {
+
+    if (method != Method::UNDEFINED) {
+        MO_DBG_ERR("HTTP transfer reuse not supported");
+        return false;
+    }
+
+    if (!url || !fileReader) {
+        MO_DBG_ERR("invalid args");
+        return false;
+    }
+
+    this->ca_cert = ca_cert;
+    this->method = Method::Post;
+    this->fileReader = fileReader;
+    this->onClose = onClose;
+
+    if (!read_url(url)) {
+        MO_DBG_ERR("could not parse URL");
+        return false;
+    }
+
+    MO_DBG_DEBUG("init upload to %s: %s", host.c_str(), path.c_str());
+
+    return openConnection() && beginRequest();
+}
+
+bool HttpTransferMbedTLS::openConnection() {
+
+    if (!buf) {
+        buf = new unsigned char[MO_HTTP_BUFSIZE];
+        if (!buf) {
+            MO_DBG_ERR("OOM");
+            return false;
+        }
+    }
+
+    if (cache->idle && cache->idle->matches(host, port, isSecure, ca_cert)) {
+        MO_DBG_DEBUG("reuse connection to %s", host.c_str());
+        conn = std::move(cache->idle);
+        connReused = true;
+        state = State::SendRequest;
+        return true;
+    }
+
+    cache->idle.reset(); //only keep one idle connection
+
+    conn = std::unique_ptr<HttpConnectionMbedTLS>(new HttpConnectionMbedTLS());
+    if (!conn) {
+        MO_DBG_ERR("OOM");
+        return false;
+    }
+    connReused = false;
+
+    const mbedtls_ssl_session *session = nullptr;
+    if (isSecure && cache->sessionValid && cache->sessionHost == host && cache->sessionPort == port) {
+        session = &cache->session;
+    }
+
+    if (auto ret = conn->open(host.c_str(), port.c_str(), isSecure, ca_cert, client_cert, client_key, session)) {
+        MO_DBG_ERR("could not establish connection to HTTP server: %i", ret);
+        conn.reset();
+        return false;
+    }
+
+    state = isSecure ? State::Handshake : State::SendRequest;
+    return true;
+}
+
+bool HttpTransferMbedTLS::beginRequest() {
+
+    const char *hostPort = host.c_str();
+    std::string hostPortBuf;
+    if (port != (isSecure ? "443" : "80")) {
+        hostPortBuf = host + ":" + port;
+        hostPort = hostPortBuf.c_str();
+    }
+
+    char range [48] = {'\0'};
+    if (method == Method::Get && offset > 0) {
+        snprintf(range, sizeof(range), "Range: bytes=%zu-\r\n", offset);
+    }
+
+    auto ret = snprintf((char*) buf, MO_HTTP_BUFSIZE,
+            "%s %s HTTP/1.1\r\n"
+            "Host: %s\r\n"
+            "User-Agent: MicroOcpp/%s\r\n"
+            "Connection: keep-alive\r\n"
+            "%s%s%s"
+            "%s"
+            "%s"
+            "\r\n",
+            method == Method::Post ? "POST" : "GET", path.c_str(),
+            hostPort,
+            MO_VERSION,
+            auth.empty() ? "" : "Authorization: Basic ", auth.c_str(), auth.empty() ? "" : "\r\n",
+            range,
+            method == Method::Post ? "Content-Type: application/octet-stream\r\nTransfer-Encoding: chunked\r\n" : "");
+
+    if (ret < 0 || (size_t)ret >= MO_HTTP_BUFSIZE) {
+        MO_DBG_ERR("request header exceeds MO_HTTP_BUFSIZE");
+        return false;
+    }
+
+    buf_len = (size_t)ret;
+    buf_offs = 0;
+    bodySent = false;
+    resetResponse();
+
+    return true;
+}
+
+void HttpTransferMbedTLS::resetResponse() {
+    status = 0;
+    keepAlive = true;
+    chunked = false;
+    hasContentLength = false;
+    contentLength = 0;
+    bodyReceived = 0;
+    skip = 0;
+    responseBegun = false;
+    redirectUrl.clear();
+    chunkState = ChunkState::Size;
+    chunkRemaining = 0;
+}
+
+void HttpTransferMbedTLS::connFailure(const char *msg, int ret) {
+
+    if (connReused && !responseBegun &&
+            (state == State::SendRequest || (state == State::RecvHeaders && method == Method::Get))) {
+        //the server has closed the keep-alive connection meanwhile. Repeat the request on a new connection
+        MO_DBG_DEBUG("keep-alive connection closed by server, reconnect");
+        conn.reset();
+        if (openConnection() && beginRequest()) {
+            return;
+        }
+        finish(MO_FtpCloseReason_Failure);
+        return;
+    }
+
+    char errbuf [128];
+    mbedtls_strerror(ret, errbuf, sizeof(errbuf));
+    MO_DBG_ERR("%s: %i, %s", msg, ret, errbuf);
+    keepAlive = false;
+    finish(MO_FtpCloseReason_Failure);
+}
+
+void HttpTransferMbedTLS::finish(MO_FtpCloseReason reason) {
+
+    if (conn) {
+        if (conn->storeSession(&cache->session)) {
+            cache->sessionHost = host;
+            cache->sessionPort = port;
+            cache->sessionValid = true;
+        }
+
+        if (reason == MO_FtpCloseReason_Success && keepAlive && buf_offs >= buf_len) {
+            cache->idle = std::move(conn);
+        } else {
+            conn.reset();
+        }
+    }
+
+    state = State::Closed;
+
+    if (onClose) {
+        auto onCloseCb = onClose;
+        onClose = nullptr;
+        onCloseCb(reason);
+    }
+}
+
+bool HttpTransferMbedTLS::processSend() {
+
+    if (state == State::SendBody && buf_offs >= buf_len) {
+        if (bodySent) {
+            state = State::RecvHeaders;
+            buf_len = 0;
+            buf_offs = 0;
+            return true;
+        }
+
+        //load next chunk. Layout: 8 hex digits size, CRLF, data, CRLF
+        const size_t headLen = 10;
+        size_t len = fileReader(buf + headLen, MO_HTTP_BUFSIZE - headLen - 2);
+        if (len > MO_HTTP_BUFSIZE - headLen - 2) {
+            MO_DBG_ERR("read error");
+            keepAlive = false;
+            finish(MO_FtpCloseReason_Failure);
+            return false;
+        }
+
+        if (len == 0) {
+            MO_DBG_DEBUG("finished file reading");
+            memcpy(buf, "0\r\n\r\n", 5);
+            buf_len = 5;
+            bodySent = true;
+        } else {
+            char head [headLen + 1];
+            snprintf(head, sizeof(head), "%08zx\r\n", len);
+            memcpy(buf, head, headLen);
+            memcpy(buf + headLen + len, "\r\n", 2);
+            buf_len = headLen + len + 2;
+        }
+        buf_offs = 0;
+    }
+
+    int ret = conn->send(buf + buf_offs, buf_len - buf_offs);
+
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        //socket not ready, wait
+        return false;
+    } else if (ret <= 0) {
+        connFailure("send", ret);
+        return false;
+    }
+
+    buf_offs += (size_t)ret;
+
+    if (state == State::SendRequest && buf_offs >= buf_len) {
+        //request header sent
+        if (method == Method::Post) {
+            state = State::SendBody;
+        } else {
+            state = State::RecvHeaders;
+            buf_len = 0;
+            buf_offs = 0;
+        }
+    }
+
+    return true;
+}
+
+bool HttpTransferMbedTLS::readSocket() {
+
+    if (buf_offs > 0) {
+        //move unprocessed data to the front
+        memmove(buf, buf + buf_offs, buf_len - buf_offs);
+        buf_len -= buf_offs;
+        buf_offs = 0;
+    }
+
+    if (buf_len >= MO_HTTP_BUFSIZE - 1) {
+        MO_DBG_ERR("header line exceeds MO_HTTP_BUFSIZE");
+        keepAlive = false;
+        finish(MO_FtpCloseReason_Failure);
+        return false;
+    }
+
+    int ret = conn->recv(buf + buf_len, MO_HTTP_BUFSIZE - 1 - buf_len);
+
+    if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+        //no new input data to be processed
+        return false;
+    } else if (ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY || ret == 0) {
+        if (state == State::RecvBody && !chunked && !hasContentLength) {
+            //body delimited by connection close
+            keepAlive = false;
+            finish(MO_FtpCloseReason_Success);
+            return false;
+        }
+        if (state == State::RecvBody && !chunked && hasContentLength && bodyReceived < contentLength) {
+            MO_DBG_ERR("connection closed before end of body (%zuB of %zuB)", bodyReceived, contentLength);
+            keepAlive = false;
+            finish(MO_FtpCloseReason_Failure);
+            return false;
+        }
+        connFailure("connection closed by server", ret);
+        return false;
+    } else if (ret < 0) {
+        connFailure("recv", ret);
+        return false;
+    }
+
+    buf_len += (size_t)ret;
+    responseBegun = true;
+    return true;
+}
+
+char *HttpTransferMbedTLS::takeLine() {
+    for (size_t i = buf_offs; i < buf_len; i++) {
+        if (buf[i] == '\n') {
+            char *line = (char*) buf + buf_offs;
+            buf[i] = '\0';
+            if (i > buf_offs && buf[i - 1] == '\r') {
+                buf[i - 1] = '\0';
+            }
+            buf_offs = i + 1;
+            return line;
+        }
+    }
+    return nullptr;
+}
+
+void HttpTransferMbedTLS::processHeaderLine(char *line) {
+
+    if (status == 0) {
+        //status line
+        unsigned int major = 0, minor = 0;
+        int code = 0;
+        if (sscanf(line, "HTTP/%u.%u %i", &major, &minor, &code) != 3) {
+            MO_DBG_ERR("invalid status line: %s", line);
+            status = -1;
+            return;
+        }
+        MO_DBG_DEBUG("RECV: %s", line);
+        status = code;
+        keepAlive = major > 1 || (major == 1 && minor >= 1); //HTTP/1.0 closes by default
+        return;
+    }
+
+    char *value = strchr(line, ':');
+    if (!value) {
+        return; //ignore malformed header
+    }
+    *value = '\0';
+    value++;
+    while (*value == ' ' || *value == '\t') {
+        value++;
+    }
+
+    //header names are case-insensitive
+    for (char *c = line; *c; c++) {
+        *c = tolower(*c);
+    }
+
+    if (!strcmp(line, "content-length")) {
+        contentLength = (size_t) strtoul(value, nullptr, 10);
+        hasContentLength = true;
+    } else if (!strcmp(line, "transfer-encoding")) {
+        for (char *c = value; *c; c++) {
+            *c = tolower(*c);
+        }
+        chunked = strstr(value, "chunked") != nullptr;
+    } else if (!strcmp(line, "connection")) {
+        for (char *c = value; *c; c++) {
+            *c = tolower(*c);
+        }
+        if (strstr(value, "close")) {
+            keepAlive = false;
+        } else if (strstr(value, "keep-alive")) {
+            keepAlive = true;
+        }
+    } else if (!strcmp(line, "location")) {
+        redirectUrl = value;
+    }
+}
+
+bool HttpTransferMbedTLS::completeHeaders() {
+
+    if (status >= 100 && status < 200) {
+        //informational response (e.g. 100 Continue). The final response follows
+        resetResponse();
+        responseBegun = true;
+        return true;
+    }
+
+    if ((status == 301 || status == 302 || status == 303 || status == 307 || status == 308) &&
+            method == Method::Get && !redirectUrl.empty()) {
+
+        if (redirects >= MO_HTTP_MAX_REDIRECTS) {
+            MO_DBG_ERR("too many redirects");
+            keepAlive = false;
+            finish(MO_FtpCloseReason_Failure);
+            return false;
+        }
+        redirects++;
+
+        MO_DBG_DEBUG("redirect to %s", redirectUrl.c_str());
+
+        std::string location = std::move(redirectUrl);
+        bool wasSecure = isSecure;
+        if (!location.empty() && location[0] == '/') {
+            //relative to the current host
+            path = location;
+        } else if (!read_url(location.c_str())) {
+            MO_DBG_ERR("could not parse redirect URL");
+            keepAlive = false;
+            finish(MO_FtpCloseReason_Failure);
+            return false;
+        }
+
+        if (wasSecure && !isSecure) {
+            MO_DBG_ERR("redirect from https to http rejected");
+            keepAlive = false;
+            finish(MO_FtpCloseReason_Failure);
+            return false;
+        }
+
+        //the body of the redirect response isn't needed. Open a new connection instead of draining it
+        conn.reset();
+        if (!openConnection() || !beginRequest()) {
+            finish(MO_FtpCloseReason_Failure);
+            return false;
+        }
+        return true;
+    }
+
+    bool accepted = false;
+    if (method == Method::Get) {
+        if (status == 206 && offset > 0) {
+            accepted = true;
+        } else if (status == 200) {
+            skip = offset; //server ignored Range. Drop the bytes which have already been received
+            accepted = true;
+        }
+    } else if (method == Method::Post) {
+        accepted = status >= 200 && status < 300;
+    }
+
+    if (!accepted) {
+        MO_DBG_WARN("HTTP failure: %i", status);
+        keepAlive = false;
+        finish(MO_FtpCloseReason_Failure);
+        return false;
+    }
+
+    if (status == 204 || status == 304) {
+        hasContentLength = true;
+        contentLength = 0;
+    }
+
+    state = State::RecvBody;
+
+    if (!chunked && hasContentLength && contentLength == 0) {
+        finish(MO_FtpCloseReason_Success);
+        return false;
+    }
+
+    return true;
+}
+
+bool HttpTransferMbedTLS::processRecvHeaders() {
+
+    while (char *line = takeLine()) {
+        if (*line != '\0') {
+            processHeaderLine(line);
+            if (status < 0) {
+                keepAlive = false;
+                finish(MO_FtpCloseReason_Failure);
+                return false;
+            }
+            continue;
+        }
+
+        //empty line: end of header
+        if (status == 0) {
+            continue; //tolerate leading empty lines
+        }
+
+        return completeHeaders();
+    }
+
+    return readSocket();
+}
+
+size_t HttpTransferMbedTLS::deliver(unsigned char *data, size_t len) {
+
+    if (skip > 0) {
+        size_t dropLen = std::min(skip, len);
+        skip -= dropLen;
+        return dropLen;
+    }
+
+    if (method != Method::Get) {
+        return len; //discard response body of upload
+    }
+
+    size_t ret = fileWriter(data, len);
+    if (ret == 0) {
+        MO_DBG_ERR("fileWriter aborted download");
+        keepAlive = false;
+        finish(MO_FtpCloseReason_Failure);
+        return 0;
+    } else if (ret > len) {
+        MO_DBG_ERR("write error");
+        keepAlive = false;
+        finish(MO_FtpCloseReason_Failure);
+        return 0;
+    }
+
+    return ret;
+}
+
+bool HttpTransferMbedTLS::processRecvBody() {
+
+    if (!chunked) {
+        if (buf_offs >= buf_len) {
+            return readSocket();
+        }
+
+        size_t len = buf_len - buf_offs;
+        if (hasContentLength) {
+            len = std::min(len, contentLength - bodyReceived);
+        }
+
+        size_t ret = deliver(buf + buf_offs, len);
+        if (ret == 0) {
+            return false;
+        }
+        buf_offs += ret;
+        bodyReceived += ret;
+
+        if (hasContentLength && bodyReceived >= contentLength) {
+            MO_DBG_DEBUG("HTTP transfer complete (%zuB)", bodyReceived);
+            finish(MO_FtpCloseReason_Success);
+            return false;
+        }
+        return true;
+    }
+
+    //chunked transfer encoding
+    switch (chunkState) {
+        case ChunkState::Size: {
+            char *line = takeLine();
+            if (!line) {
+                return readSocket();
+            }
+            chunkRemaining = (size_t) strtoul(line, nullptr, 16); //ignores chunk extensions
+            chunkState = chunkRemaining > 0 ? ChunkState::Data : ChunkState::Trailer;
+            return true;
+        }
+        case ChunkState::Data: {
+            if (buf_offs >= buf_len) {
+                return readSocket();
+            }
+            size_t len = std::min(buf_len - buf_offs, chunkRemaining);
+            size_t ret = deliver(buf + buf_offs, len);
+            if (ret == 0) {
+                return false;
+            }
+            buf_offs += ret;
+            bodyReceived += ret;
+            chunkRemaining -= ret;
+            if (chunkRemaining == 0) {
+                chunkState = ChunkState::DataEnd;
+            }
+            return true;
+        }
+        case ChunkState::DataEnd: {
+            if (!takeLine()) {
+                return readSocket();
+            }
+            chunkState = ChunkState::Size;
+            return true;
+        }
+        case ChunkState::Trailer: {
+            char *line = takeLine();
+            if (!line) {
+                return readSocket();
+            }
+            if (*line == '\0') {
+                MO_DBG_DEBUG("HTTP transfer complete (%zuB)", bodyReceived);
+                finish(MO_FtpCloseReason_Success);
+                return false;
+            }
+            return true; //ignore trailer field
+        }
+    }
+
+    return false;
+}
+
+bool HttpTransferMbedTLS::process() {
+    switch (state) {
+        case State::Handshake: {
+            auto ret = conn->handshake();
+            if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                return false;
+            } else if (ret) {
+                keepAlive = false;
+                finish(MO_FtpCloseReason_Failure);
+                return false;
+            }
+            if (conn->storeSession(&cache->session)) {
+                cache->sessionHost = host;
+                cache->sessionPort = port;
+                cache->sessionValid = true;
+            }
+            state = State::SendRequest;
+            return true;
+        }
+        case State::SendRequest:
+        case State::SendBody:
+            return processSend();
+        case State::RecvHeaders:
+            return processRecvHeaders();
+        case State::RecvBody:
+            return processRecvBody();
+        case State::Closed:
+            return false;
+    }
+    return false;
+}
+
+void HttpTransferMbedTLS::loop() {
+
+    //process until the socket has no more data or the time budget is used up
+    auto t_start = mocpp_tick_ms();
+
+    while (process()) {
+        if (mocpp_tick_ms() - t_start >= MO_HTTP_LOOP_BUDGET_MS) {
+            break;
+        }
+    }
+}
+
+bool HttpTransferMbedTLS::isActive() {
+    return state != State::Closed;
+}
+
+bool HttpTransferMbedTLS::read_url(const char *url_raw) {
+    std::string url = url_raw; //copy input url
+
+    //tolower protocol specifier
+    for (auto c = url.begin(); c != url.end() && *c != ':'; c++) {
+        *c = tolower(*c);
+    }
+
+    //parse URL: protocol specifier
+    std::string proto;
+    if (!strncmp(url.c_str(), "https://", strlen("https://"))) {
+        proto = "https://";
+        isSecure = true;
+    } else if (!strncmp(url.c_str(), "http://", strlen("http://"))) {
+        proto = "http://";
+        isSecure = false;
+    } else {
+        MO_DBG_ERR("protocol not supported. Please use https:// or http://");
+        return false;
+    }
+
+    //parse URL: path
+    auto path_pos = url.find_first_of('/', proto.length());
+    if (path_pos != std::string::npos) {
+        path = url.substr(path_pos);
+    } else {
+        path = "/";
+    }
+
+    //parse URL: user, pass, host, port
+    std::string user_pass_host_port = url.substr(proto.length(), path_pos == std::string::npos ? std::string::npos : path_pos - proto.length());
+    std::string host_port;
+    auto user_pass_delim = user_pass_host_port.find_last_of('@');
+    if (user_pass_delim != std::string::npos) {
+        host_port = user_pass_host_port.substr(user_pass_delim + 1);
+        std::string user_pass = user_pass_host_port.substr(0, user_pass_delim);
+
+        size_t auth_len = 0;
+        mbedtls_base64_encode(nullptr, 0, &auth_len, (const unsigned char*) user_pass.c_str(), user_pass.length());
+        auth.resize(auth_len);
+        if (mbedtls_base64_encode((unsigned char*) &auth[0], auth.size(), &auth_len, (const unsigned char*) user_pass.c_str(), user_pass.length())) {
+            MO_DBG_ERR("could not encode credentials");
+            return false;
+        }
+        auth.resize(auth_len);
+    } else {
+        host_port = user_pass_host_port;
+        auth.clear();
+    }
+
+    if (host_port.empty()) {
+        MO_DBG_ERR("missing hostname");
+        return false;
+    }
+
+    auto host_port_delim = host_port.find(':');
+    if (host_port_delim != std::string::npos) {
+        host = host_port.substr(0, host_port_delim);
+        port = host_port.substr(host_port_delim + 1);
+    } else {
+        //use default port number
+        host = host_port;
+        port = isSecure ? "443" : "80";
+    }
+
+    MO_DBG_DEBUG("parsed host: %s; port: %s; path: %s", host.c_str(), port.c_str(), path.c_str());
+
+    return true;
+}
+
+HttpClientMbedTLS::HttpClientMbedTLS(const char *client_cert, const char *client_key)
+        : cache(std::make_shared<HttpSessionCache>()), client_cert(client_cert), client_key(client_key) {
+
+}
+
+std::unique_ptr<FtpDownload> HttpClientMbedTLS::getFile(const char *url, std::function<size_t(unsigned char *data, size_t len)> fileWriter, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert) {
+    return getFileFromOffset(url, 0, fileWriter, onClose, ca_cert);
+}
+
+std::unique_ptr<FtpDownload> HttpClientMbedTLS::getFileFromOffset(const char *url, size_t offset, std::function<size_t(unsigned char *data, size_t len)> fileWriter, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert) {
+
+    auto handle = std::unique_ptr<HttpTransferMbedTLS>(new HttpTransferMbedTLS(cache, client_cert, client_key));
+    if (!handle) {
+        MO_DBG_ERR("OOM");
+        return nullptr;
+    }
+
+    bool success = handle->getFile(url, fileWriter, onClose, ca_cert, offset);
+
+    if (success) {
+        return handle;
+    } else {
+        return nullptr;
+    }
+}
+
+std::unique_ptr<FtpUpload> HttpClientMbedTLS::postFile(const char *url, std::function<size_t(unsigned char *out, size_t buffsize)> fileReader, std::function<void(MO_FtpCloseReason)> onClose, const char *ca_cert) {
+
+    auto handle = std::unique_ptr<HttpTransferMbedTLS>(new HttpTransferMbedTLS(cache, client_cert, client_key));
+    if (!handle) {
+        MO_DBG_ERR("OOM");
+        return nullptr;
+    }
+
+    bool success = handle->postFile(url, fileReader, onClose, ca_cert);
+
+    if (success) {
+        return handle;
+    } else {
+        return nullptr;
+    }
+}
+
+} //namespace MicroOcpp
+
+#endif //MO_ENABLE_MBEDTLS
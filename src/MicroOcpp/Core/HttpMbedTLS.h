@@ -0,0 +1,50 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_HTTP_MBEDTLS_H
+#define MO_HTTP_MBEDTLS_H
+
+/*
+ * Built-in HTTP(S) client for firmware downloads and log uploads (depends on MbedTLS)
+ *
+ * Implements the FtpClient interface, so that FirmwareService and DiagnosticsService can use it for http:// and
+ * https:// locations (see Context::getTransferClient()). Supported features:
+ *     - GET with `Range` to resume a download (getFileFromOffset)
+ *     - POST with chunked transfer encoding for uploads of unknown size (postFile)
+ *     - responses with Content-Length, chunked transfer encoding or connection close
+ *     - redirects (up to MO_HTTP_MAX_REDIRECTS)
+ *     - keep-alive: the connection of a completed transfer is reused by the next transfer to the same host
+ *     - TLS session resumption when a new connection to the same host is needed
+ *     - basic auth with credentials from the URL: http[s]://[user[:pass]@]host[:port]/path
+ */
+
+#include <MicroOcpp/Platform.h>
+
+#if MO_ENABLE_MBEDTLS
+
+#ifndef MO_HTTP_BUFSIZE
+#define MO_HTTP_BUFSIZE 4096 //I/O buffer per transfer. Must hold the request header and each response header line
+#endif
+
+#ifndef MO_HTTP_LOOP_BUDGET_MS
+#define MO_HTTP_LOOP_BUDGET_MS 20 //max. time per loop() call to drain the socket. 0 processes one chunk per loop() call
+#endif
+
+#ifndef MO_HTTP_MAX_REDIRECTS
+#define MO_HTTP_MAX_REDIRECTS 3
+#endif
+
+#include <memory>
+
+#include <MicroOcpp/Core/Ftp.h>
+
+namespace MicroOcpp {
+
+std::unique_ptr<FtpClient> makeHttpClientMbedTLS(const char *client_cert = nullptr, const char *client_key = nullptr);
+
+} //namespace MicroOcpp
+
+#endif //MO_ENABLE_MBEDTLS
+
+#endif
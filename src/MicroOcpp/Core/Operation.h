@@ -19,6 +19,7 @@
  #define MO_OPERATION_H
 
 #include <memory>
+#include <string>
 #include <ArduinoJson.h>
 
 namespace MicroOcpp {
@@ -62,6 +63,12 @@ public:
      */
     virtual std::unique_ptr<DynamicJsonDocument> createConf();
 
+    /**
+     * Optional alternative to createConf() for payloads which can become too big for a JSON document. Appends the
+     * serialized confirmation payload to out. Returns false if not supported, then createConf() is used instead.
+     */
+    virtual bool serializeConf(std::string& out) {return false;}
+
     virtual const char *getErrorCode() {return nullptr;} //nullptr means no error
     virtual const char *getErrorDescription() {return "";}
     virtual std::unique_ptr<DynamicJsonDocument> getErrorDetails() {return createEmptyDocument();}
@@ -48,7 +48,21 @@ void Request::setTimeout(unsigned long timeout) {
 }
 
 bool Request::isTimeoutExceeded() {
-    return timed_out || (timeout_period && mocpp_tick_ms() - timeout_start >= timeout_period);
+    return timed_out || (!timeout_frozen && timeout_period && mocpp_tick_ms() - timeout_start >= timeout_period);
+}
+
+unsigned long Request::getTimeoutRemainingMs() {
+    if (timed_out) {
+        return 0;
+    }
+    if (!timeout_period || timeout_frozen) {
+        return MO_WAKEUP_MAX_MS;
+    }
+    unsigned long elapsed = mocpp_tick_ms() - timeout_start;
+    if (elapsed >= timeout_period) {
+        return 0;
+    }
+    return std::min(timeout_period - elapsed, (unsigned long) MO_WAKEUP_MAX_MS);
 }
 
 void Request::executeTimeout() {
@@ -59,6 +73,29 @@ void Request::executeTimeout() {
     timed_out = true;
 }
 
+void Request::freezeTimeout() {
+    if (!timeout_freezable || timeout_frozen) {
+        return;
+    }
+    timeout_frozen = true;
+    timeout_frozen_since = mocpp_tick_ms();
+}
+
+void Request::unfreezeTimeout() {
+    if (!timeout_frozen) {
+        return;
+    }
+    timeout_start += mocpp_tick_ms() - timeout_frozen_since;
+    timeout_frozen = false;
+}
+
+void Request::setTimeoutFreezable(bool freezable) {
+    if (!freezable) {
+        unfreezeTimeout();
+    }
+    timeout_freezable = freezable;
+}
+
 void Request::setMessageID(const char *id){
     if (!messageID.empty()){
         MO_DBG_ERR("messageID already defined");
@@ -243,6 +280,36 @@ Request::CreateResponseResult Request::createResponse(DynamicJsonDocument& respo
     return CreateResponseResult::Success;
 }
 
+Request::CreateResponseResult Request::createResponse(std::string& out) {
+
+    if (!operation->getErrorCode() && !hasOnSendConfListener) {
+        /*
+         * Create OCPP-J Remote Procedure Call header and stream the payload behind it
+         */
+        DynamicJsonDocument header {JSON_ARRAY_SIZE(2)};
+        header.add(MESSAGE_TYPE_CALLRESULT);   //MessageType
+        header.add(messageID.c_str());            //Unique message ID
+
+        out.clear();
+        serializeJson(header, out);
+        out.back() = ','; //replace closing bracket
+
+        if (operation->serializeConf(out)) {
+            out.push_back(']');
+            return CreateResponseResult::Success;
+        }
+    }
+
+    DynamicJsonDocument response {0};
+    auto ret = createResponse(response);
+
+    out.clear();
+    if (ret == CreateResponseResult::Success) {
+        serializeJson(response, out);
+    }
+    return ret;
+}
+
 void Request::setOnReceiveConfListener(OnReceiveConfListener onReceiveConf){
     if (onReceiveConf)
         onReceiveConfListener = onReceiveConf;
@@ -257,8 +324,10 @@ void Request::setOnReceiveReqListener(OnReceiveReqListener onReceiveReq){
 }
 
 void Request::setOnSendConfListener(OnSendConfListener onSendConf){
-    if (onSendConf)
+    if (onSendConf) {
         onSendConfListener = onSendConf;
+        hasOnSendConfListener = true;
+    }
 }
 
 void Request::setOnTimeoutListener(OnTimeoutListener onTimeout) {
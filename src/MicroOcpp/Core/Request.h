@@ -28,6 +28,7 @@ private:
     OnReceiveConfListener onReceiveConfListener = [] (JsonObject payload) {};
     OnReceiveReqListener onReceiveReqListener = [] (JsonObject payload) {};
     OnSendConfListener onSendConfListener = [] (JsonObject payload) {};
+    bool hasOnSendConfListener = false; //if set, the payload needs to be created as JSON document
     OnTimeoutListener onTimeoutListener = [] () {};
     OnReceiveErrorListener onReceiveErrorListener = [] (const char *code, const char *description, JsonObject details) {};
     OnAbortListener onAbortListener = [] () {};
@@ -35,6 +36,9 @@ private:
     unsigned long timeout_start = 0;
     unsigned long timeout_period = 40000;
     bool timed_out = false;
+    bool timeout_frozen = false;
+    unsigned long timeout_frozen_since = 0;
+    bool timeout_freezable = true;
     
     unsigned long debugRequest_start = 0;
 
@@ -50,7 +54,11 @@ public:
     unsigned int getOpNr() {return opNr;}
     void setTimeout(unsigned long timeout); //0 = disable timeout
     bool isTimeoutExceeded();
+    unsigned long getTimeoutRemainingMs(); //time until isTimeoutExceeded() turns true, capped at MO_WAKEUP_MAX_MS
     void executeTimeout(); //call Timeout Listener
+    void freezeTimeout(); //stop the timeout clock, e.g. while the connection is down
+    void unfreezeTimeout(); //continue the timeout clock. The time while frozen doesn't count
+    void setTimeoutFreezable(bool freezable); //false: timeout also elapses while offline (e.g. to fall back to local authorization quickly)
     void setOnTimeoutListener(OnTimeoutListener onTimeout);
 
     /**
@@ -93,6 +101,7 @@ public:
     };
 
     CreateResponseResult createResponse(DynamicJsonDocument& out);
+    CreateResponseResult createResponse(std::string& out); //serialized message. Streams the payload if the operation supports it
 
     void setOnReceiveConfListener(OnReceiveConfListener onReceiveConf); //listener executed when we received the .conf() to a .req() we sent
     void setOnReceiveReqListener(OnReceiveReqListener onReceiveReq); //listener executed when we receive a .req()
@@ -10,11 +10,17 @@
 #include <MicroOcpp/Core/OcppError.h>
 #include <MicroOcpp/Core/OperationRegistry.h>
 #include <MicroOcpp/Operations/StatusNotification.h>
+#include <MicroOcpp/Operations/MeterValues.h>
 
+#include <MicroOcpp/Platform.h>
 #include <MicroOcpp/Debug.h>
 
 size_t removePayload(const char *src, size_t src_size, char *dst, size_t dst_size);
 
+namespace MicroOcpp {
+void writeRandomNonsecure(unsigned char *buf, size_t len);
+}
+
 using namespace MicroOcpp;
 
 VolatileRequestQueue::VolatileRequestQueue(unsigned int priority) : priority{priority} {
@@ -54,6 +60,14 @@ void VolatileRequestQueue::loop() {
     }
 }
 
+unsigned long VolatileRequestQueue::getNextWakeupMs() {
+    unsigned long res = MO_WAKEUP_MAX_MS;
+    for (size_t i = 0; i < len; i++) {
+        res = std::min(res, requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE]->getTimeoutRemainingMs());
+    }
+    return res;
+}
+
 unsigned int VolatileRequestQueue::getFrontRequestOpNr() {
     if (len == 0) {
         return NoOperation;
@@ -80,6 +94,36 @@ std::unique_ptr<Request> VolatileRequestQueue::fetchFrontRequest() {
     return result;
 }
 
+unsigned int VolatileRequestQueue::getFirstRequestOpNr(std::function<bool(Request&)> filter) {
+    for (size_t i = 0; i < len; i++) {
+        auto& request = requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE];
+        if (filter(*request)) {
+            return request->getOpNr() ? request->getOpNr() : priority;
+        }
+    }
+    return NoOperation;
+}
+
+std::unique_ptr<Request> VolatileRequestQueue::fetchFirstRequest(std::function<bool(Request&)> filter) {
+    for (size_t i = 0; i < len; i++) {
+        size_t index = (front + i) % MO_REQUEST_CACHE_MAXSIZE;
+        if (!filter(*requests[index])) {
+            continue;
+        }
+
+        std::unique_ptr<Request> result = std::move(requests[index]);
+        for (size_t j = i; j < len - 1; j++) {
+            requests[(front + j) % MO_REQUEST_CACHE_MAXSIZE] = std::move(requests[(front + j + 1) % MO_REQUEST_CACHE_MAXSIZE]);
+        }
+        len--;
+
+        MO_DBG_VERBOSE("front %zu len %zu", front, len);
+
+        return result;
+    }
+    return nullptr;
+}
+
 bool VolatileRequestQueue::pushRequestBack(std::unique_ptr<Request> request) {
 
     // Don't queue up multiple StatusNotification messages for the same connectorId
@@ -108,6 +152,32 @@ bool VolatileRequestQueue::pushRequestBack(std::unique_ptr<Request> request) {
         }
     }
 
+    // Batch up MeterValues which have accumulated (e.g. while offline) if enabled for the new request
+    if (strcmp(request->getOperationType(), "MeterValues") == 0)
+    {
+        auto new_meter_values = static_cast<Ocpp16::MeterValues*>(request->getOperation());
+        for (size_t i = len; i >= 1; i--) {
+            size_t index = (front + i - 1) % MO_REQUEST_CACHE_MAXSIZE;
+
+            if (strcmp(requests[index]->getOperationType(), "MeterValues") != 0)
+            {
+                continue;
+            }
+            auto old_meter_values = static_cast<Ocpp16::MeterValues*>(requests[index]->getOperation());
+            if (old_meter_values->getConnectorId() != new_meter_values->getConnectorId()) {
+                continue;
+            }
+            if (new_meter_values->mergeOlder(*old_meter_values)) {
+                requests[index].reset();
+                for (size_t j = (index + MO_REQUEST_CACHE_MAXSIZE - front) % MO_REQUEST_CACHE_MAXSIZE; j < len - 1; j++) {
+                    requests[(front + j) % MO_REQUEST_CACHE_MAXSIZE] = std::move(requests[(front + j + 1) % MO_REQUEST_CACHE_MAXSIZE]);
+                }
+                len--;
+            }
+            break; //only merge with the latest MeterValues of this connector to preserve the order of the MeterValue elements
+        }
+    }
+
     if (len >= MO_REQUEST_CACHE_MAXSIZE) {
         MO_DBG_INFO("Drop cached operation (cache full): %s", requests[front]->getOperationType());
         requests[front]->executeTimeout();
@@ -116,11 +186,29 @@ bool VolatileRequestQueue::pushRequestBack(std::unique_ptr<Request> request) {
         len--;
     }
 
+    if (timeoutsFrozen) {
+        request->freezeTimeout();
+    }
+
     requests[(front + len) % MO_REQUEST_CACHE_MAXSIZE] = std::move(request);
     len++;
     return true;
 }
 
+void VolatileRequestQueue::freezeTimeouts() {
+    timeoutsFrozen = true;
+    for (size_t i = 0; i < len; i++) {
+        requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE]->freezeTimeout();
+    }
+}
+
+void VolatileRequestQueue::unfreezeTimeouts() {
+    timeoutsFrozen = false;
+    for (size_t i = 0; i < len; i++) {
+        requests[(front + i) % MO_REQUEST_CACHE_MAXSIZE]->unfreezeTimeout();
+    }
+}
+
 RequestQueue::RequestQueue(Connection& connection, OperationRegistry& operationRegistry)
             : connection(connection), operationRegistry(operationRegistry) {
 
@@ -131,12 +219,227 @@ RequestQueue::RequestQueue(Connection& connection, OperationRegistry& operationR
     connection.setReceiveTXTcallback(callback);
 
     memset(sendQueues, 0, sizeof(sendQueues));
+    memset(heldOpNrs, 0, sizeof(heldOpNrs));
     addSendQueue(&defaultSendQueue);
     addSendQueue(&preBootSendQueue);
+
+    setDrainRateLimit(nullptr, MO_DRAIN_BURST, MO_DRAIN_INTERVAL_MS);
+
+    freezeTimeouts(); //initial state is Offline
+}
+
+void RequestQueue::updateConnectivity() {
+
+    bool connected = connection.isConnected();
+    unsigned long now = mocpp_tick_ms();
+
+    if (connectivity == ConnectivityState_Offline) {
+        if (!connected) {
+            return;
+        }
+
+        connectedSince = now;
+
+        if (!everConnected || MO_RECONNECT_BACKOFF_BASE_MS == 0) {
+            //first connection after booting, nothing has accumulated which would need a rate limit
+            MO_DBG_DEBUG("connected");
+            everConnected = true;
+            unfreezeTimeouts();
+            connectivity = ConnectivityState_Online;
+            return;
+        }
+
+        unsigned long window = MO_RECONNECT_BACKOFF_BASE_MS;
+        for (unsigned int i = 0; i < nReconnects && window < MO_RECONNECT_BACKOFF_MAX_MS; i++) {
+            window *= 2;
+        }
+        if (window > MO_RECONNECT_BACKOFF_MAX_MS) {
+            window = MO_RECONNECT_BACKOFF_MAX_MS;
+        }
+        nReconnects++;
+
+        uint32_t random = 0;
+        writeRandomNonsecure((unsigned char*) &random, sizeof(random));
+        backoffDelay = random % (window + 1);
+        backoffStart = now;
+
+        MO_DBG_INFO("reconnected, backoff %lu ms before sending", backoffDelay);
+        connectivity = ConnectivityState_Backoff;
+    }
+
+    if (!connected) {
+        MO_DBG_INFO("connection lost, freeze request timeouts");
+        if (connectivity != ConnectivityState_Backoff) {
+            freezeTimeouts();
+        }
+        if (now - connectedSince >= MO_RECONNECT_STABLE_MS) {
+            nReconnects = 0;
+        }
+        connectivity = ConnectivityState_Offline;
+        return;
+    }
+
+    if (connectivity == ConnectivityState_Backoff && now - backoffStart >= backoffDelay) {
+        MO_DBG_DEBUG("drain accumulated requests");
+        unfreezeTimeouts();
+        for (size_t i = 0; i < drainRateLimitsSize; i++) {
+            drainRateLimits[i].tokens = drainRateLimits[i].burst;
+            drainRateLimits[i].lastRefill = now;
+        }
+        connectivity = ConnectivityState_Draining;
+    }
+
+    if (connectivity == ConnectivityState_Draining && !hasPendingRequests()) {
+        MO_DBG_DEBUG("drained, back to normal operation");
+        connectivity = ConnectivityState_Online;
+    }
+}
+
+void RequestQueue::freezeTimeouts() {
+    if (sendReqFront) {
+        sendReqFront->freezeTimeout();
+    }
+    if (recvReqFront) {
+        recvReqFront->freezeTimeout();
+    }
+    for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES; i++) {
+        if (heldRequests[i]) {
+            heldRequests[i]->freezeTimeout();
+        }
+    }
+    defaultSendQueue.freezeTimeouts();
+    preBootSendQueue.freezeTimeouts();
+}
+
+void RequestQueue::unfreezeTimeouts() {
+    if (sendReqFront) {
+        sendReqFront->unfreezeTimeout();
+    }
+    if (recvReqFront) {
+        recvReqFront->unfreezeTimeout();
+    }
+    for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES; i++) {
+        if (heldRequests[i]) {
+            heldRequests[i]->unfreezeTimeout();
+        }
+    }
+    defaultSendQueue.unfreezeTimeouts();
+    preBootSendQueue.unfreezeTimeouts();
+}
+
+bool RequestQueue::hasPendingRequests() {
+    if (sendReqFront) {
+        return true;
+    }
+    for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES && sendQueues[i]; i++) {
+        if (heldRequests[i] || sendQueues[i]->getFrontRequestOpNr() != RequestEmitter::NoOperation) {
+            return true;
+        }
+    }
+    return false;
+}
+
+RequestQueue::DrainRateLimit& RequestQueue::getDrainRateLimit(const char *operationType) {
+    size_t operationTypeLen = strlen(operationType);
+    for (size_t i = 1; i < drainRateLimitsSize; i++) {
+        const char *types = drainRateLimits[i].operationTypes.c_str();
+        while (*types) {
+            const char *sep = strchr(types, ',');
+            size_t len = sep ? (size_t) (sep - types) : strlen(types);
+            if (len == operationTypeLen && !strncmp(types, operationType, len)) {
+                return drainRateLimits[i];
+            }
+            types += sep ? len + 1 : len;
+        }
+    }
+    return drainRateLimits[0]; //default class
+}
+
+void RequestQueue::refillDrainRateLimit(DrainRateLimit& limit) {
+    if (!limit.refillIntervalMs) {
+        return;
+    }
+    unsigned long now = mocpp_tick_ms();
+    unsigned long refills = (now - limit.lastRefill) / limit.refillIntervalMs;
+    if (refills == 0) {
+        return;
+    }
+    limit.lastRefill += refills * limit.refillIntervalMs;
+    if (refills >= limit.burst - limit.tokens) {
+        limit.tokens = limit.burst;
+        limit.lastRefill = now;
+    } else {
+        limit.tokens += refills;
+    }
+}
+
+unsigned long RequestQueue::getDrainTokenWaitMs(const char *operationType) {
+    auto& limit = getDrainRateLimit(operationType);
+    if (!limit.refillIntervalMs || limit.tokens > 0) {
+        return 0;
+    }
+    unsigned long elapsed = mocpp_tick_ms() - limit.lastRefill;
+    return elapsed >= limit.refillIntervalMs ? 0 : limit.refillIntervalMs - elapsed;
+}
+
+unsigned long RequestQueue::getDrainRefillWaitMs() {
+    unsigned long res = MO_WAKEUP_MAX_MS;
+    unsigned long now = mocpp_tick_ms();
+    for (size_t i = 0; i < drainRateLimitsSize; i++) {
+        auto& limit = drainRateLimits[i];
+        if (!limit.refillIntervalMs || limit.tokens > 0) {
+            continue;
+        }
+        unsigned long elapsed = now - limit.lastRefill;
+        res = std::min(res, elapsed >= limit.refillIntervalMs ? 0 : limit.refillIntervalMs - elapsed);
+    }
+    return res;
+}
+
+VolatileRequestQueue *RequestQueue::getVolatileQueue(size_t index) {
+    if (sendQueues[index] == &defaultSendQueue) {
+        return &defaultSendQueue;
+    } else if (sendQueues[index] == &preBootSendQueue) {
+        return &preBootSendQueue;
+    }
+    return nullptr;
+}
+
+bool RequestQueue::setDrainRateLimit(const char *operationTypes, unsigned int burst, unsigned long refillIntervalMs) {
+    if (!operationTypes) {
+        operationTypes = "";
+    }
+
+    size_t index = 0;
+    if (*operationTypes) {
+        index = 1;
+        while (index < drainRateLimitsSize && drainRateLimits[index].operationTypes.compare(operationTypes)) {
+            index++;
+        }
+    }
+
+    if (index >= MO_DRAIN_RATE_LIMITS_MAX) {
+        MO_DBG_ERR("exceeded MO_DRAIN_RATE_LIMITS_MAX");
+        return false;
+    }
+
+    auto& limit = drainRateLimits[index];
+    limit.operationTypes = operationTypes;
+    limit.burst = burst > 0 ? burst : 1;
+    limit.refillIntervalMs = refillIntervalMs;
+    limit.tokens = limit.burst;
+    limit.lastRefill = mocpp_tick_ms();
+
+    if (index >= drainRateLimitsSize) {
+        drainRateLimitsSize = index + 1;
+    }
+    return true;
 }
 
 void RequestQueue::loop() {
 
+    updateConnectivity();
+
     /*
      * Check if front request timed out
      */
@@ -152,6 +455,14 @@ void RequestQueue::loop() {
         recvReqFront.reset();
     }
 
+    for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES; i++) {
+        if (heldRequests[i] && heldRequests[i]->isTimeoutExceeded()) {
+            MO_DBG_INFO("operation timeout: %s", heldRequests[i]->getOperationType());
+            heldRequests[i]->executeTimeout();
+            heldRequests[i].reset();
+        }
+    }
+
     defaultSendQueue.loop();
     preBootSendQueue.loop();
 
@@ -171,13 +482,10 @@ void RequestQueue::loop() {
 
     if (recvReqFront) {
 
-        DynamicJsonDocument response {0};
-        auto ret = recvReqFront->createResponse(response);
+        std::string out;
+        auto ret = recvReqFront->createResponse(out);
 
         if (ret == Request::CreateResponseResult::Success) {
-            std::string out;
-            serializeJson(response, out);
-    
             bool success = connection.sendTXT(out.c_str(), out.length());
 
             if (success) {
@@ -189,16 +497,36 @@ void RequestQueue::loop() {
         } //else: There will be another attempt to send this conf message in a future loop call
     }
 
+    if (connectivity == ConnectivityState_Backoff) {
+        return; //hold back requests until the backoff delay has passed
+    }
+
     /**
      * Send pending req message
      */
 
     if (!sendReqFront) {
 
+        //while draining, pick the lowest opNr among the requests whose class has a token
+        bool draining = connectivity == ConnectivityState_Draining;
+        auto hasToken = [this] (Request& request) {
+            return getDrainTokenWaitMs(request.getOperationType()) == 0;
+        };
+
         unsigned int minOpNr = RequestEmitter::NoOperation;
         size_t index = MO_NUM_REQUEST_QUEUES;
         for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES && sendQueues[i]; i++) {
-            auto opNr = sendQueues[i]->getFrontRequestOpNr();
+            unsigned int opNr = RequestEmitter::NoOperation;
+            auto volatileQueue = getVolatileQueue(i);
+            if (heldRequests[i]) {
+                if (!draining || hasToken(*heldRequests[i])) {
+                    opNr = heldOpNrs[i];
+                }
+            } else if (draining && volatileQueue) {
+                opNr = volatileQueue->getFirstRequestOpNr(hasToken);
+            } else {
+                opNr = sendQueues[i]->getFrontRequestOpNr();
+            }
             if (opNr < minOpNr) {
                 minOpNr = opNr;
                 index = i;
@@ -206,12 +534,34 @@ void RequestQueue::loop() {
         }
 
         if (index < MO_NUM_REQUEST_QUEUES) {
-            sendReqFront = sendQueues[index]->fetchFrontRequest();
+            auto volatileQueue = getVolatileQueue(index);
+            if (heldRequests[index]) {
+                sendReqFront = std::move(heldRequests[index]);
+            } else if (draining && volatileQueue) {
+                sendReqFront = volatileQueue->fetchFirstRequest(hasToken);
+            } else {
+                sendReqFront = sendQueues[index]->fetchFrontRequest();
+                if (sendReqFront && draining && !hasToken(*sendReqFront)) {
+                    //wait for the next token. Hold back the rest of this queue, but let the other queues pass
+                    heldRequests[index] = std::move(sendReqFront);
+                    heldOpNrs[index] = minOpNr;
+                    return;
+                }
+            }
         }
     }
 
     if (sendReqFront && !sendReqFront->isRequestSent()) {
 
+        DrainRateLimit *limit = nullptr;
+        if (connectivity == ConnectivityState_Draining) {
+            limit = &getDrainRateLimit(sendReqFront->getOperationType());
+            refillDrainRateLimit(*limit);
+            if (limit->refillIntervalMs && limit->tokens == 0) {
+                return; //fetched before draining began. Wait for the next token
+            }
+        }
+
         DynamicJsonDocument request {0};
         auto ret = sendReqFront->createRequest(request);
 
@@ -226,6 +576,9 @@ void RequestQueue::loop() {
             if (success) {
                 MO_DBG_TRAFFIC_OUT(out.c_str());
                 sendReqFront->setRequestSent(); //mask as sent and wait for response / timeout
+                if (limit && limit->refillIntervalMs) {
+                    limit->tokens--;
+                }
             }
 
             return;
@@ -233,6 +586,77 @@ void RequestQueue::loop() {
     }
 }
 
+unsigned long RequestQueue::getNextWakeupMs() {
+
+    unsigned long res = MO_WAKEUP_MAX_MS;
+
+    if (connection.isConnected()) {
+        if (connectivity == ConnectivityState_Offline) {
+            return 0; //reconnected, loop() needs to update the connectivity state
+        }
+
+        if (recvReqFront || recvQueue.getFrontRequestOpNr() != RequestEmitter::NoOperation) {
+            return 0;
+        }
+
+        if (connectivity == ConnectivityState_Backoff) {
+            unsigned long elapsed = mocpp_tick_ms() - backoffStart;
+            if (elapsed >= backoffDelay) {
+                return 0;
+            }
+            res = std::min(res, backoffDelay - elapsed);
+        } else if (sendReqFront && !sendReqFront->isRequestSent()) {
+            if (connectivity != ConnectivityState_Draining) {
+                return 0;
+            }
+            auto& limit = getDrainRateLimit(sendReqFront->getOperationType());
+            unsigned long elapsed = mocpp_tick_ms() - limit.lastRefill;
+            if (!limit.refillIntervalMs || limit.tokens > 0 || elapsed >= limit.refillIntervalMs) {
+                return 0;
+            }
+            res = std::min(res, limit.refillIntervalMs - elapsed);
+        } else if (!sendReqFront) {
+            bool draining = connectivity == ConnectivityState_Draining;
+            for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES && sendQueues[i]; i++) {
+                auto volatileQueue = getVolatileQueue(i);
+                if (heldRequests[i]) {
+                    unsigned long wait = draining ? getDrainTokenWaitMs(heldRequests[i]->getOperationType()) : 0;
+                    if (wait == 0) {
+                        return 0;
+                    }
+                    res = std::min(res, wait);
+                } else if (draining && volatileQueue) {
+                    if (volatileQueue->getFirstRequestOpNr([this] (Request& request) {
+                                return getDrainTokenWaitMs(request.getOperationType()) == 0;
+                            }) != RequestEmitter::NoOperation) {
+                        return 0;
+                    }
+                    if (volatileQueue->getFrontRequestOpNr() != RequestEmitter::NoOperation) {
+                        res = std::min(res, getDrainRefillWaitMs()); //all queued requests wait for a token
+                    }
+                } else if (sendQueues[i]->getFrontRequestOpNr() != RequestEmitter::NoOperation) {
+                    return 0;
+                }
+            }
+        }
+    }
+
+    if (sendReqFront) {
+        res = std::min(res, sendReqFront->getTimeoutRemainingMs());
+    }
+    for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES; i++) {
+        if (heldRequests[i]) {
+            res = std::min(res, heldRequests[i]->getTimeoutRemainingMs());
+        }
+    }
+    if (recvReqFront) {
+        res = std::min(res, recvReqFront->getTimeoutRemainingMs());
+    }
+    res = std::min(res, defaultSendQueue.getNextWakeupMs());
+    res = std::min(res, preBootSendQueue.getNextWakeupMs());
+    return res;
+}
+
 void RequestQueue::sendRequest(std::unique_ptr<Request> op){
     op->setOpNr(getNextOpNr());
     defaultSendQueue.pushRequestBack(std::move(op));
@@ -242,14 +666,15 @@ void RequestQueue::sendRequestPreBoot(std::unique_ptr<Request> op){
     preBootSendQueue.pushRequestBack(std::move(op));
 }
 
-void RequestQueue::addSendQueue(RequestEmitter* sendQueue) {
+bool RequestQueue::addSendQueue(RequestEmitter* sendQueue) {
     for (size_t i = 0; i < MO_NUM_REQUEST_QUEUES; i++) {
         if (!sendQueues[i]) {
             sendQueues[i] = sendQueue;
-            return;
+            return true;
         }
     }
-    MO_DBG_ERR("exceeded sendQueue capacity");
+    MO_DBG_ERR("exceeded sendQueue capacity. Requests of this queue won't be sent. Increase MO_NUM_REQUEST_QUEUES (currently %i)", (int) MO_NUM_REQUEST_QUEUES);
+    return false;
 }
 
 unsigned int RequestQueue::getNextOpNr() {
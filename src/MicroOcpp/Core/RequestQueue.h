@@ -8,8 +8,13 @@
 #include <limits>
 
 #include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/ConnectivityState.h>
+#include <MicroOcpp/Model/ConnectorBase/EvseId.h>
+#include <MicroOcpp/Version.h>
 
 #include <memory>
+#include <string>
+#include <functional>
 #include <ArduinoJson.h>
 
 #ifndef MO_REQUEST_CACHE_MAXSIZE
@@ -17,7 +22,54 @@
 #endif
 
 #ifndef MO_NUM_REQUEST_QUEUES
-#define MO_NUM_REQUEST_QUEUES 5
+#if defined(MO_NUMCONNECTORS)
+#define MO_NUM_REQUEST_QUEUES_CONNECTORS MO_NUMCONNECTORS
+#else
+#define MO_NUM_REQUEST_QUEUES_CONNECTORS 2 //default of MO_NUMCONNECTORS
+#endif
+#if MO_ENABLE_V201
+//default and preBoot queue, one queue per Connector, VariableService and a TransactionEvent queue per EVSE
+#define MO_NUM_REQUEST_QUEUES (3 + MO_NUM_REQUEST_QUEUES_CONNECTORS + MO_NUM_EVSE)
+#else
+//default and preBoot queue and one queue per Connector
+#define MO_NUM_REQUEST_QUEUES (2 + MO_NUM_REQUEST_QUEUES_CONNECTORS)
+#endif
+#endif
+
+/*
+ * After a reconnect, MO waits for a random delay before it sends the requests which have accumulated while offline. The
+ * delay is drawn uniformly from [0, window]. The window starts at MO_RECONNECT_BACKOFF_BASE_MS and doubles with every
+ * reconnect until the connection has been stable for MO_RECONNECT_STABLE_MS. This spreads the traffic of a charger fleet
+ * after a server restart. Responses to server requests aren't delayed. The first connection after booting isn't delayed
+ */
+#ifndef MO_RECONNECT_BACKOFF_BASE_MS
+#define MO_RECONNECT_BACKOFF_BASE_MS 2000 //0 disables the backoff
+#endif
+
+#ifndef MO_RECONNECT_BACKOFF_MAX_MS
+#define MO_RECONNECT_BACKOFF_MAX_MS 60000
+#endif
+
+#ifndef MO_RECONNECT_STABLE_MS
+#define MO_RECONNECT_STABLE_MS 60000
+#endif
+
+/*
+ * While draining the accumulated requests, every request needs a token of the rate limit of its operation class. A class
+ * holds up to burst tokens and gets one new token per refill interval. The default class covers all operations which aren't
+ * assigned to another class (see RequestQueue::setDrainRateLimit). A class which waits for a token doesn't hold back the
+ * requests of the other classes. Only the requests behind it in the same transaction queue wait, too, to keep their order
+ */
+#ifndef MO_DRAIN_BURST
+#define MO_DRAIN_BURST 10
+#endif
+
+#ifndef MO_DRAIN_INTERVAL_MS
+#define MO_DRAIN_INTERVAL_MS 1000 //0 disables the rate limit
+#endif
+
+#ifndef MO_DRAIN_RATE_LIMITS_MAX
+#define MO_DRAIN_RATE_LIMITS_MAX 4 //including the default class
 #endif
 
 namespace MicroOcpp {
@@ -39,15 +91,24 @@ private:
     std::unique_ptr<Request> requests [MO_REQUEST_CACHE_MAXSIZE];
     size_t front = 0, len = 0;
     const unsigned int priority;
+    bool timeoutsFrozen = false;
 public:
     VolatileRequestQueue(unsigned int priority = 1);
     ~VolatileRequestQueue();
     void loop();
+    unsigned long getNextWakeupMs(); //time until the next queued request times out
 
     unsigned int getFrontRequestOpNr() override;
     std::unique_ptr<Request> fetchFrontRequest() override;
 
+    //like getFrontRequestOpNr() and fetchFrontRequest(), but skip the requests which aren't accepted by filter
+    unsigned int getFirstRequestOpNr(std::function<bool(Request&)> filter);
+    std::unique_ptr<Request> fetchFirstRequest(std::function<bool(Request&)> filter);
+
     bool pushRequestBack(std::unique_ptr<Request> request);
+
+    void freezeTimeouts(); //also freezes requests which are pushed later, until unfreezeTimeouts()
+    void unfreezeTimeouts();
 };
 
 class RequestQueue {
@@ -60,6 +121,10 @@ private:
     VolatileRequestQueue preBootSendQueue {0};
     std::unique_ptr<Request> sendReqFront;
 
+    //requests which wait for a drain token, one per sendQueue. The sendQueue is skipped until its held request is sent
+    std::unique_ptr<Request> heldRequests [MO_NUM_REQUEST_QUEUES];
+    unsigned int heldOpNrs [MO_NUM_REQUEST_QUEUES];
+
     VolatileRequestQueue recvQueue;
     std::unique_ptr<Request> recvReqFront;
 
@@ -68,7 +133,32 @@ private:
     void receiveRequest(JsonArray json, std::unique_ptr<Request> op);
     void receiveResponse(JsonArray json);
 
-    unsigned long sockTrackLastConnected = 0;
+    ConnectivityState connectivity = ConnectivityState_Offline;
+    bool everConnected = false;
+    unsigned long connectedSince = 0;
+    unsigned int nReconnects = 0; //since the connection was stable the last time
+    unsigned long backoffStart = 0;
+    unsigned long backoffDelay = 0;
+
+    struct DrainRateLimit {
+        std::string operationTypes; //comma-separated. Empty for the default class
+        unsigned int burst = 0;
+        unsigned long refillIntervalMs = 0;
+        unsigned int tokens = 0;
+        unsigned long lastRefill = 0;
+    };
+    DrainRateLimit drainRateLimits [MO_DRAIN_RATE_LIMITS_MAX];
+    size_t drainRateLimitsSize = 0;
+
+    void updateConnectivity();
+    void freezeTimeouts();
+    void unfreezeTimeouts();
+    bool hasPendingRequests();
+    DrainRateLimit& getDrainRateLimit(const char *operationType);
+    void refillDrainRateLimit(DrainRateLimit& limit);
+    unsigned long getDrainTokenWaitMs(const char *operationType); //0 if a token is available
+    unsigned long getDrainRefillWaitMs(); //time until any exhausted class gets its next token
+    VolatileRequestQueue *getVolatileQueue(size_t index); //defaultSendQueue or preBootSendQueue, otherwise nullptr
 
     unsigned int nextOpNr = 10; //Nr 0 - 9 reservered for internal purposes
 public:
@@ -80,10 +170,21 @@ public:
 
     void loop(); //polls all reqQueues and decides which request to send (if any)
 
+    unsigned long getNextWakeupMs(); //0 if there is a message to send, otherwise time until the next timeout
+
     void sendRequest(std::unique_ptr<Request> request); //send an OCPP operation request to the server; adds request to default queue
     void sendRequestPreBoot(std::unique_ptr<Request> request); //send an OCPP operation request to the server; adds request to preBootQueue
 
-    void addSendQueue(RequestEmitter* sendQueue);
+    bool addSendQueue(RequestEmitter* sendQueue); //returns false if there are already MO_NUM_REQUEST_QUEUES queues
+
+    ConnectivityState getConnectivityState() {return connectivity;}
+
+    /*
+     * Configure the rate limit for draining the requests of an operation class after a reconnect. operationTypes is a
+     * comma-separated list of operation types like "StatusNotification,MeterValues". nullptr or "" configures the default
+     * class. refillIntervalMs = 0 doesn't limit the class. Returns false if there are already MO_DRAIN_RATE_LIMITS_MAX classes
+     */
+    bool setDrainRateLimit(const char *operationTypes, unsigned int burst, unsigned long refillIntervalMs);
 
     unsigned int getNextOpNr();
 };
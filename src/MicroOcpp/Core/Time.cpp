@@ -11,6 +11,20 @@ namespace MicroOcpp {
 const Timestamp MIN_TIME = Timestamp(2010, 0, 0, 0, 0, 0);
 const Timestamp MAX_TIME = Timestamp(2037, 0, 0, 0, 0, 0);
 
+unsigned long getWakeupMsUntil(const Timestamp& tnow, const Timestamp& t) {
+    if (tnow >= t) {
+        return 0;
+    }
+    if (t >= MAX_TIME) {
+        return MO_WAKEUP_MAX_MS;
+    }
+    int dt = t - tnow;
+    if (dt < 0 || (unsigned long) dt >= MO_WAKEUP_MAX_MS / 1000UL) {
+        return MO_WAKEUP_MAX_MS;
+    }
+    return (unsigned long) dt * 1000UL;
+}
+
 Timestamp::Timestamp() {
     
 }
@@ -96,6 +96,11 @@ public:
 extern const Timestamp MIN_TIME;
 extern const Timestamp MAX_TIME;
 
+/*
+ * Milliseconds from tnow until t, capped at MO_WAKEUP_MAX_MS. Returns 0 if t is not in the future
+ */
+unsigned long getWakeupMsUntil(const Timestamp& tnow, const Timestamp& t);
+
 class Clock {
 private:
 
@@ -0,0 +1,1204 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Core/WebSocketPosix.h>
+
+#if MO_ENABLE_POSIX_WS
+
+#include <string.h>
+#include <stdlib.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+
+#if MO_ENABLE_MBEDTLS
+#include <mbedtls/error.h>
+#endif
+
+#include <MicroOcpp/Debug.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0
+#endif
+
+#define MO_WS_GUID "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+
+#define MO_WS_OP_CONT   0x0
+#define MO_WS_OP_TEXT   0x1
+#define MO_WS_OP_BINARY 0x2
+#define MO_WS_OP_CLOSE  0x8
+#define MO_WS_OP_PING   0x9
+#define MO_WS_OP_PONG   0xA
+
+#define MO_WS_FRAME_HEADER_MAX 14 //2 bytes + 8 bytes extended length + 4 bytes mask
+
+namespace MicroOcpp {
+
+#if MO_ENABLE_MBEDTLS
+void mo_mbedtls_log(void *user, int level, const char *file, int line, const char *str); //defined in FtpMbedTLS.cpp
+#endif
+
+namespace Posix {
+
+/*
+ * SHA-1 and Base64 for the opening handshake. SHA-1 is only used to compute Sec-WebSocket-Accept and doesn't need
+ * to be collision resistant for that (RFC 6455, Section 10.8)
+ */
+
+static uint32_t sha1_rol(uint32_t v, unsigned int n) {
+    return (v << n) | (v >> (32 - n));
+}
+
+static void sha1_block(uint32_t h [5], const unsigned char *p) {
+    uint32_t w [80];
+    for (unsigned int i = 0; i < 16; i++) {
+        w[i] = ((uint32_t) p[4*i] << 24) | ((uint32_t) p[4*i + 1] << 16) | ((uint32_t) p[4*i + 2] << 8) | (uint32_t) p[4*i + 3];
+    }
+    for (unsigned int i = 16; i < 80; i++) {
+        w[i] = sha1_rol(w[i-3] ^ w[i-8] ^ w[i-14] ^ w[i-16], 1);
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+    for (unsigned int i = 0; i < 80; i++) {
+        uint32_t f, k;
+        if (i < 20) {
+            f = (b & c) | (~b & d);
+            k = 0x5A827999;
+        } else if (i < 40) {
+            f = b ^ c ^ d;
+            k = 0x6ED9EBA1;
+        } else if (i < 60) {
+            f = (b & c) | (b & d) | (c & d);
+            k = 0x8F1BBCDC;
+        } else {
+            f = b ^ c ^ d;
+            k = 0xCA62C1D6;
+        }
+        uint32_t t = sha1_rol(a, 5) + f + e + k + w[i];
+        e = d;
+        d = c;
+        c = sha1_rol(b, 30);
+        b = a;
+        a = t;
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+    h[4] += e;
+}
+
+static void sha1(const unsigned char *data, size_t len, unsigned char out [20]) {
+    uint32_t h [5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+
+    size_t i = 0;
+    for (; i + 64 <= len; i += 64) {
+        sha1_block(h, data + i);
+    }
+
+    //padding
+    unsigned char tail [128];
+    memset(tail, 0, sizeof(tail));
+    size_t rem = len - i;
+    memcpy(tail, data + i, rem);
+    tail[rem] = 0x80;
+    size_t tailLen = rem + 1 + 8 <= 64 ? 64 : 128;
+    uint64_t bits = (uint64_t) len * 8;
+    for (unsigned int j = 0; j < 8; j++) {
+        tail[tailLen - 1 - j] = (unsigned char) (bits >> (8 * j));
+    }
+    for (size_t j = 0; j < tailLen; j += 64) {
+        sha1_block(h, tail + j);
+    }
+
+    for (unsigned int j = 0; j < 5; j++) {
+        out[4*j]     = (unsigned char) (h[j] >> 24);
+        out[4*j + 1] = (unsigned char) (h[j] >> 16);
+        out[4*j + 2] = (unsigned char) (h[j] >> 8);
+        out[4*j + 3] = (unsigned char) h[j];
+    }
+}
+
+static bool base64_encode(const unsigned char *in, size_t len, char *out, size_t size) {
+    const char *table = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+    if (size < 4 * ((len + 2) / 3) + 1) {
+        return false;
+    }
+
+    size_t o = 0;
+    for (size_t i = 0; i < len; i += 3) {
+        uint32_t v = (uint32_t) in[i] << 16;
+        if (i + 1 < len) v |= (uint32_t) in[i + 1] << 8;
+        if (i + 2 < len) v |= (uint32_t) in[i + 2];
+        out[o++] = table[(v >> 18) & 0x3F];
+        out[o++] = table[(v >> 12) & 0x3F];
+        out[o++] = i + 1 < len ? table[(v >> 6) & 0x3F] : '=';
+        out[o++] = i + 2 < len ? table[v & 0x3F] : '=';
+    }
+    out[o] = '\0';
+    return true;
+}
+
+bool makeWebSocketAccept(const char *key, char *out, size_t size) {
+    if (!key || size < MO_WS_ACCEPT_SIZE) {
+        return false;
+    }
+
+    std::string input = key;
+    input += MO_WS_GUID;
+
+    unsigned char digest [20];
+    sha1((const unsigned char*) input.c_str(), input.length(), digest);
+
+    return base64_encode(digest, sizeof(digest), out, size);
+}
+
+static bool growBuf(unsigned char*& buf, size_t& cap, size_t used, size_t need, size_t limit) {
+    if (need <= cap) {
+        return true;
+    }
+    if (need > limit) {
+        return false;
+    }
+
+    size_t newCap = cap > 0 ? cap : MO_WS_BUFSIZE;
+    while (newCap < need) {
+        newCap *= 2;
+    }
+    if (newCap > limit) {
+        newCap = limit;
+    }
+
+    auto newBuf = new unsigned char[newCap];
+    if (!newBuf) {
+        MO_DBG_ERR("OOM");
+        return false;
+    }
+    if (used > 0) {
+        memcpy(newBuf, buf, used);
+    }
+    delete[] buf;
+    buf = newBuf;
+    cap = newCap;
+    return true;
+}
+
+WSClient::WSClient(const char *url_raw, const char *chargeBoxId, const char *authorizationKey, const char *ca_cert, const char *protocol)
+        : protocol(protocol ? protocol : ""), ca_cert(ca_cert) {
+
+    key[0] = '\0';
+
+#if MO_ENABLE_MBEDTLS
+    mbedtls_net_init(&net);
+    mbedtls_ssl_init(&ssl);
+    mbedtls_ssl_config_init(&conf);
+    mbedtls_x509_crt_init(&cacert);
+    mbedtls_ctr_drbg_init(&ctr_drbg);
+    mbedtls_entropy_init(&entropy);
+    mbedtls_ssl_session_init(&session);
+#endif
+
+    if (!url_raw) {
+        MO_DBG_ERR("invalid args");
+        return;
+    }
+
+    std::string url = url_raw;
+
+    //tolower protocol specifier
+    for (auto c = url.begin(); c != url.end() && *c != ':'; c++) {
+        *c = tolower(*c);
+    }
+
+    //parse URL: protocol specifier
+    std::string proto;
+    if (!strncmp(url.c_str(), "wss://", strlen("wss://"))) {
+        proto = "wss://";
+        isSecure = true;
+    } else if (!strncmp(url.c_str(), "ws://", strlen("ws://"))) {
+        proto = "ws://";
+        isSecure = false;
+    } else {
+        MO_DBG_ERR("protocol not supported. Please use wss:// or ws://");
+        return;
+    }
+
+#if !MO_ENABLE_MBEDTLS
+    if (isSecure) {
+        MO_DBG_ERR("wss:// requires MO_ENABLE_MBEDTLS");
+        return;
+    }
+#endif
+
+    //parse URL: path
+    auto path_pos = url.find_first_of('/', proto.length());
+    std::string host_port;
+    if (path_pos != std::string::npos) {
+        host_port = url.substr(proto.length(), path_pos - proto.length());
+        path = url.substr(path_pos);
+    } else {
+        host_port = url.substr(proto.length());
+        path = "/";
+    }
+
+    if (chargeBoxId && *chargeBoxId) {
+        if (path.back() != '/') {
+            path += '/';
+        }
+        path += chargeBoxId;
+    }
+
+    //parse URL: host, port
+    auto host_port_delim = host_port.find(':');
+    std::string hostParsed;
+    if (host_port_delim != std::string::npos) {
+        hostParsed = host_port.substr(0, host_port_delim);
+        port = host_port.substr(host_port_delim + 1);
+    } else {
+        //use default port number
+        hostParsed = host_port;
+        port = isSecure ? "443" : "80";
+    }
+
+    if (hostParsed.empty() || port.empty()) {
+        MO_DBG_ERR("could not parse URL: %s", url_raw);
+        return;
+    }
+
+    if (chargeBoxId && authorizationKey && *authorizationKey) {
+        std::string user_pass = std::string(chargeBoxId) + ":" + authorizationKey;
+        auth.resize(4 * ((user_pass.length() + 2) / 3) + 1);
+        base64_encode((const unsigned char*) user_pass.c_str(), user_pass.length(), &auth[0], auth.size());
+        auth.resize(strlen(auth.c_str()));
+    }
+
+    host = hostParsed; //marks the client as configured
+
+    MO_DBG_DEBUG("parsed host: %s; port: %s; path: %s", host.c_str(), port.c_str(), path.c_str());
+}
+
+WSClient::~WSClient() {
+    if (state == State::Open) {
+        unsigned char code [2] = {0x03, 0xE8}; //1000: normal closure
+        appendFrame(MO_WS_OP_CLOSE, code, sizeof(code));
+        flush();
+    }
+    disconnect(nullptr);
+
+    delete[] recvBuf;
+    delete[] sendBuf;
+
+#if MO_ENABLE_MBEDTLS
+    mbedtls_ssl_session_free(&session);
+    mbedtls_ssl_free(&ssl);
+    mbedtls_x509_crt_free(&cacert);
+    mbedtls_ssl_config_free(&conf);
+    mbedtls_ctr_drbg_free(&ctr_drbg);
+    mbedtls_entropy_free(&entropy);
+#endif
+}
+
+#if MO_ENABLE_MBEDTLS
+bool WSClient::seedRng() {
+    if (rngSeeded) {
+        return true;
+    }
+    if (auto ret = mbedtls_ctr_drbg_seed(&ctr_drbg, mbedtls_entropy_func, &entropy,
+                                    (const unsigned char*) __FILE__,
+                                    strlen(__FILE__))) {
+        MO_DBG_ERR("mbedtls_ctr_drbg_seed: %i", ret);
+        return false;
+    }
+    rngSeeded = true;
+    return true;
+}
+
+bool WSClient::randomBytes(unsigned char *buf, size_t len) {
+    if (!seedRng()) {
+        return false;
+    }
+    if (auto ret = mbedtls_ctr_drbg_random(&ctr_drbg, buf, len)) {
+        MO_DBG_ERR("mbedtls_ctr_drbg_random: %i", ret);
+        return false;
+    }
+    return true;
+}
+#else
+bool WSClient::randomBytes(unsigned char *buf, size_t len) {
+    while (len > 0) {
+        if (rngPos >= sizeof(rngBuf)) {
+            //refill the buffer. One read serves the masks of 16 frames
+            int rfd = open("/dev/urandom", O_RDONLY);
+            if (rfd < 0) {
+                MO_DBG_ERR("open /dev/urandom: %s", strerror(errno));
+                return false;
+            }
+            auto ret = read(rfd, rngBuf, sizeof(rngBuf));
+            close(rfd);
+            if (ret != (ssize_t) sizeof(rngBuf)) {
+                MO_DBG_ERR("read /dev/urandom failure");
+                return false;
+            }
+            rngPos = 0;
+        }
+        size_t n = std::min(len, sizeof(rngBuf) - rngPos);
+        memcpy(buf, rngBuf + rngPos, n);
+        memset(rngBuf + rngPos, 0, n); //don't keep handed out bytes
+        rngPos += n;
+        buf += n;
+        len -= n;
+    }
+    return true;
+}
+#endif //MO_ENABLE_MBEDTLS
+
+bool WSClient::connectSocket() {
+
+    struct addrinfo hints;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    hints.ai_protocol = IPPROTO_TCP;
+
+    struct addrinfo *addrs = nullptr;
+    if (auto ret = getaddrinfo(host.c_str(), port.c_str(), &hints, &addrs)) {
+        MO_DBG_WARN("could not resolve %s: %s", host.c_str(), gai_strerror(ret));
+        return false;
+    }
+
+    for (auto ai = addrs; ai; ai = ai->ai_next) {
+        fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (fd < 0) {
+            continue;
+        }
+
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+
+        if (connect(fd, ai->ai_addr, ai->ai_addrlen) == 0 || errno == EINPROGRESS) {
+            break;
+        }
+
+        close(fd);
+        fd = -1;
+    }
+
+    freeaddrinfo(addrs);
+
+    if (fd < 0) {
+        MO_DBG_WARN("could not connect to %s:%s", host.c_str(), port.c_str());
+        return false;
+    }
+
+    int one = 1;
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); //OCPP messages are short and latency-sensitive
+
+    state = State::Connecting;
+    return true;
+}
+
+bool WSClient::checkConnected() {
+
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLOUT;
+    pfd.revents = 0;
+
+    if (poll(&pfd, 1, 0) <= 0) {
+        return false; //connect() still in progress
+    }
+
+    int err = 0;
+    socklen_t errLen = sizeof(err);
+    if (getsockopt(fd, SOL_SOCKET, SO_ERROR, &err, &errLen) || err) {
+        MO_DBG_WARN("could not connect to %s:%s: %s", host.c_str(), port.c_str(), strerror(err));
+        disconnect(nullptr);
+        return false;
+    }
+
+#if MO_ENABLE_MBEDTLS
+    if (isSecure) {
+        if (!setupTls()) {
+            disconnect("TLS setup failure");
+            return false;
+        }
+        state = State::TlsHandshake;
+        return true;
+    }
+#endif
+
+    return beginUpgrade();
+}
+
+#if MO_ENABLE_MBEDTLS
+bool WSClient::setupTls() {
+
+    if (!tlsConfigured) {
+        if (!seedRng()) {
+            return false;
+        }
+
+        if (ca_cert) {
+            if (auto ret = mbedtls_x509_crt_parse(&cacert, (const unsigned char *) ca_cert,
+                                        strlen(ca_cert) + 1)) {
+                MO_DBG_ERR("mbedtls_x509_crt_parse(ca_cert): %i", ret);
+                return false;
+            }
+        }
+
+        if (auto ret = mbedtls_ssl_config_defaults(&conf,
+                                            MBEDTLS_SSL_IS_CLIENT,
+                                            MBEDTLS_SSL_TRANSPORT_STREAM,
+                                            MBEDTLS_SSL_PRESET_DEFAULT)) {
+            MO_DBG_ERR("mbedtls_ssl_config_defaults: %i", ret);
+            return false;
+        }
+
+        mbedtls_ssl_conf_authmode(&conf, MBEDTLS_SSL_VERIFY_OPTIONAL); //certificate check result manually handled after handshake
+        mbedtls_ssl_conf_rng(&conf, mbedtls_ctr_drbg_random, &ctr_drbg);
+        mbedtls_ssl_conf_dbg(&conf, mo_mbedtls_log, NULL);
+
+        if (ca_cert) {
+            mbedtls_ssl_conf_ca_chain(&conf, &cacert, NULL);
+        }
+
+        tlsConfigured = true;
+    }
+
+    //new TLS context per connection
+    mbedtls_ssl_free(&ssl);
+    mbedtls_ssl_init(&ssl);
+
+    if (auto ret = mbedtls_ssl_setup(&ssl, &conf)) {
+        MO_DBG_ERR("mbedtls_ssl_setup: %i", ret);
+        return false;
+    }
+
+    if (auto ret = mbedtls_ssl_set_hostname(&ssl, host.c_str())) {
+        MO_DBG_ERR("mbedtls_ssl_set_hostname: %i", ret);
+        return false;
+    }
+
+    net.fd = fd;
+    mbedtls_ssl_set_bio(&ssl, &net, mbedtls_net_send, mbedtls_net_recv, NULL);
+
+    if (sessionValid) {
+        //resume the TLS session of the last connection. If the server refuses, MbedTLS falls back to a full handshake
+        if (auto ret = mbedtls_ssl_set_session(&ssl, &session)) {
+            MO_DBG_WARN("session reuse failure: %i", ret);
+        }
+    }
+
+    return true;
+}
+#endif //MO_ENABLE_MBEDTLS
+
+void WSClient::disconnect(const char *reason) {
+
+    if (reason) {
+        MO_DBG_WARN("disconnect from %s: %s", host.c_str(), reason);
+    }
+
+#if MO_ENABLE_MBEDTLS
+    if (isSecure && fd >= 0) {
+        if (state == State::Open) {
+            mbedtls_ssl_close_notify(&ssl);
+        }
+        mbedtls_ssl_free(&ssl);
+        mbedtls_ssl_init(&ssl);
+        net.fd = -1; //closed below
+    }
+#endif
+
+    if (fd >= 0) {
+        close(fd);
+        fd = -1;
+    }
+
+    state = State::Disconnected;
+    lastAttempt = mocpp_tick_ms(); //wait reconnectInterval before the next attempt
+
+    recvLen = 0;
+    parsePos = 0;
+    fragLen = 0;
+    fragmented = false;
+    sendLen = 0;
+    sendOffs = 0;
+    pingPending = false;
+    missedPongs = 0;
+}
+
+void WSClient::failConnection(uint16_t code, const char *reason) {
+    if (state == State::Open) {
+        unsigned char payload [2] = {(unsigned char) (code >> 8), (unsigned char) code};
+        appendFrame(MO_WS_OP_CLOSE, payload, sizeof(payload));
+        flush();
+    }
+    disconnect(reason);
+}
+
+int WSClient::sockSend(const unsigned char *buf, size_t len) {
+#if MO_ENABLE_MBEDTLS
+    if (isSecure) {
+        int ret = mbedtls_ssl_write(&ssl, buf, len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return 0;
+        } else if (ret < 0) {
+            MO_DBG_WARN("mbedtls_ssl_write: %i", ret);
+            return -1;
+        }
+        return ret;
+    }
+#endif
+
+    auto ret = send(fd, buf, len, MSG_NOSIGNAL);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        MO_DBG_WARN("send: %s", strerror(errno));
+        return -1;
+    }
+    return (int) ret;
+}
+
+int WSClient::sockRecv(unsigned char *buf, size_t len) {
+#if MO_ENABLE_MBEDTLS
+    if (isSecure) {
+        int ret = mbedtls_ssl_read(&ssl, buf, len);
+        if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+            return 0;
+        } else if (ret == 0 || ret == MBEDTLS_ERR_SSL_PEER_CLOSE_NOTIFY) {
+            return -1; //connection closed by server
+        } else if (ret < 0) {
+            MO_DBG_WARN("mbedtls_ssl_read: %i", ret);
+            return -1;
+        }
+        return ret;
+    }
+#endif
+
+    auto ret = recv(fd, buf, len, 0);
+    if (ret < 0) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+            return 0;
+        }
+        MO_DBG_WARN("recv: %s", strerror(errno));
+        return -1;
+    } else if (ret == 0) {
+        return -1; //connection closed by server
+    }
+    return (int) ret;
+}
+
+bool WSClient::beginUpgrade() {
+
+    unsigned char nonce [16];
+    if (!randomBytes(nonce, sizeof(nonce))) {
+        disconnect("no random source for Sec-WebSocket-Key");
+        return false;
+    }
+    base64_encode(nonce, sizeof(nonce), key, sizeof(key));
+
+    std::string request = "GET " + path + " HTTP/1.1\r\n";
+    request += "Host: " + host;
+    if (port != (isSecure ? "443" : "80")) {
+        request += ":" + port;
+    }
+    request += "\r\n"
+               "Upgrade: websocket\r\n"
+               "Connection: Upgrade\r\n"
+               "Sec-WebSocket-Key: ";
+    request += key;
+    request += "\r\n"
+               "Sec-WebSocket-Version: 13\r\n";
+    if (!protocol.empty()) {
+        request += "Sec-WebSocket-Protocol: " + protocol + "\r\n";
+    }
+    if (!auth.empty()) {
+        request += "Authorization: Basic " + auth + "\r\n";
+    }
+    request += "\r\n";
+
+    sendLen = 0;
+    sendOffs = 0;
+    if (!growBuf(sendBuf, sendCap, 0, request.length(), MO_WS_MAX_MSG_SIZE + MO_WS_FRAME_HEADER_MAX)) {
+        disconnect("upgrade request exceeds MO_WS_MAX_MSG_SIZE");
+        return false;
+    }
+    memcpy(sendBuf, request.c_str(), request.length());
+    sendLen = request.length();
+
+    recvLen = 0;
+    parsePos = 0;
+
+    state = State::Upgrade;
+    return true;
+}
+
+bool WSClient::processUpgrade() {
+
+    flush();
+    if (state != State::Upgrade) {
+        return false;
+    }
+
+    if (!readSocket()) {
+        return false;
+    }
+
+    //search end of HTTP header
+    size_t headerLen = 0;
+    for (size_t i = 3; i < recvLen; i++) {
+        if (recvBuf[i - 3] == '\r' && recvBuf[i - 2] == '\n' && recvBuf[i - 1] == '\r' && recvBuf[i] == '\n') {
+            headerLen = i + 1;
+            break;
+        }
+    }
+
+    if (headerLen == 0) {
+        if (recvLen >= MO_WS_MAX_MSG_SIZE) {
+            disconnect("upgrade response exceeds MO_WS_MAX_MSG_SIZE");
+        }
+        return false; //wait for more data
+    }
+
+    std::string header ((const char*) recvBuf, headerLen);
+
+    //frames which the server sent right after the upgrade response remain in recvBuf
+    parsePos = headerLen;
+
+    int status = 0;
+    if (sscanf(header.c_str(), "HTTP/%*u.%*u %i", &status) != 1 || status != 101) {
+        MO_DBG_ERR("upgrade refused: %.*s", (int) std::min(header.find('\r'), header.length()), header.c_str());
+        disconnect(status == 401 ? "authorization failure" : "upgrade failure");
+        return false;
+    }
+
+    char expectedAccept [MO_WS_ACCEPT_SIZE];
+    makeWebSocketAccept(key, expectedAccept, sizeof(expectedAccept));
+
+    bool upgradeOk = false, acceptOk = false, protocolOk = protocol.empty();
+
+    size_t lineBegin = header.find("\r\n") + 2;
+    while (lineBegin < header.length()) {
+        size_t lineEnd = header.find("\r\n", lineBegin);
+        if (lineEnd == std::string::npos || lineEnd == lineBegin) {
+            break;
+        }
+        std::string line = header.substr(lineBegin, lineEnd - lineBegin);
+        lineBegin = lineEnd + 2;
+
+        auto delim = line.find(':');
+        if (delim == std::string::npos) {
+            continue;
+        }
+        std::string name = line.substr(0, delim);
+        auto valueBegin = line.find_first_not_of(" \t", delim + 1);
+        std::string value = valueBegin != std::string::npos ? line.substr(valueBegin) : "";
+        while (!value.empty() && (value.back() == ' ' || value.back() == '\t')) {
+            value.pop_back();
+        }
+
+        //header names are case-insensitive
+        for (auto c = name.begin(); c != name.end(); c++) {
+            *c = tolower(*c);
+        }
+
+        if (name == "upgrade") {
+            for (auto c = value.begin(); c != value.end(); c++) {
+                *c = tolower(*c);
+            }
+            upgradeOk = value == "websocket";
+        } else if (name == "sec-websocket-accept") {
+            acceptOk = value == expectedAccept;
+        } else if (name == "sec-websocket-protocol") {
+            protocolOk = value == protocol;
+        } else if (name == "sec-websocket-extensions") {
+            MO_DBG_ERR("server enabled unrequested extension: %s", value.c_str());
+            disconnect("upgrade failure");
+            return false;
+        }
+    }
+
+    if (!upgradeOk || !acceptOk) {
+        MO_DBG_ERR("invalid upgrade response (upgrade: %s, accept: %s)", upgradeOk ? "ok" : "invalid", acceptOk ? "ok" : "invalid");
+        disconnect("upgrade failure");
+        return false;
+    }
+
+    if (!protocolOk) {
+        MO_DBG_WARN("server didn't confirm subprotocol %s", protocol.c_str());
+    }
+
+    auto now = mocpp_tick_ms();
+    state = State::Open;
+    lastConnected = now;
+    lastRecv = now;
+    pingSent = now;
+    pingPending = false;
+    missedPongs = 0;
+
+    MO_DBG_INFO("connected to %s:%s%s", host.c_str(), port.c_str(), path.c_str());
+    return true;
+}
+
+bool WSClient::appendFrame(unsigned char opcode, const unsigned char *payload, size_t len) {
+
+    if (len > MO_WS_MAX_MSG_SIZE) {
+        MO_DBG_ERR("message exceeds MO_WS_MAX_MSG_SIZE (%zuB)", len);
+        return false;
+    }
+
+    size_t headerLen = 2 + (len > 125 ? (len > 0xFFFF ? 8 : 2) : 0) + 4;
+
+    if (sendOffs > 0 && sendCap - sendLen < headerLen + len) {
+        //move unsent data to the front
+        memmove(sendBuf, sendBuf + sendOffs, sendLen - sendOffs);
+        sendLen -= sendOffs;
+        sendOffs = 0;
+    }
+
+    if (!growBuf(sendBuf, sendCap, sendLen, sendLen + headerLen + len, 2 * (MO_WS_MAX_MSG_SIZE + MO_WS_FRAME_HEADER_MAX))) {
+        MO_DBG_WARN("send buffer full");
+        return false;
+    }
+
+    unsigned char *out = sendBuf + sendLen;
+    *out++ = 0x80 | opcode; //FIN; messages are never fragmented by the client
+    if (len <= 125) {
+        *out++ = 0x80 | (unsigned char) len;
+    } else if (len <= 0xFFFF) {
+        *out++ = 0x80 | 126;
+        *out++ = (unsigned char) (len >> 8);
+        *out++ = (unsigned char) len;
+    } else {
+        *out++ = 0x80 | 127;
+        for (int i = 7; i >= 0; i--) {
+            *out++ = (unsigned char) ((uint64_t) len >> (8 * i));
+        }
+    }
+
+    unsigned char mask [4];
+    if (!randomBytes(mask, sizeof(mask))) {
+        return false;
+    }
+    memcpy(out, mask, 4);
+    out += 4;
+
+    //mask while copying into the send buffer
+    for (size_t i = 0; i < len; i++) {
+        out[i] = payload[i] ^ mask[i & 3];
+    }
+
+    sendLen += headerLen + len;
+    return true;
+}
+
+bool WSClient::flush() {
+
+    if (sendOffs >= sendLen) {
+        return false;
+    }
+
+    int ret = sockSend(sendBuf + sendOffs, sendLen - sendOffs);
+    if (ret < 0) {
+        disconnect("send failure");
+        return false;
+    } else if (ret == 0) {
+        return false; //socket not ready, wait
+    }
+
+    sendOffs += (size_t) ret;
+    if (sendOffs >= sendLen) {
+        sendLen = 0;
+        sendOffs = 0;
+    }
+
+    return true;
+}
+
+bool WSClient::readSocket() {
+
+    if (recvLen >= recvCap) {
+        if (parsePos > fragLen) {
+            //move unprocessed data behind the assembled fragments
+            memmove(recvBuf + fragLen, recvBuf + parsePos, recvLen - parsePos);
+            recvLen -= parsePos - fragLen;
+            parsePos = fragLen;
+        } else if (!growBuf(recvBuf, recvCap, recvLen, recvLen + 1, MO_WS_MAX_MSG_SIZE + MO_WS_FRAME_HEADER_MAX)) {
+            return false; //buffer full. processFrame() closes the connection if a frame exceeds MO_WS_MAX_MSG_SIZE
+        }
+    }
+
+    int ret = sockRecv(recvBuf + recvLen, recvCap - recvLen);
+    if (ret < 0) {
+        disconnect("connection closed");
+        return false;
+    } else if (ret == 0) {
+        return false; //no new data
+    }
+
+    recvLen += (size_t) ret;
+    return true;
+}
+
+bool WSClient::processFrame() {
+
+    size_t avail = recvLen - parsePos;
+    if (avail < 2) {
+        return false;
+    }
+
+    const unsigned char *p = recvBuf + parsePos;
+
+    bool fin = p[0] & 0x80;
+    unsigned char opcode = p[0] & 0x0F;
+    size_t headerLen = 2;
+    uint64_t payloadLen = p[1] & 0x7F;
+
+    if (p[0] & 0x70) {
+        failConnection(1002, "RSV bits set without extension");
+        return false;
+    }
+
+    if (p[1] & 0x80) {
+        failConnection(1002, "masked frame from server");
+        return false;
+    }
+
+    if (payloadLen == 126) {
+        if (avail < 4) {
+            return false;
+        }
+        payloadLen = ((uint64_t) p[2] << 8) | (uint64_t) p[3];
+        headerLen = 4;
+    } else if (payloadLen == 127) {
+        if (avail < 10) {
+            return false;
+        }
+        payloadLen = 0;
+        for (unsigned int i = 0; i < 8; i++) {
+            payloadLen = (payloadLen << 8) | (uint64_t) p[2 + i];
+        }
+        headerLen = 10;
+    }
+
+    if (opcode & 0x8) {
+        if (!fin || payloadLen > 125) {
+            failConnection(1002, "invalid control frame");
+            return false;
+        }
+    } else if (payloadLen > MO_WS_MAX_MSG_SIZE || fragLen + payloadLen > MO_WS_MAX_MSG_SIZE) {
+        failConnection(1009, "message exceeds MO_WS_MAX_MSG_SIZE");
+        return false;
+    }
+
+    if (avail < headerLen + payloadLen) {
+        return false; //wait for the remainder of the frame
+    }
+
+    unsigned char *payload = recvBuf + parsePos + headerLen;
+    size_t len = (size_t) payloadLen;
+    parsePos += headerLen + len;
+
+    lastRecv = mocpp_tick_ms();
+
+    switch (opcode) {
+        case MO_WS_OP_TEXT:
+        case MO_WS_OP_BINARY:
+            if (fragmented) {
+                failConnection(1002, "expected continuation frame");
+                return false;
+            }
+            if (fin) {
+                deliver(opcode, payload, len); //zero-copy: payload points into recvBuf
+            } else {
+                fragmented = true;
+                fragOpcode = opcode;
+                memmove(recvBuf, payload, len);
+                fragLen = len;
+            }
+            break;
+        case MO_WS_OP_CONT:
+            if (!fragmented) {
+                failConnection(1002, "unexpected continuation frame");
+                return false;
+            }
+            memmove(recvBuf + fragLen, payload, len);
+            fragLen += len;
+            if (fin) {
+                fragmented = false;
+                deliver(fragOpcode, recvBuf, fragLen);
+                fragLen = 0;
+            }
+            break;
+        case MO_WS_OP_PING:
+            appendFrame(MO_WS_OP_PONG, payload, len);
+            break;
+        case MO_WS_OP_PONG:
+            pingPending = false;
+            missedPongs = 0;
+            break;
+        case MO_WS_OP_CLOSE: {
+            uint16_t code = len >= 2 ? (uint16_t) ((payload[0] << 8) | payload[1]) : 1000;
+            MO_DBG_INFO("server closed connection (%u)", code);
+            unsigned char echo [2] = {(unsigned char) (code >> 8), (unsigned char) code};
+            appendFrame(MO_WS_OP_CLOSE, echo, sizeof(echo));
+            flush();
+            disconnect(nullptr);
+            return false;
+        }
+        default:
+            failConnection(1002, "unknown opcode");
+            return false;
+    }
+
+    if (state == State::Open && !fragmented && parsePos >= recvLen) {
+        //buffer drained. Next read starts at the front again
+        recvLen = 0;
+        parsePos = 0;
+    }
+
+    return true;
+}
+
+void WSClient::deliver(unsigned char opcode, const unsigned char *payload, size_t len) {
+    if (opcode != MO_WS_OP_TEXT) {
+        MO_DBG_WARN("ignore binary message (%zuB)", len);
+        return;
+    }
+    if (!receiveTXT) {
+        MO_DBG_WARN("no receiver");
+        return;
+    }
+    receiveTXT((const char*) payload, len);
+}
+
+void WSClient::heartbeat() {
+
+    if (pingInterval == 0) {
+        return;
+    }
+
+    auto now = mocpp_tick_ms();
+
+    if (pingPending) {
+        if (now - pingSent >= pongTimeout) {
+            pingPending = false;
+            missedPongs++;
+            MO_DBG_DEBUG("missed pong (%u)", missedPongs);
+            if (missedPongs >= 2) {
+                failConnection(1001, "heartbeat timeout");
+            }
+        }
+        return;
+    }
+
+    if (now - lastRecv >= pingInterval && now - pingSent >= pingInterval) {
+        if (appendFrame(MO_WS_OP_PING, nullptr, 0)) {
+            pingPending = true;
+            pingSent = now;
+            flush();
+        }
+    }
+}
+
+void WSClient::loop() {
+
+    auto now = mocpp_tick_ms();
+
+    switch (state) {
+        case State::Disconnected:
+            if (host.empty()) {
+                return; //not configured
+            }
+            if (!attempted || now - lastAttempt >= reconnectInterval) {
+                attempted = true;
+                lastAttempt = now;
+                MO_DBG_DEBUG("connect to %s:%s", host.c_str(), port.c_str());
+                if (!connectSocket()) {
+                    return;
+                }
+                checkConnected();
+            }
+            break;
+        case State::Connecting:
+            checkConnected();
+            break;
+        case State::TlsHandshake: {
+#if MO_ENABLE_MBEDTLS
+            int ret = mbedtls_ssl_handshake(&ssl);
+            if (ret == MBEDTLS_ERR_SSL_WANT_READ || ret == MBEDTLS_ERR_SSL_WANT_WRITE) {
+                break;
+            } else if (ret) {
+                char buf [128];
+                mbedtls_strerror(ret, buf, sizeof(buf));
+                MO_DBG_ERR("mbedtls_ssl_handshake: %i, %s", ret, buf);
+                disconnect("TLS failure");
+                break;
+            }
+
+            if (ca_cert) {
+                if (auto flags = mbedtls_ssl_get_verify_result(&ssl)) {
+                    char vrfy_buf [512];
+                    mbedtls_x509_crt_verify_info(vrfy_buf, sizeof(vrfy_buf), "   > ", flags);
+                    MO_DBG_ERR("mbedtls_ssl_get_verify_result: %s", vrfy_buf);
+                    disconnect("TLS certificate check failure");
+                    break;
+                }
+            }
+
+            mbedtls_ssl_session_free(&session);
+            mbedtls_ssl_session_init(&session);
+            sessionValid = !mbedtls_ssl_get_session(&ssl, &session);
+
+            beginUpgrade();
+#endif //MO_ENABLE_MBEDTLS
+            break;
+        }
+        case State::Upgrade:
+            processUpgrade();
+            break;
+        case State::Open:
+            break;
+    }
+
+    if (state == State::Open) {
+        flush();
+
+        //process frames until the socket has no more data or the time budget is used up
+        auto t_start = mocpp_tick_ms();
+        while (state == State::Open) {
+            if (!processFrame() && (state != State::Open || !readSocket())) {
+                break;
+            }
+            if (mocpp_tick_ms() - t_start >= MO_WS_LOOP_BUDGET_MS) {
+                break;
+            }
+        }
+
+        if (state == State::Open) {
+            flush();
+            heartbeat();
+        }
+    } else if (state != State::Disconnected && now - lastAttempt >= MO_WS_CONNECT_TIMEOUT_MS) {
+        disconnect("connect timeout");
+    }
+}
+
+bool WSClient::sendTXT(const char *msg, size_t length) {
+    if (state != State::Open) {
+        return false;
+    }
+
+    if (!appendFrame(MO_WS_OP_TEXT, (const unsigned char*) msg, length)) {
+        return false;
+    }
+
+    flush();
+    return state == State::Open;
+}
+
+void WSClient::setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) {
+    this->receiveTXT = receiveTXT;
+}
+
+unsigned long WSClient::getLastRecv() {
+    return lastRecv;
+}
+
+unsigned long WSClient::getLastConnected() {
+    return lastConnected;
+}
+
+bool WSClient::isConnected() {
+    return state == State::Open;
+}
+
+unsigned long WSClient::getNextWakeupMs() {
+
+    auto now = mocpp_tick_ms();
+    unsigned long wakeup = MO_WAKEUP_MAX_MS;
+
+    auto remaining = [now] (unsigned long since, unsigned long interval) -> unsigned long {
+        return now - since >= interval ? 0 : interval - (now - since);
+    };
+
+    switch (state) {
+        case State::Disconnected:
+            if (host.empty()) {
+                break;
+            }
+            wakeup = attempted ? remaining(lastAttempt, reconnectInterval) : 0;
+            break;
+        case State::Connecting:
+        case State::TlsHandshake:
+        case State::Upgrade:
+            wakeup = remaining(lastAttempt, MO_WS_CONNECT_TIMEOUT_MS);
+            break;
+        case State::Open:
+            if (sendOffs < sendLen || parsePos < recvLen) {
+                wakeup = 0; //unsent or unprocessed data
+            } else if (pingInterval > 0) {
+                if (pingPending) {
+                    wakeup = remaining(pingSent, pongTimeout);
+                } else {
+                    wakeup = std::max(remaining(lastRecv, pingInterval), remaining(pingSent, pingInterval));
+                }
+            }
+            break;
+    }
+
+    return std::min(wakeup, MO_WAKEUP_MAX_MS);
+}
+
+bool WSClient::waitEvent(unsigned long timeoutMs) {
+
+    int timeout = timeoutMs > (unsigned long) INT_MAX ? INT_MAX : (int) timeoutMs;
+
+    if (fd < 0) {
+        poll(nullptr, 0, timeout); //sleep
+        return false;
+    }
+
+#if MO_ENABLE_MBEDTLS
+    if (isSecure && state == State::Open && mbedtls_ssl_get_bytes_avail(&ssl) > 0) {
+        return true; //decrypted data is waiting in MbedTLS
+    }
+#endif
+
+    struct pollfd pfd;
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if (state == State::Connecting || sendOffs < sendLen) {
+        pfd.events |= POLLOUT;
+    }
+    pfd.revents = 0;
+
+    return poll(&pfd, 1, timeout) > 0;
+}
+
+void WSClient::setReconnectInterval(unsigned long reconnectIntervalMs) {
+    this->reconnectInterval = reconnectIntervalMs;
+}
+
+void WSClient::setHeartbeat(unsigned long pingIntervalMs, unsigned long pongTimeoutMs) {
+    this->pingInterval = pingIntervalMs;
+    this->pongTimeout = pongTimeoutMs;
+}
+
+} //namespace Posix
+} //namespace MicroOcpp
+
+#endif //MO_ENABLE_POSIX_WS
@@ -0,0 +1,206 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_WEBSOCKET_POSIX_H
+#define MO_WEBSOCKET_POSIX_H
+
+/*
+ * Built-in WebSocket client for POSIX hosts (ws:// and, with MbedTLS, wss://)
+ *
+ * Usage:
+ *
+ *     MicroOcpp::Posix::WSClient wsClient ("wss://example.com/ocpp", "charger001", "authorizationKey", CA_cert);
+ *     mocpp_initialize(wsClient, ChargerCredentials());
+ *
+ *     while (true) {
+ *         wsClient.waitEvent(mocpp_next_wakeup_ms()); //or add wsClient.getFd() to the host's epoll set
+ *         mocpp_loop();
+ *     }
+ *
+ * The socket is non-blocking after the DNS lookup. Received text messages are passed to MO directly from the receive
+ * buffer without copying them. Messages which the server fragments are reassembled in-place. Outgoing messages are
+ * masked while they are copied into the send buffer.
+ *
+ * The client reconnects automatically and sends a ping when the connection has been idle for the heartbeat interval.
+ * If the server doesn't answer two pings in a row, the connection counts as lost and the client reconnects.
+ */
+
+#include <MicroOcpp/Core/Connection.h>
+
+#ifndef MO_ENABLE_POSIX_WS
+#define MO_ENABLE_POSIX_WS (MO_PLATFORM == MO_PLATFORM_UNIX)
+#endif
+
+#if MO_ENABLE_POSIX_WS
+
+#include <string>
+#include <stdint.h>
+
+#if MO_ENABLE_MBEDTLS
+#include <mbedtls/net_sockets.h>
+#include <mbedtls/ssl.h>
+#include <mbedtls/entropy.h>
+#include <mbedtls/ctr_drbg.h>
+#include <mbedtls/x509_crt.h>
+#endif
+
+#ifndef MO_WS_BUFSIZE
+#define MO_WS_BUFSIZE 4096 //initial size of the receive and send buffer. They grow with larger messages up to MO_WS_MAX_MSG_SIZE
+#endif
+
+#ifndef MO_WS_MAX_MSG_SIZE
+#define MO_WS_MAX_MSG_SIZE 65536 //max. size of one message in either direction. The connection is closed if the server exceeds it
+#endif
+
+#ifndef MO_WS_LOOP_BUDGET_MS
+#define MO_WS_LOOP_BUDGET_MS 20 //max. time per loop() call to process received frames. 0 processes one frame per loop() call
+#endif
+
+#ifndef MO_WS_CONNECT_TIMEOUT_MS
+#define MO_WS_CONNECT_TIMEOUT_MS 10000 //TCP connect, TLS handshake and HTTP upgrade together
+#endif
+
+#define MO_WS_ACCEPT_SIZE 29 //Sec-WebSocket-Accept: Base64 of the SHA-1, plus terminating zero
+
+namespace MicroOcpp {
+namespace Posix {
+
+class WSClient : public Connection {
+private:
+    //URL
+    std::string host;
+    std::string port;
+    std::string path;
+    bool isSecure = false;
+    std::string auth; //Base64 of chargeBoxId:authorizationKey, or empty
+    std::string protocol;
+    const char *ca_cert = nullptr;
+
+    ReceiveTXTcallback receiveTXT;
+
+    enum class State {
+        Disconnected,
+        Connecting,
+        TlsHandshake,
+        Upgrade,
+        Open
+    };
+    State state = State::Disconnected;
+
+    int fd = -1;
+
+#if MO_ENABLE_MBEDTLS
+    mbedtls_net_context net;
+    mbedtls_entropy_context entropy;
+    mbedtls_ctr_drbg_context ctr_drbg;
+    mbedtls_ssl_config conf;
+    mbedtls_x509_crt cacert;
+    mbedtls_ssl_context ssl;
+    bool tlsConfigured = false;
+    mbedtls_ssl_session session; //resumed on reconnect
+    bool sessionValid = false;
+    bool setupTls();
+#endif
+
+    unsigned char *recvBuf = nullptr;
+    size_t recvCap = 0;
+    size_t recvLen = 0; //valid bytes in recvBuf
+    size_t parsePos = 0; //begin of the unprocessed bytes in recvBuf
+    size_t fragLen = 0; //fragments of the current message, assembled at the front of recvBuf
+    bool fragmented = false;
+    unsigned char fragOpcode = 0;
+
+    unsigned char *sendBuf = nullptr;
+    size_t sendCap = 0;
+    size_t sendLen = 0;
+    size_t sendOffs = 0;
+
+    char key [25]; //Sec-WebSocket-Key
+
+#if MO_ENABLE_MBEDTLS
+    bool rngSeeded = false; //ctr_drbg is shared by TLS, the frame masks and the handshake key
+    bool seedRng();
+#else
+    unsigned char rngBuf [64]; //buffered reads from /dev/urandom
+    size_t rngPos = sizeof(rngBuf);
+#endif
+
+    unsigned long lastRecv = 0;
+    unsigned long lastConnected = 0;
+    unsigned long lastAttempt = 0;
+    bool attempted = false;
+    unsigned long reconnectInterval = 5000;
+    unsigned long pingInterval = 15000; //0 disables the heartbeat
+    unsigned long pongTimeout = 3000;
+    unsigned int missedPongs = 0;
+    bool pingPending = false;
+    unsigned long pingSent = 0;
+
+    bool randomBytes(unsigned char *buf, size_t len); //unpredictable bytes for the frame masks and the handshake key (RFC 6455, 5.3)
+
+    bool connectSocket();
+    bool checkConnected(); //non-blocking connect() completed?
+    void disconnect(const char *reason);
+    void failConnection(uint16_t code, const char *reason); //send Close frame and disconnect
+
+    int sockSend(const unsigned char *buf, size_t len); //returns sent bytes, 0 if the socket would block, -1 on failure
+    int sockRecv(unsigned char *buf, size_t len); //returns received bytes, 0 if the socket would block, -1 on failure or EOF
+
+    bool beginUpgrade();
+    bool processUpgrade();
+
+    bool appendFrame(unsigned char opcode, const unsigned char *payload, size_t len);
+    bool flush(); //returns true if progress has been made
+    bool readSocket(); //returns true if new data has been received
+    bool processFrame(); //returns true if a frame has been processed
+    void deliver(unsigned char opcode, const unsigned char *payload, size_t len);
+    void heartbeat();
+
+public:
+    WSClient(const char *url, //e.g. "wss://example.com:8443/steve/websocket/CentralSystemService"
+            const char *chargeBoxId = nullptr, //appended to the URL path
+            const char *authorizationKey = nullptr, //HTTP Basic authentication (OCPP security profile 1 and 2)
+            const char *ca_cert = nullptr, //server certificate check for wss://. nullptr disables the check
+            const char *protocol = "ocpp1.6");
+    ~WSClient();
+
+    WSClient(const WSClient&) = delete;
+
+    void loop() override;
+
+    bool sendTXT(const char *msg, size_t length) override;
+
+    void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override;
+
+    unsigned long getLastRecv() override;
+
+    unsigned long getLastConnected() override;
+
+    bool isConnected() override;
+
+    unsigned long getNextWakeupMs() override; //time until the next reconnect attempt or heartbeat. Socket events aren't included
+
+    int getFd() {return fd;} //socket which the host can add to its epoll / poll set. -1 while disconnected
+
+    /*
+     * Block until the socket has events or until timeoutMs has elapsed, whatever comes first. Returns true if the
+     * socket has events
+     */
+    bool waitEvent(unsigned long timeoutMs);
+
+    void setReconnectInterval(unsigned long reconnectIntervalMs);
+    void setHeartbeat(unsigned long pingIntervalMs, unsigned long pongTimeoutMs); //pingIntervalMs = 0 disables the heartbeat
+};
+
+/*
+ * Expected Sec-WebSocket-Accept for the Sec-WebSocket-Key key. Writes MO_WS_ACCEPT_SIZE bytes into out
+ */
+bool makeWebSocketAccept(const char *key, char *out, size_t size);
+
+} //namespace Posix
+} //namespace MicroOcpp
+
+#endif //MO_ENABLE_POSIX_WS
+
+#endif
@@ -2,14 +2,57 @@
 // Copyright bert_qin 2023 - 2024
 
 #include <MicroOcpp/Model/Authorization/AuthorizationCache.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Platform.h>
 #include <MicroOcpp/Debug.h>
 
 #include <algorithm>
-#include <numeric>
+#include <ctype.h>
+
+#define MO_AUTHCACHE_NIL 0xFFFF
+#define MO_AUTHCACHE_EVICT_SCAN 8 // number of entries at the LRU end which are checked for expiry before eviction
+
+#define MO_AUTHCACHE_BFN "ac-"
+#define MO_AUTHCACHE_SLOT_SIZE (AUTHDATA_BINARY_SIZE + sizeof(uint32_t)) // binary record and updateNr
 
 using namespace MicroOcpp;
 
-AuthorizationCache::AuthorizationCache()
+namespace MicroOcpp
+{
+    namespace AuthorizationCacheUtils
+    {
+
+        uint32_t hashIdTag(const char *idTag)
+        {
+            // FNV-1a over case-folded characters
+            uint32_t hash = 2166136261UL;
+            for (size_t i = 0; idTag[i] != '\0' && i < IDTAG_LEN_MAX; i++)
+            {
+                hash ^= (uint32_t)tolower((unsigned char)idTag[i]);
+                hash *= 16777619UL;
+            }
+            return hash;
+        }
+
+        bool printFn(char *fn, size_t fileNr)
+        {
+            auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX MO_AUTHCACHE_BFN "%zu.bin", fileNr);
+            if (ret < 0 || ret >= MO_MAX_PATH_SIZE)
+            {
+                MO_DBG_ERR("fn error: %i", ret);
+                return false;
+            }
+            return true;
+        }
+
+    } // namespace AuthorizationCacheUtils
+} // namespace MicroOcpp
+
+using namespace MicroOcpp::AuthorizationCacheUtils;
+
+AuthorizationCache::AuthorizationCache(std::shared_ptr<FilesystemAdapter> filesystem, size_t capacity)
+    : filesystem(filesystem), capacity(std::min(capacity, (size_t)MO_AUTHCACHE_NIL - 1)),
+      lruHead(MO_AUTHCACHE_NIL), lruTail(MO_AUTHCACHE_NIL), freeHead(MO_AUTHCACHE_NIL)
 {
 }
 
@@ -17,133 +60,530 @@ AuthorizationCache::~AuthorizationCache()
 {
 }
 
-MicroOcpp::AuthorizationData *AuthorizationCache::get(const char *idTag)
+bool AuthorizationCache::allocate()
 {
-    if (!idTag)
+    if (!entries.empty())
     {
-        return nullptr;
+        return true;
     }
-    auto it = std::find_if(localAuthorizationCache.begin(), localAuthorizationCache.end(),
-                           [idTag](const AuthorizationData &data)
-                           {
-                               return strcasecmp(data.getIdTag(), idTag) == 0;
-                           });
 
-    if (it != localAuthorizationCache.end())
+    if (capacity == 0)
     {
-        return &(*it);
+        return false;
+    }
+
+    entries.resize(capacity);
+
+    // load factor at most 0.5
+    size_t nBuckets = 1;
+    while (nBuckets < 2 * capacity)
+    {
+        nBuckets <<= 1;
+    }
+    buckets.assign(nBuckets, MO_AUTHCACHE_NIL);
+
+    dirtyFiles.assign((capacity + MO_LocalAuthCacheFileSlots - 1) / MO_LocalAuthCacheFileSlots, false);
+
+    // all slots are free
+    freeHead = MO_AUTHCACHE_NIL;
+    for (size_t i = capacity; i-- > 0;)
+    {
+        entries[i].next = freeHead;
+        freeHead = (uint16_t)i;
+    }
+    lruHead = MO_AUTHCACHE_NIL;
+    lruTail = MO_AUTHCACHE_NIL;
+    count = 0;
+
+    return true;
+}
+
+int AuthorizationCache::findSlot(const char *idTag, uint32_t hash)
+{
+    if (buckets.empty())
+    {
+        return -1;
+    }
+
+    size_t mask = buckets.size() - 1;
+    for (size_t i = hash & mask;; i = (i + 1) & mask)
+    {
+        auto slot = buckets[i];
+        if (slot == MO_AUTHCACHE_NIL)
+        {
+            return -1;
+        }
+        if (entries[slot].hash == hash && !strncasecmp(entries[slot].data.getIdTag(), idTag, IDTAG_LEN_MAX))
+        {
+            return (int)slot;
+        }
+    }
+}
+
+size_t AuthorizationCache::findBucket(uint16_t slot)
+{
+    size_t mask = buckets.size() - 1;
+    size_t i = entries[slot].hash & mask;
+    while (buckets[i] != slot)
+    {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void AuthorizationCache::insertBucket(uint16_t slot)
+{
+    size_t mask = buckets.size() - 1;
+    size_t i = entries[slot].hash & mask;
+    while (buckets[i] != MO_AUTHCACHE_NIL)
+    {
+        i = (i + 1) & mask;
+    }
+    buckets[i] = slot;
+}
+
+void AuthorizationCache::removeBucket(uint16_t slot)
+{
+    size_t mask = buckets.size() - 1;
+    size_t i = findBucket(slot);
+    buckets[i] = MO_AUTHCACHE_NIL;
+
+    // shift back the following entries of the probe sequence so that lookups don't stop at the gap
+    for (size_t j = (i + 1) & mask; buckets[j] != MO_AUTHCACHE_NIL; j = (j + 1) & mask)
+    {
+        size_t home = entries[buckets[j]].hash & mask;
+        bool reachable = i <= j ? (i < home && home <= j) : (i < home || home <= j);
+        if (!reachable)
+        {
+            buckets[i] = buckets[j];
+            buckets[j] = MO_AUTHCACHE_NIL;
+            i = j;
+        }
+    }
+}
+
+void AuthorizationCache::unlinkLru(uint16_t slot)
+{
+    auto &entry = entries[slot];
+    if (entry.prev != MO_AUTHCACHE_NIL)
+    {
+        entries[entry.prev].next = entry.next;
     }
     else
     {
-        return nullptr;
+        lruHead = entry.next;
+    }
+    if (entry.next != MO_AUTHCACHE_NIL)
+    {
+        entries[entry.next].prev = entry.prev;
+    }
+    else
+    {
+        lruTail = entry.prev;
     }
 }
 
-bool AuthorizationCache::add(const char *idTag, JsonObject idTagInfo)
+void AuthorizationCache::pushLru(uint16_t slot)
 {
-    if (!idTag)
+    auto &entry = entries[slot];
+    entry.prev = MO_AUTHCACHE_NIL;
+    entry.next = lruHead;
+    if (lruHead != MO_AUTHCACHE_NIL)
     {
-        return false;
+        entries[lruHead].prev = slot;
+    }
+    lruHead = slot;
+    if (lruTail == MO_AUTHCACHE_NIL)
+    {
+        lruTail = slot;
+    }
+}
+
+void AuthorizationCache::evict(const Timestamp &now)
+{
+    // prefer expired entries close to the LRU end
+    uint16_t victim = lruTail;
+    uint16_t slot = lruTail;
+    for (size_t i = 0; i < MO_AUTHCACHE_EVICT_SCAN && slot != MO_AUTHCACHE_NIL; i++)
+    {
+        auto expiryDate = entries[slot].data.getExpiryDate();
+        if (expiryDate && *expiryDate < now)
+        {
+            victim = slot;
+            break;
+        }
+        slot = entries[slot].prev;
+    }
+
+    if (victim == MO_AUTHCACHE_NIL)
+    {
+        return;
+    }
+
+    removeBucket(victim);
+    unlinkLru(victim);
+    entries[victim].data.reset();
+    entries[victim].next = freeHead;
+    freeHead = victim;
+    count--;
+    markDirty(victim);
+}
+
+int AuthorizationCache::upsert(const char *idTag, const Timestamp &now)
+{
+    if (!idTag || idTag[0] == '\0' || !allocate())
+    {
+        return -1;
     }
-    auto it = std::find_if(localAuthorizationCache.begin(), localAuthorizationCache.end(),
-                           [idTag](const AuthorizationData &data)
-                           {
-                               return strcasecmp(data.getIdTag(), idTag) == 0;
-                           });
 
-    if (it != localAuthorizationCache.end())
+    auto hash = hashIdTag(idTag);
+    int slot = findSlot(idTag, hash);
+
+    if (slot >= 0)
     {
-        localAuthorizationCache.erase(it); // move to end
+        unlinkLru((uint16_t)slot); // move to front
     }
     else
     {
-        if (localAuthorizationCache.size() >= MO_LocalAuthCacheMaxLength)
+        if (freeHead == MO_AUTHCACHE_NIL)
         {
-            localAuthorizationCache.erase(localAuthorizationCache.begin()); // remove first
+            evict(now);
         }
+        slot = (int)freeHead;
+        freeHead = entries[slot].next;
+
+        entries[slot].hash = hash;
+        insertBucket((uint16_t)slot);
+        count++;
+    }
+
+    pushLru((uint16_t)slot);
+    entries[slot].updateNr = ++updateCounter;
+    markDirty((uint16_t)slot);
+    return slot;
+}
+
+void AuthorizationCache::markDirty(uint16_t slot)
+{
+    dirtyFiles[slot / MO_LocalAuthCacheFileSlots] = true;
+    if (!dirty)
+    {
+        dirty = true;
+        dirtySince = mocpp_tick_ms();
+    }
+}
+
+MicroOcpp::AuthorizationData *AuthorizationCache::get(const char *idTag)
+{
+    if (!idTag)
+    {
+        return nullptr;
+    }
+
+    int slot = findSlot(idTag, hashIdTag(idTag));
+    if (slot < 0)
+    {
+        return nullptr;
+    }
+
+    // move to front. The LRU order on flash is only updated by add()
+    unlinkLru((uint16_t)slot);
+    pushLru((uint16_t)slot);
+
+    return &entries[slot].data;
+}
+
+bool AuthorizationCache::add(const char *idTag, JsonObject idTagInfo, const Timestamp &now)
+{
+    int slot = upsert(idTag, now);
+    if (slot < 0)
+    {
+        return false;
     }
-    bool compact = false;
-    localAuthorizationCache.push_back(AuthorizationData());
 
-    DynamicJsonDocument doc (256);
-    JsonObject root = doc.to<JsonObject>();
-    root[AUTHDATA_KEY_IDTAG(compact)]=idTag;
-    root[AUTHDATA_KEY_IDTAGINFO]=idTagInfo;
-    localAuthorizationCache.back().readJson(root, compact);
+    entries[slot].data.readIdTagInfo(idTag, idTagInfo);
     return true;
 }
 
 bool AuthorizationCache::readJson(JsonArray authCacheJson, bool compact)
 {
-    for (size_t i = 0; i < authCacheJson.size(); i++)
+    for (JsonObject entry : authCacheJson)
     {
-
         // check if JSON object is valid
-        if (!authCacheJson[i].as<JsonObject>().containsKey(AUTHDATA_KEY_IDTAG(compact)))
+        if (!entry.containsKey(AUTHDATA_KEY_IDTAG(compact)))
         {
             return false;
         }
     }
-    if (authCacheJson.size() > MO_LocalAuthCacheMaxLength)
-    {
-        MO_DBG_WARN("localAuthCache capacity exceeded");
-        return false;
-    }
-    // apply new list
-    localAuthorizationCache.clear();
-    if (compact)
+
+    clear();
+
+    // entries are in LRU order, beginning with the least recently used
+    for (JsonObject entry : authCacheJson)
     {
-        for (size_t i = 0; i < authCacheJson.size(); i++)
+        if (!compact && !entry.containsKey(AUTHDATA_KEY_IDTAGINFO))
         {
-            localAuthorizationCache.push_back(AuthorizationData());
-            localAuthorizationCache.back().readJson(authCacheJson[i], compact);
+            continue;
         }
+
+        int slot = upsert(entry[AUTHDATA_KEY_IDTAG(compact)], MIN_TIME);
+        if (slot < 0)
+        {
+            return false;
+        }
+        entries[slot].data.readJson(entry, compact);
     }
-    else
+    return true;
+}
+
+void AuthorizationCache::release()
+{
+    entries.clear();
+    entries.shrink_to_fit();
+    buckets.clear();
+    buckets.shrink_to_fit();
+    dirtyFiles.clear();
+    lruHead = MO_AUTHCACHE_NIL;
+    lruTail = MO_AUTHCACHE_NIL;
+    freeHead = MO_AUTHCACHE_NIL;
+    count = 0;
+    updateCounter = 0;
+    dirty = false;
+}
+
+void AuthorizationCache::clear()
+{
+    release();
+
+    if (filesystem)
     {
-        for (size_t i = 0; i < authCacheJson.size(); i++)
+        FilesystemUtils::remove_if(filesystem, [](const char *fname) -> bool
+                                   { return !strncmp(fname, MO_AUTHCACHE_BFN, sizeof(MO_AUTHCACHE_BFN) - 1); });
+    }
+}
+
+bool AuthorizationCache::load()
+{
+    release();
+
+    if (!filesystem)
+    {
+        MO_DBG_WARN("no fs access");
+        return true;
+    }
+
+    bool success = true;
+
+    size_t nFiles = (capacity + MO_LocalAuthCacheFileSlots - 1) / MO_LocalAuthCacheFileSlots;
+    for (size_t fileNr = 0; fileNr < nFiles; fileNr++)
+    {
+        char fn[MO_MAX_PATH_SIZE];
+        if (!printFn(fn, fileNr))
+        {
+            return false;
+        }
+
+        size_t msize = 0;
+        if (filesystem->stat(fn, &msize) != 0)
         {
-            if (authCacheJson[i].as<JsonObject>().containsKey(AUTHDATA_KEY_IDTAGINFO))
+            continue;
+        }
+
+        size_t slotBegin = fileNr * MO_LocalAuthCacheFileSlots;
+        size_t slotEnd = std::min(capacity, slotBegin + MO_LocalAuthCacheFileSlots);
+
+        if (msize != (slotEnd - slotBegin) * MO_AUTHCACHE_SLOT_SIZE)
+        {
+            MO_DBG_ERR("invalid file size: %s", fn);
+            filesystem->remove(fn);
+            success = false;
+            continue;
+        }
+
+        auto file = filesystem->open(fn, "r");
+        if (!file || !allocate())
+        {
+            MO_DBG_ERR("could not open file: %s", fn);
+            success = false;
+            continue;
+        }
+
+        for (size_t slot = slotBegin; slot < slotEnd; slot++)
+        {
+            char buf[MO_AUTHCACHE_SLOT_SIZE];
+            if (file->read(buf, sizeof(buf)) != sizeof(buf))
+            {
+                MO_DBG_ERR("read error: %s", fn);
+                success = false;
+                break;
+            }
+
+            if (buf[0] == '\0')
+            {
+                continue; // empty slot
+            }
+
+            auto &entry = entries[slot];
+            entry.data.readBinary(buf);
+            entry.hash = hashIdTag(entry.data.getIdTag());
+            memcpy(&entry.updateNr, buf + AUTHDATA_BINARY_SIZE, sizeof(uint32_t));
+
+            if (findSlot(entry.data.getIdTag(), entry.hash) >= 0)
             {
-                localAuthorizationCache.push_back(AuthorizationData());
-                localAuthorizationCache.back().readJson(authCacheJson[i], compact);
+                entry.data.reset(); // duplicate
+                continue;
             }
+
+            insertBucket((uint16_t)slot);
+            updateCounter = std::max(updateCounter, entry.updateNr);
+            count++;
         }
     }
-    localAuthorizationCache.erase(std::remove_if(localAuthorizationCache.begin(), localAuthorizationCache.end(),
-                                                 [](const AuthorizationData &elem)
-                                                 {
-                                                     return elem.getIdTag()[0] == '\0'; //"" means no idTag --> marked for removal
-                                                 }),
-                                  localAuthorizationCache.end());
-    return true;
+
+    if (entries.empty())
+    {
+        return success;
+    }
+
+    // rebuild free list and restore LRU order
+    std::vector<uint16_t> used;
+    used.reserve(count);
+    freeHead = MO_AUTHCACHE_NIL;
+    for (size_t i = capacity; i-- > 0;)
+    {
+        if (entries[i].data.getIdTag()[0] == '\0')
+        {
+            entries[i].next = freeHead;
+            freeHead = (uint16_t)i;
+        }
+        else
+        {
+            used.push_back((uint16_t)i);
+        }
+    }
+
+    std::sort(used.begin(), used.end(), [this](uint16_t lhs, uint16_t rhs)
+              { return entries[lhs].updateNr < entries[rhs].updateNr; });
+
+    for (auto slot : used)
+    {
+        pushLru(slot);
+    }
+
+    MO_DBG_DEBUG("loaded auth cache: %zu entries", count);
+    return success;
 }
 
-void AuthorizationCache::clear()
+bool AuthorizationCache::storeFile(size_t fileNr)
 {
-    localAuthorizationCache.clear();
+    char fn[MO_MAX_PATH_SIZE];
+    if (!printFn(fn, fileNr))
+    {
+        return false;
+    }
+
+    size_t slotBegin = fileNr * MO_LocalAuthCacheFileSlots;
+    size_t slotEnd = std::min(capacity, slotBegin + MO_LocalAuthCacheFileSlots);
+
+    bool empty = true;
+    for (size_t slot = slotBegin; slot < slotEnd; slot++)
+    {
+        if (entries[slot].data.getIdTag()[0] != '\0')
+        {
+            empty = false;
+            break;
+        }
+    }
+
+    if (empty)
+    {
+        size_t msize = 0;
+        if (filesystem->stat(fn, &msize) == 0)
+        {
+            return filesystem->remove(fn);
+        }
+        return true;
+    }
+
+    auto file = filesystem->open(fn, "w");
+    if (!file)
+    {
+        MO_DBG_ERR("could not open file: %s", fn);
+        return false;
+    }
+
+    for (size_t slot = slotBegin; slot < slotEnd; slot++)
+    {
+        char buf[MO_AUTHCACHE_SLOT_SIZE];
+        entries[slot].data.writeBinary(buf);
+        memcpy(buf + AUTHDATA_BINARY_SIZE, &entries[slot].updateNr, sizeof(uint32_t));
+        if (file->write(buf, sizeof(buf)) != sizeof(buf))
+        {
+            MO_DBG_ERR("file write error: %s", fn);
+            file.reset();
+            filesystem->remove(fn);
+            return false;
+        }
+    }
+
+    return true;
 }
 
-size_t AuthorizationCache::getJsonCapacity()
+bool AuthorizationCache::flush()
 {
-    size_t res = JSON_ARRAY_SIZE(localAuthorizationCache.size());
-    for (auto &entry : localAuthorizationCache)
+    if (!dirty)
     {
-        res += entry.getJsonCapacity();
+        return true;
     }
-    return res;
+
+    if (!filesystem)
+    {
+        std::fill(dirtyFiles.begin(), dirtyFiles.end(), false);
+        dirty = false;
+        return true;
+    }
+
+    bool success = true;
+    for (size_t fileNr = 0; fileNr < dirtyFiles.size(); fileNr++)
+    {
+        if (dirtyFiles[fileNr])
+        {
+            if (storeFile(fileNr))
+            {
+                dirtyFiles[fileNr] = false;
+            }
+            else
+            {
+                success = false; //keep file dirty and retry with the next flush
+            }
+        }
+    }
+
+    if (!success)
+    {
+        dirtySince = mocpp_tick_ms(); //wait for another write delay before retrying
+    }
+
+    dirty = !success;
+    return success;
 }
 
-void AuthorizationCache::writeJson(JsonArray authCacheOut, bool compact)
+unsigned long AuthorizationCache::getWriteBehindMs()
 {
-    for (auto &entry : localAuthorizationCache)
+    if (!dirty)
+    {
+        return MO_WAKEUP_MAX_MS;
+    }
+
+    unsigned long elapsed = mocpp_tick_ms() - dirtySince;
+    if (elapsed >= MO_LocalAuthCacheWriteDelay)
     {
-        JsonObject entryJson = authCacheOut.createNestedObject();
-        entry.writeJson(entryJson, compact);
+        return 0;
     }
+    return std::min((unsigned long)MO_LocalAuthCacheWriteDelay - elapsed, (unsigned long)MO_WAKEUP_MAX_MS);
 }
 
 size_t AuthorizationCache::size()
 {
-    return localAuthorizationCache.size();
+    return count;
 }
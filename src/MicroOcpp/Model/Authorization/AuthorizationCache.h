@@ -6,32 +6,86 @@
 #define AUTHORIZATIONCACHE_H
 
 #include <MicroOcpp/Model/Authorization/AuthorizationData.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <vector>
 
 #ifndef MO_LocalAuthCacheMaxLength
-#define MO_LocalAuthCacheMaxLength 8
+#define MO_LocalAuthCacheMaxLength 8 // max number of cached idTags. Supports up to a few thousand
+#endif
+
+#ifndef MO_LocalAuthCacheFileSlots
+#define MO_LocalAuthCacheFileSlots 32 // number of cache slots which are stored together in one file
+#endif
+
+#ifndef MO_LocalAuthCacheWriteDelay
+#define MO_LocalAuthCacheWriteDelay 5000 // ms after the first change until the changed slots are written to flash
 #endif
 
 namespace MicroOcpp
 {
 
+    /*
+     * Fixed-capacity cache of idTagInfos. The slots are indexed by an open addressing hash table over the
+     * case-folded idTag and linked in LRU order. When the cache is full, an expired entry near the LRU end is
+     * evicted first, otherwise the least recently used one.
+     *
+     * Changes are written behind: add() only marks the slot as changed and flush() writes the files with changed
+     * slots. Each file holds MO_LocalAuthCacheFileSlots fixed-length slots.
+     */
     class AuthorizationCache
     {
     private:
-        std::vector<AuthorizationData> localAuthorizationCache;
+        struct Entry
+        {
+            AuthorizationData data;
+            uint32_t hash = 0;
+            uint32_t updateNr = 0; // order of updates; persisted to restore the LRU order after reboot
+            uint16_t prev;         // LRU links, or free list if unused
+            uint16_t next;
+        };
+
+        std::shared_ptr<FilesystemAdapter> filesystem;
+        const size_t capacity;
+
+        std::vector<Entry> entries;    // slots, allocated on first use
+        std::vector<uint16_t> buckets; // hash table of slot indices. Size is a power of 2
+
+        uint16_t lruHead; // most recently used
+        uint16_t lruTail; // least recently used
+        uint16_t freeHead;
+        size_t count = 0;
+        uint32_t updateCounter = 0;
+
+        std::vector<bool> dirtyFiles;
+        bool dirty = false;
+        unsigned long dirtySince = 0;
+
+        bool allocate();
+        int findSlot(const char *idTag, uint32_t hash); // returns -1 if not found
+        size_t findBucket(uint16_t slot);
+        void insertBucket(uint16_t slot);
+        void removeBucket(uint16_t slot);
+        void unlinkLru(uint16_t slot);
+        void pushLru(uint16_t slot);
+        void evict(const Timestamp &now);
+        int upsert(const char *idTag, const Timestamp &now); // returns slot of idTag, or -1 on failure
+        void markDirty(uint16_t slot);
+        bool storeFile(size_t fileNr);
+        void release(); // drop all entries from RAM
 
     public:
-        AuthorizationCache();
+        AuthorizationCache(std::shared_ptr<FilesystemAdapter> filesystem = nullptr, size_t capacity = MO_LocalAuthCacheMaxLength);
         ~AuthorizationCache();
 
         AuthorizationData *get(const char *idTag);
 
-        bool add(const char *idTag, JsonObject idTagInfo);
-        bool readJson(JsonArray localAuthorizationCache, bool compact = false); // compact: if true, then use compact non-ocpp representation
+        bool add(const char *idTag, JsonObject idTagInfo, const Timestamp &now); // now: determines expired entries
+        bool readJson(JsonArray localAuthorizationCache, bool compact = false); // imports JSON cache; compact: if true, then use compact non-ocpp representation
         void clear();
 
-        size_t getJsonCapacity();
-        void writeJson(JsonArray authCacheOut, bool compact = false);
+        bool load();  // restore cache from flash
+        bool flush(); // write changed slots to flash
+        unsigned long getWriteBehindMs(); // ms until flush() is due, MO_WAKEUP_MAX_MS if nothing changed
 
         size_t size(); // used in unit tests
     };
@@ -32,13 +32,6 @@ AuthorizationData& AuthorizationData::operator=(AuthorizationData&& other) {
 }
 
 void AuthorizationData::readJson(JsonObject entry, bool compact) {
-    if (entry.containsKey(AUTHDATA_KEY_IDTAG(compact))) {
-        strncpy(idTag, entry[AUTHDATA_KEY_IDTAG(compact)], IDTAG_LEN_MAX + 1);
-        idTag[IDTAG_LEN_MAX] = '\0';
-    } else {
-        idTag[0] = '\0';
-    }
-
     JsonObject idTagInfo;
     if (compact){
         idTagInfo = entry;
@@ -46,8 +39,21 @@ void AuthorizationData::readJson(JsonObject entry, bool compact) {
         idTagInfo = entry[AUTHDATA_KEY_IDTAGINFO];
     }
 
+    readIdTagInfo(entry[AUTHDATA_KEY_IDTAG(compact)], idTagInfo, compact);
+}
+
+void AuthorizationData::readIdTagInfo(const char *idTag, JsonObject idTagInfo, bool compact) {
+    if (idTag) {
+        strncpy(this->idTag, idTag, IDTAG_LEN_MAX + 1);
+        this->idTag[IDTAG_LEN_MAX] = '\0';
+    } else {
+        this->idTag[0] = '\0';
+    }
+
     if (idTagInfo.containsKey(AUTHDATA_KEY_EXPIRYDATE(compact))) {
-        expiryDate = std::unique_ptr<Timestamp>(new Timestamp());
+        if (!expiryDate) {
+            expiryDate = std::unique_ptr<Timestamp>(new Timestamp());
+        }
         if (!expiryDate->setTime(idTagInfo[AUTHDATA_KEY_EXPIRYDATE(compact)])) {
             expiryDate.reset();
         }
@@ -56,7 +62,9 @@ void AuthorizationData::readJson(JsonObject entry, bool compact) {
     }
 
     if (idTagInfo.containsKey(AUTHDATA_KEY_PARENTIDTAG(compact))) {
-        parentIdTag = std::unique_ptr<char[]>(new char[IDTAG_LEN_MAX + 1]);
+        if (!parentIdTag) {
+            parentIdTag = std::unique_ptr<char[]>(new char[IDTAG_LEN_MAX + 1]);
+        }
         strncpy(parentIdTag.get(), idTagInfo[AUTHDATA_KEY_PARENTIDTAG(compact)], IDTAG_LEN_MAX + 1);
         parentIdTag.get()[IDTAG_LEN_MAX] = '\0';
     } else {
@@ -116,6 +124,67 @@ void AuthorizationData::writeJson(JsonObject& entry, bool compact) {
     }
 }
 
+#define AUTHDATA_BINARY_PARENTIDTAG (IDTAG_LEN_MAX + 1)
+#define AUTHDATA_BINARY_STATUS      (2 * (IDTAG_LEN_MAX + 1))
+#define AUTHDATA_BINARY_FLAGS       (AUTHDATA_BINARY_STATUS + 1)
+#define AUTHDATA_BINARY_EXPIRYDATE  (AUTHDATA_BINARY_FLAGS + 1)
+
+#define AUTHDATA_BINARY_FLAG_EXPIRYDATE 0x01
+
+static_assert(AUTHDATA_BINARY_EXPIRYDATE + sizeof(int32_t) <= AUTHDATA_BINARY_SIZE, "AUTHDATA_BINARY_SIZE too small");
+
+void AuthorizationData::readBinary(const char *record) {
+    strncpy(idTag, record, IDTAG_LEN_MAX + 1);
+    idTag[IDTAG_LEN_MAX] = '\0';
+
+    if (record[AUTHDATA_BINARY_PARENTIDTAG] != '\0') {
+        if (!parentIdTag) {
+            parentIdTag = std::unique_ptr<char[]>(new char[IDTAG_LEN_MAX + 1]);
+        }
+        strncpy(parentIdTag.get(), record + AUTHDATA_BINARY_PARENTIDTAG, IDTAG_LEN_MAX + 1);
+        parentIdTag.get()[IDTAG_LEN_MAX] = '\0';
+    } else {
+        parentIdTag.reset();
+    }
+
+    auto statusRaw = (uint8_t) record[AUTHDATA_BINARY_STATUS];
+    if (statusRaw <= (uint8_t) AuthorizationStatus::UNDEFINED) {
+        status = (AuthorizationStatus) statusRaw;
+    } else {
+        status = AuthorizationStatus::UNDEFINED;
+    }
+
+    if (record[AUTHDATA_BINARY_FLAGS] & AUTHDATA_BINARY_FLAG_EXPIRYDATE) {
+        int32_t secs;
+        memcpy(&secs, record + AUTHDATA_BINARY_EXPIRYDATE, sizeof(secs));
+        if (!expiryDate) {
+            expiryDate = std::unique_ptr<Timestamp>(new Timestamp());
+        }
+        *expiryDate = MIN_TIME;
+        *expiryDate += (int) secs;
+    } else {
+        expiryDate.reset();
+    }
+}
+
+void AuthorizationData::writeBinary(char *record) const {
+    memset(record, 0, AUTHDATA_BINARY_SIZE);
+
+    strncpy(record, idTag, IDTAG_LEN_MAX + 1);
+
+    if (parentIdTag) {
+        strncpy(record + AUTHDATA_BINARY_PARENTIDTAG, parentIdTag.get(), IDTAG_LEN_MAX + 1);
+    }
+
+    record[AUTHDATA_BINARY_STATUS] = (char) status;
+
+    if (expiryDate) {
+        record[AUTHDATA_BINARY_FLAGS] |= AUTHDATA_BINARY_FLAG_EXPIRYDATE;
+        int32_t secs = (int32_t) (*expiryDate - MIN_TIME);
+        memcpy(record + AUTHDATA_BINARY_EXPIRYDATE, &secs, sizeof(secs));
+    }
+}
+
 void AuthorizationData::reset() {
     idTag[0] = '\0';
 }
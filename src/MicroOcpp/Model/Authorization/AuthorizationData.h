@@ -33,6 +33,16 @@ enum class AuthorizationStatus : uint8_t {
 
 #define AUTHORIZATIONSTATUS_LEN_MAX (sizeof("ConcurrentTx") - 1) //max length of serialized AuthStatus
 
+/*
+ * Fixed-length binary record of an AuthorizationData entry for the paged local list (see readBinary and writeBinary):
+ *     [0, 21)  idTag
+ *     [21, 42) parentIdTag ("" if absent)
+ *     [42]     AuthorizationStatus
+ *     [43]     flags (bit 0: expiryDate present)
+ *     [44, 48) expiryDate as seconds since MIN_TIME (int32 in native byte order)
+ */
+#define AUTHDATA_BINARY_SIZE 48
+
 const char *serializeAuthorizationStatus(AuthorizationStatus status);
 AuthorizationStatus deserializeAuthorizationStatus(const char *cstr);
 
@@ -54,10 +64,14 @@ public:
     AuthorizationData& operator=(AuthorizationData&& other);
 
     void readJson(JsonObject entry, bool compact = false); //compact: compressed representation for flash storage
+    void readIdTagInfo(const char *idTag, JsonObject idTagInfo, bool compact = false); //like readJson, but with separate idTag
 
     size_t getJsonCapacity() const;
     void writeJson(JsonObject& entry, bool compact = false); //compact: compressed representation for flash storage
 
+    void readBinary(const char *record); //record: AUTHDATA_BINARY_SIZE bytes
+    void writeBinary(char *record) const;
+
     const char *getIdTag() const {return idTag;}
     Timestamp *getExpiryDate() const {return expiryDate.get();}
     const char *getParentIdTag() const {return parentIdTag.get();}
@@ -10,11 +10,10 @@
 #include <MicroOcpp/Debug.h>
 
 #include <algorithm>
-#include <numeric>
 
 using namespace MicroOcpp;
 
-AuthorizationList::AuthorizationList() {
+AuthorizationList::AuthorizationList(size_t maxSize) : maxSize(maxSize) {
 
 }
 
@@ -45,126 +44,140 @@ MicroOcpp::AuthorizationData *AuthorizationList::get(const char *idTag) {
     return nullptr;
 }
 
-bool AuthorizationList::readJson(JsonArray authlistJson, int listVersion, bool differential, bool compact) {
-
-    if (compact) {
-        //compact representations don't contain remove commands
-        differential = false;
-    }
+bool MicroOcpp::sortAuthListUpdate(JsonArray authlistJson, AuthListUpdate& out, bool compact) {
+    out.clear();
+    out.reserve(authlistJson.size());
 
-    for (size_t i = 0; i < authlistJson.size(); i++) {
+    for (JsonObject entry : authlistJson) {
+        const char *idTag = entry[AUTHDATA_KEY_IDTAG(compact)];
 
         //check if JSON object is valid
-        if (!authlistJson[i].as<JsonObject>().containsKey(AUTHDATA_KEY_IDTAG(compact))) {
+        if (!idTag) {
             return false;
         }
+
+        out.emplace_back(idTag, entry);
     }
 
-    std::vector<int> authlist_index;
-    std::vector<int> remove_list;
+    std::stable_sort(out.begin(), out.end(),
+            [] (const AuthListUpdate::value_type& lhs, const AuthListUpdate::value_type& rhs) {
+                return strcasecmp(lhs.first, rhs.first) < 0;
+            });
 
-    unsigned int resultingListLength = 0;
+    //if an idTag occurs multiple times, then the last occurrence counts
+    size_t uniqueSize = 0;
+    for (size_t i = 0; i < out.size(); i++) {
+        if (uniqueSize > 0 && !strcasecmp(out[uniqueSize - 1].first, out[i].first)) {
+            out[uniqueSize - 1] = out[i];
+        } else {
+            out[uniqueSize++] = out[i];
+        }
+    }
+    out.resize(uniqueSize);
 
-    if (!differential) {
-        //every entry will insert an idTag
-        resultingListLength = authlistJson.size();
-    } else {
-        //update type is differential; only unkown entries will insert an idTag
+    return true;
+}
 
-        resultingListLength = localAuthorizationList.size();
+bool AuthorizationList::readJson(JsonArray authlistJson, int listVersion, bool differential, bool compact) {
 
-        //also, build index here
-        authlist_index = std::vector<int>(authlistJson.size(), -1);
+    if (compact) {
+        //compact representations don't contain remove commands
+        differential = false;
+    }
 
-        for (size_t i = 0; i < authlistJson.size(); i++) {
+    AuthListUpdate entries;
+    if (!sortAuthListUpdate(authlistJson, entries, compact)) {
+        return false;
+    }
 
-            //check if locally stored auth info is present; if yes, apply it to the index
-            AuthorizationData *found = get(authlistJson[i][AUTHDATA_KEY_IDTAG(compact)]);
+    //entries with idTagInfo insert or update an idTag, entries without remove it (differential) or are ignored (full)
+    auto isUpsert = [compact] (JsonObject entry) {
+        return compact || entry.containsKey(AUTHDATA_KEY_IDTAGINFO);
+    };
 
-            if (found) {
+    //both lists are sorted now, so all further steps are linear merges
 
-                authlist_index[i] = (int) (found - localAuthorizationList.data());
+    size_t resultingListLength = 0;
 
-                //remove or update?
-                if (!authlistJson[i].as<JsonObject>().containsKey(AUTHDATA_KEY_IDTAGINFO)) {
-                    //this entry should be removed
-                    found->reset(); //mark for deletion
-                    remove_list.push_back((int) (found - localAuthorizationList.data()));
-                    resultingListLength--;
-                } //else: this entry should be updated
-            } else {
-                //insert or ignore?
-                if (authlistJson[i].as<JsonObject>().containsKey(AUTHDATA_KEY_IDTAGINFO)) {
-                    //add
-                    resultingListLength++;
-                } //else: ignore
+    if (!differential) {
+        for (auto& entry : entries) {
+            if (isUpsert(entry.second)) {
+                resultingListLength++;
+            }
+        }
+    } else {
+        resultingListLength = localAuthorizationList.size();
+
+        size_t r = 0;
+        for (auto& entry : entries) {
+            while (r < localAuthorizationList.size() && strcasecmp(localAuthorizationList[r].getIdTag(), entry.first) < 0) {
+                r++;
+            }
+            bool exists = r < localAuthorizationList.size() && !strcasecmp(localAuthorizationList[r].getIdTag(), entry.first);
+
+            if (exists && !isUpsert(entry.second)) {
+                resultingListLength--;
+            } else if (!exists && isUpsert(entry.second)) {
+                resultingListLength++;
             }
         }
     }
 
-    if (resultingListLength > MO_LocalAuthListMaxLength) {
+    if (resultingListLength > maxSize) {
         MO_DBG_WARN("localAuthList capacity exceeded");
         return false;
     }
 
-    //apply new list
-
-    if (compact) {
-        localAuthorizationList.clear();
+    //apply new list. Move the existing entries over to reuse their allocations
 
-        for (size_t i = 0; i < authlistJson.size(); i++) {
-            localAuthorizationList.push_back(AuthorizationData());
-            localAuthorizationList.back().readJson(authlistJson[i], compact);
-        }
-    } else if (differential) {
+    std::vector<AuthorizationData> merged;
+    merged.reserve(resultingListLength);
 
-        for (size_t i = 0; i < authlistJson.size(); i++) {
+    size_t r = 0;
 
-            //is entry a remove command?
-            if (!authlistJson[i].as<JsonObject>().containsKey(AUTHDATA_KEY_IDTAGINFO)) {
-                continue; //yes, remove command, will be deleted afterwards
+    if (!differential) {
+        for (auto& entry : entries) {
+            if (!isUpsert(entry.second)) {
+                continue;
             }
 
-            //update, or insert
+            if (r < localAuthorizationList.size()) {
+                merged.push_back(std::move(localAuthorizationList[r++]));
+            } else {
+                merged.emplace_back();
+            }
+            merged.back().readJson(entry.second, compact);
+        }
+    } else {
+        for (auto& entry : entries) {
 
-            if (authlist_index[i] < 0) {
-                //auth list does not contain idTag yet -> insert new entry
+            //keep preceding entries
+            while (r < localAuthorizationList.size() && strcasecmp(localAuthorizationList[r].getIdTag(), entry.first) < 0) {
+                merged.push_back(std::move(localAuthorizationList[r++]));
+            }
+            bool exists = r < localAuthorizationList.size() && !strcasecmp(localAuthorizationList[r].getIdTag(), entry.first);
 
-                //reuse removed AuthData object?
-                if (!remove_list.empty()) {
-                    //yes, reuse
-                    authlist_index[i] = remove_list.back();
-                    remove_list.pop_back();
+            if (isUpsert(entry.second)) {
+                //update, or insert
+                if (exists) {
+                    merged.push_back(std::move(localAuthorizationList[r++]));
                 } else {
-                    //no, create new
-                    authlist_index[i] = localAuthorizationList.size();
-                    localAuthorizationList.push_back(AuthorizationData());
+                    merged.emplace_back();
                 }
+                merged.back().readJson(entry.second, compact);
+            } else if (exists) {
+                //remove
+                r++;
             }
-
-            localAuthorizationList[authlist_index[i]].readJson(authlistJson[i], compact);
         }
 
-    } else {
-        localAuthorizationList.clear();
-
-        for (size_t i = 0; i < authlistJson.size(); i++) {
-            if (authlistJson[i].as<JsonObject>().containsKey(AUTHDATA_KEY_IDTAGINFO)) {
-                localAuthorizationList.push_back(AuthorizationData());
-                localAuthorizationList.back().readJson(authlistJson[i], compact);
-            }
+        //keep remaining entries
+        while (r < localAuthorizationList.size()) {
+            merged.push_back(std::move(localAuthorizationList[r++]));
         }
     }
 
-    localAuthorizationList.erase(std::remove_if(localAuthorizationList.begin(), localAuthorizationList.end(),
-            [] (const AuthorizationData& elem) {
-                return elem.getIdTag()[0] == '\0'; //"" means no idTag --> marked for removal
-            }), localAuthorizationList.end());
-
-    std::sort(localAuthorizationList.begin(), localAuthorizationList.end(),
-            [] (const AuthorizationData& lhs, const AuthorizationData& rhs) {
-                return strcasecmp(lhs.getIdTag(), rhs.getIdTag()) < 0;
-            });
+    localAuthorizationList = std::move(merged);
     
     this->listVersion = listVersion;
 
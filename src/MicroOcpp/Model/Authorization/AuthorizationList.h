@@ -12,22 +12,47 @@
 #include <MicroOcpp/Model/Authorization/AuthorizationData.h>
 #include <vector>
 
+/*
+ * Store the local authorization list in page files on the flash instead of the RAM (see AuthorizationListPaged.h).
+ * Recommended for lists with more than a few hundred entries
+ */
+#ifndef MO_ENABLE_LOCAL_AUTH_PAGED
+#define MO_ENABLE_LOCAL_AUTH_PAGED 0
+#endif
+
 #ifndef MO_LocalAuthListMaxLength
+#if MO_ENABLE_LOCAL_AUTH_PAGED
+#define MO_LocalAuthListMaxLength 100000
+#else
 #define MO_LocalAuthListMaxLength 48
 #endif
+#endif
 
 #ifndef MO_SendLocalListMaxLength
+#if MO_ENABLE_LOCAL_AUTH_PAGED
+#define MO_SendLocalListMaxLength 500
+#else
 #define MO_SendLocalListMaxLength MO_LocalAuthListMaxLength
 #endif
+#endif
 
 namespace MicroOcpp {
 
+using AuthListUpdate = std::vector<std::pair<const char*, JsonObject>>; //idTag and JSON entry of a list update
+
+/*
+ * Collects the entries of a list update sorted by idTag. If an idTag occurs multiple times, then the last
+ * occurrence counts. Returns false if an entry has no idTag
+ */
+bool sortAuthListUpdate(JsonArray authlistJson, AuthListUpdate& out, bool compact = false);
+
 class AuthorizationList {
 private:
+    const size_t maxSize;
     int listVersion = 0;
     std::vector<AuthorizationData> localAuthorizationList; //sorted list
 public:
-    AuthorizationList();
+    AuthorizationList(size_t maxSize = MO_LocalAuthListMaxLength);
     ~AuthorizationList();
 
     AuthorizationData *get(const char *idTag);
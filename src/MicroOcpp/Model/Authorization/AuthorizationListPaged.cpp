@@ -0,0 +1,640 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Version.h>
+
+#if MO_ENABLE_LOCAL_AUTH
+
+#include <MicroOcpp/Model/Authorization/AuthorizationListPaged.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Debug.h>
+
+#include <algorithm>
+
+#define MO_LOCALAUTHLIST_PAGED_BFN "la-"
+#define MO_LOCALAUTHLIST_INDEX_FN (MO_FILENAME_PREFIX MO_LOCALAUTHLIST_PAGED_BFN "idx.bin")
+
+#define MO_LOCALAUTHLIST_INDEX_MAGIC "MOla"
+#define MO_LOCALAUTHLIST_INDEX_HEADER_SIZE 16 //magic, listVersion, listSize, pageCount
+#define MO_LOCALAUTHLIST_INDEX_ENTRY_SIZE (IDTAG_LEN_MAX + 1 + 2 * sizeof(uint16_t)) //firstIdTag, fileId, size
+
+using namespace MicroOcpp;
+
+namespace MicroOcpp {
+namespace AuthorizationListPagedUtils {
+
+bool printPageFn(char *fn, uint16_t fileId) {
+    auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX MO_LOCALAUTHLIST_PAGED_BFN "%u.bin", (unsigned int) fileId);
+    if (ret < 0 || ret >= MO_MAX_PATH_SIZE) {
+        MO_DBG_ERR("fn error: %i", ret);
+        return false;
+    }
+    return true;
+}
+
+} //end namespace AuthorizationListPagedUtils
+} //end namespace MicroOcpp
+
+using namespace MicroOcpp::AuthorizationListPagedUtils;
+
+AuthorizationListPaged::AuthorizationListPaged(std::shared_ptr<FilesystemAdapter> filesystem, size_t maxSize) : filesystem(filesystem), maxSize(maxSize) {
+
+}
+
+AuthorizationListPaged::~AuthorizationListPaged() {
+
+}
+
+bool AuthorizationListPaged::load() {
+    listVersion = 0;
+    listSize = 0;
+    pageIndex.clear();
+    nextFileId = 0;
+    for (auto& entry : pageCache) {
+        entry.fileId = -1;
+    }
+
+    if (!filesystem) {
+        MO_DBG_WARN("no fs access");
+        return true;
+    }
+
+    size_t msize = 0;
+    if (filesystem->stat(MO_LOCALAUTHLIST_INDEX_FN, &msize) != 0) {
+        MO_DBG_DEBUG("no local authorization list stored already");
+        clear(); //collect pages of an interrupted update
+        return true;
+    }
+
+    auto file = filesystem->open(MO_LOCALAUTHLIST_INDEX_FN, "r");
+    if (!file) {
+        MO_DBG_ERR("could not open file: %s", MO_LOCALAUTHLIST_INDEX_FN);
+        return false;
+    }
+
+    char header [MO_LOCALAUTHLIST_INDEX_HEADER_SIZE];
+    if (msize < sizeof(header) ||
+            file->read(header, sizeof(header)) != sizeof(header) ||
+            strncmp(header, MO_LOCALAUTHLIST_INDEX_MAGIC, 4)) {
+        MO_DBG_ERR("invalid index: %s", MO_LOCALAUTHLIST_INDEX_FN);
+        file.reset();
+        clear();
+        return false;
+    }
+
+    int32_t listVersionRaw;
+    uint32_t listSizeRaw, pageCount;
+    memcpy(&listVersionRaw, header + 4, sizeof(int32_t));
+    memcpy(&listSizeRaw, header + 8, sizeof(uint32_t));
+    memcpy(&pageCount, header + 12, sizeof(uint32_t));
+
+    if (msize != MO_LOCALAUTHLIST_INDEX_HEADER_SIZE + pageCount * MO_LOCALAUTHLIST_INDEX_ENTRY_SIZE) {
+        MO_DBG_ERR("invalid index size: %zu", msize);
+        file.reset();
+        clear();
+        return false;
+    }
+
+    pageIndex.reserve(pageCount);
+
+    size_t checkSize = 0;
+    for (uint32_t i = 0; i < pageCount; i++) {
+        char buf [MO_LOCALAUTHLIST_INDEX_ENTRY_SIZE];
+        if (file->read(buf, sizeof(buf)) != sizeof(buf)) {
+            MO_DBG_ERR("read error: %s", MO_LOCALAUTHLIST_INDEX_FN);
+            file.reset();
+            clear();
+            return false;
+        }
+
+        PageIndexEntry page;
+        memcpy(page.firstIdTag, buf, IDTAG_LEN_MAX + 1);
+        page.firstIdTag[IDTAG_LEN_MAX] = '\0';
+        memcpy(&page.fileId, buf + IDTAG_LEN_MAX + 1, sizeof(uint16_t));
+        memcpy(&page.size, buf + IDTAG_LEN_MAX + 1 + sizeof(uint16_t), sizeof(uint16_t));
+
+        if (page.size == 0 || page.size > MO_LocalAuthListPageSize) {
+            MO_DBG_ERR("invalid page size: %u", (unsigned int) page.size);
+            file.reset();
+            clear();
+            return false;
+        }
+
+        checkSize += page.size;
+        nextFileId = std::max(nextFileId, (uint16_t) (page.fileId + 1));
+        pageIndex.push_back(page);
+    }
+
+    if (checkSize != listSizeRaw) {
+        MO_DBG_ERR("inconsistent index: %zu vs %u", checkSize, (unsigned int) listSizeRaw);
+        file.reset();
+        clear();
+        return false;
+    }
+
+    listVersion = (int) listVersionRaw;
+    listSize = (size_t) listSizeRaw;
+
+    MO_DBG_DEBUG("loaded local authorization list: %zu entries in %zu pages", listSize, pageIndex.size());
+    return true;
+}
+
+bool AuthorizationListPaged::storeIndex() {
+    auto file = filesystem->open(MO_LOCALAUTHLIST_INDEX_FN, "w");
+    if (!file) {
+        MO_DBG_ERR("could not open file: %s", MO_LOCALAUTHLIST_INDEX_FN);
+        return false;
+    }
+
+    char header [MO_LOCALAUTHLIST_INDEX_HEADER_SIZE];
+    int32_t listVersionRaw = (int32_t) listVersion;
+    uint32_t listSizeRaw = (uint32_t) listSize;
+    uint32_t pageCount = (uint32_t) pageIndex.size();
+    memcpy(header, MO_LOCALAUTHLIST_INDEX_MAGIC, 4);
+    memcpy(header + 4, &listVersionRaw, sizeof(int32_t));
+    memcpy(header + 8, &listSizeRaw, sizeof(uint32_t));
+    memcpy(header + 12, &pageCount, sizeof(uint32_t));
+
+    bool success = file->write(header, sizeof(header)) == sizeof(header);
+
+    for (size_t i = 0; success && i < pageIndex.size(); i++) {
+        char buf [MO_LOCALAUTHLIST_INDEX_ENTRY_SIZE];
+        memcpy(buf, pageIndex[i].firstIdTag, IDTAG_LEN_MAX + 1);
+        memcpy(buf + IDTAG_LEN_MAX + 1, &pageIndex[i].fileId, sizeof(uint16_t));
+        memcpy(buf + IDTAG_LEN_MAX + 1 + sizeof(uint16_t), &pageIndex[i].size, sizeof(uint16_t));
+        success = file->write(buf, sizeof(buf)) == sizeof(buf);
+    }
+
+    if (!success) {
+        MO_DBG_ERR("file write error: %s", MO_LOCALAUTHLIST_INDEX_FN);
+        file.reset();
+        filesystem->remove(MO_LOCALAUTHLIST_INDEX_FN);
+        return false;
+    }
+
+    return true;
+}
+
+bool AuthorizationListPaged::removeIndex() {
+    size_t msize = 0;
+    if (filesystem->stat(MO_LOCALAUTHLIST_INDEX_FN, &msize) != 0) {
+        return true; //nothing to do
+    }
+    return filesystem->remove(MO_LOCALAUTHLIST_INDEX_FN);
+}
+
+size_t AuthorizationListPaged::findPage(const char *idTag) {
+    //binary search for the first page which begins after idTag
+    size_t l = 0;
+    size_t r = pageIndex.size();
+    while (l < r) {
+        auto m = (l + r) / 2;
+        if (strcasecmp(pageIndex[m].firstIdTag, idTag) <= 0) {
+            l = m + 1;
+        } else {
+            r = m;
+        }
+    }
+
+    //idTag belongs to the page before. If idTag precedes the whole list, then it belongs to the first page
+    return l > 0 ? l - 1 : 0;
+}
+
+const char *AuthorizationListPaged::loadPage(size_t pageNr) {
+    auto& page = pageIndex[pageNr];
+
+    pageCacheUse++;
+
+    PageCacheEntry *slot = nullptr;
+    for (auto& entry : pageCache) {
+        if (entry.fileId == (int) page.fileId) {
+            entry.lastUse = pageCacheUse;
+            return entry.buf.get();
+        }
+
+        //evict least recently used page
+        if (!slot || (slot->fileId >= 0 && (entry.fileId < 0 || entry.lastUse < slot->lastUse))) {
+            slot = &entry;
+        }
+    }
+
+    if (!slot->buf) {
+        slot->buf = std::unique_ptr<char[]>(new char[MO_LocalAuthListPageSize * AUTHDATA_BINARY_SIZE]);
+    }
+    slot->fileId = -1;
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printPageFn(fn, page.fileId)) {
+        return nullptr;
+    }
+
+    auto file = filesystem->open(fn, "r");
+    if (!file) {
+        MO_DBG_ERR("could not open file: %s", fn);
+        return nullptr;
+    }
+
+    size_t len = page.size * AUTHDATA_BINARY_SIZE;
+    size_t ret;
+    if ((ret = file->read(slot->buf.get(), len)) != len) {
+        MO_DBG_ERR("read error: %zu (expect %zu)", ret, len);
+        return nullptr;
+    }
+
+    slot->fileId = (int) page.fileId;
+    slot->lastUse = pageCacheUse;
+    return slot->buf.get();
+}
+
+bool AuthorizationListPaged::storePage(uint16_t fileId, const char *records, size_t size) {
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printPageFn(fn, fileId)) {
+        return false;
+    }
+
+    invalidatePageCache(fileId);
+
+    auto file = filesystem->open(fn, "w");
+    if (!file) {
+        MO_DBG_ERR("could not open file: %s", fn);
+        return false;
+    }
+
+    size_t len = size * AUTHDATA_BINARY_SIZE;
+    if (file->write(records, len) != len) {
+        MO_DBG_ERR("file write error: %s", fn);
+        return false;
+    }
+
+    return true;
+}
+
+bool AuthorizationListPaged::removePage(uint16_t fileId) {
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printPageFn(fn, fileId)) {
+        return false;
+    }
+
+    invalidatePageCache(fileId);
+
+    size_t msize = 0;
+    if (filesystem->stat(fn, &msize) != 0) {
+        return true; //nothing to do
+    }
+    return filesystem->remove(fn);
+}
+
+void AuthorizationListPaged::invalidatePageCache(uint16_t fileId) {
+    for (auto& entry : pageCache) {
+        if (entry.fileId == (int) fileId) {
+            entry.fileId = -1;
+        }
+    }
+}
+
+uint16_t AuthorizationListPaged::allocFileId() {
+    //file ids only need to be unique. Search for the next unused one
+    while (true) {
+        auto fileId = nextFileId++;
+        if (std::none_of(pageIndex.begin(), pageIndex.end(), [fileId] (const PageIndexEntry& page) {
+                    return page.fileId == fileId;
+                })) {
+            return fileId;
+        }
+    }
+}
+
+const char *AuthorizationListPaged::findRecord(const char *idTag) {
+    if (!idTag || pageIndex.empty()) {
+        return nullptr;
+    }
+
+    auto pageNr = findPage(idTag);
+    auto records = loadPage(pageNr);
+    if (!records) {
+        return nullptr;
+    }
+
+    //binary search within page
+    int l = 0;
+    int r = ((int) pageIndex[pageNr].size) - 1;
+    while (l <= r) {
+        auto m = (r + l) / 2;
+        auto diff = strcasecmp(records + m * AUTHDATA_BINARY_SIZE, idTag);
+        if (diff < 0) {
+            l = m + 1;
+        } else if (diff > 0) {
+            r = m - 1;
+        } else {
+            return records + m * AUTHDATA_BINARY_SIZE;
+        }
+    }
+    return nullptr;
+}
+
+AuthorizationData *AuthorizationListPaged::get(const char *idTag) {
+    auto record = findRecord(idTag);
+    if (!record) {
+        return nullptr;
+    }
+
+    lookupResult.readBinary(record);
+    return &lookupResult;
+}
+
+bool AuthorizationListPaged::readJson(JsonArray authlistJson, int listVersion, bool differential) {
+    if (!filesystem) {
+        MO_DBG_ERR("paged local list requires fs access");
+        return false;
+    }
+
+    AuthListUpdate entries;
+    if (!sortAuthListUpdate(authlistJson, entries)) {
+        return false;
+    }
+
+    bool success = differential ?
+            readJsonDifferential(entries) :
+            readJsonFull(entries);
+
+    if (!success) {
+        return false;
+    }
+
+    this->listVersion = listVersion;
+
+    if (listSize == 0) {
+        this->listVersion = 0;
+    }
+
+    if (!storeIndex()) {
+        clear();
+        return false;
+    }
+
+    return true;
+}
+
+bool AuthorizationListPaged::readJsonFull(AuthListUpdate& entries) {
+
+    size_t resultingListSize = 0;
+    for (auto& entry : entries) {
+        if (entry.second.containsKey(AUTHDATA_KEY_IDTAGINFO)) {
+            resultingListSize++;
+        }
+    }
+
+    if (resultingListSize > maxSize) {
+        MO_DBG_WARN("localAuthList capacity exceeded");
+        return false;
+    }
+
+    //invalidate the stored list until the update is complete
+    if (!removeIndex()) {
+        MO_DBG_ERR("fs error");
+        return false;
+    }
+
+    std::vector<uint16_t> oldFileIds;
+    oldFileIds.reserve(pageIndex.size());
+    for (auto& page : pageIndex) {
+        oldFileIds.push_back(page.fileId);
+    }
+
+    pageIndex.clear();
+    nextFileId = 0;
+    for (auto& entry : pageCache) {
+        entry.fileId = -1;
+    }
+
+    std::unique_ptr<char[]> buf (new char[MO_LocalAuthListPageSize * AUTHDATA_BINARY_SIZE]);
+    size_t bufSize = 0;
+    AuthorizationData authData;
+    bool success = true;
+
+    //write consecutive pages with fileIds 0, 1, 2, ...
+    auto flushPage = [this, &buf, &bufSize] () -> bool {
+        PageIndexEntry page;
+        memcpy(page.firstIdTag, buf.get(), IDTAG_LEN_MAX + 1);
+        page.firstIdTag[IDTAG_LEN_MAX] = '\0';
+        page.fileId = nextFileId++;
+        page.size = (uint16_t) bufSize;
+        pageIndex.push_back(page);
+        bufSize = 0;
+        return storePage(page.fileId, buf.get(), page.size);
+    };
+
+    for (auto& entry : entries) {
+        if (!entry.second.containsKey(AUTHDATA_KEY_IDTAGINFO)) {
+            continue;
+        }
+
+        if (bufSize >= MO_LocalAuthListPageSize) {
+            if (!flushPage()) {
+                success = false;
+                break;
+            }
+        }
+
+        authData.readJson(entry.second, false);
+        authData.writeBinary(buf.get() + bufSize * AUTHDATA_BINARY_SIZE);
+        bufSize++;
+    }
+
+    if (success && bufSize > 0) {
+        success = flushPage();
+    }
+
+    //remove pages of the previous list which haven't been overwritten
+    for (auto fileId : oldFileIds) {
+        if (fileId >= nextFileId) {
+            removePage(fileId);
+        }
+    }
+
+    if (!success) {
+        clear();
+        return false;
+    }
+
+    pageIndex.shrink_to_fit();
+
+    listSize = resultingListSize;
+    return true;
+}
+
+bool AuthorizationListPaged::readJsonDifferential(AuthListUpdate& entries) {
+
+    //determine the resulting list size before modifying any page
+    size_t resultingListSize = listSize;
+    for (auto& entry : entries) {
+        bool exists = findRecord(entry.first) != nullptr;
+        bool remove = !entry.second.containsKey(AUTHDATA_KEY_IDTAGINFO);
+
+        if (exists && remove) {
+            resultingListSize--;
+        } else if (!exists && !remove) {
+            resultingListSize++;
+        }
+    }
+
+    if (resultingListSize > maxSize) {
+        MO_DBG_WARN("localAuthList capacity exceeded");
+        return false;
+    }
+
+    //invalidate the stored list until the update is complete
+    if (!removeIndex()) {
+        MO_DBG_ERR("fs error");
+        return false;
+    }
+
+    std::vector<char> merged;
+    AuthorizationData authData;
+    bool success = true;
+
+    //entries are sorted. Rewrite every affected page once and merge all of its updates in one go
+    size_t i = 0;
+    while (success && i < entries.size()) {
+
+        if (pageIndex.empty()) {
+            //first entry of the list, begin with an empty page
+            PageIndexEntry page;
+            page.firstIdTag[0] = '\0';
+            page.fileId = allocFileId();
+            page.size = 0;
+            pageIndex.push_back(page);
+        }
+
+        size_t pageNr = findPage(entries[i].first);
+
+        //all entries before the next page belong to this page
+        size_t end = i + 1;
+        if (pageNr + 1 < pageIndex.size()) {
+            const char *nextIdTag = pageIndex[pageNr + 1].firstIdTag;
+            while (end < entries.size() && strcasecmp(entries[end].first, nextIdTag) < 0) {
+                end++;
+            }
+        } else {
+            end = entries.size();
+        }
+
+        size_t pageSize = pageIndex[pageNr].size;
+        const char *records = nullptr;
+        if (pageSize > 0) {
+            records = loadPage(pageNr);
+            if (!records) {
+                success = false;
+                break;
+            }
+        }
+
+        merged.resize((pageSize + (end - i)) * AUTHDATA_BINARY_SIZE);
+        size_t mergedSize = 0;
+
+        size_t r = 0;
+        while (r < pageSize || i < end) {
+            int cmp;
+            if (r >= pageSize) {
+                cmp = 1;
+            } else if (i >= end) {
+                cmp = -1;
+            } else {
+                cmp = strcasecmp(records + r * AUTHDATA_BINARY_SIZE, entries[i].first);
+            }
+
+            if (cmp < 0) {
+                //keep stored entry
+                memcpy(merged.data() + mergedSize * AUTHDATA_BINARY_SIZE, records + r * AUTHDATA_BINARY_SIZE, AUTHDATA_BINARY_SIZE);
+                mergedSize++;
+                r++;
+                continue;
+            }
+
+            if (entries[i].second.containsKey(AUTHDATA_KEY_IDTAGINFO)) {
+                //insert or update
+                authData.readJson(entries[i].second, false);
+                authData.writeBinary(merged.data() + mergedSize * AUTHDATA_BINARY_SIZE);
+                mergedSize++;
+            } //else: remove command; drop stored entry if existing
+
+            if (cmp == 0) {
+                r++;
+            }
+            i++;
+        }
+
+        uint16_t fileId = pageIndex[pageNr].fileId;
+
+        if (mergedSize == 0) {
+            removePage(fileId);
+            pageIndex.erase(pageIndex.begin() + pageNr);
+            continue;
+        }
+
+        //split overflowing page into pages of equal size
+        size_t nPages = (mergedSize + MO_LocalAuthListPageSize - 1) / MO_LocalAuthListPageSize;
+        size_t offset = 0;
+        for (size_t p = 0; p < nPages; p++) {
+            PageIndexEntry page;
+            page.size = (uint16_t) ((mergedSize - offset + (nPages - p) - 1) / (nPages - p));
+            page.fileId = p == 0 ? fileId : allocFileId();
+            memcpy(page.firstIdTag, merged.data() + offset * AUTHDATA_BINARY_SIZE, IDTAG_LEN_MAX + 1);
+            page.firstIdTag[IDTAG_LEN_MAX] = '\0';
+
+            if (p == 0) {
+                pageIndex[pageNr] = page;
+            } else {
+                pageIndex.insert(pageIndex.begin() + pageNr + p, page);
+            }
+
+            if (!storePage(page.fileId, merged.data() + offset * AUTHDATA_BINARY_SIZE, page.size)) {
+                success = false;
+                break;
+            }
+
+            offset += page.size;
+        }
+    }
+
+    if (!success) {
+        clear();
+        return false;
+    }
+
+    listSize = resultingListSize;
+    return true;
+}
+
+void AuthorizationListPaged::clear() {
+    listVersion = 0;
+    listSize = 0;
+    pageIndex.clear();
+    nextFileId = 0;
+    for (auto& entry : pageCache) {
+        entry.fileId = -1;
+    }
+
+    if (filesystem) {
+        FilesystemUtils::remove_if(filesystem, [] (const char *fname) -> bool {
+            return !strncmp(fname, MO_LOCALAUTHLIST_PAGED_BFN, sizeof(MO_LOCALAUTHLIST_PAGED_BFN) - 1);
+        });
+    }
+}
+
+size_t AuthorizationListPaged::size() {
+    return listSize;
+}
+
+size_t AuthorizationListPaged::getMemoryUsage() {
+    size_t res = sizeof(*this) + pageIndex.capacity() * sizeof(PageIndexEntry);
+    for (auto& entry : pageCache) {
+        if (entry.buf) {
+            res += MO_LocalAuthListPageSize * AUTHDATA_BINARY_SIZE;
+        }
+    }
+    return res;
+}
+
+#endif //MO_ENABLE_LOCAL_AUTH
@@ -0,0 +1,97 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_AUTHORIZATIONLISTPAGED_H
+#define MO_AUTHORIZATIONLISTPAGED_H
+
+#include <MicroOcpp/Version.h>
+
+#if MO_ENABLE_LOCAL_AUTH
+
+#include <MicroOcpp/Model/Authorization/AuthorizationData.h>
+#include <MicroOcpp/Model/Authorization/AuthorizationList.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <vector>
+
+#ifndef MO_LocalAuthListPageSize
+#define MO_LocalAuthListPageSize 64 //max number of entries per page file
+#endif
+
+#ifndef MO_LocalAuthListPageCacheSize
+#define MO_LocalAuthListPageCacheSize 2 //number of pages which are kept in RAM
+#endif
+
+namespace MicroOcpp {
+
+/*
+ * Local authorization list which resides on the flash. The entries are sorted by idTag and split into page
+ * files of up to MO_LocalAuthListPageSize fixed-length records (see AUTHDATA_BINARY_SIZE). Only a page index with
+ * the first idTag of every page stays in RAM, so a lookup costs a binary search over the index and at most one
+ * page read. The last used pages are kept in a small LRU cache.
+ *
+ * A differential update only rewrites the pages which it touches. Pages which overflow are split, pages which
+ * become empty are removed. The index file is deleted while an update is in progress, so an interrupted update
+ * results in an empty list with listVersion 0 which the CSMS will replace by a full update.
+ */
+class AuthorizationListPaged {
+private:
+    struct PageIndexEntry {
+        char firstIdTag [IDTAG_LEN_MAX + 1];
+        uint16_t fileId;
+        uint16_t size;
+    };
+
+    struct PageCacheEntry {
+        int fileId = -1;
+        unsigned int lastUse = 0;
+        std::unique_ptr<char[]> buf; //MO_LocalAuthListPageSize * AUTHDATA_BINARY_SIZE bytes
+    };
+
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    const size_t maxSize;
+
+    int listVersion = 0;
+    size_t listSize = 0;
+    std::vector<PageIndexEntry> pageIndex; //sorted by firstIdTag
+    uint16_t nextFileId = 0;
+
+    PageCacheEntry pageCache [MO_LocalAuthListPageCacheSize];
+    unsigned int pageCacheUse = 0;
+
+    AuthorizationData lookupResult;
+
+    size_t findPage(const char *idTag); //position of the page which contains idTag if present. pageIndex must not be empty
+    const char *findRecord(const char *idTag); //returns the binary record of idTag, or nullptr if not found
+    const char *loadPage(size_t pageNr); //returns the records of the page, or nullptr on failure
+    bool storePage(uint16_t fileId, const char *records, size_t size);
+    bool removePage(uint16_t fileId);
+    void invalidatePageCache(uint16_t fileId);
+    uint16_t allocFileId();
+
+    bool storeIndex();
+    bool removeIndex();
+
+    bool readJsonFull(AuthListUpdate& entries);
+    bool readJsonDifferential(AuthListUpdate& entries);
+public:
+    AuthorizationListPaged(std::shared_ptr<FilesystemAdapter> filesystem, size_t maxSize = MO_LocalAuthListMaxLength);
+    ~AuthorizationListPaged();
+
+    bool load(); //restore page index from flash
+
+    AuthorizationData *get(const char *idTag); //returned object is valid until the next call of get()
+
+    bool readJson(JsonArray localAuthorizationList, int listVersion, bool differential = false); //applies and persists update
+    void clear();
+
+    int getListVersion() {return listVersion;}
+    size_t size(); //used in unit tests
+
+    size_t getMemoryUsage(); //RAM footprint of the page index and cache; used in benchmarks
+};
+
+}
+
+#endif //MO_ENABLE_LOCAL_AUTH
+#endif
@@ -21,11 +21,14 @@
 #include <MicroOcpp/Model/Variables/VariableService.h>
 
 #define MO_LOCALAUTHORIZATIONLIST_FN (MO_FILENAME_PREFIX "localauth.jsn")
-#define MO_LOCALAUTHORIZATIONCACHE_BFN "authcache.jsn"
-#define MO_LOCALAUTHORIZATIONCACHE_FN (MO_FILENAME_PREFIX MO_LOCALAUTHORIZATIONCACHE_BFN)
+#define MO_LOCALAUTHORIZATIONCACHE_FN (MO_FILENAME_PREFIX "authcache.jsn") //JSON cache of previous versions
 using namespace MicroOcpp;
 
-AuthorizationService::AuthorizationService(Context& context, std::shared_ptr<FilesystemAdapter> filesystem) : context(context), filesystem(filesystem) {
+AuthorizationService::AuthorizationService(Context& context, std::shared_ptr<FilesystemAdapter> filesystem) : context(context), filesystem(filesystem)
+#if MO_ENABLE_LOCAL_AUTH_PAGED
+        , localAuthorizationList(filesystem)
+#endif
+        , localAuthorizationCache(filesystem) {
 #if MO_ENABLE_V201
     if(context.getVersion().major==2){
         auto varService = context.getModel().getVariableService();
@@ -61,10 +64,23 @@ AuthorizationService::AuthorizationService(Context& context, std::shared_ptr<Fil
 }
 
 AuthorizationService::~AuthorizationService() {
-    
+    localAuthorizationCache.flush();
+}
+
+void AuthorizationService::loop() {
+    if (localAuthorizationCache.getWriteBehindMs() == 0) {
+        localAuthorizationCache.flush();
+    }
+}
+
+unsigned long AuthorizationService::getNextWakeupMs() {
+    return localAuthorizationCache.getWriteBehindMs();
 }
 
 bool AuthorizationService::loadLists() {
+#if MO_ENABLE_LOCAL_AUTH_PAGED
+    return localAuthorizationList.load();
+#else
     if (!filesystem) {
         MO_DBG_WARN("no fs access");
         return true;
@@ -92,6 +108,7 @@ bool AuthorizationService::loadLists() {
     }
 
     return true;
+#endif //MO_ENABLE_LOCAL_AUTH_PAGED
 }
 bool AuthorizationService::loadCache() {
     if (!filesystem) {
@@ -101,9 +118,10 @@ bool AuthorizationService::loadCache() {
 
     size_t msize = 0;
     if (filesystem->stat(MO_LOCALAUTHORIZATIONCACHE_FN, &msize) != 0) {
-        MO_DBG_DEBUG("no local authorization cache stored already");
-        return true;
+        return localAuthorizationCache.load();
     }
+
+    //migrate JSON cache of previous versions into the slot files
     
     auto doc = FilesystemUtils::loadJson(filesystem, MO_LOCALAUTHORIZATIONCACHE_FN);
     if (!doc) {
@@ -118,6 +136,12 @@ bool AuthorizationService::loadCache() {
         return false;
     }
 
+    if (!localAuthorizationCache.flush()) {
+        MO_DBG_ERR("cache write failure");
+        return false;
+    }
+
+    filesystem->remove(MO_LOCALAUTHORIZATIONCACHE_FN);
     return true;
 }
 
@@ -160,16 +184,24 @@ bool AuthorizationService::updateLocalList(JsonArray localAuthorizationListJson,
     if(context.getModel().getVersion().major ==2){
         doc = DynamicJsonDocument(localAuthorizationListJson.memoryUsage());
         JsonArray array = doc.to<JsonArray>();
-        for (size_t i = 0; i < localAuthorizationListJson.size(); i++) {
+        for (JsonObject entry : localAuthorizationListJson) {
             JsonObject item = array.createNestedObject();
-            item["idTag"] = localAuthorizationListJson[i]["idToken"]["idToken"];
-            if(localAuthorizationListJson[i].containsKey("idTokenInfo")){
-                item["idTagInfo"] = tokenToTagInfo(localAuthorizationListJson[i]["idTokenInfo"])->as<JsonObject>();
+            item["idTag"] = entry["idToken"]["idToken"];
+            if(entry.containsKey("idTokenInfo")){
+                writeTagInfo(entry["idTokenInfo"], item.createNestedObject("idTagInfo"));
             }    
         }
         localAuthorizationListJson = array;
     }
 #endif
+#if MO_ENABLE_LOCAL_AUTH_PAGED
+    //paged list persists updates on its own
+    bool success = localAuthorizationList.readJson(localAuthorizationListJson, listVersion, differential);
+
+    if (!success) {
+        loadLists();
+    }
+#else
     bool success = localAuthorizationList.readJson(localAuthorizationListJson, listVersion, differential, false);
 
     if (success) {
@@ -187,45 +219,27 @@ bool AuthorizationService::updateLocalList(JsonArray localAuthorizationListJson,
             loadLists();
         }
     }
+#endif //MO_ENABLE_LOCAL_AUTH_PAGED
 
     return success;
 }
 
 bool AuthorizationService::addAutchCache(const char* idTag,JsonObject localAuthorizationCacheJson) {
-    bool success = localAuthCacheEnabledBool->getBool() && localAuthorizationCache.add(idTag,localAuthorizationCacheJson);
-
-    if (success) {
-        
-        DynamicJsonDocument doc (
-                JSON_OBJECT_SIZE(3) +
-                localAuthorizationCache.getJsonCapacity());
-
-        JsonObject root = doc.to<JsonObject>();
-        JsonArray authCacheCompact = root.createNestedArray("localAuthorizationCache");
-        localAuthorizationCache.writeJson(authCacheCompact, true);
-        success = FilesystemUtils::storeJson(filesystem, MO_LOCALAUTHORIZATIONCACHE_FN, doc);
-
-        if (!success) {
-            loadCache();
-        }
-    }
-
-    return success;
+    //the cache writes changes behind in loop()
+    return localAuthCacheEnabledBool->getBool() &&
+            localAuthorizationCache.add(idTag, localAuthorizationCacheJson, context.getModel().getClock().now());
 }
 
 bool AuthorizationService::clearAutchCache() {
-    bool success = false;
     localAuthorizationCache.clear();
 
-    success = FilesystemUtils::remove_if(filesystem, [] (const char *fname) -> bool {
-        return !strncmp(fname, MO_LOCALAUTHORIZATIONCACHE_BFN, strlen(fname));
-    });
-
-    if (!success) {
-        loadCache();
+    //remove JSON cache of previous versions
+    size_t msize = 0;
+    if (filesystem && filesystem->stat(MO_LOCALAUTHORIZATIONCACHE_FN, &msize) == 0) {
+        return filesystem->remove(MO_LOCALAUTHORIZATIONCACHE_FN);
     }
 
-    return success;
+    return true;
 }
 
 
@@ -313,16 +327,19 @@ void AuthorizationService::notifyAuthorization(const char *idTag, JsonObject idT
 }
 
 #if MO_ENABLE_V201
-std::unique_ptr<DynamicJsonDocument> AuthorizationService::tokenToTagInfo(JsonObject token){
-    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(token.memoryUsage()));
-    JsonObject root = doc->to<JsonObject>();
-    root["status"] = token["status"];
+void AuthorizationService::writeTagInfo(JsonObject token, JsonObject out){
+    out["status"] = token["status"];
     if(token.containsKey("groupIdToken")){
-        root["parentIdTag"] = token["groupIdToken"]["idToken"];
+        out["parentIdTag"] = token["groupIdToken"]["idToken"];
     }
     if(token.containsKey("cacheExpiryDateTime")){
-        root["expiryDate"] = token["cacheExpiryDateTime"];
+        out["expiryDate"] = token["cacheExpiryDateTime"];
     }
+}
+
+std::unique_ptr<DynamicJsonDocument> AuthorizationService::tokenToTagInfo(JsonObject token){
+    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(token.memoryUsage()));
+    writeTagInfo(token, doc->to<JsonObject>());
     return doc;
 }
 #endif
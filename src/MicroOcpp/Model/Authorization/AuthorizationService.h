@@ -10,6 +10,7 @@
 #if MO_ENABLE_LOCAL_AUTH
 
 #include <MicroOcpp/Model/Authorization/AuthorizationList.h>
+#include <MicroOcpp/Model/Authorization/AuthorizationListPaged.h>
 #include <MicroOcpp/Model/Authorization/AuthorizationCache.h>
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 #include <MicroOcpp/Core/Configuration.h>
@@ -22,7 +23,11 @@ class AuthorizationService {
 private:
     Context& context;
     std::shared_ptr<FilesystemAdapter> filesystem;
+#if MO_ENABLE_LOCAL_AUTH_PAGED
+    AuthorizationListPaged localAuthorizationList;
+#else
     AuthorizationList localAuthorizationList;
+#endif
     AuthorizationCache localAuthorizationCache;
 
     std::shared_ptr<ICfg> localAuthListEnabledBool;
@@ -32,6 +37,9 @@ public:
     AuthorizationService(Context& context, std::shared_ptr<FilesystemAdapter> filesystem);
     ~AuthorizationService();
 
+    void loop();
+    unsigned long getNextWakeupMs(); //writing the auth cache behind is due
+
     bool loadLists();
     bool loadCache();
 
@@ -50,6 +58,7 @@ public:
     std::shared_ptr<FilesystemAdapter>& getFilesystem(){return filesystem;}
     
 #if MO_ENABLE_V201    
+    static void writeTagInfo(JsonObject token, JsonObject out); //converts 2.0.1 IdTokenInfo into 1.6 idTagInfo
     std::unique_ptr<DynamicJsonDocument> tokenToTagInfo(JsonObject token);
 #endif
 };
@@ -3,6 +3,7 @@
 // MIT License
 
 #include <limits>
+#include <algorithm>
 
 #include <MicroOcpp/Model/Boot/BootService.h>
 #include <MicroOcpp/Core/Context.h>
@@ -87,6 +88,31 @@ void BootService::loop() {
     lastBootNotification = mocpp_tick_ms();
 }
 
+unsigned long BootService::getNextWakeupMs() {
+
+    if (!executedFirstTime) {
+        return 0;
+    }
+
+    unsigned long res = MO_WAKEUP_MAX_MS;
+
+    if (!executedLongTime) {
+        unsigned long elapsed = mocpp_tick_ms() - firstExecutionTimestamp;
+        res = std::min(res, elapsed >= MO_BOOTSTATS_LONGTIME_MS ? 0UL : MO_BOOTSTATS_LONGTIME_MS - elapsed);
+    }
+
+    if (!activatedModel && (status == RegistrationStatus::Accepted || preBootTransactionsBool->getBool())) {
+        return 0;
+    }
+
+    if (status != RegistrationStatus::Accepted) {
+        unsigned long elapsed = mocpp_tick_ms() - lastBootNotification;
+        res = std::min(res, elapsed >= interval_s * 1000UL ? 0UL : interval_s * 1000UL - elapsed);
+    }
+
+    return res;
+}
+
 void BootService::setChargePointCredentials(JsonObject credentials) {
     auto written = serializeJson(credentials, cpCredentials);
     if (written < 2) {
@@ -58,6 +58,8 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs(); //time until loop() has pending work
+
     void setChargePointCredentials(JsonObject credentials);
     void setChargePointCredentials(const char *credentials); //credentials: serialized BootNotification payload
     std::unique_ptr<DynamicJsonDocument> getChargePointCredentials();
@@ -7,12 +7,14 @@
 #if MO_ENABLE_CERT_MGMT && MO_ENABLE_CERT_STORE_MBEDTLS
 
 #include <string.h>
+#include <algorithm>
 
 #include <mbedtls/version.h>
 #include <mbedtls/x509_crt.h>
 #include <mbedtls/md.h>
 #include <mbedtls/error.h>
 
+#include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Debug.h>
 
 bool ocpp_get_cert_hash(mbedtls_x509_crt& cacert, HashAlgorithmType hashAlg, ocpp_cert_hash *out) {
@@ -133,18 +135,107 @@ bool ocpp_get_cert_hash(const unsigned char *buf, size_t len, HashAlgorithmType
 }
 
 namespace MicroOcpp {
+namespace CertStoreUtils {
 
+const char *certTypeFnStrs [] = {MO_CERT_FN_CSMS_ROOT, MO_CERT_FN_MANUFACTURER_ROOT};
+#define MO_CERT_TYPE_COUNT (sizeof(certTypeFnStrs) / sizeof(certTypeFnStrs[0]))
+
+const HashAlgorithmType hashAlgs [] = {HashAlgorithmType_SHA256, HashAlgorithmType_SHA384, HashAlgorithmType_SHA512};
+#define MO_CERT_HASH_ALG_COUNT (sizeof(hashAlgs) / sizeof(hashAlgs[0]))
+
+uint32_t crc32(uint32_t crc, const unsigned char *buf, size_t len) {
+    crc = ~crc;
+    for (size_t i = 0; i < len; i++) {
+        crc ^= buf[i];
+        for (int k = 0; k < 8; k++) {
+            crc = (crc >> 1) ^ (0xEDB88320U & (0U - (crc & 1U)));
+        }
+    }
+    return ~crc;
+}
+
+} //namespace CertStoreUtils
+} //namespace MicroOcpp
+
+using namespace MicroOcpp::CertStoreUtils;
+
+namespace MicroOcpp {
+
+/*
+ * The CertificateStore keeps an index of the precomputed CertificateHashes of all installed certs in all supported
+ * hash algorithms. The hashes are computed once at install time and persisted in the index file, so that queries
+ * don't need to parse the certs. An index entry is only valid as long as the size and CRC-32 of its cert file match.
+ * The CRCs are checked when loading the index and the sizes on each access.
+ */
 class CertificateStoreMbedTLS : public CertificateStore {
 private:
     std::shared_ptr<FilesystemAdapter> filesystem;
 
-    bool getCertHash(const char *fn, HashAlgorithmType hashAlg, CertificateHash& out) {
-        size_t fsize;
-        if (filesystem->stat(fn, &fsize) != 0) {
-            MO_DBG_ERR("certificate does not exist: %s", fn);
+    struct IndexEntry {
+        bool valid = false; //entry matches the cert file
+        bool broken = false; //cert file failed to parse. Not retried until its size changes
+        size_t size = 0; //size of cert file
+        uint32_t crc = 0; //CRC-32 of cert file
+        CertificateHash hash [MO_CERT_HASH_ALG_COUNT]; //same order as hashAlgs
+        uint8_t hashValid = 0; //bitset: hash[i] is valid if bit i is set
+    };
+
+    IndexEntry certIndex [MO_CERT_TYPE_COUNT] [MO_CERT_STORE_SIZE];
+
+    //computes the hashes for all supported algorithms with a single parse of the cert
+    bool computeHashes(const unsigned char *buf, size_t len, IndexEntry& entry) {
+        mbedtls_x509_crt cacert;
+        mbedtls_x509_crt_init(&cacert);
+
+        entry.hashValid = 0;
+
+        int ret;
+        if((ret = mbedtls_x509_crt_parse(&cacert, buf, len + 1)) >= 0) {
+            for (size_t i = 0; i < MO_CERT_HASH_ALG_COUNT; i++) {
+                if (ocpp_get_cert_hash(cacert, hashAlgs[i], &entry.hash[i])) {
+                    entry.hashValid |= (1 << i);
+                }
+            }
+        } else {
+            char err [100];
+            mbedtls_strerror(ret, err, 100);
+            MO_DBG_ERR("mbedtls_x509_crt_parse: %i -- %s", ret, err);
+        }
+
+        mbedtls_x509_crt_free(&cacert);
+        return entry.hashValid != 0;
+    }
+
+    bool computeCrc(const char *fn, size_t fsize, uint32_t& out) {
+        auto file = filesystem->open(fn, "r");
+        if (!file) {
+            MO_DBG_ERR("could not open file: %s", fn);
             return false;
         }
 
+        uint32_t crc = 0;
+        unsigned char buf [64];
+        size_t total = 0;
+        while (total < fsize) {
+            size_t ret = file->read((char*) buf, std::min(sizeof(buf), fsize - total));
+            if (ret == 0) {
+                MO_DBG_ERR("read error: %s", fn);
+                return false;
+            }
+            crc = crc32(crc, buf, ret);
+            total += ret;
+        }
+
+        out = crc;
+        return true;
+    }
+
+    //reads and parses the cert file. Only executed if the index is missing or out of date
+    bool rebuildEntry(const char *fn, size_t fsize, IndexEntry& entry) {
+        entry.valid = false;
+        entry.broken = true; //until the cert has been parsed
+        entry.size = fsize;
+
         if (fsize >= MO_MAX_CERT_SIZE) {
             MO_DBG_ERR("cert file exceeds limit: %s,  %zuB", fn, fsize);
             return false;
@@ -173,66 +264,281 @@ private:
         buf[fsize] = '\0';
 
         if (success) {
-            success &= ocpp_get_cert_hash(buf, fsize, hashAlg, &out);
+            success &= computeHashes(buf, fsize, entry);
         }
 
-        if (!success) {
+        if (success) {
+            entry.crc = crc32(0, buf, fsize);
+            entry.valid = true;
+            entry.broken = false;
+        } else {
             MO_DBG_ERR("could not read cert: %s", fn);
         }
 
         delete[] buf;
         return success;
     }
+
+    void loadIndex() {
+        char fn [MO_MAX_PATH_SIZE];
+        if (!printIndexFn(fn, sizeof(fn))) {
+            return;
+        }
+
+        size_t msize;
+        if (filesystem->stat(fn, &msize) != 0) {
+            return; //no index stored yet
+        }
+
+        auto doc = FilesystemUtils::loadJson(filesystem, fn);
+        if (!doc) {
+            MO_DBG_ERR("failed to load %s", fn);
+            return;
+        }
+
+        JsonArray certs = (*doc)["certs"];
+        for (JsonObject cert : certs) {
+            const char *certType = cert["type"] | "_Undefined";
+            size_t typeIndex = 0;
+            for (; typeIndex < MO_CERT_TYPE_COUNT; typeIndex++) {
+                if (!strcmp(certType, certTypeFnStrs[typeIndex])) {
+                    break;
+                }
+            }
+            size_t slot = cert["slot"] | MO_CERT_STORE_SIZE;
+            if (typeIndex >= MO_CERT_TYPE_COUNT || slot >= MO_CERT_STORE_SIZE) {
+                MO_DBG_ERR("invalid index entry");
+                continue;
+            }
+
+            IndexEntry& entry = certIndex[typeIndex][slot];
+            entry.size = cert["size"] | (size_t)0;
+            entry.crc = cert["crc"] | (uint32_t)0;
+            entry.hashValid = 0;
+
+            JsonArray hashes = cert["hashes"];
+            for (size_t i = 0; i < MO_CERT_HASH_ALG_COUNT && i < hashes.size(); i++) {
+                JsonObject hash = hashes[i];
+                if (!hash.containsKey("name")) {
+                    continue; //hash algorithm not supported
+                }
+                CertificateHash& out = entry.hash[i];
+                out.hashAlgorithm = hashAlgs[i];
+                if (ocpp_cert_set_issuerNameHash(&out, hash["name"] | "", hashAlgs[i]) >= 0 &&
+                        ocpp_cert_set_issuerKeyHash(&out, hash["key"] | "", hashAlgs[i]) >= 0 &&
+                        ocpp_cert_set_serialNumber(&out, hash["serial"] | "") >= 0) {
+                    entry.hashValid |= (1 << i);
+                }
+            }
+
+            entry.valid = entry.hashValid != 0;
+        }
+    }
+
+    bool storeIndex() {
+        char fn [MO_MAX_PATH_SIZE];
+        if (!printIndexFn(fn, sizeof(fn))) {
+            return false;
+        }
+
+        size_t nEntries = 0;
+        for (size_t typeIndex = 0; typeIndex < MO_CERT_TYPE_COUNT; typeIndex++) {
+            for (size_t slot = 0; slot < MO_CERT_STORE_SIZE; slot++) {
+                if (certIndex[typeIndex][slot].valid) {
+                    nEntries++;
+                }
+            }
+        }
+
+        size_t capacity = JSON_OBJECT_SIZE(1) + JSON_ARRAY_SIZE(nEntries) +
+                nEntries * (JSON_OBJECT_SIZE(5) + JSON_ARRAY_SIZE(MO_CERT_HASH_ALG_COUNT) +
+                        MO_CERT_HASH_ALG_COUNT * (JSON_OBJECT_SIZE(3) + 2 * MO_CERT_HASH_ISSUER_NAME_KEY_SIZE + MO_CERT_HASH_SERIAL_NUMBER_SIZE));
+
+        DynamicJsonDocument doc {capacity};
+        JsonArray certs = doc.createNestedArray("certs");
+
+        for (size_t typeIndex = 0; typeIndex < MO_CERT_TYPE_COUNT; typeIndex++) {
+            for (size_t slot = 0; slot < MO_CERT_STORE_SIZE; slot++) {
+                IndexEntry& entry = certIndex[typeIndex][slot];
+                if (!entry.valid) {
+                    continue;
+                }
+
+                JsonObject cert = certs.createNestedObject();
+                cert["type"] = certTypeFnStrs[typeIndex];
+                cert["slot"] = slot;
+                cert["size"] = entry.size;
+                cert["crc"] = entry.crc;
+
+                JsonArray hashes = cert.createNestedArray("hashes");
+                for (size_t i = 0; i < MO_CERT_HASH_ALG_COUNT; i++) {
+                    JsonObject hash = hashes.createNestedObject();
+                    if (!(entry.hashValid & (1 << i))) {
+                        continue; //hash algorithm not supported, leave empty
+                    }
+                    char buf [MO_CERT_HASH_ISSUER_NAME_KEY_SIZE];
+                    ocpp_cert_print_issuerNameHash(&entry.hash[i], buf, sizeof(buf));
+                    hash["name"] = (char*) buf; // force copy-mode
+                    ocpp_cert_print_issuerKeyHash(&entry.hash[i], buf, sizeof(buf));
+                    hash["key"] = (char*) buf; // force copy-mode
+                    ocpp_cert_print_serialNumber(&entry.hash[i], buf, sizeof(buf));
+                    hash["serial"] = (char*) buf; // force copy-mode
+                }
+            }
+        }
+
+        if (!FilesystemUtils::storeJson(filesystem, fn, doc)) {
+            MO_DBG_ERR("failed to store %s", fn);
+            return false;
+        }
+
+        return true;
+    }
+
+    //checks the index against the cert files and repairs it if necessary
+    void validateIndex() {
+        bool modified = false;
+
+        for (size_t typeIndex = 0; typeIndex < MO_CERT_TYPE_COUNT; typeIndex++) {
+            for (size_t slot = 0; slot < MO_CERT_STORE_SIZE; slot++) {
+                IndexEntry& entry = certIndex[typeIndex][slot];
+
+                char fn [MO_MAX_PATH_SIZE];
+                if (!printCertFn(certTypeFnStrs[typeIndex], slot, fn, sizeof(fn))) {
+                    MO_DBG_ERR("internal error");
+                    return;
+                }
+
+                size_t fsize;
+                if (filesystem->stat(fn, &fsize) != 0) {
+                    //no cert installed at this slot
+                    modified |= entry.valid;
+                    entry.valid = false;
+                    entry.broken = false;
+                    continue;
+                }
+
+                uint32_t crc;
+                if (entry.valid && entry.size == fsize && computeCrc(fn, fsize, crc) && entry.crc == crc) {
+                    continue; //up to date
+                }
+
+                MO_DBG_INFO("rebuild index entry: %s", fn);
+                bool wasValid = entry.valid;
+                bool success = rebuildEntry(fn, fsize, entry);
+                modified |= success || wasValid;
+            }
+        }
+
+        if (modified) {
+            storeIndex();
+        }
+    }
+
+    //returns the up-to-date index entry of the cert at the given slot or nullptr if no cert is installed there
+    IndexEntry *getEntry(size_t typeIndex, size_t slot) {
+        char fn [MO_MAX_PATH_SIZE];
+        if (!printCertFn(certTypeFnStrs[typeIndex], slot, fn, sizeof(fn))) {
+            MO_DBG_ERR("internal error");
+            return nullptr;
+        }
+
+        IndexEntry& entry = certIndex[typeIndex][slot];
+
+        size_t fsize;
+        if (filesystem->stat(fn, &fsize) != 0) {
+            //no cert installed at this slot
+            entry.broken = false;
+            if (entry.valid) {
+                entry.valid = false;
+                storeIndex();
+            }
+            return nullptr;
+        }
+
+        if (entry.broken && entry.size == fsize) {
+            return nullptr; //parsing this cert file failed before, don't retry on every query
+        }
+
+        if (!entry.valid || entry.size != fsize) {
+            //cert file has been replaced
+            MO_DBG_INFO("rebuild index entry: %s", fn);
+            bool wasValid = entry.valid;
+            bool success = rebuildEntry(fn, fsize, entry);
+            if (success || wasValid) {
+                storeIndex();
+            }
+            if (!success) {
+                return nullptr;
+            }
+        }
+
+        return &entry;
+    }
+
+    bool printIndexFn(char *buf, size_t bufsize) {
+        auto ret = snprintf(buf, bufsize, MO_FILENAME_PREFIX MO_CERT_FN_PREFIX "index.jsn");
+        if (ret < 0 || (size_t)ret >= bufsize) {
+            MO_DBG_ERR("fn error: %i", ret);
+            return false;
+        }
+        return true;
+    }
+
+    static size_t getTypeIndex(GetCertificateIdType certType) {
+        switch (certType) {
+            case GetCertificateIdType_CSMSRootCertificate:
+                return 0;
+            case GetCertificateIdType_ManufacturerRootCertificate:
+                return 1;
+            default:
+                return MO_CERT_TYPE_COUNT;
+        }
+    }
+
+    static size_t getHashIndex(HashAlgorithmType hashAlg) {
+        for (size_t i = 0; i < MO_CERT_HASH_ALG_COUNT; i++) {
+            if (hashAlgs[i] == hashAlg) {
+                return i;
+            }
+        }
+        return MO_CERT_HASH_ALG_COUNT;
+    }
 public:
     CertificateStoreMbedTLS(std::shared_ptr<FilesystemAdapter> filesystem)
             : filesystem(filesystem) {
 
+        loadIndex();
+        validateIndex();
     }
 
     GetInstalledCertificateStatus getCertificateIds(const std::vector<GetCertificateIdType>& certificateType, std::vector<CertificateChainHash>& out) override {
         out.clear();
 
         for (auto certType : certificateType) {
-            const char *certTypeFnStr = nullptr;
-            switch (certType) {
-                case GetCertificateIdType_CSMSRootCertificate:
-                    certTypeFnStr = MO_CERT_FN_CSMS_ROOT;
-                    break;
-                case GetCertificateIdType_ManufacturerRootCertificate:
-                    certTypeFnStr = MO_CERT_FN_MANUFACTURER_ROOT;
-                    break;
-                default:
-                    MO_DBG_ERR("only CSMS / Manufacturer root supported");
-                    break;
-            }
-
-            if (!certTypeFnStr) {
+            size_t typeIndex = getTypeIndex(certType);
+            if (typeIndex >= MO_CERT_TYPE_COUNT) {
+                MO_DBG_ERR("only CSMS / Manufacturer root supported");
                 continue;
             }
 
-            for (size_t i = 0; i < MO_CERT_STORE_SIZE; i++) {
-                char fn [MO_MAX_PATH_SIZE];
-                if (!printCertFn(certTypeFnStr, i, fn, MO_MAX_PATH_SIZE)) {
-                    MO_DBG_ERR("internal error");
-                    out.clear();
-                    break;
+            for (size_t slot = 0; slot < MO_CERT_STORE_SIZE; slot++) {
+                auto entry = getEntry(typeIndex, slot);
+                if (!entry) {
+                    continue; //no cert installed at this slot
                 }
 
-                size_t msize;
-                if (filesystem->stat(fn, &msize) != 0) {
-                    continue; //no cert installed at this slot
+                size_t hashIndex = getHashIndex(HashAlgorithmType_SHA256);
+                if (!(entry->hashValid & (1 << hashIndex))) {
+                    MO_DBG_ERR("could not create hash: %s-%zu", certTypeFnStrs[typeIndex], slot);
+                    continue;
                 }
 
                 out.emplace_back();
                 CertificateChainHash& rootCert = out.back();
 
                 rootCert.certificateType = certType;
-
-                if (!getCertHash(fn, HashAlgorithmType_SHA256, rootCert.certificateHashData)) {
-                    MO_DBG_ERR("could not create hash: %s", fn);
-                    out.pop_back();
-                    continue;
-                }
+                rootCert.certificateHashData = entry->hash[hashIndex];
             }
         }
 
@@ -244,33 +550,41 @@ public:
     DeleteCertificateStatus deleteCertificate(const CertificateHash& hash) override {
         bool err = false;
 
-        //enumerate all certs possibly installed by this CertStore implementation
-        for (const char *certTypeFnStr : {MO_CERT_FN_CSMS_ROOT, MO_CERT_FN_MANUFACTURER_ROOT}) {
-            for (size_t i = 0; i < MO_CERT_STORE_SIZE; i++) {
-
-                char fn [MO_MAX_PATH_SIZE] = {'\0'}; //cert fn on flash storage
+        size_t hashIndex = getHashIndex(hash.hashAlgorithm);
+        if (hashIndex >= MO_CERT_HASH_ALG_COUNT) {
+            MO_DBG_ERR("hash algorithm not supported");
+            return DeleteCertificateStatus_Failed;
+        }
 
-                if (!printCertFn(certTypeFnStr, i, fn, MO_MAX_PATH_SIZE)) {
-                    MO_DBG_ERR("internal error");
-                    return DeleteCertificateStatus_Failed;
-                }
+        //enumerate all certs possibly installed by this CertStore implementation
+        for (size_t typeIndex = 0; typeIndex < MO_CERT_TYPE_COUNT; typeIndex++) {
+            for (size_t slot = 0; slot < MO_CERT_STORE_SIZE; slot++) {
 
-                size_t msize;
-                if (filesystem->stat(fn, &msize) != 0) {
+                auto entry = getEntry(typeIndex, slot);
+                if (!entry) {
                     continue; //no cert installed at this slot
                 }
 
-                CertificateHash probe;
-                if (!getCertHash(fn, hash.hashAlgorithm, probe)) {
-                    MO_DBG_ERR("could not create hash: %s", fn);
+                if (!(entry->hashValid & (1 << hashIndex))) {
+                    MO_DBG_ERR("could not create hash: %s-%zu", certTypeFnStrs[typeIndex], slot);
                     err = true;
                     continue;
                 }
 
-                if (ocpp_cert_equals(&probe, &hash)) {
+                if (ocpp_cert_equals(&entry->hash[hashIndex], &hash)) {
                     //found, delete
 
+                    char fn [MO_MAX_PATH_SIZE] = {'\0'}; //cert fn on flash storage
+                    if (!printCertFn(certTypeFnStrs[typeIndex], slot, fn, MO_MAX_PATH_SIZE)) {
+                        MO_DBG_ERR("internal error");
+                        return DeleteCertificateStatus_Failed;
+                    }
+
                     bool success = filesystem->remove(fn);
+                    if (success) {
+                        entry->valid = false;
+                        storeIndex();
+                    }
                     return success ?
                         DeleteCertificateStatus_Accepted :
                         DeleteCertificateStatus_Failed;
@@ -284,29 +598,36 @@ public:
     }
 
     InstallCertificateStatus installCertificate(InstallCertificateType certificateType, const char *certificate) override {
-        const char *certTypeFnStr;
-        GetCertificateIdType certTypeGetType;
+        size_t typeIndex;
         switch (certificateType) {
             case InstallCertificateType_CSMSRootCertificate:
-                certTypeFnStr = MO_CERT_FN_CSMS_ROOT;
-                certTypeGetType = GetCertificateIdType_CSMSRootCertificate;
+                typeIndex = getTypeIndex(GetCertificateIdType_CSMSRootCertificate);
                 break;
             case InstallCertificateType_ManufacturerRootCertificate:
-                certTypeFnStr = MO_CERT_FN_MANUFACTURER_ROOT;
-                certTypeGetType = GetCertificateIdType_ManufacturerRootCertificate;
+                typeIndex = getTypeIndex(GetCertificateIdType_ManufacturerRootCertificate);
                 break;
             default:
                 MO_DBG_ERR("only CSMS / Manufacturer root supported");
                 return InstallCertificateStatus_Failed;
         }
 
-        //check if this implementation is able to parse incoming cert
-        CertificateHash certId;
-        if (!ocpp_get_cert_hash((const unsigned char*)certificate, strlen(certificate), HashAlgorithmType_SHA256, &certId)) {
+        size_t cert_len = strlen(certificate);
+
+        //check if this implementation is able to parse incoming cert. Keep the result for the index
+        IndexEntry certEntry;
+        if (!computeHashes((const unsigned char*)certificate, cert_len, certEntry)) {
+            MO_DBG_ERR("unable to parse cert");
+            return InstallCertificateStatus_Rejected;
+        }
+
+        size_t hashIndex = getHashIndex(HashAlgorithmType_SHA256);
+        if (!(certEntry.hashValid & (1 << hashIndex))) {
             MO_DBG_ERR("unable to parse cert");
             return InstallCertificateStatus_Rejected;
         }
 
+        CertificateHash& certId = certEntry.hash[hashIndex];
+
 #if MO_DBG_LEVEL >= MO_DL_DEBUG
         {
             MO_DBG_DEBUG("Cert ID:");
@@ -325,54 +646,51 @@ public:
 #endif // MO_DBG_LEVEL >= MO_DL_DEBUG
 
         //check if cert is already stored on flash
-        std::vector<CertificateChainHash> installedCerts;
-        auto ret = getCertificateIds({certTypeGetType}, installedCerts);
-        if (ret == GetInstalledCertificateStatus_Accepted) {
-            for (auto &installedCert : installedCerts) {
-                if (ocpp_cert_equals(&installedCert.certificateHashData, &certId)) {
-                    MO_DBG_INFO("certificate already installed");
-                    return InstallCertificateStatus_Accepted;
-                }
-                for (auto& installedChild : installedCert.childCertificateHashData) {
-                    if (ocpp_cert_equals(&installedChild, &certId)) {
-                        MO_DBG_INFO("certificate already installed");
-                        return InstallCertificateStatus_Accepted;
-                    }
-                }
-            }
-        }
-
-        char fn [MO_MAX_PATH_SIZE] = {'\0'}; //cert fn on flash storage
-
-        //check for free cert slot
-        for (size_t i = 0; i < MO_CERT_STORE_SIZE; i++) {
-            if (!printCertFn(certTypeFnStr, i, fn, MO_MAX_PATH_SIZE)) {
+        size_t freeSlot = MO_CERT_STORE_SIZE;
+        for (size_t slot = 0; slot < MO_CERT_STORE_SIZE; slot++) {
+            char fn [MO_MAX_PATH_SIZE];
+            if (!printCertFn(certTypeFnStrs[typeIndex], slot, fn, sizeof(fn))) {
                 MO_DBG_ERR("invalid cert fn");
                 return InstallCertificateStatus_Failed;
             }
 
             size_t msize;
             if (filesystem->stat(fn, &msize) != 0) {
-                //found free slot; fn contains result
-                break;
-            } else {
-                //this slot is already occupied; invalidate fn and try next
-                fn[0] = '\0';
+                //no file at this slot
+                if (freeSlot >= MO_CERT_STORE_SIZE) {
+                    freeSlot = slot;
+                }
+                continue;
+            }
+
+            auto entry = getEntry(typeIndex, slot);
+            if (!entry) {
+                continue; //slot is occupied by a cert which failed to parse
+            }
+
+            if ((entry->hashValid & (1 << hashIndex)) && ocpp_cert_equals(&entry->hash[hashIndex], &certId)) {
+                MO_DBG_INFO("certificate already installed");
+                return InstallCertificateStatus_Accepted;
             }
         }
 
-        if (fn[0] == '\0') {
+        if (freeSlot >= MO_CERT_STORE_SIZE) {
             MO_DBG_ERR("exceed maximum number of certs; must delete before");
             return InstallCertificateStatus_Rejected;
         }
 
+        char fn [MO_MAX_PATH_SIZE] = {'\0'}; //cert fn on flash storage
+        if (!printCertFn(certTypeFnStrs[typeIndex], freeSlot, fn, MO_MAX_PATH_SIZE)) {
+            MO_DBG_ERR("invalid cert fn");
+            return InstallCertificateStatus_Failed;
+        }
+
         auto file = filesystem->open(fn, "w");
         if (!file) {
             MO_DBG_ERR("could not open file");
             return InstallCertificateStatus_Failed;
         }
 
-        size_t cert_len = strlen(certificate);
         auto written = file->write(certificate, cert_len);
         if (written < cert_len) {
             MO_DBG_ERR("file write error");
@@ -380,6 +698,13 @@ public:
             filesystem->remove(fn);
             return InstallCertificateStatus_Failed;
         }
+        file.reset(); //close file
+
+        certEntry.size = cert_len;
+        certEntry.crc = crc32(0, (const unsigned char*)certificate, cert_len);
+        certEntry.valid = true;
+        certIndex[typeIndex][freeSlot] = certEntry;
+        storeIndex();
 
         MO_DBG_INFO("installed certificate: %s", fn);
         return InstallCertificateStatus_Accepted;
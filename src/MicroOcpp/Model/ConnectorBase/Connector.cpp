@@ -40,7 +40,9 @@ Connector::Connector(Context &context, std::shared_ptr<FilesystemAdapter> filesy
     : context(context), model(context.getModel()), filesystem(filesystem), connectorId(connectorId)
 {
 
-    context.getRequestQueue().addSendQueue(this); // register at RequestQueue as Request emitter
+    if (!context.getRequestQueue().addSendQueue(this)) { // register at RequestQueue as Request emitter
+        MO_DBG_ERR("connector %u cannot send requests", connectorId);
+    }
 
     snprintf(availabilityBoolKey, sizeof(availabilityBoolKey), MO_CONFIG_EXT_PREFIX "AVAIL_CONN_%d", connectorId);
     availabilityBool = declareConfiguration<bool>(availabilityBoolKey, true, MO_KEYVALUE_FN, false, false, false);
@@ -652,6 +654,62 @@ void Connector::loop()
     return;
 }
 
+unsigned long Connector::getNextWakeupMs()
+{
+    if (transaction)
+    {
+        // transaction state machine polls the hardware inputs and timeouts
+        return 0;
+    }
+
+    return getNextDeadlineMs();
+}
+
+unsigned long Connector::getNextDeadlineMs()
+{
+    if (!trackLoopExecute)
+    {
+        return 0;
+    }
+
+    if (getStatus() != currentStatus)
+    {
+        return 0;
+    }
+
+    unsigned long res = MO_WAKEUP_MAX_MS;
+
+    if (reportedStatus != currentStatus && model.getClock().now() >= MIN_TIME)
+    {
+        if (!minimumStatusDurationInt || minimumStatusDurationInt->getInt() <= 0)
+        {
+            return 0;
+        }
+        unsigned long minimumStatusDuration = ((unsigned long)minimumStatusDurationInt->getInt()) * 1000UL;
+        unsigned long elapsed = mocpp_tick_ms() - t_statusTransition;
+        if (elapsed >= minimumStatusDuration)
+        {
+            return 0;
+        }
+        res = std::min(res, minimumStatusDuration - elapsed);
+    }
+
+    if (transaction &&
+        transaction->isActive() &&
+        !transaction->getStartSync().isRequested() &&
+        transaction->getBeginTimestamp() > MIN_TIME &&
+        connectionTimeOutInt && connectionTimeOutInt->getInt() > 0 &&
+        connectorPluggedInput && !connectorPluggedInput())
+    {
+        // ConnectionTimeOut is the only timer of the transaction state machine. Everything else follows the inputs
+        auto timeout = transaction->getBeginTimestamp();
+        timeout += connectionTimeOutInt->getInt();
+        res = std::min(res, getWakeupMsUntil(model.getClock().now(), timeout));
+    }
+
+    return res;
+}
+
 bool Connector::isFaulted()
 {
     // for (auto i = errorDataInputs.begin(); i != errorDataInputs.end(); ++i) {
@@ -690,9 +748,21 @@ std::shared_ptr<ITransaction> Connector::allocateTransaction()
     {
         txr = (txr + MAX_TX_CNT - 1) % MAX_TX_CNT; // decrement by 1
 
-        auto tx = model.getTransactionStore()->getTransaction(connectorId, txr);
         // check if dangling silent tx, aborted tx, or corrupted entry (tx == null)
-        if (!tx || tx->isSilent() || (tx->isAborted() && MO_TX_CLEAN_ABORTED))
+        bool dangling = false;
+        uint8_t txState;
+        if (model.getTransactionStore()->getTransactionState(connectorId, txr, txState))
+        {
+            // tx index is sufficient, no need to load tx
+            dangling = (txState & TransactionIndexEntry::Silent) || ((txState & TransactionIndexEntry::Aborted) && MO_TX_CLEAN_ABORTED);
+        }
+        else
+        {
+            auto tx = model.getTransactionStore()->getTransaction(connectorId, txr);
+            dangling = !tx || tx->isSilent() || (tx->isAborted() && MO_TX_CLEAN_ABORTED);
+        }
+
+        if (dangling)
         {
             // yes, remove
             bool removed = true;
@@ -752,9 +822,22 @@ std::shared_ptr<ITransaction> Connector::allocateTransaction()
 
             // no transaction allocated, delete history entry to make space
 
-            auto txhist = model.getTransactionStore()->getTransaction(connectorId, txl);
             // oldest entry, now check if it's history and can be removed or corrupted entry
-            if (!txhist || txhist->isCompleted() || txhist->isAborted() || (txhist->isSilent() && txhist->getStopSync().isRequested()))
+            bool history = false;
+            uint8_t txState;
+            if (model.getTransactionStore()->getTransactionState(connectorId, txl, txState))
+            {
+                // tx index is sufficient, no need to load tx
+                history = (txState & (TransactionIndexEntry::Completed | TransactionIndexEntry::Aborted)) ||
+                          ((txState & TransactionIndexEntry::Silent) && (txState & TransactionIndexEntry::StopRequested));
+            }
+            else
+            {
+                auto txhist = model.getTransactionStore()->getTransaction(connectorId, txl);
+                history = !txhist || txhist->isCompleted() || txhist->isAborted() || (txhist->isSilent() && txhist->getStopSync().isRequested());
+            }
+
+            if (history)
             {
                 // yes, remove
                 bool removed = true;
@@ -1011,6 +1094,7 @@ std::shared_ptr<ITransaction> Connector::beginTransaction(const char *idTag)
         authorize = makeRequest(new Ocpp16::Authorize(context.getModel(), idTag));
     }
     authorize->setTimeout(authorizationTimeoutInt && authorizationTimeoutInt->getInt() > 0 ? authorizationTimeoutInt->getInt() * 1000UL : 20UL * 1000UL);
+    authorize->setTimeoutFreezable(false); //the user is waiting. Fall back to local authorization also if the connection drops
 
     if (!context.getConnection().isConnected())
     {
@@ -1270,6 +1354,7 @@ void Connector::endTransaction(const char *idTag, const char *reason)
             authorize = makeRequest(new Ocpp16::Authorize(context.getModel(), idTag));
         }
         authorize->setTimeout(authorizationTimeoutInt && authorizationTimeoutInt->getInt() > 0 ? authorizationTimeoutInt->getInt() * 1000UL : 20UL * 1000UL);
+        authorize->setTimeoutFreezable(false);
 
         if (!context.getConnection().isConnected())
         {
@@ -1512,6 +1597,17 @@ unsigned int Connector::getFrontRequestOpNr()
 
         if (!transactionFront)
         {
+            uint8_t txState;
+            if (model.getTransactionStore()->getTransactionState(connectorId, txNrFront, txState) &&
+                (txState & (TransactionIndexEntry::Aborted | TransactionIndexEntry::Completed | TransactionIndexEntry::Silent)))
+            {
+                // advance front without loading tx
+                MO_DBG_DEBUG("skip front transaction %u-%u", connectorId, txNrFront);
+                txNrFront = (txNrFront + 1) % MAX_TX_CNT;
+                MO_DBG_VERBOSE("txNrBegin=%u, txNrFront=%u, txNrBack=%u", txNrBegin, txNrFront, txNrBack);
+                continue;
+            }
+
             transactionFront = model.getTransactionStore()->getTransaction(connectorId, txNrFront);
 
 #if MO_DBG_LEVEL >= MO_DL_VERBOSE
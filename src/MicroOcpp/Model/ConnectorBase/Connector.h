@@ -141,6 +141,9 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs(); //0 while a transaction is ongoing or a status change is pending
+    unsigned long getNextDeadlineMs(); //like getNextWakeupMs(), but assumes that loop() is called when the inputs change. Only timers count during a transaction
+
     ChargePointStatus getStatus();
 
     bool ocppPermitsCharge();
@@ -13,13 +13,7 @@
 #include <MicroOcpp/Operations/DiagnosticsStatusNotification.h>
 #include <MicroOcpp/Operations/LogStatusNotification.h>
 
-//Fetch relevant data from other modules for diagnostics
-#include <MicroOcpp/Model/Boot/BootService.h>
-#include <MicroOcpp/Operations/StatusNotification.h> //for serializing ChargePointStatus
-#include <MicroOcpp/Core/Connection.h>
-#include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MicroOcpp/Version.h> //for MO_ENABLE_V201
-#include <MicroOcpp/Model/ConnectorBase/UnlockConnectorResult.h> //for MO_ENABLE_CONNECTOR_LOCK
 
 using namespace MicroOcpp;
 
@@ -42,17 +36,8 @@ DiagnosticsService::DiagnosticsService(Context& context) : context(context) {
     }
 }
 
-DiagnosticsService::~DiagnosticsService() {
-    free(diagPreamble);
-    free(diagPostamble);
-}
-
 void DiagnosticsService::loop() {
 
-    if (ftpUpload && ftpUpload->isActive()) {
-        ftpUpload->loop();
-    }
-
     if (ftpUpload) {
         if (ftpUpload->isActive()) {
             ftpUpload->loop();
@@ -127,6 +112,19 @@ void DiagnosticsService::loop() {
     } //end try upload
 }
 
+unsigned long DiagnosticsService::getNextWakeupMs() {
+
+    if (ftpUpload || uploadIssued || getDiagnosticsStatus() != lastReportedStatus) {
+        return 0;
+    }
+
+    if (retries > 0) {
+        return getWakeupMsUntil(context.getModel().getClock().now(), nextTry);
+    }
+
+    return MO_WAKEUP_MAX_MS;
+}
+
 //timestamps before year 2021 will be treated as "undefined"
 std::string DiagnosticsService::requestDiagnosticsUpload(const char *location, unsigned int retries, unsigned int retryInterval, Timestamp startTime, Timestamp stopTime, int requestId) {
     if (onUpload == nullptr) {
@@ -256,223 +254,23 @@ void DiagnosticsService::setOnUploadStatusInput(std::function<UploadStatus()> up
 
 void DiagnosticsService::setDiagnosticsReader(std::function<size_t(char *buf, size_t size)> diagnosticsReader, std::function<void()> onClose, std::shared_ptr<FilesystemAdapter> filesystem) {
 
-    this->onUpload = [this, diagnosticsReader, onClose, filesystem] (const char *location, Timestamp &startTime, Timestamp &stopTime) -> bool {
-
-        auto ftpClient = context.getFtpClient();
-        if (!ftpClient) {
-            MO_DBG_ERR("FTP client not set");
-            this->ftpUploadStatus = UploadStatus::UploadFailed;
-            return false;
-        }
-
-        const size_t diagPreambleSize = 128;
-        diagPreamble = (char*) malloc(diagPreambleSize);
-        if (!diagPreamble) {
-            MO_DBG_ERR("OOM");
-            this->ftpUploadStatus = UploadStatus::UploadFailed;
-            return false;
-        }
-        diagPreambleLen = 0;
-        diagPreambleTransferred = 0;
-
-        diagReaderHasData = diagnosticsReader ? true : false;
-
-        const size_t diagPostambleSize = 1024;
-        diagPostamble = (char*) malloc(diagPostambleSize);
-        if (!diagPostamble) {
-            MO_DBG_ERR("OOM");
-            this->ftpUploadStatus = UploadStatus::UploadFailed;
-            free(diagPreamble);
-            return false;
-        }
-        diagPostambleLen = 0;
-        diagPostambleTransferred = 0;
-
-        auto& model = context.getModel();
-
-        std::string cpModel;
-        std::string fwVersion;
-
-        if (auto bootService = model.getBootService()) {
-            if (auto cpCreds = bootService->getChargePointCredentials()) {
-                cpModel = (*cpCreds)["chargePointModel"] | "Charger";
-                fwVersion = (*cpCreds)["firmwareVersion"] | "";
-            }
-        }
-
-        char jsonDate [JSONDATE_LENGTH + 1];
-        model.getClock().now().toJsonString(jsonDate, sizeof(jsonDate));
-
-        int ret;
+    diagStreamer.reset(new DiagnosticsStreamer(context, filesystem, diagnosticsReader));
 
-        ret = snprintf(diagPreamble, diagPreambleSize,
-                "### %s Hardware Diagnostics%s%s\n%s\n",
-                cpModel.c_str(),
-                fwVersion.empty() ? "" : " - v. ", fwVersion.c_str(),
-                jsonDate);
+    this->onUpload = [this, onClose] (const char *location, Timestamp &startTime, Timestamp &stopTime) -> bool {
 
-        if (ret < 0 || (size_t)ret >= diagPreambleSize) {
-            MO_DBG_ERR("snprintf: %i", ret);
+        auto ftpClient = context.getTransferClient(location);
+        if (!ftpClient) {
+            MO_DBG_ERR("no transfer client for %s", location);
             this->ftpUploadStatus = UploadStatus::UploadFailed;
-            free(diagPreamble);
-            free(diagPostamble);
             return false;
         }
 
-        diagPreambleLen += (size_t)ret;
-
-        Connector *connector0 = model.getConnector(0);
-        Connector *connector1 = model.getConnector(1);
-        ITransaction *connector1Tx = connector1 ? connector1->getTransaction().get() : nullptr;
-        Connector *connector2 = model.getNumConnectors() > 2 ? model.getConnector(2) : nullptr;
-        ITransaction *connector2Tx = connector2 ? connector2->getTransaction().get() : nullptr;
-
-        ret = 0;
-
-        if (ret >= 0 && (size_t)ret + diagPostambleLen < diagPostambleSize) {
-            diagPostambleLen += (size_t)ret;
-            ret = snprintf(diagPostamble + diagPostambleLen, diagPostambleSize - diagPostambleLen,
-                "\n# OCPP"
-                "\nclient_version=%s"
-                "\nuptime=%lus"
-                "%s%s"
-                "%s%s"
-                "%s%s"
-                "\nws_status=%s"
-                "\nws_last_conn=%lus"
-                "\nws_last_recv=%lus"
-                "%s%s"
-                "%s%s"
-                "%s%s"
-                "%s%s"
-                "%s%s"
-                "%s%s"
-                "%s%s"
-                "%s%s"
-                "\nENABLE_CONNECTOR_LOCK=%i"
-                "\nENABLE_FILE_INDEX=%i"
-                "\nENABLE_V201=%i"
-                "\n",
-                MO_VERSION,
-                mocpp_tick_ms() / 1000UL,
-                connector0 ? "\nocpp_status_cId0=" : "", connector0 ? cstrFromOcppEveState(connector0->getStatus()) : "",
-                connector1 ? "\nocpp_status_cId1=" : "", connector1 ? cstrFromOcppEveState(connector1->getStatus()) : "",
-                connector2 ? "\nocpp_status_cId2=" : "", connector2 ? cstrFromOcppEveState(connector2->getStatus()) : "",
-                context.getConnection().isConnected() ? "connected" : "unconnected",
-                context.getConnection().getLastConnected() / 1000UL,
-                context.getConnection().getLastRecv() / 1000UL,
-                connector1 ? "\ncId1_hasTx=" : "", connector1 ? (connector1Tx ? "1" : "0") : "",
-                connector1Tx ? "\ncId1_txActive=" : "", connector1Tx ? (connector1Tx->isActive() ? "1" : "0") : "",
-                connector1Tx ? "\ncId1_txHasStarted=" : "", connector1Tx ? (connector1Tx->getStartSync().isRequested() ? "1" : "0") : "",
-                connector1Tx ? "\ncId1_txHasStopped=" : "", connector1Tx ? (connector1Tx->getStopSync().isRequested() ? "1" : "0") : "",
-                connector2 ? "\ncId2_hasTx=" : "", connector2 ? (connector2Tx ? "1" : "0") : "",
-                connector2Tx ? "\ncId2_txActive=" : "", connector2Tx ? (connector2Tx->isActive() ? "1" : "0") : "",
-                connector2Tx ? "\ncId2_txHasStarted=" : "", connector2Tx ? (connector2Tx->getStartSync().isRequested() ? "1" : "0") : "",
-                connector2Tx ? "\ncId2_txHasStopped=" : "", connector2Tx ? (connector2Tx->getStopSync().isRequested() ? "1" : "0") : "",
-                MO_ENABLE_CONNECTOR_LOCK,
-                MO_ENABLE_FILE_INDEX,
-                MO_ENABLE_V201
-                );
-        }
-
-        if (filesystem) {
-
-            if (ret >= 0 && (size_t)ret + diagPostambleLen < diagPostambleSize) {
-                diagPostambleLen += (size_t)ret;
-                ret = snprintf(diagPostamble + diagPostambleLen, diagPostambleSize - diagPostambleLen, "\n# Filesystem\n");
-            }
-
-            filesystem->ftw_root([this, &ret] (const char *fname) -> int {
-                if (ret >= 0 && (size_t)ret + diagPostambleLen < diagPostambleSize) {
-                    diagPostambleLen += (size_t)ret;
-                    ret = snprintf(diagPostamble + diagPostambleLen, diagPostambleSize - diagPostambleLen, "%s\n", fname);
-                }
-                diagFileList.emplace_back(fname);
-                return 0;
-            });
-
-            MO_DBG_DEBUG("discovered %zu files", diagFileList.size());
-        }
-
-        if (ret >= 0 && (size_t)ret + diagPostambleLen < diagPostambleSize) {
-            diagPostambleLen += (size_t)ret;
-        } else {
-            char errMsg [64];
-            auto errLen = snprintf(errMsg, sizeof(errMsg), "\n[Diagnostics cut]\n");
-            size_t ellipseStart = std::min(diagPostambleSize - (size_t)errLen - 1, diagPostambleLen);
-            auto ret2 = snprintf(diagPostamble + ellipseStart, diagPostambleSize - ellipseStart, "%s", errMsg);
-            diagPostambleLen += (size_t)ret2;
-        }
+        ftpUpload.reset(); //fileReader of a previous try refers to diagStreamer
+        diagStreamer->begin();
 
         this->ftpUpload = ftpClient->postFile(location,
-            [this, diagnosticsReader, filesystem] (unsigned char *buf, size_t size) -> size_t {
-                size_t written = 0;
-                if (written < size && diagPreambleTransferred < diagPreambleLen) {
-                    size_t writeLen = std::min(size - written, diagPreambleLen - diagPreambleTransferred);
-                    memcpy(buf + written, diagPreamble + diagPreambleTransferred, writeLen);
-                    diagPreambleTransferred += writeLen;
-                    written += writeLen;
-                }
-
-                while (written < size && diagReaderHasData && diagnosticsReader) {
-                    size_t writeLen = diagnosticsReader((char*)buf + written, size - written);
-                    if (writeLen == 0) {
-                        diagReaderHasData = false;
-                    }
-                    written += writeLen;
-                }
-
-                if (written < size && diagPostambleTransferred < diagPostambleLen) {
-                    size_t writeLen = std::min(size - written, diagPostambleLen - diagPostambleTransferred);
-                    memcpy(buf + written, diagPostamble + diagPostambleTransferred, writeLen);
-                    diagPostambleTransferred += writeLen;
-                    written += writeLen;
-                }
-
-                while (written < size && !diagFileList.empty() && filesystem) {
-
-                    char fpath [MO_MAX_PATH_SIZE];
-                    auto ret = snprintf(fpath, sizeof(fpath), "%s%s", MO_FILENAME_PREFIX, diagFileList.front().c_str());
-                    if (ret < 0 || (size_t)ret >= sizeof(fpath)) {
-                        MO_DBG_ERR("fn error: %i", ret);
-                        diagFileList.pop_front();
-                        continue;
-                    }
-
-                    if (auto file = filesystem->open(fpath, "r")) {
-
-                        if (diagFilesFrontTransferred == 0) {
-                            char fileHeading [30 + MO_MAX_PATH_SIZE];
-                            auto writeLen = snprintf(fileHeading, sizeof(fileHeading), "\n\n# File %s:\n", diagFileList.front().c_str());
-                            if (writeLen < 0 || (size_t)writeLen >= sizeof(fileHeading)) {
-                                MO_DBG_ERR("fn error: %i", ret);
-                                diagFileList.pop_front();
-                                continue;
-                            }
-                            if (writeLen + written > size || //heading doesn't fit anymore, return with a bit unused buffer space and print heading the next time
-                                    writeLen + written == size) { //filling the buffer up exactly would mean that no file payload is written and this head gets printed again
-                                
-                                MO_DBG_DEBUG("upload diag chunk (%zuB)", written);
-                                return written;
-                            }
-
-                            memcpy(buf + written, fileHeading, (size_t)writeLen);
-                            written += (size_t)writeLen;
-                        }
-
-                        file->seek(diagFilesFrontTransferred);
-                        size_t writeLen = file->read((char*)buf + written, size - written);
-
-                        if (writeLen < size - written) {
-                            diagFileList.pop_front();
-                        }
-                        written += writeLen;
-                    } else {
-                        MO_DBG_ERR("could not open file: %s", fpath);
-                        diagFileList.pop_front();
-                    }
-                }
-
+            [this] (unsigned char *buf, size_t size) -> size_t {
+                auto written = diagStreamer->read(buf, size);
                 MO_DBG_DEBUG("upload diag chunk (%zuB)", written);
                 return written;
             },
@@ -485,14 +283,10 @@ void DiagnosticsService::setDiagnosticsReader(std::function<size_t(char *buf, si
                     this->ftpUploadStatus = UploadStatus::UploadFailed;
                 }
 
-                free(diagPreamble);
-                free(diagPostamble);
-                diagFileList.clear();
-
                 if (onClose) {
                     onClose();
                 }
-            });
+            }, ftpServerCert);
 
         if (this->ftpUpload) {
             this->ftpUploadStatus = UploadStatus::NotUploaded;
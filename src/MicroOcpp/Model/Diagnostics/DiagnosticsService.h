@@ -8,10 +8,10 @@
 #include <functional>
 #include <memory>
 #include <string>
-#include <deque>
 #include <MicroOcpp/Core/Time.h>
 #include <MicroOcpp/Core/Ftp.h>
 #include <MicroOcpp/Model/Diagnostics/DiagnosticsStatus.h>
+#include <MicroOcpp/Model/Diagnostics/DiagnosticsStreamer.h>
 
 namespace MicroOcpp {
 
@@ -47,15 +47,7 @@ private:
     std::unique_ptr<FtpUpload> ftpUpload;
     UploadStatus ftpUploadStatus = UploadStatus::NotUploaded;
     const char *ftpServerCert = nullptr;
-    char *diagPreamble = nullptr;
-    size_t diagPreambleLen = 0;
-    size_t diagPreambleTransferred = 0;
-    bool diagReaderHasData = false;
-    char *diagPostamble = nullptr;
-    size_t diagPostambleLen = 0;
-    size_t diagPostambleTransferred = 0;
-    std::deque<std::string> diagFileList;
-    size_t diagFilesFrontTransferred = 0;
+    std::unique_ptr<DiagnosticsStreamer> diagStreamer;
 
     std::unique_ptr<Request> getDiagnosticsStatusNotification();
 
@@ -63,10 +55,11 @@ private:
 
 public:
     DiagnosticsService(Context& context);
-    ~DiagnosticsService();
 
     void loop();
 
+    unsigned long getNextWakeupMs(); //0 while an upload is in progress
+
     //timestamps before year 2021 will be treated as "undefined"
     //returns empty std::string if onUpload is missing or upload cannot be scheduled for another reason
     //returns fileName of diagnostics file to be uploaded if upload has been scheduled
@@ -92,6 +85,8 @@ public:
      * return the number of bytes actually written (without terminating zero-byte). It's not necessary to append
      * a terminating zero, MO will ignore any data after the string. To end the reading process, return 0.
      *
+     * The report is generated while it is uploaded (see DiagnosticsStreamer), so its size isn't limited by a buffer.
+     *
      * Note that this function only works if MO_ENABLE_MBEDTLS=1, or MO has been configured with a custom FTP client
      */
     void setDiagnosticsReader(std::function<size_t(char *buf, size_t size)> diagnosticsReader, std::function<void()> onClose, std::shared_ptr<FilesystemAdapter> filesystem);
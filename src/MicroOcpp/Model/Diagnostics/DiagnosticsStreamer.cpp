@@ -0,0 +1,350 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Model/Diagnostics/DiagnosticsStreamer.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Configuration.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Model/Model.h>
+#include <MicroOcpp/Model/Boot/BootService.h>
+#include <MicroOcpp/Model/ConnectorBase/Connector.h>
+#include <MicroOcpp/Model/ConnectorBase/UnlockConnectorResult.h> //for MO_ENABLE_CONNECTOR_LOCK
+#include <MicroOcpp/Model/Transactions/Transaction.h>
+#include <MicroOcpp/Operations/StatusNotification.h> //for serializing ChargePointStatus
+#include <MicroOcpp/Version.h>
+#include <MicroOcpp/Debug.h>
+
+#include <stdarg.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace MicroOcpp;
+
+DiagnosticsStreamer::DiagnosticsStreamer(Context& context, std::shared_ptr<FilesystemAdapter> filesystem, std::function<size_t(char *buf, size_t size)> diagnosticsReader)
+        : context(context), filesystem(filesystem), diagnosticsReader(diagnosticsReader) {
+
+}
+
+void DiagnosticsStreamer::begin() {
+    section = Section::Header;
+    lineLen = 0;
+    lineOffs = 0;
+    statusIndex = 0;
+    containerIndex = 0;
+    configIndex = 0;
+    valueOffs = 0;
+    fileIndex = 0;
+    file.reset();
+}
+
+bool DiagnosticsStreamer::appendLine(const char *format, ...) {
+    va_list args;
+    va_start(args, format);
+    auto ret = vsnprintf(line + lineLen, sizeof(line) - lineLen, format, args);
+    va_end(args);
+
+    if (ret < 0) {
+        MO_DBG_ERR("snprintf: %i", ret);
+        return false;
+    }
+
+    if ((size_t)ret >= sizeof(line) - lineLen) {
+        MO_DBG_WARN("diagnostics line cut");
+        lineLen = sizeof(line) - 1;
+        return false;
+    }
+
+    lineLen += (size_t)ret;
+    return true;
+}
+
+bool DiagnosticsStreamer::nextStatusLine() {
+
+    auto& model = context.getModel();
+    auto numConnectors = model.getNumConnectors();
+
+    if (statusIndex == 0) {
+        appendLine(
+                "\n# OCPP"
+                "\nclient_version=%s"
+                "\nuptime=%lus"
+                "\nws_status=%s"
+                "\nws_last_conn=%lus"
+                "\nws_last_recv=%lus",
+                MO_VERSION,
+                mocpp_tick_ms() / 1000UL,
+                context.getConnection().isConnected() ? "connected" : "unconnected",
+                context.getConnection().getLastConnected() / 1000UL,
+                context.getConnection().getLastRecv() / 1000UL);
+    } else if (statusIndex <= numConnectors) {
+        unsigned int cId = statusIndex - 1;
+        if (auto connector = model.getConnector(cId)) {
+            appendLine("\nocpp_status_cId%u=%s", cId, cstrFromOcppEveState(connector->getStatus()));
+
+            if (cId >= 1) {
+                auto tx = connector->getTransaction().get();
+                appendLine("\ncId%u_hasTx=%i", cId, tx ? 1 : 0);
+                if (tx) {
+                    appendLine(
+                            "\ncId%u_txActive=%i"
+                            "\ncId%u_txHasStarted=%i"
+                            "\ncId%u_txHasStopped=%i",
+                            cId, tx->isActive() ? 1 : 0,
+                            cId, tx->getStartSync().isRequested() ? 1 : 0,
+                            cId, tx->getStopSync().isRequested() ? 1 : 0);
+                }
+            }
+        }
+    } else if (statusIndex == numConnectors + 1) {
+        appendLine(
+                "\nENABLE_CONNECTOR_LOCK=%i"
+                "\nENABLE_FILE_INDEX=%i"
+                "\nENABLE_V201=%i"
+                "\n",
+                MO_ENABLE_CONNECTOR_LOCK,
+                MO_ENABLE_FILE_INDEX,
+                MO_ENABLE_V201);
+    } else {
+        return false;
+    }
+
+    statusIndex++;
+    return true;
+}
+
+bool DiagnosticsStreamer::nextConfigurationLine() {
+
+    while (auto container = getConfigurationContainerPublic(containerIndex)) {
+
+        if (configIndex >= container->size()) {
+            containerIndex++;
+            configIndex = 0;
+            continue;
+        }
+
+        auto config = container->getConfiguration(configIndex);
+        if (!config || !config->getKey()) {
+            configIndex++;
+            continue;
+        }
+
+        switch (config->getType()) {
+            case TConfig::Int:
+                appendLine("\n%s=%i", config->getKey(), config->getInt());
+                configIndex++;
+                break;
+            case TConfig::Bool:
+                appendLine("\n%s=%s", config->getKey(), config->getBool() ? "true" : "false");
+                configIndex++;
+                break;
+            case TConfig::String:
+                appendLine("\n%s=", config->getKey());
+                valueOffs = 0;
+                section = Section::ConfigurationValue;
+                break;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+bool DiagnosticsStreamer::fetchFilename(size_t index) {
+    if (!filesystem) {
+        return false;
+    }
+
+    //enumerate the directory again for each file instead of keeping a list of all filenames
+    size_t i = 0;
+    bool found = false;
+    filesystem->ftw_root([this, index, &i, &found] (const char *fpath) -> int {
+        if (i++ < index) {
+            return 0; //continue
+        }
+        auto ret = snprintf(fname, sizeof(fname), "%s", fpath);
+        if (ret < 0 || (size_t)ret >= sizeof(fname)) {
+            MO_DBG_ERR("fn error: %i", ret);
+            fname[0] = '\0';
+        }
+        found = true;
+        return 1; //stop
+    });
+
+    return found;
+}
+
+bool DiagnosticsStreamer::nextLine() {
+
+    lineLen = 0;
+    lineOffs = 0;
+
+    switch (section) {
+        case Section::Header: {
+            const char *cpModel = "Charger";
+            const char *fwVersion = "";
+
+            std::unique_ptr<DynamicJsonDocument> cpCreds;
+            if (auto bootService = context.getModel().getBootService()) {
+                cpCreds = bootService->getChargePointCredentials();
+                if (cpCreds) {
+                    cpModel = (*cpCreds)["chargePointModel"] | "Charger";
+                    fwVersion = (*cpCreds)["firmwareVersion"] | "";
+                }
+            }
+
+            char jsonDate [JSONDATE_LENGTH + 1];
+            context.getModel().getClock().now().toJsonString(jsonDate, sizeof(jsonDate));
+
+            appendLine("### %s Hardware Diagnostics%s%s\n%s\n",
+                    cpModel,
+                    *fwVersion ? " - v. " : "", fwVersion,
+                    jsonDate);
+
+            section = Section::Status;
+            return true;
+        }
+        case Section::Status:
+            if (nextStatusLine()) {
+                return true;
+            }
+            section = Section::ConfigurationHeading;
+            return false;
+        case Section::ConfigurationHeading:
+            appendLine("\n# Configuration");
+            containerIndex = 0;
+            configIndex = 0;
+            section = Section::Configuration;
+            return true;
+        case Section::Configuration:
+            if (nextConfigurationLine()) {
+                return true;
+            }
+            appendLine("\n");
+            section = Section::FileListHeading;
+            return true;
+        case Section::FileListHeading:
+            if (!filesystem) {
+                section = Section::Reader;
+                return false;
+            }
+            appendLine("\n# Filesystem\n");
+            fileIndex = 0;
+            section = Section::FileList;
+            return true;
+        case Section::FileList:
+            if (fetchFilename(fileIndex)) {
+                appendLine("%s\n", fname);
+                fileIndex++;
+                return true;
+            }
+            fileIndex = 0;
+            section = Section::FileHeading;
+            return false;
+        case Section::FileHeading: {
+            if (!fetchFilename(fileIndex)) {
+                section = Section::Reader;
+                return false;
+            }
+
+            char fpath [MO_MAX_PATH_SIZE];
+            auto ret = snprintf(fpath, sizeof(fpath), "%s%s", MO_FILENAME_PREFIX, fname);
+            if (ret < 0 || (size_t)ret >= sizeof(fpath)) {
+                MO_DBG_ERR("fn error: %i", ret);
+                fileIndex++;
+                return false;
+            }
+
+            file = filesystem->open(fpath, "r");
+            if (!file) {
+                MO_DBG_ERR("could not open file: %s", fpath);
+                fileIndex++;
+                return false;
+            }
+
+            appendLine("\n\n# File %s:\n", fname);
+            section = Section::FileContent;
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+size_t DiagnosticsStreamer::read(unsigned char *buf, size_t size) {
+
+    size_t written = 0;
+
+    while (written < size) {
+
+        if (lineOffs < lineLen) {
+            //pending line from the last call or from nextLine()
+            size_t writeLen = std::min(size - written, lineLen - lineOffs);
+            memcpy(buf + written, line + lineOffs, writeLen);
+            lineOffs += writeLen;
+            written += writeLen;
+            continue;
+        }
+
+        if (section == Section::FileContent) {
+            size_t writeLen = file ? file->read((char*)buf + written, size - written) : 0;
+            if (writeLen == 0) {
+                file.reset();
+                fileIndex++;
+                section = Section::FileHeading;
+            }
+            written += writeLen;
+            continue;
+        }
+
+        if (section == Section::ConfigurationValue) {
+            Configuration *config = nullptr;
+            if (auto container = getConfigurationContainerPublic(containerIndex)) {
+                if (configIndex < container->size()) {
+                    config = container->getConfiguration(configIndex);
+                }
+            }
+            const char *value = config ? config->getString() : "";
+            size_t valueLen = strlen(value);
+            if (valueOffs >= valueLen) {
+                configIndex++;
+                section = Section::Configuration;
+                continue;
+            }
+            size_t writeLen = std::min(size - written, valueLen - valueOffs);
+            memcpy(buf + written, value + valueOffs, writeLen);
+            valueOffs += writeLen;
+            written += writeLen;
+            continue;
+        }
+
+        if (section == Section::Reader && size - written < sizeof(line)) {
+            //little space left in buf. Let the reader write into the line buffer, so it doesn't need to split its output
+            lineLen = diagnosticsReader ? diagnosticsReader(line, sizeof(line)) : 0;
+            lineLen = std::min(lineLen, sizeof(line));
+            lineOffs = 0;
+            if (lineLen == 0) {
+                section = Section::Done;
+            }
+            continue;
+        }
+
+        if (section == Section::Reader) {
+            size_t writeLen = diagnosticsReader ? diagnosticsReader((char*)buf + written, size - written) : 0;
+            if (writeLen == 0) {
+                section = Section::Done;
+            }
+            written += std::min(writeLen, size - written);
+            continue;
+        }
+
+        if (section == Section::Done) {
+            break;
+        }
+
+        nextLine();
+    }
+
+    return written;
+}
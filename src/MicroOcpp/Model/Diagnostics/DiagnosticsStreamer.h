@@ -0,0 +1,78 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_DIAGNOSTICSSTREAMER_H
+#define MO_DIAGNOSTICSSTREAMER_H
+
+#include <functional>
+#include <memory>
+#include <stddef.h>
+
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+
+#ifndef MO_DIAG_LINE_SIZE
+#define MO_DIAG_LINE_SIZE (128 + MO_MAX_PATH_SIZE) //buffer for one generated line of the diagnostics report
+#endif
+
+namespace MicroOcpp {
+
+class Context;
+
+/*
+ * Generates the diagnostics file section by section while the FTP client pulls it: header, OCPP status,
+ * configuration dump, file listing, the contents of each file in the MO store and the output of the custom
+ * diagnosticsReader. Only one line is generated at a time and the files are read directly into the output
+ * buffer, so the report has no size limit and doesn't allocate memory per section or per file (except the
+ * file handles of the FilesystemAdapter).
+ */
+class DiagnosticsStreamer {
+private:
+    Context& context;
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    std::function<size_t(char *buf, size_t size)> diagnosticsReader;
+
+    enum class Section {
+        Header,
+        Status,
+        ConfigurationHeading,
+        Configuration,
+        ConfigurationValue, //long string values are streamed directly from the Configuration
+        FileListHeading,
+        FileList,
+        FileHeading,
+        FileContent,
+        Reader,
+        Done
+    } section = Section::Done;
+
+    char line [MO_DIAG_LINE_SIZE];
+    size_t lineLen = 0;
+    size_t lineOffs = 0;
+
+    unsigned int statusIndex = 0;
+    size_t containerIndex = 0;
+    size_t configIndex = 0;
+    size_t valueOffs = 0;
+    size_t fileIndex = 0;
+    char fname [MO_MAX_PATH_SIZE];
+    std::unique_ptr<FileAdapter> file;
+
+    bool appendLine(const char *format, ...); //appends to the current line
+    bool nextLine(); //generates the next line of the current section. Returns false if the current section has no (more) lines
+    bool nextStatusLine();
+    bool nextConfigurationLine();
+    bool fetchFilename(size_t index); //stores the filename of the nth file of the MO store in fname
+public:
+    DiagnosticsStreamer(Context& context, std::shared_ptr<FilesystemAdapter> filesystem, std::function<size_t(char *buf, size_t size)> diagnosticsReader);
+
+    void begin(); //(re)starts the report at the header
+
+    size_t read(unsigned char *buf, size_t size); //FTP fileReader. Returns 0 if the report is complete
+
+    bool isDone() {return section == Section::Done && lineOffs >= lineLen;}
+};
+
+} //end namespace MicroOcpp
+
+#endif
@@ -0,0 +1,219 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Model/FirmwareManagement/FirmwareDownload.h>
+
+#include <string.h>
+#include <stdio.h>
+#include <ctype.h>
+#include <algorithm>
+
+#if MO_ENABLE_MBEDTLS
+#include <mbedtls/x509_crt.h>
+#include <mbedtls/base64.h>
+#include <mbedtls/error.h>
+#endif
+
+#include <MicroOcpp/Debug.h>
+
+using namespace MicroOcpp;
+
+FirmwareDownload::FirmwareDownload(std::function<size_t(const unsigned char *buf, size_t size)> firmwareWriter)
+        : firmwareWriter(firmwareWriter) {
+
+    for (unsigned int i = 0; i < 2; i++) {
+        buf[i] = new unsigned char[MO_FW_DOWNLOAD_BUFSIZE];
+        if (!buf[i]) {
+            MO_DBG_ERR("OOM");
+            failure = true;
+        }
+    }
+
+#if MO_ENABLE_MBEDTLS
+    mbedtls_md_init(&sha256);
+
+    const mbedtls_md_info_t *md_info = mbedtls_md_info_from_type(MBEDTLS_MD_SHA256);
+    if (md_info && !mbedtls_md_setup(&sha256, md_info, 0) && !mbedtls_md_starts(&sha256)) {
+        sha256Valid = true;
+    } else {
+        MO_DBG_ERR("could not initialize SHA-256");
+    }
+#endif
+}
+
+FirmwareDownload::~FirmwareDownload() {
+#if MO_ENABLE_MBEDTLS
+    mbedtls_md_free(&sha256);
+#endif
+    delete[] buf[0];
+    delete[] buf[1];
+}
+
+size_t FirmwareDownload::receive(const unsigned char *data, size_t len) {
+    if (failure || !data || len == 0) {
+        return 0;
+    }
+
+    if (digestValid) {
+        MO_DBG_ERR("download already finished");
+        return 0;
+    }
+
+    while (bufLen[1 - writeIndex] >= MO_FW_DOWNLOAD_BUFSIZE) {
+        //receive buffer full. Drain the write buffer so that they can be swapped
+        if (!flush()) {
+            return 0;
+        }
+    }
+
+    unsigned int recvIndex = 1 - writeIndex;
+
+    size_t n = std::min(len, (size_t) MO_FW_DOWNLOAD_BUFSIZE - bufLen[recvIndex]);
+    memcpy(buf[recvIndex] + bufLen[recvIndex], data, n);
+    bufLen[recvIndex] += n;
+    offset += n;
+
+#if MO_ENABLE_MBEDTLS
+    if (sha256Valid && mbedtls_md_update(&sha256, data, n)) {
+        MO_DBG_ERR("SHA-256 update failure");
+        sha256Valid = false;
+    }
+#endif
+
+    return n;
+}
+
+bool FirmwareDownload::flush() {
+    if (failure) {
+        return false;
+    }
+
+    if (bufOffs[writeIndex] >= bufLen[writeIndex]) {
+        //write buffer drained. Swap with receive buffer
+        bufLen[writeIndex] = 0;
+        bufOffs[writeIndex] = 0;
+        if (bufLen[1 - writeIndex] == 0) {
+            return true; //nothing to write
+        }
+        writeIndex = 1 - writeIndex;
+    }
+
+    return writeFront();
+}
+
+bool FirmwareDownload::writeFront() {
+    size_t remaining = bufLen[writeIndex] - bufOffs[writeIndex];
+
+    size_t ret = firmwareWriter(buf[writeIndex] + bufOffs[writeIndex], remaining);
+    if (ret == 0) {
+        MO_DBG_ERR("firmwareWriter aborted download");
+        failure = true;
+        return false;
+    } else if (ret > remaining) {
+        MO_DBG_ERR("write error");
+        failure = true;
+        return false;
+    }
+
+    bufOffs[writeIndex] += ret;
+    written += ret;
+    return true;
+}
+
+bool FirmwareDownload::isFlushed() {
+    return written == offset;
+}
+
+bool FirmwareDownload::getSha256(unsigned char out [MO_FW_SHA256_SIZE]) {
+#if MO_ENABLE_MBEDTLS
+    if (!digestValid && sha256Valid) {
+        if (!mbedtls_md_finish(&sha256, digest)) {
+            digestValid = true;
+        } else {
+            MO_DBG_ERR("SHA-256 finish failure");
+        }
+        sha256Valid = false;
+    }
+#endif
+
+    if (!digestValid) {
+        MO_DBG_ERR("SHA-256 not available");
+        return false;
+    }
+
+    memcpy(out, digest, MO_FW_SHA256_SIZE);
+    return true;
+}
+
+bool FirmwareDownload::verifySha256(const char *hex) {
+    unsigned char hash [MO_FW_SHA256_SIZE];
+    if (!hex || !getSha256(hash)) {
+        return false;
+    }
+
+    if (strlen(hex) != 2 * MO_FW_SHA256_SIZE) {
+        MO_DBG_ERR("invalid SHA-256 format");
+        return false;
+    }
+
+    for (size_t i = 0; i < MO_FW_SHA256_SIZE; i++) {
+        char byteHex [3];
+        snprintf(byteHex, sizeof(byteHex), "%02x", hash[i]);
+        if (tolower((unsigned char) hex[2 * i]) != byteHex[0] ||
+                tolower((unsigned char) hex[2 * i + 1]) != byteHex[1]) {
+            MO_DBG_WARN("SHA-256 mismatch");
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool FirmwareDownload::verifySignature(const char *signingCertificate, const char *signature) {
+#if MO_ENABLE_MBEDTLS
+    if (!signingCertificate || !signature) {
+        MO_DBG_ERR("invalid args");
+        return false;
+    }
+
+    unsigned char hash [MO_FW_SHA256_SIZE];
+    if (!getSha256(hash)) {
+        return false;
+    }
+
+    size_t sigLen = 0;
+    mbedtls_base64_decode(nullptr, 0, &sigLen, (const unsigned char*) signature, strlen(signature));
+
+    unsigned char *sig = new unsigned char[sigLen + 1];
+    if (!sig) {
+        MO_DBG_ERR("OOM");
+        return false;
+    }
+
+    mbedtls_x509_crt crt;
+    mbedtls_x509_crt_init(&crt);
+
+    bool success = false;
+    int ret;
+
+    if ((ret = mbedtls_base64_decode(sig, sigLen + 1, &sigLen, (const unsigned char*) signature, strlen(signature)))) {
+        MO_DBG_ERR("invalid signature encoding: %i", ret);
+    } else if ((ret = mbedtls_x509_crt_parse(&crt, (const unsigned char*) signingCertificate, strlen(signingCertificate) + 1)) < 0) {
+        char err [100];
+        mbedtls_strerror(ret, err, 100);
+        MO_DBG_ERR("mbedtls_x509_crt_parse: %i -- %s", ret, err);
+    } else if ((ret = mbedtls_pk_verify(&crt.pk, MBEDTLS_MD_SHA256, hash, sizeof(hash), sig, sigLen))) {
+        MO_DBG_WARN("invalid signature: %i", ret);
+    } else {
+        success = true;
+    }
+
+    mbedtls_x509_crt_free(&crt);
+    delete[] sig;
+    return success;
+#else
+    MO_DBG_ERR("signature verification requires MbedTLS");
+    return false;
+#endif
+}
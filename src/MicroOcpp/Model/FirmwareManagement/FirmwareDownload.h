@@ -0,0 +1,90 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_FIRMWAREDOWNLOAD_H
+#define MO_FIRMWAREDOWNLOAD_H
+
+#include <functional>
+#include <stddef.h>
+
+#include <MicroOcpp/Platform.h>
+
+#if MO_ENABLE_MBEDTLS
+#include <mbedtls/md.h>
+#endif
+
+#ifndef MO_FW_DOWNLOAD_BUFSIZE
+#define MO_FW_DOWNLOAD_BUFSIZE 4096 //size of each of the two stage buffers. Same as the default MO_FTP_DATA_BUFSIZE
+#endif
+
+#ifndef MO_FW_DOWNLOAD_RESUME_ATTEMPTS
+#define MO_FW_DOWNLOAD_RESUME_ATTEMPTS 3 //max. number of times a dropped download is resumed before it counts as failed
+#endif
+
+#define MO_FW_SHA256_SIZE 32
+
+namespace MicroOcpp {
+
+/*
+ * Download stage between the FTP client and the firmware writer. Incoming chunks are copied into one of two buffers
+ * while the other one is drained into the firmware writer during the next loop calls. So the network receive
+ * continues while the firmware writer is busy with a chunk, and the firmware writer may accept only a part of a
+ * chunk per call (e.g. one flash page) without stalling the download.
+ *
+ * The stage hashes the image in flight (SHA-256, requires MbedTLS) and counts the received bytes, so that a dropped
+ * download can be resumed at getOffset() and the hash doesn't need to be computed from flash afterwards.
+ */
+class FirmwareDownload {
+private:
+    std::function<size_t(const unsigned char *buf, size_t size)> firmwareWriter;
+
+    unsigned char *buf [2] = {nullptr, nullptr};
+    size_t bufLen [2] = {0, 0}; //bytes in buffer
+    size_t bufOffs [2] = {0, 0}; //bytes of buffer which have been passed to the firmwareWriter
+    unsigned int writeIndex = 0; //buffer which is drained into the firmwareWriter. The other one receives data
+
+    size_t offset = 0; //received bytes
+    size_t written = 0; //bytes accepted by the firmwareWriter
+    bool failure = false;
+
+#if MO_ENABLE_MBEDTLS
+    mbedtls_md_context_t sha256;
+    bool sha256Valid = false;
+#endif
+    unsigned char digest [MO_FW_SHA256_SIZE];
+    bool digestValid = false;
+
+    bool writeFront(); //passes the front buffer to the firmwareWriter once
+public:
+    FirmwareDownload(std::function<size_t(const unsigned char *buf, size_t size)> firmwareWriter);
+    ~FirmwareDownload();
+
+    FirmwareDownload(const FirmwareDownload&) = delete;
+
+    size_t receive(const unsigned char *data, size_t len); //FTP fileWriter. Returns the number of accepted bytes, 0 on failure
+    bool flush(); //passes buffered data to the firmwareWriter. Call periodically. Returns false on failure
+
+    bool isFlushed(); //true if the firmwareWriter has received all data
+    bool isFailed() {return failure;}
+
+    size_t getOffset() {return offset;} //resume a dropped download from here
+    size_t getWritten() {return written;}
+
+    /*
+     * SHA-256 of the received image. Call after the download has completed, i.e. no more data will be received.
+     * Returns false if MbedTLS is disabled
+     */
+    bool getSha256(unsigned char out [MO_FW_SHA256_SIZE]);
+    bool verifySha256(const char *hex); //compare against hex-encoded SHA-256
+
+    /*
+     * Verify the signature over the SHA-256 of the received image with the public key of signingCertificate (PEM).
+     * signature is Base64 encoded, e.g. from the SignedUpdateFirmware request of OCPP 2.0.1
+     */
+    bool verifySignature(const char *signingCertificate, const char *signature);
+};
+
+} //namespace MicroOcpp
+
+#endif
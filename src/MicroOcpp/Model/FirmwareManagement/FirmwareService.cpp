@@ -2,6 +2,8 @@
 // Copyright Matthias Akstaller 2019 - 2024
 // MIT License
 
+#include <algorithm>
+
 #include <MicroOcpp/Model/FirmwareManagement/FirmwareService.h>
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
@@ -44,10 +46,6 @@ void FirmwareService::setBuildNumber(const char *buildNumber) {
 
 void FirmwareService::loop() {
 
-    if (ftpDownload && ftpDownload->isActive()) {
-        ftpDownload->loop();
-    }
-
     if (ftpDownload) {
         if (ftpDownload->isActive()) {
             ftpDownload->loop();
@@ -57,6 +55,8 @@ void FirmwareService::loop() {
         }
     }
 
+    loopFwDownload();
+
     auto notification = getFirmwareStatusNotification();
     if (notification) {
         context.initiateRequest(std::move(notification));
@@ -201,6 +201,30 @@ void FirmwareService::loop() {
     }
 }
 
+unsigned long FirmwareService::getNextWakeupMs() {
+
+    if (ftpDownload || fwDownload) {
+        return 0;
+    }
+
+    if (!checkedSuccessfulFwUpdate && !buildNumber.empty() && previousBuildNumberString != nullptr) {
+        return 0;
+    }
+
+    if (getFirmwareStatus() != lastReportedStatus) {
+        return 0;
+    }
+
+    if (retries > 0) {
+        unsigned long elapsed = mocpp_tick_ms() - timestampTransition;
+        unsigned long transitionMs = elapsed >= delayTransition ? 0 : delayTransition - elapsed;
+        unsigned long retreiveMs = getWakeupMsUntil(context.getModel().getClock().now(), retreiveDate);
+        return std::min(std::max(transitionMs, retreiveMs), (unsigned long) MO_WAKEUP_MAX_MS);
+    }
+
+    return MO_WAKEUP_MAX_MS;
+}
+
 void FirmwareService::scheduleFirmwareUpdate(const char *location, Timestamp retreiveDate, unsigned int retries, unsigned int retryInterval, int requestId) {
 
     if (!onDownload && !onInstall) {
@@ -336,32 +360,20 @@ void FirmwareService::resetStage() {
 
 void FirmwareService::setDownloadFileWriter(std::function<size_t(const unsigned char *buf, size_t size)> firmwareWriter, std::function<void(MO_FtpCloseReason)> onClose) {
 
-    this->onDownload = [this, firmwareWriter, onClose] (const char *location) -> bool {
-
-        auto ftpClient = context.getFtpClient();
-        if (!ftpClient) {
-            MO_DBG_ERR("FTP client not set");
-            this->ftpDownloadStatus = DownloadStatus::DownloadFailed;
-            return false;
-        }
+    this->firmwareWriter = firmwareWriter;
+    this->fwDownloadOnClose = onClose;
 
-        this->ftpDownload = ftpClient->getFile(location, firmwareWriter,
-            [this, onClose] (MO_FtpCloseReason reason) -> void {
-                if (reason == MO_FtpCloseReason_Success) {
-                    MO_DBG_INFO("FTP download success");
-                    this->ftpDownloadStatus = DownloadStatus::Downloaded;
-                } else {
-                    MO_DBG_INFO("FTP download failure (%i)", reason);
-                    this->ftpDownloadStatus = DownloadStatus::DownloadFailed;
-                }
+    this->onDownload = [this] (const char *location) -> bool {
 
-                onClose(reason);
-            });
+        ftpDownload.reset(); //FTP fileWriter refers to fwDownload
+        fwDownload.reset(new FirmwareDownload(this->firmwareWriter));
+        resumeAttempts = 0;
 
-        if (this->ftpDownload) {
+        if (startFtpDownload()) {
             this->ftpDownloadStatus = DownloadStatus::NotDownloaded;
             return true;
         } else {
+            fwDownload.reset();
             this->ftpDownloadStatus = DownloadStatus::DownloadFailed;
             return false;
         }
@@ -372,6 +384,98 @@ void FirmwareService::setDownloadFileWriter(std::function<size_t(const unsigned
     };
 }
 
+bool FirmwareService::startFtpDownload() {
+
+    auto ftpClient = context.getTransferClient(location.c_str());
+    if (!ftpClient) {
+        MO_DBG_ERR("no transfer client for %s", location.c_str());
+        return false;
+    }
+
+    auto download = fwDownload.get();
+    if (!download || download->isFailed()) {
+        MO_DBG_ERR("download stage not initialized");
+        return false;
+    }
+
+    auto fileWriter = [download] (unsigned char *data, size_t len) -> size_t {
+        return download->receive(data, len);
+    };
+
+    auto onClose = [this] (MO_FtpCloseReason reason) -> void {
+        this->ftpCloseReason = reason; //evaluated in loopFwDownload() after the stage has been flushed
+    };
+
+    ftpCloseReason = MO_FtpCloseReason_Undefined;
+
+    if (download->getOffset() > 0) {
+        MO_DBG_INFO("resume FTP download at %zuB", download->getOffset());
+        ftpDownload = ftpClient->getFileFromOffset(location.c_str(), download->getOffset(), fileWriter, onClose, ftpServerCert);
+    } else {
+        ftpDownload = ftpClient->getFile(location.c_str(), fileWriter, onClose, ftpServerCert);
+    }
+
+    return ftpDownload != nullptr;
+}
+
+void FirmwareService::loopFwDownload() {
+
+    if (!fwDownload || ftpDownloadStatus != DownloadStatus::NotDownloaded) {
+        return;
+    }
+
+    //pass the data of the last receive to the firmwareWriter while the FTP client receives the next chunk
+    bool success = fwDownload->flush();
+
+    if (success && ftpCloseReason == MO_FtpCloseReason_Undefined) {
+        return; //download ongoing
+    }
+
+    if (success && ftpCloseReason == MO_FtpCloseReason_Failure) {
+        ftpDownload.reset();
+
+        if (fwDownload->getOffset() > 0 && resumeAttempts < MO_FW_DOWNLOAD_RESUME_ATTEMPTS) {
+            resumeAttempts++;
+            if (startFtpDownload()) {
+                return; //continue download
+            }
+            MO_DBG_WARN("could not resume FTP download");
+        }
+        success = false;
+    }
+
+    if (success) {
+        //FTP download complete
+        if (!fwDownload->isFlushed()) {
+            return; //firmwareWriter hasn't received all data yet
+        }
+
+        if (downloadIntegrityCheck && !downloadIntegrityCheck(*fwDownload)) {
+            MO_DBG_WARN("firmware image rejected by integrity check");
+            success = false;
+        }
+    }
+
+    if (success) {
+        MO_DBG_INFO("FTP download success (%zuB)", fwDownload->getWritten());
+        ftpDownloadStatus = DownloadStatus::Downloaded;
+    } else {
+        MO_DBG_INFO("FTP download failure (%i)", ftpCloseReason);
+        ftpDownloadStatus = DownloadStatus::DownloadFailed;
+    }
+
+    ftpDownload.reset(); //FTP fileWriter refers to fwDownload
+    fwDownload.reset();
+
+    if (fwDownloadOnClose) {
+        fwDownloadOnClose(success ? MO_FtpCloseReason_Success : MO_FtpCloseReason_Failure);
+    }
+}
+
+void FirmwareService::setDownloadIntegrityCheck(std::function<bool(FirmwareDownload& download)> downloadIntegrityCheck) {
+    this->downloadIntegrityCheck = downloadIntegrityCheck;
+}
+
 void FirmwareService::setFtpServerCert(const char *cert) {
     this->ftpServerCert = cert;
 }
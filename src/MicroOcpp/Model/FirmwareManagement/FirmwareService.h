@@ -12,6 +12,7 @@
 #include <MicroOcpp/Model/FirmwareManagement/FirmwareStatus.h>
 #include <MicroOcpp/Core/Time.h>
 #include <MicroOcpp/Core/Ftp.h>
+#include <MicroOcpp/Model/FirmwareManagement/FirmwareDownload.h>
 #include <MicroOcpp/Version.h>
 
 namespace MicroOcpp {
@@ -45,6 +46,13 @@ private:
     DownloadStatus ftpDownloadStatus = DownloadStatus::NotDownloaded;
     const char *ftpServerCert = nullptr;
 
+    std::unique_ptr<FirmwareDownload> fwDownload; //stage between FTP client and firmwareWriter
+    std::function<size_t(const unsigned char *buf, size_t size)> firmwareWriter;
+    std::function<void(MO_FtpCloseReason)> fwDownloadOnClose;
+    std::function<bool(FirmwareDownload& download)> downloadIntegrityCheck;
+    MO_FtpCloseReason ftpCloseReason = MO_FtpCloseReason_Undefined;
+    unsigned int resumeAttempts = 0;
+
     std::function<InstallationStatus()> installationStatusInput;
     bool installationIssued = false;
 
@@ -78,6 +86,9 @@ private:
 
     std::unique_ptr<Request> getFirmwareStatusNotification();
 
+    bool startFtpDownload(); //starts or resumes the FTP download into fwDownload
+    void loopFwDownload();
+
 public:
     FirmwareService(Context& context);
 
@@ -85,6 +96,8 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs(); //0 while an update is in progress and status inputs need to be polled
+
     void scheduleFirmwareUpdate(const char *location, Timestamp retreiveDate, unsigned int retries = 1, unsigned int retryInterval = 0, int requestId = -1);
 
     FirmwareStatus getFirmwareStatus();
@@ -95,6 +108,11 @@ public:
      * next chunk of FW data and `size` being the chunk size. `firmwareWriter` must return the number of bytes written, whereas
      * the result can be between 1 and `size`, and 0 aborts the download. MO executes `onClose` with the reason why the connection
      * has been closed. If the download hasn't been successful, MO will abort the update routine in any case.
+     *
+     * The chunks are staged in a double buffer (see FirmwareDownload), so `firmwareWriter` may run while the next chunk
+     * is received. If the connection drops, MO resumes the download at the last received byte, up to
+     * MO_FW_DOWNLOAD_RESUME_ATTEMPTS times. In this case, `onClose` is only executed once the download has finally
+     * completed or failed.
      * 
      * Note that this function only works if MO_ENABLE_MBEDTLS=1, or MO has been configured with a custom FTP client
      */
@@ -102,6 +120,16 @@ public:
 
     void setFtpServerCert(const char *cert); //zero-copy mode, i.e. cert must outlive MO
 
+    /*
+     * Sets a check which is executed after the FTP download has completed and before the download counts as successful.
+     * The FirmwareDownload object provides the SHA-256 of the image which has been computed during the download, e.g.
+     * `download.verifySha256(expectedHash)` or `download.verifySignature(signingCert, signature)`. Return false to reject
+     * the image. Only applies to the FTP download handler `setDownloadFileWriter`
+     */
+    void setDownloadIntegrityCheck(std::function<bool(FirmwareDownload& download)> downloadIntegrityCheck);
+
+    FirmwareDownload *getFirmwareDownload() {return fwDownload.get();} //ongoing FTP download, or nullptr
+
     /*
      * Manual alternative for FTP download handler `setDownloadFileWriter`
      */
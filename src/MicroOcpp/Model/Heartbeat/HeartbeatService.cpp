@@ -2,6 +2,8 @@
 // Copyright Matthias Akstaller 2019 - 2024
 // MIT License
 
+#include <algorithm>
+
 #include <MicroOcpp/Model/Heartbeat/HeartbeatService.h>
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Core/Request.h>
@@ -40,3 +42,15 @@ void HeartbeatService::loop() {
         context.initiateRequest(std::move(heartbeat));
     }
 }
+
+unsigned long HeartbeatService::getNextWakeupMs() {
+    unsigned long hbInterval = heartbeatIntervalInt->getInt();
+    hbInterval *= 1000UL; //conversion s -> ms
+    unsigned long elapsed = mocpp_tick_ms() - lastHeartbeat;
+
+    if (elapsed >= hbInterval) {
+        return 0;
+    }
+
+    return std::min(hbInterval - elapsed, (unsigned long) MO_WAKEUP_MAX_MS);
+}
@@ -23,6 +23,8 @@ public:
     HeartbeatService(Context& context);
 
     void loop();
+
+    unsigned long getNextWakeupMs(); //time until the next Heartbeat is due
 };
 
 }
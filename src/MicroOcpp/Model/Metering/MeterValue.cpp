@@ -8,36 +8,69 @@
 
 using namespace MicroOcpp;
 
-std::unique_ptr<DynamicJsonDocument> MeterValue::toJson(const ProtocolVersion& version) {
+size_t MeterValue::getJsonCapacity(const ProtocolVersion& version, bool compact) {
     size_t capacity = 0;
-    std::vector<std::unique_ptr<DynamicJsonDocument>> entries;
+    capacity += JSON_OBJECT_SIZE(2);
+    capacity += JSONDATE_LENGTH + 1;
+    capacity += JSON_ARRAY_SIZE(sampledValue.size());
     for (auto sample = sampledValue.begin(); sample != sampledValue.end(); sample++) {
-        auto json = (*sample)->toJson(version);
-        if (!json) {
-            return nullptr;
-        }
-        capacity += json->capacity();
-        entries.push_back(std::move(json));
+        capacity += (*sample)->getJsonCapacity(version, compact);
     }
+    return capacity;
+}
 
-    capacity += JSON_ARRAY_SIZE(entries.size());
-    capacity += JSONDATE_LENGTH + 1;
-    capacity += JSON_OBJECT_SIZE(2);
-    
-    auto result = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(capacity + 100)); //TODO remove safety space
-    auto jsonPayload = result->to<JsonObject>();
-
+bool MeterValue::toJson(JsonObject out, const ProtocolVersion& version, bool compact) {
     char timestampStr [JSONDATE_LENGTH + 1] = {'\0'};
     if (timestamp.toJsonString(timestampStr, JSONDATE_LENGTH + 1)) {
-        jsonPayload["timestamp"] = timestampStr;
+        out["timestamp"] = timestampStr;
     }
-    auto jsonMeterValue = jsonPayload.createNestedArray("sampledValue");
-    for (auto entry = entries.begin(); entry != entries.end(); entry++) {
-        jsonMeterValue.add(**entry);
+    auto jsonMeterValue = out.createNestedArray("sampledValue");
+    for (auto sample = sampledValue.begin(); sample != sampledValue.end(); sample++) {
+        if (!(*sample)->toJson(jsonMeterValue.createNestedObject(), version, compact)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::unique_ptr<DynamicJsonDocument> MeterValue::toJson(const ProtocolVersion& version, bool compact) {
+    auto result = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(getJsonCapacity(version, compact)));
+    if (!toJson(result->to<JsonObject>(), version, compact)) {
+        return nullptr;
     }
     return result;
 }
 
+size_t MeterValue::getJsonSize(const ProtocolVersion& version) {
+    DynamicJsonDocument doc {getJsonCapacity(version)};
+    if (!toJson(doc.to<JsonObject>(), version)) {
+        return 0;
+    }
+    return measureJson(doc);
+}
+
+std::unique_ptr<MeterValue> MeterValue::splitFront(size_t maxSize, const ProtocolVersion& version) {
+    auto front = std::unique_ptr<MeterValue>(new MeterValue(timestamp));
+    size_t size = front->getJsonSize(version); //timestamp and empty sampledValue array
+
+    size_t n = 0;
+    for (; n < sampledValue.size(); n++) {
+        DynamicJsonDocument sample {sampledValue[n]->getJsonCapacity(version)};
+        sampledValue[n]->toJson(sample.to<JsonObject>(), version);
+        size_t sampleSize = measureJson(sample) + 1; //plus separator
+        if (n > 0 && size + sampleSize > maxSize) {
+            break;
+        }
+        size += sampleSize;
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        front->sampledValue.push_back(std::move(sampledValue[i]));
+    }
+    sampledValue.erase(sampledValue.begin(), sampledValue.begin() + n);
+    return front;
+}
+
 const Timestamp& MeterValue::getTimestamp() {
     return timestamp;
 }
@@ -56,69 +89,124 @@ ReadingContext MeterValue::getReadingContext() {
     return ReadingContext::NOT_SET;
 }
 
+void SamplerIndex::addSampler(size_t samplerIndex) {
+    if (samplerIndex != samplerMeasurandIds.size() || samplerIndex >= samplers.size()) {
+        MO_DBG_ERR("index out of sync");
+        return;
+    }
+
+    auto& properties = samplers[samplerIndex]->getProperties();
+
+    int measurandId = getMeasurandId(properties.getMeasurand().c_str(), properties.getMeasurand().length());
+    if (measurandId < 0) {
+        measurandId = (int) measurands.size();
+        measurands.push_back(properties.getMeasurand().c_str());
+    }
+
+    samplerMeasurandIds.push_back((uint16_t) measurandId);
+    samplerKeys.push_back(properties.getKey());
+    revision++;
+}
+
+int SamplerIndex::getMeasurandId(const char *measurand, size_t len) {
+    for (size_t i = 0; i < measurands.size(); i++) {
+        if (!strncmp(measurands[i], measurand, len) && measurands[i][len] == '\0') {
+            return (int) i;
+        }
+    }
+    return -1;
+}
+
+SampledValueSampler *SamplerIndex::findSampler(uint32_t propertiesKey, const char *format, const char *measurand, const char *phase, const char *location, const char *unit) {
+    for (size_t i = 0; i < samplerKeys.size(); i++) {
+        if (samplerKeys[i] != propertiesKey) {
+            continue;
+        }
+        //confirm match to rule out hash collisions
+        auto& properties = samplers[i]->getProperties();
+        if (!properties.getMeasurand().compare(measurand) &&
+                !properties.getFormat().compare(format) &&
+                !properties.getPhase().compare(phase) &&
+                !properties.getLocation().compare(location) &&
+                !properties.getUnit().compare(unit)) {
+            return samplers[i].get();
+        }
+    }
+    return nullptr;
+}
+
 MeterValueBuilder::MeterValueBuilder(const std::vector<std::unique_ptr<SampledValueSampler>> &samplers,
+            SamplerIndex& samplerIndex,
             std::shared_ptr<ICfg> samplersSelectStr) :
             samplers(samplers),
+            samplerIndex(samplerIndex),
             selectString(samplersSelectStr) {
         
     updateObservedSamplers();
-    select_observe = selectString->getValueRevision();
 }
 
 void MeterValueBuilder::updateObservedSamplers() {
 
-    if (select_mask.size() != samplers.size()) {
-        select_mask.resize(samplers.size(), false);
-        select_n = 0;
-    }
+    select_observe = selectString->getValueRevision();
+    index_observe = samplerIndex.getRevision();
+
+    select_samplers.clear();
 
-    for (size_t i = 0; i < select_mask.size(); i++) {
-        select_mask[i] = false;
+    if (samplerIndex.size() != samplers.size()) {
+        MO_DBG_ERR("sampler index out of sync");
+        return;
     }
-    
-    auto sstring = selectString->getString();
-    auto ssize = strlen(sstring) + 1;
-    size_t sl = 0, sr = 0;
-    while (sstring && sl < ssize) {
-        while (sr < ssize) {
-            if (sstring[sr] == ',') {
-                break;
-            }
-            sr++;
-        }
 
-        if (sr != sl + 1) {
-            for (size_t i = 0; i < samplers.size(); i++) {
-                if (!strncmp(samplers[i]->getProperties().getMeasurand().c_str(), sstring + sl, sr - sl)) {
-                    select_mask[i] = true;
-                    select_n++;
-                }
-            }
+    //resolve the select string to measurand ids
+    std::vector<bool> select_measurands (samplerIndex.getMeasurandCount(), false);
+    bool selected = false;
+
+    const char *sstring = selectString->getString();
+    const char *l = sstring; //the beginning of an entry of the comma-separated list
+    while (l && *l) {
+        if (*l == ',') {
+            l++;
+            continue;
         }
+        const char *r = l + 1; //one place after the last character of the entry beginning with l
+        while (*r != '\0' && *r != ',') {
+            r++;
+        }
+        int measurandId = samplerIndex.getMeasurandId(l, (size_t) (r - l));
+        if (measurandId >= 0) {
+            select_measurands[measurandId] = true;
+            selected = true;
+        }
+        l = r;
+    }
 
-        sr++;
-        sl = sr;
+    if (!selected) {
+        return;
+    }
+
+    //compile into list of sampler indexes
+    for (size_t i = 0; i < samplers.size(); i++) {
+        if (select_measurands[samplerIndex.getSamplerMeasurandId(i)]) {
+            select_samplers.push_back((uint16_t) i);
+        }
     }
 }
 
 std::unique_ptr<MeterValue> MeterValueBuilder::takeSample(const Timestamp& timestamp, const ReadingContext& context) {
     if (select_observe != selectString->getValueRevision() || //OCPP server has changed configuration about which measurands to take
-            samplers.size() != select_mask.size()) {    //Client has added another Measurand; synchronize lists
+            index_observe != samplerIndex.getRevision()) {    //Client has added another Measurand; synchronize lists
         MO_DBG_DEBUG("Updating observed samplers due to config change or samplers added");
         updateObservedSamplers();
-        select_observe = selectString->getValueRevision();
     }
 
-    if (select_n == 0) {
+    if (select_samplers.empty()) {
         return nullptr;
     }
 
     auto sample = std::unique_ptr<MeterValue>(new MeterValue(timestamp));
 
-    for (size_t i = 0; i < select_mask.size(); i++) {
-        if (select_mask[i]) {
-            sample->addSampledValue(samplers[i]->takeValue(context));
-        }
+    for (auto i : select_samplers) {
+        sample->addSampledValue(samplers[i]->takeValue(context));
     }
 
     return sample;
@@ -136,23 +224,25 @@ std::unique_ptr<MeterValue> MeterValueBuilder::deserializeSample(const JsonObjec
     auto sample = std::unique_ptr<MeterValue>(new MeterValue(timestamp));
 
     JsonArray sampledValue = mvJson["sampledValue"];
-    for (JsonObject svJson : sampledValue) {  //for each sampled value, search sampler with matching measurand type
-        for (auto& sampler : samplers) {
-            auto& properties = sampler->getProperties();
-            if (!properties.getMeasurand().compare(svJson["measurand"] | "") &&
-                    !properties.getFormat().compare(svJson["format"] | "") &&
-                    !properties.getPhase().compare(svJson["phase"] | "") &&
-                    !properties.getLocation().compare(svJson["location"] | "") &&
-                    !properties.getUnit().compare(svJson["unit"] | "")) {
-                //found correct sampler
-                auto dVal = sampler->deserializeValue(svJson);
-                if (dVal) {
-                    sample->addSampledValue(std::move(dVal));
-                } else {
-                    MO_DBG_ERR("deserialization error");
-                }
-                break;
-            }
+    for (JsonObject svJson : sampledValue) {  //for each sampled value, search sampler with matching properties
+        const char *format = svJson["format"] | "";
+        const char *measurand = svJson["measurand"] | "";
+        const char *phase = svJson["phase"] | "";
+        const char *location = svJson["location"] | "";
+        const char *unit = svJson["unit"] | "";
+
+        auto sampler = samplerIndex.findSampler(
+                SampledValueProperties::makeKey(format, measurand, phase, location, unit),
+                format, measurand, phase, location, unit);
+        if (!sampler) {
+            continue;
+        }
+
+        auto dVal = sampler->deserializeValue(svJson);
+        if (dVal) {
+            sample->addSampledValue(std::move(dVal));
+        } else {
+            MO_DBG_ERR("deserialization error");
         }
     }
 
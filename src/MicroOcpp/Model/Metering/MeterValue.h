@@ -24,7 +24,15 @@ public:
 
     void addSampledValue(std::unique_ptr<SampledValue> sample) {sampledValue.push_back(std::move(sample));}
 
-    std::unique_ptr<DynamicJsonDocument> toJson(const ProtocolVersion& version=VER_1_6_J);
+    size_t getJsonCapacity(const ProtocolVersion& version=VER_1_6_J, bool compact=false); //exact capacity which toJson(JsonObject, ...) consumes
+    bool toJson(JsonObject out, const ProtocolVersion& version=VER_1_6_J, bool compact=false); //links strings of the sampler properties, see SampledValue
+    std::unique_ptr<DynamicJsonDocument> toJson(const ProtocolVersion& version=VER_1_6_J, bool compact=false);
+    size_t getJsonSize(const ProtocolVersion& version=VER_1_6_J); //length of the serialized toJson(...) output
+
+    //moves the leading sampledValues which fit into maxSize serialized bytes into a new MeterValue with the same timestamp. Takes at least one sampledValue
+    std::unique_ptr<MeterValue> splitFront(size_t maxSize, const ProtocolVersion& version=VER_1_6_J);
+
+    size_t getSampledValueCount() {return sampledValue.size();}
 
     const Timestamp& getTimestamp();
     void setTimestamp(Timestamp timestamp);
@@ -32,17 +40,46 @@ public:
     ReadingContext getReadingContext();
 };
 
+/*
+ * Lookup tables over the samplers of one connector, shared by all MeterValueBuilders of that connector.
+ * Measurands are interned to small integer ids when a sampler is registered and the sampler properties
+ * are hashed into a key for matching stored sampled values
+ */
+class SamplerIndex {
+private:
+    const std::vector<std::unique_ptr<SampledValueSampler>>& samplers;
+    std::vector<const char*> measurands; //interned measurand strings. The position in this list is the measurand id
+    std::vector<uint16_t> samplerMeasurandIds; //measurand id of each sampler
+    std::vector<uint32_t> samplerKeys; //hashed properties of each sampler
+    uint16_t revision = 0; //incremented with each registered sampler
+public:
+    SamplerIndex(const std::vector<std::unique_ptr<SampledValueSampler>>& samplers) : samplers(samplers) { }
+
+    void addSampler(size_t samplerIndex); //call after the sampler has been appended to the samplers list
+
+    int getMeasurandId(const char *measurand, size_t len); //-1 if no sampler exists for measurand
+    size_t getMeasurandCount() {return measurands.size();}
+    uint16_t getSamplerMeasurandId(size_t samplerIndex) {return samplerMeasurandIds[samplerIndex];}
+
+    SampledValueSampler *findSampler(uint32_t propertiesKey, const char *format, const char *measurand, const char *phase, const char *location, const char *unit);
+
+    size_t size() {return samplerMeasurandIds.size();}
+    uint16_t getRevision() {return revision;}
+};
+
 class MeterValueBuilder {
 private:
     const std::vector<std::unique_ptr<SampledValueSampler>> &samplers;
+    SamplerIndex& samplerIndex;
     std::shared_ptr<ICfg> selectString;
-    std::vector<bool> select_mask;
-    unsigned int select_n {0};
+    std::vector<uint16_t> select_samplers; //indexes of the selected samplers
     decltype(selectString->getValueRevision()) select_observe;
+    uint16_t index_observe;
 
     void updateObservedSamplers();
 public:
     MeterValueBuilder(const std::vector<std::unique_ptr<SampledValueSampler>> &samplers,
+            SamplerIndex& samplerIndex,
             std::shared_ptr<ICfg> samplersSelectStr);
     
     std::unique_ptr<MeterValue> takeSample(const Timestamp& timestamp, const ReadingContext& context);
@@ -14,6 +14,7 @@
 #include <MicroOcpp/Model/Variables/VariableService.h>
 
 #include <cstddef>
+#include <algorithm>
 #include <cinttypes>
 
 using namespace MicroOcpp;
@@ -42,8 +43,9 @@ MeteringConnector::MeteringConnector(Model& model, int connectorId, MeterStore&
         meterValueCacheSizeInt = varService->declareVariable<int>("CustomCtrlr","MeterValueCacheSize",1);
         meterValuesInTxOnlyBool = varService->declareVariable<bool>("CustomCtrlr","MeterValuesInTxOnly",true);
         stopTxnDataCapturePeriodicBool = varService->declareVariable<bool>("CustomCtrlr","StopTxnDataCapturePeriodic",false);
+        meterValuesBatchMaxSizeInt = varService->declareVariable<int>("CustomCtrlr","MeterValuesBatchMaxSize",0);
         
-        txStartDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, meterValuesTxStartedDataString));
+        txStartDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, samplerIndex, meterValuesTxStartedDataString));
     }else
 #endif
     {
@@ -59,15 +61,15 @@ MeteringConnector::MeteringConnector(Model& model, int connectorId, MeterStore&
         stopTxnAlignedDataString = declareConfiguration<const char*>("StopTxnAlignedData", "");
         meterValuesInTxOnlyBool = declareConfiguration<bool>(MO_CONFIG_EXT_PREFIX "MeterValuesInTxOnly", true);
         stopTxnDataCapturePeriodicBool = declareConfiguration<bool>(MO_CONFIG_EXT_PREFIX "StopTxnDataCapturePeriodic", false);
+        meterValuesBatchMaxSizeInt = declareConfiguration<int>(MO_CONFIG_EXT_PREFIX "MeterValuesBatchMaxSize", 0); //max payload size of batched MeterValues. 0 disables batching
     }
-    sampledDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, meterValuesSampledDataString));
-    alignedDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, meterValuesAlignedDataString));
-    stopTxnSampledDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, stopTxnSampledDataString));
-    stopTxnAlignedDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, stopTxnAlignedDataString));
+    sampledDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, samplerIndex, meterValuesSampledDataString));
+    alignedDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, samplerIndex, meterValuesAlignedDataString));
+    stopTxnSampledDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, samplerIndex, stopTxnSampledDataString));
+    stopTxnAlignedDataBuilder = std::unique_ptr<MeterValueBuilder>(new MeterValueBuilder(samplers, samplerIndex, stopTxnAlignedDataString));
 }
 
-std::unique_ptr<Operation> MeteringConnector::loop() {
-    bool txBreak = false;
+std::shared_ptr<ITransaction> MeteringConnector::getCurrentTransaction() {
     std::shared_ptr<ITransaction> curTx = nullptr;
 #if MO_ENABLE_V201    
     if(model.getVersion().major == 2){
@@ -81,6 +83,12 @@ std::unique_ptr<Operation> MeteringConnector::loop() {
             curTx = model.getConnector(connectorId)->getTransaction();
         }
     }
+    return curTx;
+}
+
+std::unique_ptr<Operation> MeteringConnector::loop() {
+    bool txBreak = false;
+    auto curTx = getCurrentTransaction();
 
     txBreak = (curTx && curTx->isRunning()) != trackTxRunning;
     trackTxRunning = (curTx && curTx->isRunning());
@@ -102,6 +110,9 @@ std::unique_ptr<Operation> MeteringConnector::loop() {
 #endif
         {
             auto meterValues = std::unique_ptr<MeterValues>(new MeterValues(std::move(meterData), connectorId, transaction,model.getVersion()));
+            if (meterValuesBatchMaxSizeInt->getInt() > 0) {
+                meterValues->setBatchMaxSize((size_t) meterValuesBatchMaxSizeInt->getInt());
+            }
             meterData.clear();
             return std::move(meterValues); //std::move is required for some compilers even if it's not mandated by standard C++
 
@@ -237,7 +248,7 @@ std::unique_ptr<Operation> MeteringConnector::loop() {
                     stopTxnData->addTxData(std::move(sampleStopTx));
                 }
             }
-            lastSampleTime = mocpp_tick_ms();
+            lastTxEndSampleTime = mocpp_tick_ms();
         }
     }
 #endif
@@ -248,6 +259,67 @@ std::unique_ptr<Operation> MeteringConnector::loop() {
     return nullptr; //successful method completition. Currently there is no reason to send a MeterValues Msg.
 }
 
+static unsigned long getWakeupMsUntilAligned(const Timestamp& nextAligned, const Timestamp& tnow, int interval) {
+    int dt = nextAligned - tnow;
+    if (dt <= 0 || dt > interval) {
+        return 0;
+    }
+    return std::min((unsigned long) dt * 1000UL, (unsigned long) MO_WAKEUP_MAX_MS);
+}
+
+static unsigned long getWakeupMsUntilPeriodic(unsigned long lastSample, int interval) {
+    unsigned long intervalMs = (unsigned long) interval * 1000UL;
+    unsigned long elapsed = mocpp_tick_ms() - lastSample;
+    if (elapsed >= intervalMs) {
+        return 0;
+    }
+    return std::min(intervalMs - elapsed, (unsigned long) MO_WAKEUP_MAX_MS);
+}
+
+unsigned long MeteringConnector::getNextWakeupMs() {
+
+    auto curTx = getCurrentTransaction();
+    bool txRunning = curTx && curTx->isRunning();
+    if (txRunning != trackTxRunning || transaction != curTx) {
+        return 0;
+    }
+
+    if (!meterData.empty() && meterData.size() >= (size_t) meterValueCacheSizeInt->getInt()) {
+        return 0;
+    }
+
+    unsigned long res = MO_WAKEUP_MAX_MS;
+
+    auto& tnow = model.getClock().now();
+
+    bool sampling = (transaction && transaction->isRunning() && !transaction->isSilent()) ||
+            connectorId == 0 || !meterValuesInTxOnlyBool->getBool();
+
+    if (sampling) {
+        if (clockAlignedDataIntervalInt->getInt() >= 1 && tnow >= MIN_TIME) {
+            res = std::min(res, getWakeupMsUntilAligned(nextAlignedTime, tnow, clockAlignedDataIntervalInt->getInt()));
+        }
+
+        if (meterValueSampleIntervalInt->getInt() >= 1) {
+            res = std::min(res, getWakeupMsUntilPeriodic(lastSampleTime, meterValueSampleIntervalInt->getInt()));
+        }
+    }
+
+#if MO_ENABLE_V201
+    if (model.getVersion().major == 2) {
+        if (alignedDataTxEndedIntervalInt->getInt() >= 1 && tnow >= MIN_TIME) {
+            res = std::min(res, getWakeupMsUntilAligned(nextTxEndAlignedTime, tnow, alignedDataTxEndedIntervalInt->getInt()));
+        }
+
+        if (sampledDataTxEndedIntervalInt->getInt() >= 1) {
+            res = std::min(res, getWakeupMsUntilPeriodic(lastTxEndSampleTime, sampledDataTxEndedIntervalInt->getInt()));
+        }
+    }
+#endif //MO_ENABLE_V201
+
+    return res;
+}
+
 std::unique_ptr<Operation> MeteringConnector::takeTriggeredMeterValues() {
 
     auto sample = sampledDataBuilder->takeSample(model.getClock().now(), ReadingContext::Trigger);
@@ -282,6 +354,7 @@ void MeteringConnector::addMeterValueSampler(std::unique_ptr<SampledValueSampler
         energySamplerIndex = samplers.size();
     }
     samplers.push_back(std::move(meterValueSampler));
+    samplerIndex.addSampler(samplers.size() - 1);
 }
 
 std::unique_ptr<SampledValue> MeteringConnector::readTxEnergyMeter(ReadingContext model) {
@@ -337,14 +410,7 @@ std::shared_ptr<TransactionMeterData> MeteringConnector::getStopTxMeterData(ITra
 }
 
 bool MeteringConnector::existsSampler(const char *measurand, size_t len) {
-    for (size_t i = 0; i < samplers.size(); i++) {
-        if (samplers[i]->getProperties().getMeasurand().length() == len &&
-                !strncmp(measurand, samplers[i]->getProperties().getMeasurand().c_str(), len)) {
-            return true;
-        }
-    }
-
-    return false;
+    return samplerIndex.getMeasurandId(measurand, len) >= 0;
 }
 
 #if MO_ENABLE_V201 
@@ -368,4 +434,8 @@ bool MeteringConnector::takeTriggeredTransactionEvent() {
 std::unique_ptr<MeterValue> MeteringConnector::takeBeginMeterValue() {
     return txStartDataBuilder->takeSample(model.getClock().now(), ReadingContext::TransactionBegin);
 }
+
+std::unique_ptr<MeterValue> MeteringConnector::deserializeMeterValue(JsonObject mvJson) {
+    return sampledDataBuilder->deserializeSample(mvJson);
+}
 #endif
\ No newline at end of file
@@ -40,6 +40,7 @@ private:
     bool trackTxRunning = false;
  
     std::vector<std::unique_ptr<SampledValueSampler>> samplers;
+    SamplerIndex samplerIndex {samplers};
     int energySamplerIndex {-1};
 
     std::shared_ptr<ICfg> meterValueSampleIntervalInt;
@@ -47,6 +48,7 @@ private:
     std::shared_ptr<ICfg> clockAlignedDataIntervalInt;
     std::shared_ptr<ICfg> meterValuesInTxOnlyBool;
     std::shared_ptr<ICfg> stopTxnDataCapturePeriodicBool;
+    std::shared_ptr<ICfg> meterValuesBatchMaxSizeInt;
 #if MO_ENABLE_V201
     std::shared_ptr<ICfg> sampledDataTxEndedIntervalInt;
     std::shared_ptr<ICfg> alignedDataTxEndedIntervalInt;
@@ -54,11 +56,15 @@ private:
     unsigned long lastTxEndSampleTime = 0; //0 means not charging right now
     Timestamp nextTxEndAlignedTime;
 #endif
+
+    std::shared_ptr<ITransaction> getCurrentTransaction();
 public:
     MeteringConnector(Model& model, int connectorId, MeterStore& meterStore);
 
     std::unique_ptr<Operation> loop();
 
+    unsigned long getNextWakeupMs(); //time until the next clock-aligned or periodic sample is due
+
     void addMeterValueSampler(std::unique_ptr<SampledValueSampler> meterValueSampler);
 
     std::unique_ptr<SampledValue> readTxEnergyMeter(ReadingContext model);
@@ -78,6 +84,7 @@ public:
 #if MO_ENABLE_V201
     bool takeTriggeredTransactionEvent();
     std::unique_ptr<MeterValue> takeBeginMeterValue();
+    std::unique_ptr<MeterValue> deserializeMeterValue(JsonObject mvJson); //restores a MeterValue which has been stored as JSON
 #endif
 
 };
@@ -2,6 +2,8 @@
 // Copyright Matthias Akstaller 2019 - 2024
 // MIT License
 
+#include <algorithm>
+
 #include <MicroOcpp/Model/Metering/MeteringService.h>
 #include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MicroOcpp/Core/Context.h>
@@ -72,6 +74,7 @@ MeteringService::MeteringService(Context& context, int numConn, std::shared_ptr<
     registerConfigurationValidator("StopTxnAlignedData", validateSelectString);
     registerConfigurationValidator("MeterValueSampleInterval", validateUnsignedIntString);
     registerConfigurationValidator("ClockAlignedDataInterval", validateUnsignedIntString);
+    registerConfigurationValidator(MO_CONFIG_EXT_PREFIX "MeterValuesBatchMaxSize", validateUnsignedIntString);
 
     /*
      * Register further message handlers to support echo mode: when this library
@@ -94,6 +97,14 @@ void MeteringService::loop(){
     }
 }
 
+unsigned long MeteringService::getNextWakeupMs() {
+    unsigned long res = MO_WAKEUP_MAX_MS;
+    for (unsigned int i = 0; i < connectors.size(); i++) {
+        res = std::min(res, connectors[i]->getNextWakeupMs());
+    }
+    return res;
+}
+
 void MeteringService::addMeterValueSampler(int connectorId, std::unique_ptr<SampledValueSampler> meterValueSampler) {
     if (connectorId < 0 || connectorId >= (int) connectors.size()) {
         MO_DBG_ERR("connectorId is out of bounds");
@@ -219,4 +230,17 @@ std::unique_ptr<MeterValue> MeteringService::takeBeginMeterValue(int connectorId
     MO_DBG_ERR("Could not find connector");
     return nullptr;
 }
+
+std::unique_ptr<MeterValue> MeteringService::deserializeMeterValue(int connectorId, JsonObject mvJson) {
+    if (connectorId < 0 || connectorId >= (int) connectors.size()) {
+        MO_DBG_ERR("connectorId out of bounds. Ignore");
+        return nullptr;
+    }
+    auto& connector = connectors.at(connectorId);
+    if (connector.get()) {
+        return connector->deserializeMeterValue(mvJson);
+    }
+    MO_DBG_ERR("Could not find connector");
+    return nullptr;
+}
 # endif
\ No newline at end of file
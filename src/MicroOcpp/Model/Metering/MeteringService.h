@@ -30,6 +30,8 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs();
+
     void addMeterValueSampler(int connectorId, std::unique_ptr<SampledValueSampler> meterValueSampler);
 
     std::unique_ptr<SampledValue> readTxEnergyMeter(int connectorId, ReadingContext reason);
@@ -50,6 +52,7 @@ public:
 #if MO_ENABLE_V201 
     bool takeTriggeredTransactionEvent(int connectorId);
     std::unique_ptr<MeterValue> takeBeginMeterValue(int connectorId);
+    std::unique_ptr<MeterValue> deserializeMeterValue(int connectorId, JsonObject mvJson);
 #endif
 };
 
@@ -5,9 +5,10 @@
 #include <MicroOcpp/Model/Metering/SampledValue.h>
 #include <MicroOcpp/Debug.h>
 #include <cinttypes>
+#include <cstring>
 
-#ifndef MO_SAMPLEDVALUE_FLOAT_FORMAT
-#define MO_SAMPLEDVALUE_FLOAT_FORMAT "%.2f"
+#ifndef MO_SAMPLEDVALUE_FLOAT_DECIMALS
+#define MO_SAMPLEDVALUE_FLOAT_DECIMALS 2 //ignored if MO_SAMPLEDVALUE_FLOAT_FORMAT is defined
 #endif
 
 using namespace MicroOcpp;
@@ -16,17 +17,96 @@ int32_t SampledValueDeSerializer<int32_t>::deserialize(const char *str) {
     return strtol(str, nullptr, 10);
 }
 
-std::string SampledValueDeSerializer<int32_t>::serialize(int32_t& val) {
-    char str [12] = {'\0'};
-    snprintf(str, 12, "%" PRId32, val);
-    return std::string(str);
+int SampledValueDeSerializer<int32_t>::serialize(int32_t& val, char *buf, size_t size) {
+    return snprintf(buf, size, "%" PRId32, val);
+}
+
+#ifndef MO_SAMPLEDVALUE_FLOAT_FORMAT
+/*
+ * Fixed-point formatting of floats with the given number of decimals, like snprintf(buf, size, "%.2f", val)
+ * but without the overhead of the generic printf implementation
+ */
+static int printFixedPoint(float val, unsigned int decimals, char *buf, size_t size) {
+    const uint32_t pow10 [] = {1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000};
+
+    if (decimals >= sizeof(pow10) / sizeof(pow10[0])) {
+        return snprintf(buf, size, "%.*f", (int) decimals, (double) val);
+    }
+
+    double scaled = (double) val * pow10[decimals];
+    bool negative = scaled < 0.;
+    if (negative) {
+        scaled = -scaled;
+    }
+
+    if (!(scaled < 1e18)) {
+        //out of range for integer arithmetics, NaN or infinite
+        return snprintf(buf, size, "%.*f", (int) decimals, (double) val);
+    }
+
+    uint64_t fixed = (uint64_t) (scaled + 0.5);
+
+    char digits [24]; //digits in reverse order
+    size_t n = 0;
+    for (unsigned int i = 0; i < decimals; i++) {
+        digits[n++] = '0' + (char) (fixed % 10);
+        fixed /= 10;
+    }
+    if (decimals > 0) {
+        digits[n++] = '.';
+    }
+    do {
+        digits[n++] = '0' + (char) (fixed % 10);
+        fixed /= 10;
+    } while (fixed);
+
+    bool isZero = true;
+    for (size_t i = 0; i < n; i++) {
+        if (digits[i] != '0' && digits[i] != '.') {
+            isZero = false;
+            break;
+        }
+    }
+    if (negative && !isZero) {
+        digits[n++] = '-';
+    }
+
+    if (size > 0) {
+        size_t len = n < size - 1 ? n : size - 1;
+        for (size_t i = 0; i < len; i++) {
+            buf[i] = digits[n - 1 - i];
+        }
+        buf[len] = '\0';
+    }
+
+    return (int) n;
+}
+#endif
+
+int SampledValueDeSerializer<float>::serialize(float& val, char *buf, size_t size) {
+#ifdef MO_SAMPLEDVALUE_FLOAT_FORMAT
+    return snprintf(buf, size, MO_SAMPLEDVALUE_FLOAT_FORMAT, val);
+#else
+    return printFixedPoint(val, MO_SAMPLEDVALUE_FLOAT_DECIMALS, buf, size);
+#endif
+}
+
+uint32_t SampledValueProperties::getKey() const {
+    return makeKey(format.c_str(), measurand.c_str(), phase.c_str(), location.c_str(), unit.c_str());
 }
 
-std::string SampledValueDeSerializer<float>::serialize(float& val) {
-    char str [20];
-    str[0] = '\0';
-    snprintf(str, 20, MO_SAMPLEDVALUE_FLOAT_FORMAT, val);
-    return std::string(str);
+uint32_t SampledValueProperties::makeKey(const char *format, const char *measurand, const char *phase, const char *location, const char *unit) {
+    //FNV-1a over all properties, each terminated by the '\0' byte
+    uint32_t key = 2166136261U;
+    const char *properties [] = {format, measurand, phase, location, unit};
+    for (size_t i = 0; i < sizeof(properties) / sizeof(properties[0]); i++) {
+        const char *c = properties[i] ? properties[i] : "";
+        do {
+            key ^= (uint32_t) (unsigned char) *c;
+            key *= 16777619U;
+        } while (*c++);
+    }
+    return key;
 }
 
 //helper function
@@ -89,56 +169,106 @@ ReadingContext deserializeReadingContext(const char *context) {
 }
 }} //end namespaces
 
-std::unique_ptr<DynamicJsonDocument> SampledValue::toJson(const ProtocolVersion& version) {
-    auto value = serializeValue();
-    if (value.empty()) {
-        return nullptr;
-    }
-    size_t capacity = 0;
-    capacity += JSON_OBJECT_SIZE(9);
-    capacity += value.length() + 1
-                + properties.getFormat().length() + 1
-                + properties.getMeasurand().length() + 1
-                + properties.getPhase().length() + 1
-                + properties.getLocation().length() + 1
-                + properties.getUnit().length() + 1;
-    auto result = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(capacity + 100)); //TODO remove safety space
-    auto payload = result->to<JsonObject>();
+namespace MicroOcpp {
+
+//selection of the properties which SampledValue::toJson() writes
+struct SampledValueFields {
+    const char *context = nullptr;
+    bool format = false, measurand = false, phase = false, location = false, unit = false;
+
+    SampledValueFields(const SampledValueProperties& properties, ReadingContext readingContext, const ProtocolVersion& version, bool compact) {
+        context = Ocpp16::serializeReadingContext(readingContext);
+        format = !properties.getFormat().empty();
+        measurand = !properties.getMeasurand().empty();
+        phase = !properties.getPhase().empty();
+        location = !properties.getLocation().empty();
+        unit = !properties.getUnit().empty();
+
+        if (compact && version.major == 1) {
+            //the defaults of OCPP 1.6 allow to omit these properties without changing the meaning of the sampled value
+            if (readingContext == ReadingContext::SamplePeriodic) {
+                context = nullptr;
+            }
+            format &= properties.getFormat().compare("Raw") != 0;
+            measurand &= properties.getMeasurand().compare("Energy.Active.Import.Register") != 0;
+            location &= properties.getLocation().compare("Outlet") != 0;
+            unit &= properties.getUnit().compare("Wh") != 0 ||
+                    (!properties.getMeasurand().empty() && properties.getMeasurand().compare(0, strlen("Energy"), "Energy") != 0);
+        }
+    }
+
+    size_t count() {
+        return (context ? 1 : 0) + (format ? 1 : 0) + (measurand ? 1 : 0) + (phase ? 1 : 0) + (location ? 1 : 0) + (unit ? 1 : 0);
+    }
+};
+
+} //end namespace MicroOcpp
+
+size_t SampledValue::getJsonCapacity(const ProtocolVersion& version, bool compact) {
+    SampledValueFields fields {properties, context, version, compact};
+
+    size_t capacity = JSON_OBJECT_SIZE(1 + fields.count()); //value and properties
+#if MO_ENABLE_V201
+    if (version.major == 2) {
+        if (fields.unit) {
+            capacity += JSON_OBJECT_SIZE(1); //unitOfMeasure
+        }
+        return capacity; //value is a number in OCPP 2.0.1
+    }
+#endif
+
+    char value [MO_SAMPLEDVALUE_STRING_SIZE];
+    auto ret = serializeValue(value, sizeof(value));
+    if (ret > 0 && (size_t) ret < sizeof(value)) {
+        capacity += (size_t) ret + 1;
+    }
+    return capacity;
+}
+
+bool SampledValue::toJson(JsonObject payload, const ProtocolVersion& version, bool compact) {
+    char value [MO_SAMPLEDVALUE_STRING_SIZE];
+    auto ret = serializeValue(value, sizeof(value));
+    if (ret <= 0 || (size_t) ret >= sizeof(value)) {
+        return false;
+    }
+
 #if MO_ENABLE_V201
     if(version.major==2)
     {
-        payload["value"] = std::stod(value);
+        payload["value"] = strtod(value, nullptr);
     }
     else
 #endif
     {
-        payload["value"] = value;
-    }
-    auto context_cstr = Ocpp16::serializeReadingContext(context);
-    if (context_cstr)
-        payload["context"] = context_cstr;
-    if (!properties.getFormat().empty())
-        payload["format"] = properties.getFormat();
-    if (!properties.getMeasurand().empty())
-        payload["measurand"] = properties.getMeasurand();
-    if (!properties.getPhase().empty())
-        payload["phase"] = properties.getPhase();
-    if (!properties.getLocation().empty())
-        payload["location"] = properties.getLocation();
-    if (!properties.getUnit().empty())
+        payload["value"] = value; //copy
+    }
+
+    //property strings are linked into the JSON document without copy
+    SampledValueFields fields {properties, context, version, compact};
+    if (fields.context)
+        payload["context"] = fields.context;
+    if (fields.format)
+        payload["format"] = properties.getFormat().c_str();
+    if (fields.measurand)
+        payload["measurand"] = properties.getMeasurand().c_str();
+    if (fields.phase)
+        payload["phase"] = properties.getPhase().c_str();
+    if (fields.location)
+        payload["location"] = properties.getLocation().c_str();
+    if (fields.unit)
     {
 #if MO_ENABLE_V201
         if(version.major==2)
         {
-            payload["unitOfMeasure"]["unit"] = properties.getUnit();
+            payload["unitOfMeasure"]["unit"] = properties.getUnit().c_str();
         }
         else
 #endif
         {
-            payload["unit"] = properties.getUnit();
+            payload["unit"] = properties.getUnit().c_str();
         }
     }
-    return result;
+    return true;
 }
 
 ReadingContext SampledValue::getReadingContext() {
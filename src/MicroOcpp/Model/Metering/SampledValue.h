@@ -12,14 +12,22 @@
 #include <MicroOcpp/Platform.h>
 #include <MicroOcpp/Version.h>
 
+#ifndef MO_SAMPLEDVALUE_STRING_SIZE
+#define MO_SAMPLEDVALUE_STRING_SIZE 48 //buffer size for the value string, including the terminating '\0'
+#endif
+
 namespace MicroOcpp {
 
+/*
+ * serialize() writes val as string into buf of the given size. Returns the string length like snprintf, i.e. the
+ * result is invalid if negative or not less than size
+ */
 template <class T>
 class SampledValueDeSerializer {
 public:
     static T deserialize(const char *str);
     static bool ready(T& val);
-    static std::string serialize(T& val);
+    static int serialize(T& val, char *buf, size_t size);
     static int32_t toInteger(T& val);
 };
 
@@ -28,7 +36,7 @@ class SampledValueDeSerializer<int32_t> { // example class
 public:
     static int32_t deserialize(const char *str);
     static bool ready(int32_t& val) {return true;} //int32_t is always valid
-    static std::string serialize(int32_t& val);
+    static int serialize(int32_t& val, char *buf, size_t size);
     static int32_t toInteger(int32_t& val) {return val;} //no conversion required
 };
 
@@ -37,7 +45,7 @@ class SampledValueDeSerializer<float> { // Used in meterValues
 public:
     static float deserialize(const char *str) {return atof(str);}
     static bool ready(float& val) {return true;} //float is always valid
-    static std::string serialize(float& val);
+    static int serialize(float& val, char *buf, size_t size);
     static int32_t toInteger(float& val) {return (int32_t) val;}
 };
 
@@ -69,6 +77,9 @@ public:
     const std::string& getLocation() const {return location;}
     void setUnit(const char *unit) {this->unit = unit;}
     const std::string& getUnit() const {return unit;}
+
+    uint32_t getKey() const; //hash over all properties. Use for lookups, then confirm with a full comparison
+    static uint32_t makeKey(const char *format, const char *measurand, const char *phase, const char *location, const char *unit);
 };
 
 enum class ReadingContext {
@@ -92,13 +103,19 @@ class SampledValue {
 protected:
     const SampledValueProperties& properties;
     const ReadingContext context;
-    virtual std::string serializeValue() = 0;
+    virtual int serializeValue(char *buf, size_t size) = 0;
 public:
     SampledValue(const SampledValueProperties& properties, ReadingContext context) : properties(properties), context(context) { }
     SampledValue(const SampledValue& other) : properties(other.properties), context(other.context) { }
     virtual ~SampledValue() = default;
 
-    std::unique_ptr<DynamicJsonDocument> toJson(const ProtocolVersion& version=VER_1_6_J);
+    /*
+     * Serialization into a JSON document owned by the caller. getJsonCapacity() returns the exact capacity which
+     * toJson() consumes. The property strings are linked into the document without copy, so the document must
+     * not outlive this SampledValue. compact: omit properties which equal the OCPP 1.6 defaults
+     */
+    size_t getJsonCapacity(const ProtocolVersion& version=VER_1_6_J, bool compact=false);
+    bool toJson(JsonObject out, const ProtocolVersion& version=VER_1_6_J, bool compact=false);
 
     virtual operator bool() = 0;
     virtual int32_t toInteger() = 0;
@@ -117,7 +134,7 @@ public:
 
     operator bool() override {return DeSerializer::ready(value);}
 
-    std::string serializeValue() override {return DeSerializer::serialize(value);}
+    int serializeValue(char *buf, size_t size) override {return DeSerializer::serialize(value, buf, size);}
 
     int32_t toInteger() override { return DeSerializer::toInteger(value);}
 };
@@ -5,6 +5,7 @@
 #include <MicroOcpp/Model/Model.h>
 
 #include <string>
+#include <algorithm>
 
 #include <MicroOcpp/Model/Transactions/TransactionStore.h>
 #include <MicroOcpp/Model/SmartCharging/SmartChargingService.h>
@@ -58,18 +59,24 @@ void Model::loop() {
     if (smartChargingService)
         smartChargingService->loop();
 
-    if (heartbeatService)
+    //purely timer-driven services: skip while they are idle
+    if (heartbeatService && heartbeatService->getNextWakeupMs() == 0)
         heartbeatService->loop();
 
     if (meteringService)
         meteringService->loop();
 
-    if (diagnosticsService)
+    if (diagnosticsService && diagnosticsService->getNextWakeupMs() == 0)
         diagnosticsService->loop();
 
-    if (firmwareService)
+    if (firmwareService && firmwareService->getNextWakeupMs() == 0)
         firmwareService->loop();
 
+#if MO_ENABLE_LOCAL_AUTH
+    if (authorizationService && authorizationService->getNextWakeupMs() == 0)
+        authorizationService->loop();
+#endif //MO_ENABLE_LOCAL_AUTH
+
 #if MO_ENABLE_RESERVATION
     if (reservationService)
         reservationService->loop();
@@ -81,16 +88,83 @@ void Model::loop() {
         if (transactionService)
             transactionService->loop();
         
-        if (resetServiceV201)
+        if (resetServiceV201 && resetServiceV201->getNextWakeupMs() == 0)
             resetServiceV201->loop();
     }else
 #endif
     {
-        if (resetService)
+        if (resetService && resetService->getNextWakeupMs() == 0)
             resetService->loop();
     }
 }
 
+unsigned long Model::getNextWakeupMs() {
+    return getNextWakeupMs(false);
+}
+
+unsigned long Model::getNextDeadlineMs() {
+    return getNextWakeupMs(true);
+}
+
+unsigned long Model::getNextWakeupMs(bool deadlinesOnly) {
+
+    unsigned long res = MO_WAKEUP_MAX_MS;
+
+    if (bootService) {
+        res = std::min(res, bootService->getNextWakeupMs());
+    }
+
+    if (capabilitiesUpdated) {
+        return 0;
+    }
+
+    if (!runTasks) {
+        return res;
+    }
+
+    for (auto& connector : connectors) {
+        res = std::min(res, deadlinesOnly ? connector->getNextDeadlineMs() : connector->getNextWakeupMs());
+    }
+
+    if (smartChargingService)
+        res = std::min(res, smartChargingService->getNextWakeupMs());
+
+    if (heartbeatService)
+        res = std::min(res, heartbeatService->getNextWakeupMs());
+
+    if (meteringService)
+        res = std::min(res, meteringService->getNextWakeupMs());
+
+    if (diagnosticsService)
+        res = std::min(res, diagnosticsService->getNextWakeupMs());
+
+    if (firmwareService)
+        res = std::min(res, firmwareService->getNextWakeupMs());
+
+#if MO_ENABLE_LOCAL_AUTH
+    if (authorizationService)
+        res = std::min(res, authorizationService->getNextWakeupMs());
+#endif //MO_ENABLE_LOCAL_AUTH
+
+#if MO_ENABLE_RESERVATION
+    if (reservationService)
+        res = std::min(res, reservationService->getNextWakeupMs());
+#endif //MO_ENABLE_RESERVATION
+
+#if MO_ENABLE_V201
+    if(version.major==2){
+        if (resetServiceV201)
+            res = std::min(res, resetServiceV201->getNextWakeupMs());
+    }else
+#endif
+    {
+        if (resetService)
+            res = std::min(res, resetService->getNextWakeupMs());
+    }
+
+    return res;
+}
+
 void Model::setTransactionStore(std::unique_ptr<TransactionStore> ts) {
     transactionStore = std::move(ts);
     capabilitiesUpdated = true;
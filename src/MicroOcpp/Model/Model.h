@@ -84,6 +84,8 @@ private:
 
     bool runTasks = false;
 
+    unsigned long getNextWakeupMs(bool deadlinesOnly);
+
     const uint16_t bootNr = 0; //each boot of this lib has a unique number
 
 public:
@@ -93,6 +95,18 @@ public:
 
     void loop();
 
+    /*
+     * Time in ms until loop() has pending work which is triggered by a timer. Changes of the hardware inputs
+     * (e.g. connectorPlugged) are not predicted. 0 if loop() should be called immediately again
+     */
+    unsigned long getNextWakeupMs();
+
+    /*
+     * Like getNextWakeupMs(), but for hosts which call loop() whenever an input changes (e.g. simulations with scripted
+     * inputs). Running transactions don't keep the result at 0, only the timers of the services count
+     */
+    unsigned long getNextDeadlineMs();
+
     void activateTasks() {runTasks = true;}
 
     void setTransactionStore(std::unique_ptr<TransactionStore> transactionStore);
@@ -6,6 +6,8 @@
 
 #if MO_ENABLE_RESERVATION
 
+#include <algorithm>
+
 #include <MicroOcpp/Model/Reservation/ReservationService.h>
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
@@ -74,6 +76,20 @@ void ReservationService::loop() {
     }
 }
 
+unsigned long ReservationService::getNextWakeupMs() {
+    //connector and tx updates wake up the loop anyway. Only the expiry of a reservation is a deadline on its own
+    unsigned long res = MO_WAKEUP_MAX_MS;
+    auto& tnow = context.getModel().getClock().now();
+    for (auto& reservation : reservations) {
+        if (reservation->isActive()) {
+            auto expiry = reservation->getExpiryDate();
+            expiry += 1; //isActive() turns false once now > expiryDate
+            res = std::min(res, getWakeupMsUntil(tnow, expiry));
+        }
+    }
+    return res;
+}
+
 Reservation *ReservationService::getReservation(unsigned int connectorId) {
     if (connectorId == 0) {
         MO_DBG_DEBUG("tried to fetch connectorId 0");
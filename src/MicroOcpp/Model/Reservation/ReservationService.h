@@ -31,6 +31,8 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs(); //time until the next reservation expires, MO_WAKEUP_MAX_MS if there is none
+
     Reservation *getReservation(unsigned int connectorId); //by connectorId
     Reservation *getReservation(const char *idTag, const char *parentIdTag = nullptr); //by idTag
 
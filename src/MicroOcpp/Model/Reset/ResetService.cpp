@@ -2,6 +2,8 @@
 // Copyright Matthias Akstaller 2019 - 2024
 // MIT License
 
+#include <algorithm>
+
 #include <MicroOcpp/Model/Reset/ResetService.h>
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
@@ -70,6 +72,15 @@ void ResetService::loop() {
     }
 }
 
+unsigned long ResetService::getNextWakeupMs() {
+    if (outstandingResetRetries <= 0) {
+        return MO_WAKEUP_MAX_MS;
+    }
+
+    unsigned long elapsed = mocpp_tick_ms() - t_resetRetry;
+    return elapsed >= MO_RESET_DELAY ? 0 : std::min((unsigned long) MO_RESET_DELAY - elapsed, (unsigned long) MO_WAKEUP_MAX_MS);
+}
+
 void ResetService::setPreReset(std::function<bool(bool)> preReset) {
     this->preReset = preReset;
 }
@@ -188,6 +199,19 @@ void ResetService::Evse::loop() {
     }
 }
 
+unsigned long ResetService::Evse::getNextWakeupMs() {
+    if (!outstandingResetRetries) {
+        return MO_WAKEUP_MAX_MS;
+    }
+
+    if (awaitTxStop) {
+        return 0; //poll tx state
+    }
+
+    unsigned long elapsed = mocpp_tick_ms() - t_resetRetry;
+    return elapsed >= MO_RESET_DELAY ? 0 : std::min((unsigned long) MO_RESET_DELAY - elapsed, (unsigned long) MO_WAKEUP_MAX_MS);
+}
+
 ResetService::Evse *ResetService::getEvse(unsigned int evseId) {
     for (size_t i = 0; i < evses.size(); i++) {
         if (evses[i].evseId == evseId) {
@@ -217,6 +241,14 @@ void ResetService::loop() {
     }
 }
 
+unsigned long ResetService::getNextWakeupMs() {
+    unsigned long res = MO_WAKEUP_MAX_MS;
+    for (Evse& evse : evses) {
+        res = std::min(res, evse.getNextWakeupMs());
+    }
+    return res;
+}
+
 void ResetService::setNotifyReset(std::function<bool(ResetType)> notifyReset, unsigned int evseId) {
     Evse *evse = getOrCreateEvse(evseId);
     if (!evse) {
@@ -35,6 +35,8 @@ public:
     
     void loop();
 
+    unsigned long getNextWakeupMs();
+
     void setPreReset(std::function<bool(bool isHard)> preReset);
     std::function<bool(bool isHard)> getPreReset();
 
@@ -84,6 +86,8 @@ private:
         Evse(Context& context, ResetService& resetService, unsigned int evseId);
 
         void loop();
+
+        unsigned long getNextWakeupMs();
     };
 
     std::vector<Evse> evses;
@@ -98,6 +102,8 @@ public:
     
     void loop();
 
+    unsigned long getNextWakeupMs();
+
     void setNotifyReset(std::function<bool(ResetType)> notifyReset, unsigned int evseId = 0);
     std::function<bool(ResetType)> getNotifyReset(unsigned int evseId = 0);
 
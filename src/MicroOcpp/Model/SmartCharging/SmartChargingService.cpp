@@ -2,6 +2,8 @@
 // Copyright Matthias Akstaller 2019 - 2024
 // MIT License
 
+#include <algorithm>
+
 #include <MicroOcpp/Model/SmartCharging/SmartChargingService.h>
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
@@ -189,6 +191,10 @@ void SmartChargingConnector::loop(){
     }
 }
 
+unsigned long SmartChargingConnector::getNextWakeupMs() {
+    return getWakeupMsUntil(model.getClock().now(), nextChange);
+}
+
 void SmartChargingConnector::setSmartChargingOutput(std::function<void(float,float,int)> limitOutput) {
     if (this->limitOutput) {
         MO_DBG_WARN("replacing existing SmartChargingOutput");
@@ -576,6 +582,14 @@ void SmartChargingService::loop(){
     }
 }
 
+unsigned long SmartChargingService::getNextWakeupMs() {
+    unsigned long res = getWakeupMsUntil(context.getModel().getClock().now(), nextChange);
+    for (size_t i = 0; i < connectors.size(); i++) {
+        res = std::min(res, connectors[i].getNextWakeupMs());
+    }
+    return res;
+}
+
 void SmartChargingService::setSmartChargingOutput(unsigned int connectorId, std::function<void(float,float,int)> limitOutput) {
     if ((connectorId > 0 && !getScConnectorById(connectorId))) {
         MO_DBG_ERR("invalid args");
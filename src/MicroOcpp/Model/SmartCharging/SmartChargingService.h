@@ -59,6 +59,8 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs(); //time until the limit changes next
+
     void setSmartChargingOutput(std::function<void(float,float,int)> limitOutput); //read maximum Watt x Amps x numberPhases
 
     ChargingProfile *updateProfiles(std::unique_ptr<ChargingProfile> chargingProfile);
@@ -103,6 +105,8 @@ public:
 
     void loop();
 
+    unsigned long getNextWakeupMs();
+
     void setSmartChargingOutput(unsigned int connectorId, std::function<void(float,float,int)> limitOutput); //read maximum Watt x Amps x numberPhases
     void updateAllowedChargingRateUnit(bool powerSupported, bool currentSupported); //set supported measurand of SmartChargingOutput
 
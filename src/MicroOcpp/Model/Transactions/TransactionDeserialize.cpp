@@ -291,4 +291,100 @@ bool deserializeTransaction(ITransaction& tx, JsonObject state) {
     return true;
 }
 
+
+#if MO_ENABLE_V201
+
+bool serializeTransactionEvent(Ocpp201::TransactionEventData& txEvent, JsonObject out) {
+
+    out["eventType"] = (int) txEvent.eventType;
+
+    char timestamp [JSONDATE_LENGTH + 1] = {'\0'};
+    txEvent.timestamp.toJsonString(timestamp, JSONDATE_LENGTH + 1);
+    out["timestamp"] = timestamp;
+
+    out["triggerReason"] = (int) txEvent.triggerReason;
+
+    if (txEvent.offline) {
+        out["offline"] = true;
+    }
+    if (txEvent.numberOfPhasesUsed >= 0) {
+        out["numberOfPhasesUsed"] = txEvent.numberOfPhasesUsed;
+    }
+    if (txEvent.cableMaxCurrent >= 0) {
+        out["cableMaxCurrent"] = txEvent.cableMaxCurrent;
+    }
+    if (txEvent.reservationId >= 0) {
+        out["reservationId"] = txEvent.reservationId;
+    }
+    if (txEvent.remoteStartId >= 0) {
+        out["remoteStartId"] = txEvent.remoteStartId;
+    }
+    if (txEvent.chargingState != Ocpp201::TransactionEventData::ChargingState::UNDEFINED) {
+        out["chargingState"] = (int) txEvent.chargingState;
+    }
+    if (txEvent.idToken) {
+        out["idToken"] = txEvent.idToken->get();
+        out["idTokenType"] = txEvent.idToken->getTypeCstr();
+    }
+    if (txEvent.evse.id >= 0) {
+        out["evseId"] = txEvent.evse.id;
+        if (txEvent.evse.connectorId >= 0) {
+            out["connectorId"] = txEvent.evse.connectorId;
+        }
+    }
+    return true;
+}
+
+bool deserializeTransactionEvent(Ocpp201::TransactionEventData& txEvent, JsonObject in) {
+
+    int eventType = in["eventType"] | -1;
+    if (eventType < (int) Ocpp201::TransactionEventData::Type::Ended || eventType > (int) Ocpp201::TransactionEventData::Type::Updated) {
+        MO_DBG_ERR("read err");
+        return false;
+    }
+    txEvent.eventType = (Ocpp201::TransactionEventData::Type) eventType;
+
+    if (!txEvent.timestamp.setTime(in["timestamp"] | "Invalid")) {
+        MO_DBG_ERR("read err");
+        return false;
+    }
+
+    int triggerReason = in["triggerReason"] | -1;
+    if (triggerReason < (int) Ocpp201::TransactionEventTriggerReason::UNDEFINED || triggerReason > (int) Ocpp201::TransactionEventTriggerReason::ResetCommand) {
+        MO_DBG_ERR("read err");
+        return false;
+    }
+    txEvent.triggerReason = (Ocpp201::TransactionEventTriggerReason) triggerReason;
+
+    txEvent.offline = in["offline"] | false;
+    txEvent.numberOfPhasesUsed = in["numberOfPhasesUsed"] | -1;
+    txEvent.cableMaxCurrent = in["cableMaxCurrent"] | -1;
+    txEvent.reservationId = in["reservationId"] | -1;
+    txEvent.remoteStartId = in["remoteStartId"] | -1;
+
+    int chargingState = in["chargingState"] | (int) Ocpp201::TransactionEventData::ChargingState::UNDEFINED;
+    if (chargingState < (int) Ocpp201::TransactionEventData::ChargingState::UNDEFINED || chargingState > (int) Ocpp201::TransactionEventData::ChargingState::Idle) {
+        MO_DBG_ERR("read err");
+        return false;
+    }
+    txEvent.chargingState = (Ocpp201::TransactionEventData::ChargingState) chargingState;
+
+    if (in.containsKey("idToken")) {
+        std::unique_ptr<IdToken> idToken {new IdToken()};
+        if (!idToken->parseCstr(in["idToken"] | "", in["idTokenType"] | "")) {
+            MO_DBG_ERR("read err");
+            return false;
+        }
+        txEvent.idToken = std::move(idToken);
+    }
+
+    if (in.containsKey("evseId")) {
+        txEvent.evse = EvseId(in["evseId"] | -1, in["connectorId"] | -1);
+    }
+
+    return true;
+}
+
+#endif //MO_ENABLE_V201
+
 }
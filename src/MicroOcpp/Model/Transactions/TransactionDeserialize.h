@@ -14,6 +14,15 @@ namespace MicroOcpp {
 bool serializeTransaction(ITransaction& tx, DynamicJsonDocument& out);
 bool deserializeTransaction(ITransaction& tx, JsonObject in);
 
+bool serializeSendStatus(SendStatus& status, JsonObject out);
+bool deserializeSendStatus(SendStatus& status, JsonObject in);
+
+#if MO_ENABLE_V201
+//TransactionEvent fields except transaction, seqNo and meterValue
+bool serializeTransactionEvent(Ocpp201::TransactionEventData& txEvent, JsonObject out);
+bool deserializeTransactionEvent(Ocpp201::TransactionEventData& txEvent, JsonObject in);
+#endif //MO_ENABLE_V201
+
 }
 
 #endif
@@ -0,0 +1,382 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Version.h>
+
+#if MO_ENABLE_V201
+
+#include <MicroOcpp/Model/Transactions/TransactionEventQueue.h>
+#include <MicroOcpp/Model/Transactions/TransactionDeserialize.h>
+#include <MicroOcpp/Model/Transactions/TransactionStore.h>
+#include <MicroOcpp/Model/Metering/MeteringService.h>
+#include <MicroOcpp/Model/Variables/VariableService.h>
+#include <MicroOcpp/Model/Model.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Operations/TransactionEvent.h>
+#include <MicroOcpp/Debug.h>
+
+#include <string.h>
+#include <algorithm>
+
+using namespace MicroOcpp;
+using namespace MicroOcpp::Ocpp201;
+
+namespace MicroOcpp {
+namespace TransactionEventQueueUtils {
+
+bool printEventFn(char *fn, unsigned int evseId, unsigned int slot) {
+    auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX "txe-%u-%u.jsn", evseId, slot);
+    if (ret < 0 || ret >= MO_MAX_PATH_SIZE) {
+        MO_DBG_ERR("fn error: %i", ret);
+        return false;
+    }
+    return true;
+}
+
+} //end namespace TransactionEventQueueUtils
+} //end namespace MicroOcpp
+
+using namespace MicroOcpp::TransactionEventQueueUtils;
+
+TransactionEventQueue::TransactionEventQueue(Context& context, unsigned int evseId, std::shared_ptr<FilesystemAdapter> filesystem)
+        : context(context), model(context.getModel()), filesystem(filesystem), evseId(evseId) {
+
+    auto varService = model.getVariableService();
+    messageAttemptsInt = varService->declareVariable<int>("OCPPCommCtrlr", "MessageAttempts", 3, MO_VARIABLE_FN, Variable::Mutability::ReadWrite, "TransactionEvent");
+    messageAttemptIntervalInt = varService->declareVariable<int>("OCPPCommCtrlr", "MessageAttemptInterval", 60, MO_VARIABLE_FN, Variable::Mutability::ReadWrite, "TransactionEvent");
+
+    queue.reserve(MO_TXEVENTRECORD_SIZE);
+
+    load();
+
+    if (!context.getRequestQueue().addSendQueue(this)) { //register at RequestQueue as Request emitter
+        MO_DBG_ERR("TransactionEvent queue of EVSE %u cannot send requests", evseId);
+    }
+}
+
+void TransactionEventQueue::load() {
+    if (!filesystem) {
+        MO_DBG_DEBUG("volatile mode");
+        return;
+    }
+
+    char fnPrefix [30];
+    snprintf(fnPrefix, sizeof(fnPrefix), "txe-%u-", evseId);
+    size_t fnPrefixLen = strlen(fnPrefix);
+
+    std::vector<uint16_t> slots;
+
+    filesystem->ftw_root([fnPrefix, fnPrefixLen, &slots] (const char *fname) {
+        if (!strncmp(fname, fnPrefix, fnPrefixLen)) {
+            unsigned int slot = 0;
+            for (size_t i = fnPrefixLen; fname[i] >= '0' && fname[i] <= '9'; i++) {
+                slot *= 10;
+                slot += fname[i] - '0';
+            }
+            if (slot < MO_TXEVENTRECORD_SIZE) {
+                slots.push_back((uint16_t) slot);
+            }
+        }
+        return 0;
+    });
+
+    for (auto slot : slots) {
+        char fn [MO_MAX_PATH_SIZE];
+        if (!printEventFn(fn, evseId, slot)) {
+            return;
+        }
+
+        auto doc = FilesystemUtils::loadJson(filesystem, fn);
+        if (!doc) {
+            MO_DBG_ERR("failed to load %s", fn);
+            filesystem->remove(fn);
+            continue;
+        }
+
+        JsonObject in = doc->as<JsonObject>();
+
+        Entry entry;
+        if (!in.containsKey("eventNr") || !in.containsKey("txNr") ||
+                !deserializeSendStatus(entry.sync, in["sync"])) {
+            MO_DBG_ERR("corrupted TransactionEvent %s", fn);
+            filesystem->remove(fn);
+            continue;
+        }
+        entry.eventNr = in["eventNr"];
+        entry.txNr = in["txNr"];
+        entry.slot = slot;
+
+        queue.push_back(std::move(entry));
+    }
+
+    std::sort(queue.begin(), queue.end(), [] (const Entry& a, const Entry& b) {
+        return a.eventNr < b.eventNr;
+    });
+
+    //the opNrs of the previous run are not comparable with the opNrs of this run
+    for (auto& entry : queue) {
+        entry.sync.setOpNr(context.getRequestQueue().getNextOpNr());
+    }
+
+    if (!queue.empty()) {
+        nextEventNr = queue.back().eventNr + 1;
+    }
+
+    MO_DBG_DEBUG("restored %zu TransactionEvents of EVSE %u", queue.size(), evseId);
+}
+
+uint16_t TransactionEventQueue::allocSlot() {
+    bool used [MO_TXEVENTRECORD_SIZE] = {false};
+    for (auto& entry : queue) {
+        used[entry.slot] = true;
+    }
+    for (uint16_t slot = 0; slot < MO_TXEVENTRECORD_SIZE; slot++) {
+        if (!used[slot]) {
+            return slot;
+        }
+    }
+    return MO_TXEVENTRECORD_SIZE;
+}
+
+bool TransactionEventQueue::store(Entry& entry) {
+    if (!filesystem || !entry.txEvent) {
+        return false;
+    }
+
+    auto& txEvent = *entry.txEvent;
+
+    size_t capacity =
+            JSON_OBJECT_SIZE(19) + //total of 19 fields
+            JSON_OBJECT_SIZE(5) + //sync
+            2 * (JSONDATE_LENGTH + 1) + //timestamp and attemptTime strings
+            JSON_ARRAY_SIZE(txEvent.meterValue.size());
+    for (auto& mv : txEvent.meterValue) {
+        capacity += mv->getJsonCapacity();
+    }
+
+    DynamicJsonDocument doc {capacity};
+    JsonObject out = doc.to<JsonObject>();
+
+    out["eventNr"] = entry.eventNr;
+    out["txNr"] = entry.txNr;
+    out["transactionId"] = txEvent.transaction->getTransactionIdStr();
+    out["seqNo"] = txEvent.seqNo;
+
+    if (!serializeSendStatus(entry.sync, out.createNestedObject("sync")) ||
+            !serializeTransactionEvent(txEvent, out)) {
+        MO_DBG_ERR("serialization error");
+        return false;
+    }
+
+    if (!txEvent.meterValue.empty()) {
+        JsonArray meterValueJson = out.createNestedArray("meterValue");
+        for (auto& mv : txEvent.meterValue) {
+            if (!mv->toJson(meterValueJson.createNestedObject())) {
+                MO_DBG_ERR("MV not ready yet");
+                return false;
+            }
+        }
+    }
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printEventFn(fn, evseId, entry.slot)) {
+        return false;
+    }
+
+    if (!FilesystemUtils::storeJson(filesystem, fn, doc)) {
+        MO_DBG_ERR("FS error");
+        return false;
+    }
+
+    return true;
+}
+
+bool TransactionEventQueue::restore(Entry& entry) {
+    if (!filesystem) {
+        return false;
+    }
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printEventFn(fn, evseId, entry.slot)) {
+        return false;
+    }
+
+    auto doc = FilesystemUtils::loadJson(filesystem, fn);
+    if (!doc) {
+        MO_DBG_ERR("failed to load %s", fn);
+        return false;
+    }
+
+    JsonObject in = doc->as<JsonObject>();
+
+    auto transaction = findTransaction(entry.txNr, in["transactionId"] | "");
+    if (!transaction) {
+        MO_DBG_ERR("tx %u of TransactionEvent not found", entry.txNr);
+        return false;
+    }
+
+    auto txEvent = std::make_shared<TransactionEventData>(transaction, in["seqNo"] | 0U);
+    if (!deserializeTransactionEvent(*txEvent, in)) {
+        return false;
+    }
+
+    auto meteringService = model.getMeteringService();
+
+    JsonArray meterValueJson = in["meterValue"];
+    for (JsonObject mvJson : meterValueJson) {
+        std::unique_ptr<MeterValue> mv;
+        if (meteringService) {
+            mv = meteringService->deserializeMeterValue(evseId, mvJson);
+        }
+        if (!mv) {
+            MO_DBG_ERR("deserialization error");
+            continue;
+        }
+        txEvent->meterValue.push_back(std::move(mv));
+    }
+
+    entry.txEvent = std::move(txEvent);
+    return true;
+}
+
+void TransactionEventQueue::remove(size_t index) {
+    if (filesystem) {
+        char fn [MO_MAX_PATH_SIZE];
+        if (printEventFn(fn, evseId, queue[index].slot)) {
+            filesystem->remove(fn);
+        }
+    }
+    queue.erase(queue.begin() + index);
+}
+
+std::shared_ptr<Ocpp201::Transaction> TransactionEventQueue::findTransaction(unsigned int txNr, const char *transactionId) {
+    auto txStore = model.getTransactionStore();
+    if (!txStore) {
+        return nullptr;
+    }
+
+    //the tx is stored under this EVSE, or under EVSE 0 if it has been assigned to this EVSE later
+    auto transaction = txStore->getTransaction(evseId, txNr);
+    if ((!transaction || strcmp(transaction->getTransactionIdStr(), transactionId)) && evseId != 0) {
+        transaction = txStore->getTransaction(0, txNr);
+    }
+
+    if (!transaction || strcmp(transaction->getTransactionIdStr(), transactionId)) {
+        return nullptr;
+    }
+
+    return std::static_pointer_cast<Ocpp201::Transaction>(transaction);
+}
+
+bool TransactionEventQueue::push(std::shared_ptr<TransactionEventData> txEvent) {
+    if (!txEvent || !txEvent->transaction) {
+        MO_DBG_ERR("invalid arg");
+        return false;
+    }
+
+    if (txEvent->transaction->isSilent()) {
+        MO_DBG_INFO("silent Transaction: omit TransactionEvent");
+        return true;
+    }
+
+    if (isFull()) {
+        //never drop stored events. The caller holds the event back until the CSMS has confirmed queued events
+        MO_DBG_WARN("TransactionEvent queue of EVSE %u full", evseId);
+        return false;
+    }
+
+    Entry entry;
+    entry.txEvent = std::move(txEvent);
+    entry.eventNr = nextEventNr++;
+    entry.txNr = entry.txEvent->transaction->getTxNr();
+    entry.slot = allocSlot();
+    entry.sync.setRequested();
+    entry.sync.setOpNr(context.getRequestQueue().getNextOpNr());
+
+    if (filesystem) {
+        if (!store(entry)) {
+            MO_DBG_ERR("cannot store TransactionEvent. Keep in RAM");
+        } else if (!queue.empty()) {
+            //free RAM. Restored when the event reaches the front
+            entry.txEvent = nullptr;
+        }
+    }
+
+    queue.push_back(std::move(entry));
+    return true;
+}
+
+unsigned int TransactionEventQueue::getFrontRequestOpNr() {
+
+    while (!queue.empty()) {
+        auto& front = queue.front();
+
+        if (!front.txEvent && !restore(front)) {
+            MO_DBG_ERR("discard TransactionEvent %u", front.eventNr);
+            remove(0);
+            continue;
+        }
+
+        auto& transaction = front.txEvent->transaction;
+
+        if (transaction->isSilent()) {
+            //tx has been discarded, e.g. after the Started event exceeded MessageAttempts
+            MO_DBG_DEBUG("discard TransactionEvent %u of silent tx", front.eventNr);
+            remove(0);
+            continue;
+        }
+
+        if (!transaction->getStartSync().isConfirmed()) {
+            //the Started event must arrive first
+            return NoOperation;
+        }
+
+        return front.sync.getOpNr();
+    }
+
+    return NoOperation;
+}
+
+std::unique_ptr<Request> TransactionEventQueue::fetchFrontRequest() {
+
+    if (queue.empty() || !queue.front().txEvent) {
+        return nullptr;
+    }
+
+    auto& front = queue.front();
+
+    if ((int)front.sync.getAttemptNr() >= messageAttemptsInt->getInt()) {
+        MO_DBG_WARN("exceeded MessageAttempts. Discard TransactionEvent %u", front.eventNr);
+        remove(0);
+        return nullptr;
+    }
+
+    Timestamp nextAttempt = front.sync.getAttemptTime() +
+                            front.sync.getAttemptNr() * messageAttemptIntervalInt->getInt();
+
+    if (nextAttempt > model.getClock().now()) {
+        return nullptr;
+    }
+
+    front.sync.advanceAttemptNr();
+    front.sync.setAttemptTime(model.getClock().now());
+    if (filesystem) {
+        store(front);
+    }
+
+    auto txEvent = makeRequest(new TransactionEvent(model, front.txEvent));
+
+    auto eventNr = front.eventNr;
+    txEvent->setOnReceiveConfListener([this, eventNr] (JsonObject) {
+        if (!queue.empty() && queue.front().eventNr == eventNr) {
+            remove(0);
+        }
+    });
+
+    return txEvent;
+}
+
+#endif //MO_ENABLE_V201
@@ -0,0 +1,83 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_TRANSACTIONEVENTQUEUE_H
+#define MO_TRANSACTIONEVENTQUEUE_H
+
+#include <MicroOcpp/Version.h>
+
+#if MO_ENABLE_V201
+
+#include <MicroOcpp/Model/Transactions/Transaction.h>
+#include <MicroOcpp/Core/RequestQueue.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+
+#include <memory>
+#include <vector>
+
+#ifndef MO_TXEVENTRECORD_SIZE
+#define MO_TXEVENTRECORD_SIZE 16 //no. of TransactionEvents per EVSE to hold on flash storage
+#endif
+
+namespace MicroOcpp {
+
+class Context;
+class Model;
+class Variable;
+
+/*
+ * Persistent queue of the TransactionEvents (eventType Updated) of one EVSE. Each event is stored in a file slot
+ * when it is created and removed after the CSMS has confirmed it. The events are sent in creation order with retries
+ * according to MessageAttemptsTransactionEvent and MessageAttemptIntervalTransactionEvent. Started and Ended events
+ * remain with the tx and are sent by the Connector. The opNr order with the Connector guarantees that an Updated
+ * event is sent after Started and before Ended of its tx.
+ *
+ * After a reboot, the stored events are restored in creation order and get new opNrs, so they are sent before any
+ * event of the new run. Only the front event is kept in RAM if a filesystem is present.
+ */
+class TransactionEventQueue : public RequestEmitter {
+private:
+    struct Entry {
+        std::shared_ptr<Ocpp201::TransactionEventData> txEvent; //nullptr while the event is only on flash
+        SendStatus sync; //opNr and attempts
+        uint32_t eventNr; //creation order
+        unsigned int txNr;
+        uint16_t slot; //file slot
+    };
+
+    Context& context;
+    Model& model;
+    std::shared_ptr<FilesystemAdapter> filesystem;
+    const unsigned int evseId;
+
+    std::shared_ptr<Variable> messageAttemptsInt;
+    std::shared_ptr<Variable> messageAttemptIntervalInt;
+
+    std::vector<Entry> queue; //sorted by eventNr
+    uint32_t nextEventNr = 0;
+
+    uint16_t allocSlot(); //returns MO_TXEVENTRECORD_SIZE if all slots are taken
+    bool store(Entry& entry);
+    bool restore(Entry& entry); //loads the txEvent of the entry from flash
+    void remove(size_t index);
+    void load(); //restores the queue index from flash
+
+    std::shared_ptr<Ocpp201::Transaction> findTransaction(unsigned int txNr, const char *transactionId);
+public:
+    TransactionEventQueue(Context& context, unsigned int evseId, std::shared_ptr<FilesystemAdapter> filesystem);
+
+    bool push(std::shared_ptr<Ocpp201::TransactionEventData> txEvent); //persists txEvent and enqueues it for sending. Returns false if the queue is full
+
+    size_t size() {return queue.size();}
+    size_t getFreeSlots() {return MO_TXEVENTRECORD_SIZE - queue.size();}
+    bool isFull() {return queue.size() >= MO_TXEVENTRECORD_SIZE;}
+
+    unsigned int getFrontRequestOpNr() override;
+    std::unique_ptr<Request> fetchFrontRequest() override;
+};
+
+} //end namespace MicroOcpp
+
+#endif //MO_ENABLE_V201
+#endif
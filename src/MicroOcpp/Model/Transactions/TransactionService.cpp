@@ -29,6 +29,8 @@ using namespace MicroOcpp::Ocpp201;
 
 TransactionService::Evse::Evse(Context& context, TransactionService& txService, unsigned int evseId) :
         context(context), model(context.getModel()), connector(model.getConnector(evseId)), txService(txService), evseId(evseId) {
+
+    txEventQueue = std::unique_ptr<TransactionEventQueue>(new TransactionEventQueue(context, evseId, txService.filesystem));
 }
 
 std::shared_ptr<Ocpp201::Transaction> TransactionService::Evse::allocateTransaction() {
@@ -147,6 +149,43 @@ void TransactionService::Evse::loop() {
             transaction->commit();
             connector->updateTxNotification(TxNotification::StopTx);
 
+            std::vector<std::unique_ptr<MeterValue>> stopMeterValue;
+
+            auto meteringService = context.getModel().getMeteringService();
+            if (meteringService) {
+                std::shared_ptr<TransactionMeterData> stopTxData = meteringService->endTxMeterData(transaction.get());
+                if(stopTxData){
+                    stopMeterValue = stopTxData->retrieveStopTxData();
+                }
+            } else {
+                MO_DBG_ERR("MeterStart undefined");
+            }
+
+            //meter data which exceeds the size of one TransactionEvent is sent in Updated events ahead of Ended
+            auto chunks = Ocpp201::TransactionEvent::splitMeterValue(std::move(stopMeterValue));
+            size_t nUpdated = chunks.empty() ? 0 : chunks.size() - 1;
+            if (nUpdated > txEventQueue->getFreeSlots()) {
+                //the chunks which don't fit into the queue remain in the Ended event
+                MO_DBG_WARN("TransactionEvent queue of EVSE %u full. Ended event exceeds MO_TXEVENT_METERVALUE_SIZE", evseId);
+                nUpdated = txEventQueue->getFreeSlots();
+            }
+            for (size_t i = 0; i < nUpdated; i++) {
+                auto updatedEvent = std::make_shared<TransactionEventData>(transaction, transaction->seqNoCounter++);
+                updatedEvent->eventType = TransactionEventData::Type::Updated;
+                updatedEvent->triggerReason = TransactionEventTriggerReason::MeterValuePeriodic;
+                updatedEvent->timestamp = context.getModel().getClock().now();
+                updatedEvent->offline = !context.getConnection().isConnected();
+                updatedEvent->meterValue = std::move(chunks[i]);
+
+                transaction->commit(); //persist seqNoCounter
+                txEventQueue->push(std::move(updatedEvent));
+            }
+
+            if (nUpdated > 0) {
+                //keep Ended behind the Updated events
+                transaction->getStopSync().setOpNr(context.getRequestQueue().getNextOpNr());
+            }
+
             txEvent = std::make_shared<TransactionEventData>(transaction, transaction->seqNoCounter++);
             if (!txEvent) {
                 // OOM
@@ -159,14 +198,10 @@ void TransactionService::Evse::loop() {
             txEvent->eventType = TransactionEventData::Type::Ended;
             txEvent->triggerReason = triggerReason;
 
-            auto meteringService = context.getModel().getMeteringService();
-            if (meteringService) {
-                std::shared_ptr<TransactionMeterData> stopTxData = meteringService->endTxMeterData(transaction.get());
-                if(stopTxData){
-                    txEvent->meterValue = std::move(stopTxData->retrieveStopTxData());
+            for (size_t i = nUpdated; i < chunks.size(); i++) {
+                for (auto& mv : chunks[i]) {
+                    txEvent->meterValue.push_back(std::move(mv));
                 }
-            } else {
-                MO_DBG_ERR("MeterStart undefined");
             }
         }
     } 
@@ -280,8 +315,8 @@ void TransactionService::Evse::loop() {
 
     std::vector<std::unique_ptr<MeterValue>>* meterValue = nullptr;
 
-    if (transaction) {
-        // update tx?
+    if (transaction && (txEvent || !txEventQueue->isFull())) {
+        // update tx? While the queue of Updated events is full, the changes are detected after the CSMS has confirmed queued events
 
         bool txUpdateCondition = false;
 
@@ -382,9 +417,8 @@ void TransactionService::Evse::loop() {
         }else if(txEvent->eventType == TransactionEventData::Type::Ended){
             transaction->stopTxEvent = txEvent;
         }else{
-            auto txEventRequest = makeRequest(new Ocpp201::TransactionEvent(context.getModel(), txEvent));
-            txEventRequest->setTimeout(0);
-            context.initiateRequest(std::move(txEventRequest));
+            transaction->commit(); //persist seqNoCounter
+            txEventQueue->push(std::move(txEvent));
         }
     }
 }
@@ -521,7 +555,7 @@ bool TransactionService::parseTxStartStopPoint(const char *csl, std::vector<TxSt
     return true;
 }
 
-TransactionService::TransactionService(Context& context) : context(context) {
+TransactionService::TransactionService(Context& context, std::shared_ptr<FilesystemAdapter> filesystem) : context(context), filesystem(filesystem) {
     auto variableService = context.getModel().getVariableService();
 
     txStartPointString = variableService->declareVariable<const char*>("TxCtrlr", "TxStartPoint", "PowerPathClosed");
@@ -15,6 +15,7 @@
 
 #include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MicroOcpp/Model/Transactions/TransactionDefs.h>
+#include <MicroOcpp/Model/Transactions/TransactionEventQueue.h>
 #include <MicroOcpp/Model/Model.h>
 
 #include <memory>
@@ -46,6 +47,8 @@ public:
         std::function<bool()> startTxReadyInput;
         std::function<bool()> stopTxReadyInput;
 
+        std::unique_ptr<TransactionEventQueue> txEventQueue; //Updated events
+
         std::shared_ptr<Ocpp201::Transaction> allocateTransaction();
     public:
         Evse(Context& context, TransactionService& txService, unsigned int evseId);
@@ -67,6 +70,7 @@ public:
 
         bool ocppPermitsCharge();
         Connector* getConnector(){return connector;}
+        TransactionEventQueue* getTransactionEventQueue(){return txEventQueue.get();}
 
         friend TransactionService;
     };
@@ -84,6 +88,7 @@ private:
     };
 
     Context& context;
+    std::shared_ptr<FilesystemAdapter> filesystem;
     std::vector<Evse> evses;
 
     std::shared_ptr<Variable> txStartPointString = nullptr;
@@ -102,7 +107,7 @@ private:
     bool parseTxStartStopPoint(const char *src, std::vector<TxStartStopPoint>& dst);
 
 public:
-    TransactionService(Context& context);
+    TransactionService(Context& context, std::shared_ptr<FilesystemAdapter> filesystem = nullptr);
 
     void loop();
 
@@ -7,44 +7,161 @@
 #include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Debug.h>
 
+#include <algorithm>
+
+#define MO_TXINDEX_RECORD_SIZE 5 //txNr (4 bytes, little endian) + state
+
 using namespace MicroOcpp;
 
+namespace MicroOcpp {
+namespace TransactionStoreUtils {
+
+uint8_t getIndexState(ITransaction& transaction) {
+    uint8_t state = 0;
+    if (transaction.isAborted()) {
+        state |= TransactionIndexEntry::Aborted;
+    }
+    if (transaction.isCompleted()) {
+        state |= TransactionIndexEntry::Completed;
+    }
+    if (transaction.isSilent()) {
+        state |= TransactionIndexEntry::Silent;
+    }
+    if (transaction.getStopSync().isRequested()) {
+        state |= TransactionIndexEntry::StopRequested;
+    }
+    return state;
+}
+
+bool printIndexFn(char *fn, unsigned int connectorId) {
+    auto ret = snprintf(fn, MO_MAX_PATH_SIZE, MO_FILENAME_PREFIX "txi-%u.bin", connectorId);
+    if (ret < 0 || ret >= MO_MAX_PATH_SIZE) {
+        MO_DBG_ERR("fn error: %i", ret);
+        return false;
+    }
+    return true;
+}
+
+bool compareTxNr(const TransactionIndexEntry& entry, unsigned int txNr) {
+    return entry.txNr < txNr;
+}
+
+//allocator for std::allocate_shared. Keeps the pool alive as long as a tx lives in it
+template <class T>
+struct TransactionPoolAllocator {
+    typedef T value_type;
+
+    std::shared_ptr<TransactionPool> pool;
+
+    TransactionPoolAllocator(std::shared_ptr<TransactionPool> pool) : pool(std::move(pool)) { }
+    template <class U>
+    TransactionPoolAllocator(const TransactionPoolAllocator<U>& other) : pool(other.pool) { }
+
+    T *allocate(size_t n) {
+        return static_cast<T*>(pool->allocate(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t) {
+        pool->deallocate(ptr);
+    }
+};
+
+template <class T, class U>
+bool operator==(const TransactionPoolAllocator<T>& a, const TransactionPoolAllocator<U>& b) {return a.pool == b.pool;}
+template <class T, class U>
+bool operator!=(const TransactionPoolAllocator<T>& a, const TransactionPoolAllocator<U>& b) {return a.pool != b.pool;}
+
+} //end namespace TransactionStoreUtils
+} //end namespace MicroOcpp
+
+using namespace MicroOcpp::TransactionStoreUtils;
+
+void *TransactionPool::allocate(size_t size) {
+    if (!block) {
+        //first allocation determines the slot size
+        slotSize = size;
+        block.reset(new unsigned char[slotSize * MO_TX_POOL_SIZE]);
+        if (!block) {
+            MO_DBG_ERR("OOM");
+            slotSize = 0;
+        }
+    }
+
+    if (block && size <= slotSize) {
+        for (size_t i = 0; i < MO_TX_POOL_SIZE; i++) {
+            if (!(used & (1UL << i))) {
+                used |= (1UL << i);
+                return block.get() + i * slotSize;
+            }
+        }
+    }
+
+    nFallbacks++;
+    return ::operator new(size);
+}
+
+void TransactionPool::deallocate(void *ptr) {
+    auto p = static_cast<unsigned char*>(ptr);
+    if (block && p >= block.get() && p < block.get() + slotSize * MO_TX_POOL_SIZE) {
+        used &= ~(1UL << ((p - block.get()) / slotSize));
+    } else {
+        ::operator delete(ptr);
+    }
+}
+
 ConnectorTransactionStore::ConnectorTransactionStore(TransactionStore& context, unsigned int connectorId, std::shared_ptr<FilesystemAdapter> filesystem, const ProtocolVersion& version) :
         context(context),
         connectorId(connectorId),
         filesystem(filesystem),
-        version(version) {
+        version(version),
+        pool(std::make_shared<TransactionPool>()) {
 
+    transactions.reserve(MO_TX_POOL_SIZE);
 }
 
 ConnectorTransactionStore::~ConnectorTransactionStore() {
 
 }
 
-std::shared_ptr<ITransaction> ConnectorTransactionStore::getTransaction(unsigned int txNr) {
+std::shared_ptr<ITransaction> ConnectorTransactionStore::makeTransaction(unsigned int txNr, bool silent) {
 
-    //check for most recent element of cache first because of temporal locality
-    if (!transactions.empty()) {
-        if (auto cached = transactions.back().lock()) {
-            if (cached->getTxNr() == txNr) {
-                //cache hit
-                return cached;
-            }
+    //release the pool slots of outdated cache references before allocating the new tx
+    for (auto& cached : transactions) {
+        if (cached.expired()) {
+            cached.reset();
+        }
+    }
+
+#if MO_ENABLE_V201
+    if(version.major==2){
+        return std::allocate_shared<Ocpp201::Transaction>(TransactionPoolAllocator<Ocpp201::Transaction>(pool), *this, connectorId, txNr, silent);
+    }
+#endif
+    return std::allocate_shared<Transaction>(TransactionPoolAllocator<Transaction>(pool), *this, connectorId, txNr, silent);
+}
+
+void ConnectorTransactionStore::addTransaction(std::shared_ptr<ITransaction> transaction) {
+    //replace an expired entry. This also releases its pool slot which the weak_ptr keeps allocated
+    for (auto& cached : transactions) {
+        if (cached.expired()) {
+            cached = std::move(transaction);
+            return;
         }
     }
+    transactions.push_back(std::move(transaction));
+}
 
-    //check all other elements (and free up unused entries)
-    auto cached = transactions.begin();
-    while (cached != transactions.end()) {
-        if (auto tx = cached->lock()) {
+std::shared_ptr<ITransaction> ConnectorTransactionStore::getTransaction(unsigned int txNr) {
+
+    for (auto& cached : transactions) {
+        if (auto tx = cached.lock()) {
             if (tx->getTxNr() == txNr) {
                 //cache hit
                 return tx;
             }
-            cached++;
         } else {
-            //collect outdated cache reference
-            cached = transactions.erase(cached);
+            //release pool slot of outdated cache reference
+            cached.reset();
         }
     }
 
@@ -75,63 +192,28 @@ std::shared_ptr<ITransaction> ConnectorTransactionStore::getTransaction(unsigned
         return nullptr;
     }
 
-    std::shared_ptr<ITransaction> transaction;
-#if MO_ENABLE_V201
-    if(version.major==2){
-        transaction = std::make_shared<Ocpp201::Transaction>(*this, connectorId, txNr);
-    }else
-#endif
-    {
-        transaction = std::make_shared<Transaction>(*this, connectorId, txNr);
-    }
+    auto transaction = makeTransaction(txNr, false);
     JsonObject txJson = doc->as<JsonObject>();
     if (!deserializeTransaction(*transaction, txJson)) {
         MO_DBG_ERR("deserialization error");
         return nullptr;
     }
-    //before adding new entry, clean cache
-    cached = transactions.begin();
-    while (cached != transactions.end()) {
-        if (cached->expired()) {
-            //collect outdated cache reference
-            cached = transactions.erase(cached);
-        } else {
-            cached++;
-        }
-    }
 
-    transactions.push_back(transaction);
+    updateIndex(*transaction); //tx may be missing in the index, e.g. after an update from a version without tx index
+
+    addTransaction(transaction);
     return transaction;
 }
 
 std::shared_ptr<ITransaction> ConnectorTransactionStore::createTransaction(unsigned int txNr, bool silent) {
-    std::shared_ptr<ITransaction> transaction;
-#if MO_ENABLE_V201
-    if(version.major==2){
-        transaction = std::make_shared<Ocpp201::Transaction>(*this, connectorId, txNr, silent);
-    }else
-#endif
-    {
-        transaction = std::make_shared<Transaction>(*this, connectorId, txNr, silent);
-    }
+    auto transaction = makeTransaction(txNr, silent);
 
     if (!commit(transaction.get())) {
         MO_DBG_ERR("FS error");
         return nullptr;
     }
 
-    //before adding new entry, clean cache
-    auto cached = transactions.begin();
-    while (cached != transactions.end()) {
-        if (cached->expired()) {
-            //collect outdated cache reference
-            cached = transactions.erase(cached);
-        } else {
-            cached++;
-        }
-    }
-
-    transactions.push_back(transaction);
+    addTransaction(transaction);
     return transaction;
 }
 
@@ -160,6 +242,8 @@ bool ConnectorTransactionStore::commit(ITransaction *transaction) {
         return false;
     }
 
+    updateIndex(*transaction);
+
     //success
     return true;
 }
@@ -178,6 +262,15 @@ bool ConnectorTransactionStore::remove(unsigned int txNr) {
         return false;
     }
 
+    //update index first: if the tx file remains after a power loss, the tx isn't indexed and will be loaded
+    if (loadIndex()) {
+        auto entry = std::lower_bound(txIndex.begin(), txIndex.end(), txNr, compareTxNr);
+        if (entry != txIndex.end() && entry->txNr == txNr) {
+            txIndex.erase(entry);
+            storeIndex();
+        }
+    }
+
     size_t msize;
     if (filesystem->stat(fn, &msize) != 0) {
         MO_DBG_DEBUG("%s already removed", fn);
@@ -189,6 +282,148 @@ bool ConnectorTransactionStore::remove(unsigned int txNr) {
     return filesystem->remove(fn);
 }
 
+bool ConnectorTransactionStore::loadIndex() {
+    if (txIndexLoaded) {
+        return txIndexValid;
+    }
+    txIndexLoaded = true;
+    txIndexValid = false;
+    txIndex.clear();
+
+    if (!filesystem) {
+        return false;
+    }
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printIndexFn(fn, connectorId)) {
+        return false;
+    }
+
+    size_t msize = 0;
+    if (filesystem->stat(fn, &msize) != 0) {
+        //no index yet. Txs are indexed when they are committed or loaded
+        txIndexValid = true;
+        return true;
+    }
+
+    if (msize % MO_TXINDEX_RECORD_SIZE != 0) {
+        MO_DBG_ERR("invalid file size: %s", fn);
+        filesystem->remove(fn);
+        txIndexValid = true;
+        return true;
+    }
+
+    auto file = filesystem->open(fn, "r");
+    if (!file) {
+        MO_DBG_ERR("could not open file: %s", fn);
+        return false;
+    }
+
+    txIndex.reserve(msize / MO_TXINDEX_RECORD_SIZE);
+
+    for (size_t i = 0; i < msize / MO_TXINDEX_RECORD_SIZE; i++) {
+        unsigned char buf [MO_TXINDEX_RECORD_SIZE];
+        if (file->read((char*) buf, sizeof(buf)) != sizeof(buf)) {
+            MO_DBG_ERR("read error: %s", fn);
+            txIndex.clear();
+            return false;
+        }
+
+        TransactionIndexEntry entry;
+        entry.txNr = (unsigned int) buf[0] | ((unsigned int) buf[1] << 8) | ((unsigned int) buf[2] << 16) | ((unsigned int) buf[3] << 24);
+        entry.state = buf[4];
+
+        if (!txIndex.empty() && txIndex.back().txNr >= entry.txNr) {
+            MO_DBG_ERR("index corrupt: %s", fn);
+            txIndex.clear();
+            file.reset();
+            filesystem->remove(fn);
+            txIndexValid = true;
+            return true;
+        }
+
+        txIndex.push_back(entry);
+    }
+
+    MO_DBG_DEBUG("loaded tx index of connector %u with %zu entries", connectorId, txIndex.size());
+
+    txIndexValid = true;
+    return true;
+}
+
+bool ConnectorTransactionStore::storeIndex() {
+
+    char fn [MO_MAX_PATH_SIZE];
+    if (!printIndexFn(fn, connectorId)) {
+        txIndexValid = false;
+        return false;
+    }
+
+    auto file = filesystem->open(fn, "w");
+    if (!file) {
+        MO_DBG_ERR("could not open file: %s", fn);
+        txIndexValid = false;
+        filesystem->remove(fn);
+        return false;
+    }
+
+    for (auto& entry : txIndex) {
+        unsigned char buf [MO_TXINDEX_RECORD_SIZE];
+        buf[0] = (unsigned char) (entry.txNr >> 0);
+        buf[1] = (unsigned char) (entry.txNr >> 8);
+        buf[2] = (unsigned char) (entry.txNr >> 16);
+        buf[3] = (unsigned char) (entry.txNr >> 24);
+        buf[4] = entry.state;
+        if (file->write((char*) buf, sizeof(buf)) != sizeof(buf)) {
+            MO_DBG_ERR("file write error: %s", fn);
+            //stale index would be worse than none
+            txIndexValid = false;
+            file.reset();
+            filesystem->remove(fn);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void ConnectorTransactionStore::updateIndex(ITransaction& transaction) {
+    if (!loadIndex()) {
+        return;
+    }
+
+    auto state = getIndexState(transaction);
+
+    auto entry = std::lower_bound(txIndex.begin(), txIndex.end(), transaction.getTxNr(), compareTxNr);
+    if (entry != txIndex.end() && entry->txNr == transaction.getTxNr()) {
+        if (entry->state == state) {
+            return; //no change. Most commits don't change the life cycle state
+        }
+        entry->state = state;
+    } else {
+        TransactionIndexEntry newEntry;
+        newEntry.txNr = transaction.getTxNr();
+        newEntry.state = state;
+        txIndex.insert(entry, newEntry);
+    }
+
+    storeIndex();
+}
+
+bool ConnectorTransactionStore::getTransactionState(unsigned int txNr, uint8_t& state) {
+    if (!loadIndex()) {
+        return false;
+    }
+
+    auto entry = std::lower_bound(txIndex.begin(), txIndex.end(), txNr, compareTxNr);
+    if (entry == txIndex.end() || entry->txNr != txNr) {
+        return false;
+    }
+
+    state = entry->state;
+    return true;
+}
+
 TransactionStore::TransactionStore(unsigned int nConnectors, std::shared_ptr<FilesystemAdapter> filesystem, const ProtocolVersion& version) {
     
     for (unsigned int i = 0; i < nConnectors; i++) {
@@ -233,3 +468,19 @@ bool TransactionStore::remove(unsigned int connectorId, unsigned int txNr) {
     }
     return connectors[connectorId]->remove(txNr);
 }
+
+bool TransactionStore::getTransactionState(unsigned int connectorId, unsigned int txNr, uint8_t& state) {
+    if (connectorId >= connectors.size()) {
+        MO_DBG_ERR("Invalid connectorId");
+        return false;
+    }
+    return connectors[connectorId]->getTransactionState(txNr, state);
+}
+
+ConnectorTransactionStore *TransactionStore::getConnectorStore(unsigned int connectorId) {
+    if (connectorId >= connectors.size()) {
+        MO_DBG_ERR("Invalid connectorId");
+        return nullptr;
+    }
+    return connectors[connectorId].get();
+}
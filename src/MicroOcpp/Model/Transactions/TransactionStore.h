@@ -6,22 +6,82 @@
 #define MO_TRANSACTIONSTORE_H
 
 #include <vector>
-#include <deque>
 
 #include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MicroOcpp/Core/FilesystemAdapter.h>
 
+#ifndef MO_TX_POOL_SIZE
+#define MO_TX_POOL_SIZE 4 //number of tx objects per connector which live in a preallocated memory block. Max 32
+#endif
+
+#if MO_TX_POOL_SIZE > 32
+#error MO_TX_POOL_SIZE must not exceed 32
+#endif
+
 namespace MicroOcpp {
 
 class TransactionStore;
 
+/*
+ * Fixed number of equally-sized slots for the tx objects of one connector. The slot size is determined by the first
+ * allocation (the tx object together with its shared_ptr control block) and the block is allocated once. Freed slots
+ * are reused. If all slots are taken, tx objects are allocated on the heap as usual.
+ */
+class TransactionPool {
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t slotSize = 0;
+    uint32_t used = 0; //bitset of slots in use
+    size_t nFallbacks = 0;
+public:
+    void *allocate(size_t size);
+    void deallocate(void *ptr);
+
+    size_t getFallbackCount() const {return nFallbacks;} //number of allocations which didn't fit into the pool
+};
+
+//life cycle state of a tx which is kept in the tx index file
+struct TransactionIndexEntry {
+    enum : uint8_t {
+        Aborted = 1 << 0,
+        Completed = 1 << 1,
+        Silent = 1 << 2,
+        StopRequested = 1 << 3
+    };
+
+    unsigned int txNr;
+    uint8_t state;
+};
+
+/*
+ * Stores the txs of one connector in one file per tx. In addition, a compact index file contains the life cycle state
+ * of all stored txs, so that the Connector can find the front tx and clean the tx history without deserializing the
+ * tx files. The index is written after the tx file on commit and before the tx file on remove. Thus, a tx state in the
+ * index may lag behind, but never runs ahead of the tx file. If a tx is missing in the index, it must be loaded.
+ */
 class ConnectorTransactionStore {
 private:
     TransactionStore& context;
     const unsigned int connectorId;
     std::shared_ptr<FilesystemAdapter> filesystem;
     const ProtocolVersion& version;
-    std::deque<std::weak_ptr<ITransaction>> transactions;
+
+    std::shared_ptr<TransactionPool> pool;
+    std::vector<std::weak_ptr<ITransaction>> transactions; //txs which are currently in use. Expired entries are replaced
+
+    std::shared_ptr<ITransaction> makeTransaction(unsigned int txNr, bool silent);
+    void addTransaction(std::shared_ptr<ITransaction> transaction);
+
+    std::vector<TransactionIndexEntry> txIndex; //sorted by txNr
+    bool txIndexLoaded = false;
+    bool txIndexValid = false;
+
+    bool loadIndex();
+    bool storeIndex();
+    void updateIndex(ITransaction& transaction);
+
+    const TransactionPool& getPool() const {return *pool;}
+    friend class TransactionStoreInspector; //unit tests
 
 public:
     ConnectorTransactionStore(TransactionStore& context, unsigned int connectorId, std::shared_ptr<FilesystemAdapter> filesystem, const ProtocolVersion& version=VER_1_6_J);
@@ -37,11 +97,16 @@ public:
     std::shared_ptr<ITransaction> createTransaction(unsigned int txNr, bool silent = false);
 
     bool remove(unsigned int txNr);
+
+    bool getTransactionState(unsigned int txNr, uint8_t& state); //looks up the state in the tx index. Returns false if not indexed, then the tx must be loaded
 };
 
 class TransactionStore {
 private:
     std::vector<std::unique_ptr<ConnectorTransactionStore>> connectors;
+
+    ConnectorTransactionStore *getConnectorStore(unsigned int connectorId);
+    friend class TransactionStoreInspector; //unit tests
 public:
     TransactionStore(unsigned int nConnectors, std::shared_ptr<FilesystemAdapter> filesystem, const ProtocolVersion& version=VER_1_6_J);
 
@@ -51,6 +116,8 @@ public:
     std::shared_ptr<ITransaction> createTransaction(unsigned int connectorId, unsigned int txNr, bool silent = false);
 
     bool remove(unsigned int connectorId, unsigned int txNr);
+
+    bool getTransactionState(unsigned int connectorId, unsigned int txNr, uint8_t& state);
 };
 
 }
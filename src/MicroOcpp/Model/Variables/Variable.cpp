@@ -412,6 +412,101 @@ std::unique_ptr<Variable> MicroOcpp::makeVariable(Variable::InternalDataType dty
     return nullptr;
 }
 
+VariablePool::VariablePool(size_t capacity) {
+    if (capacity > 0) {
+        block.reset(new unsigned char[capacity]);
+        if (!block) {
+            MO_DBG_ERR("OOM");
+            return;
+        }
+        this->capacity = capacity;
+    }
+}
+
+void *VariablePool::allocate(size_t size, size_t align) {
+    size_t offset = (size_t) ((uintptr_t) (block.get() + used) % align);
+    size_t begin = used + (offset ? align - offset : 0);
+    if (begin + size > capacity) {
+        return nullptr;
+    }
+    used = begin + size;
+    return block.get() + begin;
+}
+
+bool VariablePool::contains(const void *ptr) const {
+    return ptr >= block.get() && ptr < block.get() + capacity;
+}
+
+namespace MicroOcpp {
+
+//allocator for std::allocate_shared. Keeps the pool alive as long as a Variable lives in it
+template <class T>
+struct VariablePoolAllocator {
+    typedef T value_type;
+
+    std::shared_ptr<VariablePool> pool;
+
+    VariablePoolAllocator(std::shared_ptr<VariablePool> pool) : pool(std::move(pool)) { }
+    template <class U>
+    VariablePoolAllocator(const VariablePoolAllocator<U>& other) : pool(other.pool) { }
+
+    T *allocate(size_t n) {
+        if (auto ptr = pool->allocate(n * sizeof(T), alignof(T))) {
+            return static_cast<T*>(ptr);
+        }
+        MO_DBG_DEBUG("variable pool exhausted, fall back to heap");
+        return static_cast<T*>(::operator new(n * sizeof(T)));
+    }
+
+    void deallocate(T *ptr, size_t) {
+        if (!pool->contains(ptr)) {
+            ::operator delete(ptr);
+        }
+    }
+};
+
+template <class T, class U>
+bool operator==(const VariablePoolAllocator<T>& a, const VariablePoolAllocator<U>& b) {return a.pool == b.pool;}
+template <class T, class U>
+bool operator!=(const VariablePoolAllocator<T>& a, const VariablePoolAllocator<U>& b) {return a.pool != b.pool;}
+
+template <class V>
+std::shared_ptr<Variable> allocateVariable(std::shared_ptr<VariablePool> pool, Variable::AttributeTypeSet supportAttributes) {
+    return std::allocate_shared<V>(VariablePoolAllocator<V>(std::move(pool)), supportAttributes);
+}
+
+} //end namespace MicroOcpp
+
+std::shared_ptr<Variable> MicroOcpp::makeVariableShared(std::shared_ptr<VariablePool> pool, Variable::InternalDataType dtype, Variable::AttributeTypeSet supportAttributes) {
+    if (!pool || !pool->getCapacity()) {
+        return makeVariable(dtype, supportAttributes);
+    }
+
+    switch(dtype) {
+        case Variable::InternalDataType::Int:
+            if (supportAttributes.count() > 1) {
+                return allocateVariable<VariableInt<VariableFullData>>(std::move(pool), supportAttributes);
+            } else {
+                return allocateVariable<VariableInt<VariableSingleData>>(std::move(pool), supportAttributes);
+            }
+        case Variable::InternalDataType::Bool:
+            if (supportAttributes.count() > 1) {
+                return allocateVariable<VariableBool<VariableFullData>>(std::move(pool), supportAttributes);
+            } else {
+                return allocateVariable<VariableBool<VariableSingleData>>(std::move(pool), supportAttributes);
+            }
+        case Variable::InternalDataType::String:
+            if (supportAttributes.count() > 1) {
+                return allocateVariable<VariableString<VariableFullData>>(std::move(pool), supportAttributes);
+            } else {
+                return allocateVariable<VariableString<VariableSingleData>>(std::move(pool), supportAttributes);
+            }
+    }
+
+    MO_DBG_ERR("internal error");
+    return nullptr;
+}
+
 const char * MicroOcpp::serializeTVar(Variable::InternalDataType type) {
     switch (type) {
         case Variable::InternalDataType::Int:
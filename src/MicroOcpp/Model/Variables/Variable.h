@@ -25,6 +25,10 @@
 #define MO_VARIABLE_TYPECHECK 1
 #endif
 
+#ifndef MO_VARIABLE_POOL_SIZE
+#define MO_VARIABLE_POOL_SIZE 4096 //bytes of the memory block which is allocated for Variable objects at initialization. 0 to disable
+#endif
+
 namespace MicroOcpp {
 
 // VariableCharacteristicsType (2.51)
@@ -244,6 +248,30 @@ bool deserializeTVar(const char *serialized, Variable::InternalDataType& out);
 
 std::unique_ptr<Variable> makeVariable(Variable::InternalDataType dtype, Variable::AttributeTypeSet supportAttributes);
 
+/*
+ * Memory block for Variable objects which is allocated once at initialization. Variables are placed one after
+ * another, together with their shared_ptr control block, instead of two separate heap allocations per Variable.
+ * The memory of destroyed Variables isn't reused (Variables normally live until deinitialization). If the pool is
+ * exhausted, Variables are allocated on the heap as usual.
+ */
+class VariablePool {
+private:
+    std::unique_ptr<unsigned char[]> block;
+    size_t capacity = 0;
+    size_t used = 0;
+public:
+    VariablePool(size_t capacity);
+
+    void *allocate(size_t size, size_t align); //returns nullptr if exhausted
+    bool contains(const void *ptr) const;
+
+    size_t getCapacity() const {return capacity;}
+    size_t getUsed() const {return used;}
+};
+
+//creates Variable in pool if possible. pool may be nullptr
+std::shared_ptr<Variable> makeVariableShared(std::shared_ptr<VariablePool> pool, Variable::InternalDataType dtype, Variable::AttributeTypeSet supportAttributes);
+
 } // namespace MicroOcpp
 
 #endif // MO_ENABLE_V201
@@ -22,8 +22,16 @@ VariableContainer::~VariableContainer() {
 
 }
 
-VariableContainerVolatile::VariableContainerVolatile(const char *filename, bool accessible) :
-        VariableContainer(filename, accessible) {
+std::shared_ptr<Variable> VariableContainer::getVariableShared(size_t i) const {
+    auto variable = getVariable(i);
+    if (!variable) {
+        return nullptr;
+    }
+    return getVariable(variable->getComponentId(), variable->getName(), variable->getInstance());
+}
+
+VariableContainerVolatile::VariableContainerVolatile(const char *filename, bool accessible, std::shared_ptr<VariablePool> pool) :
+        VariableContainer(filename, accessible), pool(std::move(pool)) {
 
 }
 
@@ -40,7 +48,7 @@ bool VariableContainerVolatile::save() {
 }
 
 std::shared_ptr<Variable> VariableContainerVolatile::createVariable(Variable::InternalDataType dtype, Variable::AttributeTypeSet attributes) {
-    return makeVariable(dtype, attributes);
+    return makeVariableShared(pool, dtype, attributes);
 }
 
 bool VariableContainerVolatile::add(std::shared_ptr<Variable> variable) {
@@ -56,6 +64,10 @@ Variable *VariableContainerVolatile::getVariable(size_t i) const {
     return variables[i].get();
 }
 
+std::shared_ptr<Variable> VariableContainerVolatile::getVariableShared(size_t i) const {
+    return variables[i];
+}
+
 std::shared_ptr<Variable> VariableContainerVolatile::getVariable(const ComponentId& component, const char *variableName, const char *instanceName) const {
     for (auto it = variables.begin(); it != variables.end(); it++) {
         if (!strcmp((*it)->getName(), variableName) &&
@@ -67,8 +79,8 @@ std::shared_ptr<Variable> VariableContainerVolatile::getVariable(const Component
     return nullptr;
 }
 
-std::unique_ptr<VariableContainerVolatile> MicroOcpp::makeVariableContainerVolatile(const char *filename, bool accessible) {
-    return std::unique_ptr<VariableContainerVolatile>(new VariableContainerVolatile(filename, accessible));
+std::unique_ptr<VariableContainerVolatile> MicroOcpp::makeVariableContainerVolatile(const char *filename, bool accessible, std::shared_ptr<VariablePool> pool) {
+    return std::unique_ptr<VariableContainerVolatile>(new VariableContainerVolatile(filename, accessible, std::move(pool)));
 }
 
 #endif // MO_ENABLE_V201
@@ -51,14 +51,16 @@ public:
     virtual size_t size() const = 0;
     virtual Variable *getVariable(size_t i) const = 0;
     virtual std::shared_ptr<Variable> getVariable(const ComponentId& component, const char *variableName, const char *instanceName=nullptr) const = 0;
+    virtual std::shared_ptr<Variable> getVariableShared(size_t i) const; //used by the VariableService index. Default implementation is a linear search
     virtual void loadStaticKey(Variable& var, const ComponentId& component, const char *variableName, const char* instanceName) { } //possible optimization: can replace internal key with passed static key
 };
 
 class VariableContainerVolatile : public VariableContainer {
 private:
     std::vector<std::shared_ptr<Variable>> variables;
+    std::shared_ptr<VariablePool> pool;
 public:
-    VariableContainerVolatile(const char *filename, bool accessible);
+    VariableContainerVolatile(const char *filename, bool accessible, std::shared_ptr<VariablePool> pool = nullptr);
     ~VariableContainerVolatile();
 
     //VariableContainer definitions
@@ -69,9 +71,10 @@ public:
     size_t size() const override;
     Variable *getVariable(size_t i) const override;
     std::shared_ptr<Variable> getVariable(const ComponentId& component, const char *variableName, const char *instanceName=nullptr) const override;
+    std::shared_ptr<Variable> getVariableShared(size_t i) const override;
 };
 
-std::unique_ptr<VariableContainerVolatile> makeVariableContainerVolatile(const char *filename, bool accessible);
+std::unique_ptr<VariableContainerVolatile> makeVariableContainerVolatile(const char *filename, bool accessible, std::shared_ptr<VariablePool> pool = nullptr);
 
 } //end namespace MicroOcpp
 
@@ -19,6 +19,7 @@ namespace MicroOcpp
         uint16_t revisionSum = 0;
         bool loaded = false;
         std::vector<std::unique_ptr<char[]>> keyPool;
+        std::shared_ptr<VariablePool> pool;
 
         void clearKeyPool(const char *key)
         {
@@ -50,7 +51,7 @@ namespace MicroOcpp
         }
 
     public:
-        VariableContainerFlash(std::shared_ptr<FilesystemAdapter> filesystem, const char *filename, bool accessible) : VariableContainer(filename, accessible), filesystem(filesystem) {}
+        VariableContainerFlash(std::shared_ptr<FilesystemAdapter> filesystem, const char *filename, bool accessible, std::shared_ptr<VariablePool> pool) : VariableContainer(filename, accessible), filesystem(filesystem), pool(std::move(pool)) {}
 
         // VariableContainer definitions
         bool load() override
@@ -311,7 +312,7 @@ namespace MicroOcpp
 
         std::shared_ptr<Variable> createVariable(Variable::InternalDataType dtype, Variable::AttributeTypeSet attributes) override
         {
-            return makeVariable(dtype, attributes);
+            return makeVariableShared(pool, dtype, attributes);
         }
 
         bool add(std::shared_ptr<Variable> variable) override
@@ -330,6 +331,11 @@ namespace MicroOcpp
             return variables[i].get();
         }
 
+        std::shared_ptr<Variable> getVariableShared(size_t i) const override
+        {
+            return variables[i];
+        }
+
         std::shared_ptr<Variable> getVariable(const ComponentId &component, const char *variableName, const char *instanceName=nullptr) const override
         {
             for (auto it = variables.begin(); it != variables.end(); it++)
@@ -357,9 +363,9 @@ namespace MicroOcpp
         }
     };
 
-    std::unique_ptr<VariableContainer> makeVariableContainerFlash(std::shared_ptr<FilesystemAdapter> filesystem, const char *filename, bool accessible)
+    std::unique_ptr<VariableContainer> makeVariableContainerFlash(std::shared_ptr<FilesystemAdapter> filesystem, const char *filename, bool accessible, std::shared_ptr<VariablePool> pool)
     {
-        return std::unique_ptr<VariableContainer>(new VariableContainerFlash(filesystem, filename, accessible));
+        return std::unique_ptr<VariableContainer>(new VariableContainerFlash(filesystem, filename, accessible, std::move(pool)));
     }
 
 } // end namespace MicroOcpp
@@ -29,7 +29,7 @@ namespace MicroOcpp {
 //         }
 //     ]
 // }
-std::unique_ptr<VariableContainer> makeVariableContainerFlash(std::shared_ptr<FilesystemAdapter> filesystem, const char *filename, bool accessible);
+std::unique_ptr<VariableContainer> makeVariableContainerFlash(std::shared_ptr<FilesystemAdapter> filesystem, const char *filename, bool accessible, std::shared_ptr<VariablePool> pool = nullptr);
 
 } //end namespace MicroOcpp
 
@@ -33,25 +33,204 @@ VariableValidator<T>::VariableValidator(const ComponentId& component, const char
 }
 
 template <class T>
-VariableValidator<T> *getVariableValidator(std::vector<VariableValidator<T>>& collection, const ComponentId& component, const char *name) {
-    for (auto& validator : collection) {
-        if (!strcmp(name, validator.name) && component.equals(validator.component)) {
-            return &validator;
+uint16_t getVariableValidator(std::vector<VariableValidator<T>>& collection, const ComponentId& component, const char *name) {
+    for (size_t i = 0; i < collection.size(); i++) {
+        if (!strcmp(name, collection[i].name) && component.equals(collection[i].component)) {
+            return (uint16_t) i;
         }
     }
-    return nullptr;
+    return MO_VARIABLE_INDEX_NIL;
+}
+
+uint16_t VariableService::findValidator(Variable::InternalDataType type, const ComponentId& component, const char *name) {
+    switch (type) {
+        case Variable::InternalDataType::Int:
+            return getVariableValidator<int>(validatorInt, component, name);
+        case Variable::InternalDataType::Bool:
+            return getVariableValidator<bool>(validatorBool, component, name);
+        case Variable::InternalDataType::String:
+            return getVariableValidator<const char*>(validatorString, component, name);
+    }
+    return MO_VARIABLE_INDEX_NIL;
+}
+
+template <>
+bool VariableService::validate<int>(const VariableIndexEntry& entry, int value) {
+    return entry.validator == MO_VARIABLE_INDEX_NIL || validatorInt[entry.validator].validate(value);
+}
+
+template <>
+bool VariableService::validate<bool>(const VariableIndexEntry& entry, bool value) {
+    return entry.validator == MO_VARIABLE_INDEX_NIL || validatorBool[entry.validator].validate(value);
+}
+
+template <>
+bool VariableService::validate<const char*>(const VariableIndexEntry& entry, const char *value) {
+    return entry.validator == MO_VARIABLE_INDEX_NIL || validatorString[entry.validator].validate(value);
+}
+
+namespace VariableIndex {
+
+uint32_t hashAppend(uint32_t hash, const char *str) {
+    //FNV-1a, including the terminating zero. nullptr is hashed like a string which cannot occur
+    if (!str) {
+        hash ^= 0xFF;
+        hash *= 16777619UL;
+        return hash;
+    }
+    do {
+        hash ^= (uint8_t) *str;
+        hash *= 16777619UL;
+    } while (*str++);
+    return hash;
+}
+
+uint32_t hashAppend(uint32_t hash, int val) {
+    for (size_t i = 0; i < sizeof(val); i++) {
+        hash ^= (uint8_t) (val >> (8 * i));
+        hash *= 16777619UL;
+    }
+    return hash;
+}
+
+uint32_t hashComponent(const ComponentId& component) {
+    uint32_t hash = 2166136261UL;
+    hash = hashAppend(hash, component.name);
+    hash = hashAppend(hash, component.instance);
+    hash = hashAppend(hash, component.evse.id < 0 ? -1 : component.evse.id); //negative ids are all "undefined", see ComponentId::equals
+    hash = hashAppend(hash, component.evse.connectorId < 0 ? -1 : component.evse.connectorId);
+    return hash;
+}
+
+uint32_t hashVariable(uint32_t componentHash, const char *name) {
+    return hashAppend(componentHash, name);
+}
+
+void bucketsPut(std::vector<uint16_t>& buckets, size_t pos, uint32_t hash) {
+    size_t mask = buckets.size() - 1;
+    size_t i = hash & mask;
+    while (buckets[i] != MO_VARIABLE_INDEX_NIL) {
+        i = (i + 1) & mask;
+    }
+    buckets[i] = (uint16_t) pos;
+}
+
+//make space for one more position in buckets. Keeps the load factor at most 1/2 and rehashes if necessary
+bool bucketsReserve(std::vector<uint16_t>& buckets, size_t size, std::function<uint32_t(size_t)> hashAt) {
+    if (size + 1 >= MO_VARIABLE_INDEX_NIL) {
+        MO_DBG_ERR("exceed max number of variables");
+        return false;
+    }
+    if ((size + 1) * 2 <= buckets.size()) {
+        return true;
+    }
+    buckets.assign(buckets.empty() ? 32 : 2 * buckets.size(), MO_VARIABLE_INDEX_NIL);
+    for (size_t i = 0; i < size; i++) {
+        bucketsPut(buckets, i, hashAt(i));
+    }
+    return true;
 }
 
-VariableValidator<int> *VariableService::getValidatorInt(const ComponentId& component, const char *name) {
-    return getVariableValidator<int>(validatorInt, component, name);
+bool matchesInstance(const char *instance, const char *other) {
+    return (!instance && !other) || (instance && other && !strcmp(instance, other));
 }
 
-VariableValidator<bool> *VariableService::getValidatorBool(const ComponentId& component, const char *name) {
-    return getVariableValidator<bool>(validatorBool, component, name);
+} //end namespace VariableIndex
+
+using namespace VariableIndex;
+
+bool VariableService::indexInsert(std::shared_ptr<Variable> variable, VariableContainer *container) {
+    if (!variable->getName() || !variable->getComponentId().name) {
+        return true; //cannot be looked up
+    }
+
+    if (!bucketsReserve(indexBuckets, index.size(), [this] (size_t i) {return index[i].hash;}) ||
+            !bucketsReserve(componentBuckets, index.size(), [this] (size_t i) {return index[i].componentHash;})) {
+        return false;
+    }
+
+    uint32_t componentHash = hashComponent(variable->getComponentId());
+    uint32_t hash = hashVariable(componentHash, variable->getName());
+    uint16_t validator = findValidator(variable->getInternalDataType(), variable->getComponentId(), variable->getName());
+
+    index.push_back(VariableIndexEntry{std::move(variable), container, hash, componentHash, validator});
+    bucketsPut(indexBuckets, index.size() - 1, hash);
+    bucketsPut(componentBuckets, index.size() - 1, componentHash);
+    return true;
+}
+
+bool VariableService::indexBuild() {
+    index.clear();
+    indexBuckets.clear();
+    componentBuckets.clear();
+    indexedSize = 0;
+    indexValid = false;
+
+    for (auto& container : containers) {
+        for (size_t i = 0; i < container->size(); i++) {
+            indexedSize++;
+            auto variable = container->getVariableShared(i);
+            if (variable && !indexInsert(std::move(variable), container.get())) {
+                return false;
+            }
+        }
+    }
+
+    indexValid = true;
+    return true;
 }
 
-VariableValidator<const char*> *VariableService::getValidatorString(const ComponentId& component, const char *name) {
-    return getVariableValidator<const char*>(validatorString, component, name);
+bool VariableService::indexUpToDate() {
+    if (!indexValid) {
+        return false;
+    }
+
+    size_t size = 0;
+    for (auto& container : containers) {
+        size += container->size();
+    }
+    return size == indexedSize;
+}
+
+VariableIndexEntry *VariableService::lookupVariable(const ComponentId& component, const char *name, const char *instance, bool accessibleOnly, bool *foundComponent) {
+
+    if (!(indexUpToDate() || indexBuild()) || index.empty()) {
+        return nullptr;
+    }
+
+    size_t mask = indexBuckets.size() - 1;
+    uint32_t componentHash = hashComponent(component);
+    uint32_t hash = hashVariable(componentHash, name);
+
+    for (size_t i = hash & mask; indexBuckets[i] != MO_VARIABLE_INDEX_NIL; i = (i + 1) & mask) {
+        auto& entry = index[indexBuckets[i]];
+        if (entry.hash == hash &&
+                !entry.variable->isDetached() &&
+                (!accessibleOnly || entry.container->isAccessible()) &&
+                !strcmp(entry.variable->getName(), name) &&
+                matchesInstance(entry.variable->getInstance(), instance) &&
+                entry.variable->getComponentId().equals(component)) {
+            if (foundComponent) {
+                *foundComponent = true;
+            }
+            return &entry;
+        }
+    }
+
+    if (foundComponent) {
+        *foundComponent = false;
+        for (size_t i = componentHash & mask; componentBuckets[i] != MO_VARIABLE_INDEX_NIL; i = (i + 1) & mask) {
+            auto& entry = index[componentBuckets[i]];
+            if (entry.componentHash == componentHash &&
+                    (!accessibleOnly || entry.container->isAccessible()) &&
+                    entry.variable->getComponentId().equals(component)) {
+                *foundComponent = true;
+                break;
+            }
+        }
+    }
+
+    return nullptr;
 }
 
 std::unique_ptr<VariableContainer> VariableService::createContainer(const char *filename, bool accessible) const {
@@ -60,10 +239,10 @@ std::unique_ptr<VariableContainer> VariableService::createContainer(const char *
     //     - Filename starts with "/volatile"
    if (!filesystem ||
                 !strncmp(filename, MO_VARIABLE_VOLATILE, strlen(MO_VARIABLE_VOLATILE))) {
-        return makeVariableContainerVolatile(filename, accessible);
+        return makeVariableContainerVolatile(filename, accessible, pool);
    } else {
        //create persistent Variable store. This is the normal case
-       return makeVariableContainerFlash(filesystem, filename, accessible);
+       return makeVariableContainerFlash(filesystem, filename, accessible, pool);
    }
 }
 
@@ -80,31 +259,59 @@ std::shared_ptr<VariableContainer> VariableService::getContainer(const char *fil
     return nullptr;
 }
 
+//replaces the validator of component x name in place, so that the positions in the index stay valid. Returns the position
 template <class T>
-bool registerVariableValidator(std::vector<VariableValidator<T>>& collection, const ComponentId& component, const char *name, std::function<bool(T)> validate) {
-    for (auto it = collection.begin(); it != collection.end(); it++) {
-        if (!strcmp(name, it->name) && component.equals(it->component)) {
-            collection.erase(it);
-            break;
-        }
+uint16_t registerVariableValidator(std::vector<VariableValidator<T>>& collection, const ComponentId& component, const char *name, std::function<bool(T)> validate) {
+    auto i = getVariableValidator<T>(collection, component, name);
+    if (i != MO_VARIABLE_INDEX_NIL) {
+        collection[i].validate = validate;
+        return i;
+    }
+    if (collection.size() + 1 >= MO_VARIABLE_INDEX_NIL) {
+        MO_DBG_ERR("exceed max number of validators");
+        return MO_VARIABLE_INDEX_NIL;
     }
     collection.emplace_back(component, name, validate);
-    return true;
+    return (uint16_t) (collection.size() - 1);
+}
+
+//resolve validator of all instances of component x name which have already been declared
+void attachValidator(std::vector<VariableIndexEntry>& index, std::vector<uint16_t>& indexBuckets, Variable::InternalDataType type, const ComponentId& component, const char *name, uint16_t validator) {
+    if (index.empty()) {
+        return;
+    }
+    size_t mask = indexBuckets.size() - 1;
+    uint32_t hash = hashVariable(hashComponent(component), name);
+    for (size_t i = hash & mask; indexBuckets[i] != MO_VARIABLE_INDEX_NIL; i = (i + 1) & mask) {
+        auto& entry = index[indexBuckets[i]];
+        if (entry.hash == hash &&
+                entry.variable->getInternalDataType() == type &&
+                !strcmp(entry.variable->getName(), name) &&
+                entry.variable->getComponentId().equals(component)) {
+            entry.validator = validator;
+        }
+    }
 }
 
 template <>
 bool VariableService::registerValidator<int>(const ComponentId& component, const char *name, std::function<bool(int)> validate) {
-    return registerVariableValidator<int>(validatorInt, component, name, validate);
+    auto validator = registerVariableValidator<int>(validatorInt, component, name, validate);
+    attachValidator(index, indexBuckets, Variable::InternalDataType::Int, component, name, validator);
+    return validator != MO_VARIABLE_INDEX_NIL;
 }
 
 template <>
 bool VariableService::registerValidator<bool>(const ComponentId& component, const char *name, std::function<bool(bool)> validate) {
-    return registerVariableValidator<bool>(validatorBool, component, name, validate);
+    auto validator = registerVariableValidator<bool>(validatorBool, component, name, validate);
+    attachValidator(index, indexBuckets, Variable::InternalDataType::Bool, component, name, validator);
+    return validator != MO_VARIABLE_INDEX_NIL;
 }
 
 template <>
 bool VariableService::registerValidator<const char*>(const ComponentId& component, const char *name, std::function<bool(const char*)> validate) {
-    return registerVariableValidator<const char*>(validatorString, component, name, validate);
+    auto validator = registerVariableValidator<const char*>(validatorString, component, name, validate);
+    attachValidator(index, indexBuckets, Variable::InternalDataType::String, component, name, validator);
+    return validator != MO_VARIABLE_INDEX_NIL;
 }
 
 VariableContainer *VariableService::declareContainer(const char *filename, bool accessible) {
@@ -129,28 +336,28 @@ VariableContainer *VariableService::declareContainer(const char *filename, bool
     return container.get();
 }
 
-std::shared_ptr<Variable> VariableService::getVariable(Variable::InternalDataType type, const ComponentId& component, const char *name, const char* instance, bool accessible) {
-    for (auto& container : containers) {
-        if (auto variable = container->getVariable(component, name, instance)) {
-            if (variable->isDetached()) {
-                continue;
-            }
-            if (variable->getInternalDataType() != type) {
-                MO_DBG_ERR("conflicting type for %s - remove old variable", name);
-                variable->detach();
-                continue;
-            }
-            if (container->isAccessible() != accessible) {
-                MO_DBG_ERR("conflicting accessibility for %s", name);
-            }
-            container->loadStaticKey(*variable,component, name,instance);
-            return variable;
+VariableIndexEntry *VariableService::getVariable(Variable::InternalDataType type, const ComponentId& component, const char *name, const char* instance, bool accessible) {
+    while (auto entry = lookupVariable(component, name, instance, false)) {
+        auto& variable = entry->variable;
+        if (variable->getInternalDataType() != type) {
+            MO_DBG_ERR("conflicting type for %s - remove old variable", name);
+            variable->detach();
+            continue;
+        }
+        if (entry->container->isAccessible() != accessible) {
+            MO_DBG_ERR("conflicting accessibility for %s", name);
         }
+        entry->container->loadStaticKey(*variable,component, name,instance);
+        return entry;
     }
     return nullptr;
 }
 
 VariableService::VariableService(Context& context, std::shared_ptr<FilesystemAdapter> filesystem) : context(context), filesystem(filesystem) {
+    #if MO_VARIABLE_POOL_SIZE > 0
+    pool = std::make_shared<VariablePool>(MO_VARIABLE_POOL_SIZE);
+    #endif
+
     declareVariable<int>("OCPPCommCtrlr", "MessageTimeout", 30, MO_VARIABLE_VOLATILE, Variable::Mutability::ReadOnly,"Default");
     declareVariable<const char*>("OCPPCommCtrlr", "FileTransferProtocols", "HTTP,HTTPS", MO_VARIABLE_VOLATILE, Variable::Mutability::ReadOnly);
     declareVariable<const char*>("OCPPCommCtrlr", "NetworkConfigurationPriority", "3,2,1,0", MO_VARIABLE_VOLATILE, Variable::Mutability::ReadOnly);
@@ -174,6 +381,10 @@ VariableService::VariableService(Context& context, std::shared_ptr<FilesystemAda
         return new Ocpp201::GetVariables(*this);});
     context.getOperationRegistry().registerOperation("GetBaseReport", [this] () {
         return new Ocpp201::GetBaseReport(*this);});
+
+    if (!context.getRequestQueue().addSendQueue(this)) { // register at RequestQueue as Request emitter
+        MO_DBG_ERR("VariableService cannot send requests");
+    }
 }
 
 template<class T>
@@ -231,8 +442,10 @@ template<> Variable::InternalDataType getInternalDataType<const char*>() {return
 template<class T>
 std::shared_ptr<Variable> VariableService::declareVariable(const ComponentId& component, const char *name, T factoryDefault, const char *containerPath, Variable::Mutability mutability, const char*instance, Variable::AttributeTypeSet attributes, bool rebootRequired, bool accessible) {
 
-    auto res = getVariable(getInternalDataType<T>(), component, name, instance, accessible);
-    if (!res) {
+    std::shared_ptr<Variable> res;
+    if (auto entry = getVariable(getInternalDataType<T>(), component, name, instance, accessible)) {
+        res = entry->variable;
+    } else {
         auto container = declareContainer(containerPath, accessible);
         if (!container) {
             return nullptr;
@@ -256,6 +469,14 @@ std::shared_ptr<Variable> VariableService::declareVariable(const ComponentId& co
         if (!container->add(std::move(variable))) {
             return nullptr;
         }
+
+        if (indexValid) {
+            //keep index up-to-date without rebuilding it for every declared variable
+            indexedSize++;
+            if (!indexInsert(res, container)) {
+                indexValid = false;
+            }
+        }
     }
     loadVariableCharacteristics(*res, mutability, rebootRequired, getInternalDataType<T>());
     return res;
@@ -291,35 +512,10 @@ bool VariableService::load() {
 
 SetVariableStatus VariableService::setVariable(Variable::AttributeType attrType, const char *value, const ComponentId& component, const char *variableName, const char* variableInstance) {
 
-    Variable *variable = nullptr;
-
     bool foundComponent = false;
-    for (const auto& container : containers) {
-        if (!container->isAccessible()) {
-            // container intended for internal use only
-            continue;
-        }
-        for (size_t i = 0; i < container->size(); i++) {
-            auto entry = container->getVariable(i);
-
-            if (entry->getComponentId().equals(component)) {
-                foundComponent = true;
+    auto entry = lookupVariable(component, variableName, variableInstance, true, &foundComponent); // skip containers intended for internal use only
 
-                if (!strcmp(entry->getName(), variableName) &&
-                ((!entry->getInstance() && !variableInstance) || !strcmp(entry->getInstance(), variableName))) {
-                    // found variable. Search terminated in this block
-                    variable = entry;
-                    break;
-                }
-            }
-        }
-        if (variable) {
-            // result found in inner for-loop
-            break;
-        }
-    }
-
-    if (!variable) {
+    if (!entry) {
         if (foundComponent) {
             return SetVariableStatus::UnknownVariable;
         } else {
@@ -327,6 +523,8 @@ SetVariableStatus VariableService::setVariable(Variable::AttributeType attrType,
         }
     }
 
+    auto variable = entry->variable.get();
+
     if (variable->getMutability() == Variable::Mutability::ReadOnly) {
         return SetVariableStatus::Rejected;
     }
@@ -396,22 +594,19 @@ SetVariableStatus VariableService::setVariable(Variable::AttributeType attrType,
     // validate and store (parsed) value to Config
 
     if (variable->getInternalDataType() == Variable::InternalDataType::Int && convertibleInt) {
-        auto validator = getValidatorInt(component, variableName);
-        if (validator && !validator->validate(numInt)) {
+        if (!validate<int>(*entry, numInt)) {
             MO_DBG_WARN("validation failed for variable=%s", variableName);
             return SetVariableStatus::Rejected;
         }
         variable->setInt(numInt);
     } else if (variable->getInternalDataType() == Variable::InternalDataType::Bool && convertibleBool) {
-        auto validator = getValidatorBool(component, variableName);
-        if (validator && !validator->validate(numBool)) {
+        if (!validate<bool>(*entry, numBool)) {
             MO_DBG_WARN("validation failed for variable=%s", variableName);
             return SetVariableStatus::Rejected;
         }
         variable->setBool(numBool);
     } else if (variable->getInternalDataType() == Variable::InternalDataType::String) {
-        auto validator = getValidatorString(component, variableName);
-        if (validator && !validator->validate(value)) {
+        if (!validate<const char*>(*entry, value)) {
             MO_DBG_WARN("validation failed for variable=%s", variableName);
             return SetVariableStatus::Rejected;
         }
@@ -431,29 +626,18 @@ SetVariableStatus VariableService::setVariable(Variable::AttributeType attrType,
 GetVariableStatus VariableService::getVariable(Variable::AttributeType attrType, const ComponentId& component, const char *variableName,  const char* instance, Variable **result) {
 
     bool foundComponent = false;
-    for (const auto& container : containers) {
-        for (size_t i = 0; i < container->size(); i++) {
-            auto variable = container->getVariable(i);
-
-            if (variable->getComponentId().equals(component)) {
-                foundComponent = true;
-
-                if (!strcmp(variable->getName(), variableName) &&
-                ((!variable->getInstance() && !instance) ||  (variable->getInstance() && instance && !strcmp(variable->getInstance(), instance)))) {
-                    // found variable. Search terminated in this block
-
-                    if (variable->getMutability() == Variable::Mutability::WriteOnly) {
-                        return GetVariableStatus::Rejected;
-                    }
-
-                    if (variable->hasAttribute(attrType)) {
-                        *result = variable;
-                        return GetVariableStatus::Accepted;
-                    } else {
-                        return GetVariableStatus::NotSupportedAttributeType;
-                    }
-                }
-            }
+    if (auto entry = lookupVariable(component, variableName, instance, false, &foundComponent)) {
+        auto variable = entry->variable.get();
+
+        if (variable->getMutability() == Variable::Mutability::WriteOnly) {
+            return GetVariableStatus::Rejected;
+        }
+
+        if (variable->hasAttribute(attrType)) {
+            *result = variable;
+            return GetVariableStatus::Accepted;
+        } else {
+            return GetVariableStatus::NotSupportedAttributeType;
         }
     }
 
@@ -470,50 +654,100 @@ GenericDeviceModelStatus VariableService::getBaseReport(int requestId, ReportBas
         return GenericDeviceModelStatus_NotSupported;
     }
 
-    std::vector<Variable*> variables;
+    if (reportRequestId >= 0) {
+        MO_DBG_WARN("base report %i still in progress", reportRequestId);
+        return GenericDeviceModelStatus_Rejected;
+    }
 
-    for (const auto& container : containers) {
+    this->reportBase = reportBase;
+
+    VariableCursor cursor;
+    if (!nextReportVariable(cursor)) {
+        return GenericDeviceModelStatus_EmptyResultSet;
+    }
+
+    reportRequestId = requestId;
+    reportSeqNo = 0;
+    reportCursor = VariableCursor();
+    reportOpNr = context.getRequestQueue().getNextOpNr();
+    reportPageSent = false;
+
+    return GenericDeviceModelStatus_Accepted;
+}
+
+Variable *VariableService::nextReportVariable(VariableCursor& cursor) {
+    for (; cursor.container < containers.size(); cursor.container++, cursor.index = 0) {
+        auto& container = containers[cursor.container];
         if (!container->isAccessible()) {
             // container intended for internal use only
             continue;
         }
-        for (size_t i = 0; i < container->size(); i++) {
-            auto variable = container->getVariable(i);
+        while (cursor.index < container->size()) {
+            auto variable = container->getVariable(cursor.index);
+            cursor.index++;
+
+            if (variable->isDetached()) {
+                continue;
+            }
 
             if (reportBase == ReportBase_ConfigurationInventory && variable->getMutability() == Variable::Mutability::ReadOnly) {
                 continue;
             }
 
-            variables.push_back(variable);
+            return variable;
         }
     }
+    return nullptr;
+}
 
-    if (variables.empty()) {
-        return GenericDeviceModelStatus_EmptyResultSet;
+unsigned int VariableService::getFrontRequestOpNr() {
+    if (reportRequestId < 0 || reportPageSent) {
+        return NoOperation;
     }
+    return reportOpNr;
+}
 
-    std::vector<std::vector<Variable*>> groupedVariables;
-
-    for (size_t i = 0; i < variables.size(); i += MO_MAX_REPORT_ITEMS) {
-        auto start = variables.begin() + i;
-        auto end = (i + MO_MAX_REPORT_ITEMS < variables.size()) ? start + MO_MAX_REPORT_ITEMS : variables.end();
-        std::vector<Variable*> group(start, end);
-        groupedVariables.push_back(group);
+std::unique_ptr<Request> VariableService::fetchFrontRequest() {
+    if (reportRequestId < 0 || reportPageSent) {
+        return nullptr;
     }
 
-    for (size_t i = 0; i < groupedVariables.size(); i++) {
-        auto notifyReport = makeRequest(new Ocpp201::NotifyReport(
-                context.getModel(), 
-                requestId,
-                context.getModel().getClock().now(),
-                i != groupedVariables.size()-1,
-                i,
-                groupedVariables[i]));
+    auto notifyReport = new Ocpp201::NotifyReport(
+            context.getModel(),
+            *this,
+            reportRequestId,
+            context.getModel().getClock().now(),
+            reportSeqNo,
+            reportCursor);
+
+    auto request = makeRequest(notifyReport);
+    request->setOpNr(reportOpNr);
+
+    request->setOnReceiveConfListener([this, notifyReport] (JsonObject) {
+        //page confirmed, continue with next page or finish report
+        reportCursor = notifyReport->getEnd();
+        reportSeqNo++;
+        reportOpNr = context.getRequestQueue().getNextOpNr();
+        reportPageSent = false;
+        if (!notifyReport->isTbc()) {
+            MO_DBG_DEBUG("base report %i finished", reportRequestId);
+            reportRequestId = -1;
+        }
+    });
 
-        context.initiateRequest(std::move(notifyReport));
-    }
+    request->setOnTimeoutListener([this] () {
+        //send this page again
+        reportPageSent = false;
+    });
 
-    return GenericDeviceModelStatus_Accepted;
+    request->setOnReceiveErrorListener([this] (const char*, const char*, JsonObject) {
+        MO_DBG_ERR("base report %i aborted", reportRequestId);
+        reportRequestId = -1;
+        reportPageSent = false;
+    });
+
+    reportPageSent = true;
+    return request;
 }
 
 } // namespace MicroOcpp
@@ -22,6 +22,7 @@
 #include <MicroOcpp/Model/Variables/Variable.h>
 #include <MicroOcpp/Model/Variables/VariableContainer.h>
 #include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/RequestQueue.h>
 
 #ifndef MO_VARIABLE_FN
 #define MO_VARIABLE_FN (MO_FILENAME_PREFIX "ocpp-vars.jsn")
@@ -35,11 +36,17 @@
 #define MO_VARIABLE_INTERNAL_FN (MO_FILENAME_PREFIX "mo-vars.jsn")
 #endif
 
-#ifndef MO_MAX_REPORT_ITEMS
+#define MO_VARIABLE_INDEX_NIL 0xFFFF
+
+#ifdef MO_MAX_REPORT_ITEMS
+#error MO_MAX_REPORT_ITEMS has been replaced by MO_REPORT_PAGE_SIZE, the max serialized size of the reportData of one NotifyReport in bytes
+#endif
+
+#ifndef MO_REPORT_PAGE_SIZE
 #if MO_PLATFORM == MO_PLATFORM_UNIX
-#define MO_MAX_REPORT_ITEMS 8192
+#define MO_REPORT_PAGE_SIZE 8192 //max serialized size of the reportData of one NotifyReport
 #else
-#define MO_MAX_REPORT_ITEMS 30
+#define MO_REPORT_PAGE_SIZE 2048
 #endif
 #endif
 
@@ -55,25 +62,61 @@ struct VariableValidator {
 
 class Context;
 
-class VariableService {
+//entry of the VariableService lookup index
+struct VariableIndexEntry {
+    std::shared_ptr<Variable> variable;
+    VariableContainer *container;
+    uint32_t hash; //hash of component and variable name. All instances of a variable have the same hash
+    uint32_t componentHash;
+    uint16_t validator; //position in the validator list of the variable data type, or MO_VARIABLE_INDEX_NIL
+};
+
+//position in the variable containers of the VariableService
+struct VariableCursor {
+    size_t container = 0;
+    size_t index = 0;
+};
+
+class VariableService : public RequestEmitter {
 private:
     Context& context;
     std::shared_ptr<FilesystemAdapter> filesystem;
     std::vector<std::shared_ptr<VariableContainer>> containers;
+    std::shared_ptr<VariablePool> pool; //memory of the Variables of the built-in containers
 
     std::vector<VariableValidator<int>> validatorInt;
     std::vector<VariableValidator<bool>> validatorBool;
     std::vector<VariableValidator<const char*>> validatorString;
 
-    VariableValidator<int> *getValidatorInt(const ComponentId& component, const char *name);
-    VariableValidator<bool> *getValidatorBool(const ComponentId& component, const char *name);
-    VariableValidator<const char*> *getValidatorString(const ComponentId& component, const char *name);
+    uint16_t findValidator(Variable::InternalDataType type, const ComponentId& component, const char *name); //position in the validator list of type, or MO_VARIABLE_INDEX_NIL
+    template <class T>
+    bool validate(const VariableIndexEntry& entry, T value);
+
+    //hash index over the variables of all containers. Dense entries + open addressing tables of entry positions
+    std::vector<VariableIndexEntry> index;
+    std::vector<uint16_t> indexBuckets; //keyed by VariableIndexEntry::hash
+    std::vector<uint16_t> componentBuckets; //keyed by VariableIndexEntry::componentHash
+    size_t indexedSize = 0; //sum of the container sizes when the index was built. Detects variables added by containers
+    bool indexValid = false;
+
+    bool indexInsert(std::shared_ptr<Variable> variable, VariableContainer *container);
+    bool indexBuild();
+    bool indexUpToDate();
+    VariableIndexEntry *lookupVariable(const ComponentId& component, const char *name, const char *instance, bool accessibleOnly, bool *foundComponent = nullptr); //returns non-detached variable or nullptr
 
     std::unique_ptr<VariableContainer> createContainer(const char *filename, bool accessible) const;
 
     VariableContainer *declareContainer(const char *filename, bool accessible);
 
-    std::shared_ptr<Variable> getVariable(Variable::InternalDataType type, const ComponentId& component, const char *name, const char* instance, bool accessible);
+    VariableIndexEntry *getVariable(Variable::InternalDataType type, const ComponentId& component, const char *name, const char* instance, bool accessible);
+
+    //base report which is being sent. Pages are emitted one after another when the previous one is confirmed
+    int reportRequestId = -1; //-1 if no report is in progress
+    ReportBase reportBase = ReportBase_FullInventory;
+    int reportSeqNo = 0;
+    VariableCursor reportCursor; //begin of the next page
+    unsigned int reportOpNr = NoOperation;
+    bool reportPageSent = false;
 
 public:
     VariableService(Context& context, std::shared_ptr<FilesystemAdapter> filesystem);
@@ -91,11 +134,19 @@ public:
     template <class T>
     bool registerValidator(const ComponentId& component, const char *name, std::function<bool(T)> validate);
 
-    SetVariableStatus setVariable(Variable::AttributeType attrType, const char *attrVal, const ComponentId& component, const char* variableInstance, const char *variableName);
+    SetVariableStatus setVariable(Variable::AttributeType attrType, const char *attrVal, const ComponentId& component, const char *variableName, const char* variableInstance);
 
     GetVariableStatus getVariable(Variable::AttributeType attrType, const ComponentId& component, const char *variableName,  const char* instance,  Variable **result);
 
     GenericDeviceModelStatus getBaseReport(int requestId, ReportBase reportBase);
+
+    const VariablePool *getPool() const {return pool.get();} //used in unit tests
+
+    Variable *nextReportVariable(VariableCursor& cursor); //returns the next Variable of the current base report at or after cursor and moves cursor behind it. nullptr if none left
+
+    //RequestEmitter definitions: emits the NotifyReports of the current base report
+    unsigned int getFrontRequestOpNr() override;
+    std::unique_ptr<Request> fetchFrontRequest() override;
 };
 
 } // namespace MicroOcpp
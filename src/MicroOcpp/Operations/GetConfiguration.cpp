@@ -29,10 +29,9 @@ std::unique_ptr<DynamicJsonDocument> GetConfiguration::createConf(){
     std::vector<Configuration*> configurations;
     std::vector<const char*> unknownKeys;
 
-    auto containers = getConfigurationContainersPublic();
-
     if (keys.empty()) {
         //return all existing keys
+        auto containers = getConfigurationContainersPublic();
         for (auto container : containers) {
             for (size_t i = 0; i < container->size(); i++) {
                 if (!container->getConfiguration(i)->getKey()) {
@@ -45,12 +44,7 @@ std::unique_ptr<DynamicJsonDocument> GetConfiguration::createConf(){
     } else {
         //only return keys that were searched using the "key" parameter
         for (auto& key : keys) {
-            Configuration *res = nullptr;
-            for (auto container : containers) {
-                if ((res = container->getConfiguration(key.c_str()).get())) {
-                    break;
-                }
-            }
+            Configuration *res = getConfigurationPublic(key.c_str());
 
             if (res) {
                 configurations.push_back(res);
@@ -144,3 +138,114 @@ std::unique_ptr<DynamicJsonDocument> GetConfiguration::createConf(){
 
     return doc;
 }
+
+namespace MicroOcpp {
+namespace Ocpp16 {
+namespace GetConfigurationUtils {
+
+//appends {"key":...,"readonly":...,"value":...} to out
+void serializeKeyValue(Configuration& config, std::string& out) {
+    char vbuf [VALUE_BUFSIZE];
+    const char *v = "";
+    switch (config.getType()) {
+        case TConfig::Int: {
+            auto ret = snprintf(vbuf, VALUE_BUFSIZE, "%i", config.getInt());
+            if (ret < 0 || ret >= VALUE_BUFSIZE) {
+                MO_DBG_ERR("value error");
+                break;
+            }
+            v = vbuf;
+            break;
+        }
+        case TConfig::Bool:
+            v = config.getBool() ? "true" : "false";
+            break;
+        case TConfig::String:
+            v = config.getString();
+            break;
+    }
+
+    //scratch document for one entry. Strings are linked in zero-copy mode
+    StaticJsonDocument<JSON_OBJECT_SIZE(3)> entry;
+    entry["key"] = config.getKey();
+    entry["readonly"] = config.isReadOnly();
+    entry["value"] = v;
+    serializeJson(entry, out);
+}
+
+//appends a JSON string to out
+void serializeString(const char *str, std::string& out) {
+    StaticJsonDocument<JSON_ARRAY_SIZE(1)> scratch;
+    scratch.set(str);
+    serializeJson(scratch, out);
+}
+
+} //end namespace GetConfigurationUtils
+} //end namespace Ocpp16
+} //end namespace MicroOcpp
+
+using namespace MicroOcpp::Ocpp16::GetConfigurationUtils;
+
+bool GetConfiguration::serializeConf(std::string& out) {
+
+    //write the entries one after another into the message. Memory usage doesn't depend on the number of configs
+
+    out += "{\"configurationKey\":[";
+
+    bool empty = true;
+    size_t nUnknownKeys = 0;
+
+    if (keys.empty()) {
+        //return all existing keys
+        for (auto container : getConfigurationContainersPublic()) {
+            for (size_t i = 0; i < container->size(); i++) {
+                auto config = container->getConfiguration(i);
+                if (!config->getKey()) {
+                    MO_DBG_ERR("invalid config");
+                    continue;
+                }
+                if (!empty) {
+                    out.push_back(',');
+                }
+                serializeKeyValue(*config, out);
+                empty = false;
+            }
+        }
+    } else {
+        //only return keys that were searched using the "key" parameter
+        for (auto& key : keys) {
+            auto config = getConfigurationPublic(key.c_str());
+            if (!config) {
+                nUnknownKeys++;
+                continue;
+            }
+            if (!empty) {
+                out.push_back(',');
+            }
+            serializeKeyValue(*config, out);
+            empty = false;
+        }
+    }
+
+    out.push_back(']');
+
+    if (nUnknownKeys > 0) {
+        out += ",\"unknownKey\":[";
+        empty = true;
+        for (auto& key : keys) {
+            if (getConfigurationPublic(key.c_str())) {
+                continue;
+            }
+            MO_DBG_DEBUG("Unknown key: %s", key.c_str());
+            if (!empty) {
+                out.push_back(',');
+            }
+            serializeString(key.c_str(), out);
+            empty = false;
+        }
+        out.push_back(']');
+    }
+
+    out.push_back('}');
+    return true;
+}
@@ -27,6 +27,8 @@ public:
 
     std::unique_ptr<DynamicJsonDocument> createConf() override;
 
+    bool serializeConf(std::string& out) override;
+
     const char *getErrorCode() override {return errorCode;}
     const char *getErrorDescription() override {return errorDescription;}
 
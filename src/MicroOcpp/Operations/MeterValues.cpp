@@ -8,6 +8,8 @@
 #include <MicroOcpp/Model/Transactions/Transaction.h>
 #include <MicroOcpp/Debug.h>
 
+#include <algorithm>
+
 using MicroOcpp::Ocpp16::MeterValues;
 
 #define ENERGY_METER_TIMEOUT_MS 30 * 1000  //after waiting for 30s, send MeterValues without missing readings
@@ -30,29 +32,63 @@ const char* MeterValues::getOperationType(){
     return "MeterValues";
 }
 
-std::unique_ptr<DynamicJsonDocument> MeterValues::createReq() {
-
-    size_t capacity = 0;
-    std::vector<std::unique_ptr<DynamicJsonDocument>> entries;
-    for (auto value = meterValue.begin(); value != meterValue.end(); value++) {
-        auto entry = (*value)->toJson(version);
-        if (entry) {
-            capacity += entry->capacity();
-            entries.push_back(std::move(entry));
-        } else {
-            MO_DBG_ERR("Energy meter reading not convertible to JSON");
+size_t MeterValues::getMeterValueSize() {
+    if (meterValueSize == 0 && !meterValue.empty()) {
+        //measure with a scratch document which is sized for the largest MeterValue
+        size_t capacity = 0;
+        for (auto value = meterValue.begin(); value != meterValue.end(); value++) {
+            capacity = std::max(capacity, (*value)->getJsonCapacity(version, batchMaxSize > 0));
+        }
+        DynamicJsonDocument entry {capacity};
+        for (auto value = meterValue.begin(); value != meterValue.end(); value++) {
+            entry.clear();
+            if ((*value)->toJson(entry.to<JsonObject>(), version, batchMaxSize > 0)) {
+                meterValueSize += measureJson(entry) + 1; //plus separator
+            }
         }
     }
+    return meterValueSize;
+}
+
+bool MeterValues::mergeOlder(MeterValues& older) {
+    if (!batchMaxSize || !older.batchMaxSize ||
+            connectorId != older.connectorId ||
+            transaction != older.transaction ||
+            version.major != older.version.major) {
+        return false;
+    }
 
+    const size_t headerSize = 64; //connectorId, transactionId and keys, rounded up
+    if (headerSize + older.getMeterValueSize() + getMeterValueSize() > batchMaxSize) {
+        return false;
+    }
+
+    meterValueSize += older.getMeterValueSize();
+    older.meterValueSize = 0;
+
+    older.meterValue.reserve(older.meterValue.size() + meterValue.size());
+    for (auto& value : meterValue) {
+        older.meterValue.push_back(std::move(value));
+    }
+    meterValue = std::move(older.meterValue);
+    older.meterValue.clear();
+
+    MO_DBG_DEBUG("batched MeterValues, now %zu elements", meterValue.size());
+    return true;
+}
+
+std::unique_ptr<DynamicJsonDocument> MeterValues::createReq() {
+
+    bool compact = batchMaxSize > 0;
+
+    size_t capacity = 0;
     capacity += JSON_OBJECT_SIZE(3);
-    capacity += JSON_ARRAY_SIZE(entries.size());
-#if MO_ENABLE_V201
-    if(version.major == 2){
-        capacity+=MO_TXID_LEN_MAX;
+    capacity += JSON_ARRAY_SIZE(meterValue.size());
+    for (auto value = meterValue.begin(); value != meterValue.end(); value++) {
+        capacity += (*value)->getJsonCapacity(version, compact);
     }
-#endif
 
-    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(capacity + 100)); //TODO remove safety space
+    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(capacity));
     auto payload = doc->to<JsonObject>();
 
 #if MO_ENABLE_V201
@@ -81,8 +117,12 @@ std::unique_ptr<DynamicJsonDocument> MeterValues::createReq() {
     }
 
     auto meterValueJson = payload.createNestedArray("meterValue");
-    for (auto entry = entries.begin(); entry != entries.end(); entry++) {
-        meterValueJson.add(**entry);
+    for (auto value = meterValue.begin(); value != meterValue.end(); value++) {
+        auto entry = meterValueJson.createNestedObject();
+        if (!(*value)->toJson(entry, version, compact)) {
+            MO_DBG_ERR("Energy meter reading not convertible to JSON");
+            meterValueJson.remove(meterValueJson.size() - 1);
+        }
     }
 
     return doc;
@@ -27,6 +27,10 @@ private:
     std::shared_ptr<ITransaction> transaction;
     ProtocolVersion version;
 
+    size_t batchMaxSize = 0; //0 means batching disabled
+    size_t meterValueSize = 0; //serialized size of the meterValue elements. 0 means not measured yet
+
+    size_t getMeterValueSize();
 public:
     MeterValues(std::vector<std::unique_ptr<MeterValue>>&& meterValue, unsigned int connectorId, std::shared_ptr<ITransaction> transaction = nullptr,const ProtocolVersion& version=VER_1_6_J);
 
@@ -34,6 +38,17 @@ public:
 
     ~MeterValues();
 
+    /*
+     * Batching: allow this operation to take over the MeterValue elements of other MeterValues requests of
+     * the same connector and transaction while it is still queued, as long as the payload stays within
+     * maxSize bytes. Batched payloads omit the SampledValue properties which equal the OCPP defaults
+     */
+    void setBatchMaxSize(size_t maxSize) {batchMaxSize = maxSize;}
+
+    bool mergeOlder(MeterValues& older); //prepend the MeterValue elements of older; true if successful and older is empty now
+
+    unsigned int getConnectorId() {return connectorId;}
+
     const char* getOperationType() override;
 
     std::unique_ptr<DynamicJsonDocument> createReq() override;
@@ -14,60 +14,137 @@
 using MicroOcpp::Ocpp201::NotifyReport;
 using namespace MicroOcpp::Ocpp201;
 
-NotifyReport::NotifyReport(Model& model, int requestId, const Timestamp& generatedAt, bool tbc, int seqNo, const std::vector<Variable*>& reportData)
-        : model(model), requestId(requestId), generatedAt(generatedAt), tbc(tbc), seqNo(seqNo), reportData(reportData) {
+namespace MicroOcpp {
+namespace Ocpp201 {
+namespace NotifyReportUtils {
+
+#define VALUE_BUFSIZE 30 // for primitives (int)
+
+const Variable::AttributeType enumerateAttributeTypes [] = {
+    Variable::AttributeType::Actual,
+    Variable::AttributeType::Target,
+    Variable::AttributeType::MinSet,
+    Variable::AttributeType::MaxSet
+};
+
+size_t getReportDataCapacity(Variable& variable) {
+    size_t capacity = 0;
+    capacity += JSON_OBJECT_SIZE(4); //total of 4 fields
+    capacity += 2 * JSON_OBJECT_SIZE(3); //component composite
+    capacity += JSON_OBJECT_SIZE(2); //variable composite
+
+    //names are stored in copy-mode
+    capacity += strlen(variable.getComponentId().name) + 1;
+    if (variable.getComponentId().instance) {
+        capacity += strlen(variable.getComponentId().instance) + 1;
+    }
+    capacity += strlen(variable.getName()) + 1;
+    if (variable.getInstance()) {
+        capacity += strlen(variable.getInstance()) + 1;
+    }
 
-}
+    size_t nAttributes = 0;
+    size_t valueCapacity = 0;
+    for (auto attributeType : enumerateAttributeTypes) {
+        if (!variable.hasAttribute(attributeType)) {
+            continue;
+        }
+        nAttributes++;
+        switch (variable.getInternalDataType()) {
+            case Variable::InternalDataType::Int: {
+                // measure int size by printing to a dummy buf
+                char valbuf [VALUE_BUFSIZE];
+                auto ret = snprintf(valbuf, VALUE_BUFSIZE, "%i", variable.getInt());
+                if (ret < 0 || ret >= VALUE_BUFSIZE) {
+                    continue;
+                }
+                valueCapacity += (size_t) ret + 1;
+                break;
+            }
+            case Variable::InternalDataType::Bool:
+                // bool will be stored in zero-copy mode (string literal "true" or "false")
+                break;
+            case Variable::InternalDataType::String:
+                valueCapacity += strlen(variable.getString()) + 1; // TODO limit by ReportingValueSize
+                break;
+            default:
+                MO_DBG_ERR("internal error");
+                break;
+        }
+    }
 
-const char* NotifyReport::getOperationType() {
-    return "NotifyReport";
+    capacity += JSON_ARRAY_SIZE(nAttributes) + nAttributes * JSON_OBJECT_SIZE(5); //variableAttribute composite
+    capacity += valueCapacity; //variableAttribute value total size
+
+    capacity += JSON_OBJECT_SIZE(2); //variableCharacteristics composite: only send two data fields
+    return capacity;
 }
 
-std::unique_ptr<DynamicJsonDocument> NotifyReport::createReq() {
+void writeReportData(Variable& variable, JsonObject reportData) {
+    reportData["component"]["name"] = (char*) variable.getComponentId().name; // force copy-mode
+    if(variable.getComponentId().instance){
+        reportData["component"]["instance"] = (char*) variable.getComponentId().instance; // force copy-mode
+    }
 
-    #define VALUE_BUFSIZE 30 // for primitives (int)
+    if (variable.getComponentId().evse.id >= 0) {
+        reportData["component"]["evse"]["id"] = variable.getComponentId().evse.id;
+    }
 
-    const Variable::AttributeType enumerateAttributeTypes [] = {
-        Variable::AttributeType::Actual,
-        Variable::AttributeType::Target,
-        Variable::AttributeType::MinSet,
-        Variable::AttributeType::MaxSet
-    };
+    if (variable.getComponentId().evse.connectorId >= 0) {
+        reportData["component"]["evse"]["connectorId"] = variable.getComponentId().evse.connectorId;
+    }
 
-    size_t capacity = 
-            JSON_OBJECT_SIZE(5) + //total of 5 fields
-            JSONDATE_LENGTH + 1; //timestamp string
+    reportData["variable"]["name"] = (char*) variable.getName(); // force copy-mode
+    if(variable.getInstance()){
+        reportData["variable"]["instance"] = (char*) variable.getInstance(); // force copy-mode
+    }
+    JsonArray variableAttribute = reportData.createNestedArray("variableAttribute");
 
-    capacity += JSON_ARRAY_SIZE(reportData.size());
-    for (auto variable : reportData) {
-        capacity += JSON_OBJECT_SIZE(4); //total of 4 fields
-        capacity += 2 * JSON_OBJECT_SIZE(3); //component composite
-        capacity += JSON_OBJECT_SIZE(2); //variable composite
-
-        size_t nAttributes = 0;
-        size_t valueCapacity = 0;
-        for (auto attributeType : enumerateAttributeTypes) {
-            if (!variable->hasAttribute(attributeType)) {
-                continue;
-            }
-            nAttributes++;
-            switch (variable->getInternalDataType()) {
+    for (auto attributeType : enumerateAttributeTypes) {
+        if (!variable.hasAttribute(attributeType)) {
+            continue;
+        }
+
+        JsonObject attribute = variableAttribute.createNestedObject();
+
+        const char *attributeTypeCstr = nullptr;
+        switch (attributeType) {
+            case Variable::AttributeType::Actual:
+                // leave blank when Actual
+                break;
+            case Variable::AttributeType::Target:
+                attributeTypeCstr = "Target";
+                break;
+            case Variable::AttributeType::MinSet:
+                attributeTypeCstr = "MinSet";
+                break;
+            case Variable::AttributeType::MaxSet:
+                attributeTypeCstr = "MaxSet";
+                break;
+            default:
+                MO_DBG_ERR("internal error");
+                break;
+        }
+        if (attributeTypeCstr) {
+            attribute["type"] = attributeTypeCstr;
+        }
+
+        if (variable.getMutability() != Variable::Mutability::WriteOnly) {
+            switch (variable.getInternalDataType()) {
                 case Variable::InternalDataType::Int: {
-                    // measure int size by printing to a dummy buf
                     char valbuf [VALUE_BUFSIZE];
-                    auto ret = snprintf(valbuf, VALUE_BUFSIZE, "%i", variable->getInt());
+                    auto ret = snprintf(valbuf, VALUE_BUFSIZE, "%i", variable.getInt());
                     if (ret < 0 || ret >= VALUE_BUFSIZE) {
-                        continue;
+                        break;
                     }
-                    valueCapacity = (size_t) ret + 1;
+                    attribute["value"] = valbuf;
                     break;
                 }
                 case Variable::InternalDataType::Bool:
-                    // bool will be stored in zero-copy mode (string literal "true" or "false")
-                    valueCapacity = 0;
+                    attribute["value"] = variable.getBool() ? "true" : "false";
                     break;
                 case Variable::InternalDataType::String:
-                    valueCapacity = strlen(variable->getString()); // TODO limit by ReportingValueSize
+                    attribute["value"] = (char*) variable.getString(); // force zero-copy mode
                     break;
                 default:
                     MO_DBG_ERR("internal error");
@@ -75,172 +152,145 @@ std::unique_ptr<DynamicJsonDocument> NotifyReport::createReq() {
             }
         }
 
-        capacity += nAttributes * JSON_OBJECT_SIZE(5); //variableAttribute composite
-        capacity += valueCapacity; //variableAttribute value total size
+        const char *mutabilityCstr = nullptr;
+        switch (variable.getMutability()) {
+            case Variable::Mutability::ReadOnly:
+                mutabilityCstr = "ReadOnly";
+                break;
+            case Variable::Mutability::WriteOnly:
+                mutabilityCstr = "WriteOnly";
+                break;
+            case Variable::Mutability::ReadWrite:
+                // leave blank when ReadWrite
+                break;
+            default:
+                MO_DBG_ERR("internal error");
+                break;
+        }
+        if (mutabilityCstr) {
+            attribute["mutability"] = mutabilityCstr;
+        }
 
-        capacity += JSON_OBJECT_SIZE(2); //variableCharacteristics composite: only send two data fields
+        if (variable.isPersistent()) {
+            attribute["persistent"] = true;
+        }
+
+        if (variable.isConstant()) {
+            attribute["constant"] = true;
+        }
     }
 
-    if (capacity > MO_MAX_JSON_CAPACITY)
-    {
-        MO_DBG_ERR("report JSON exceeds maximum capacity (%zu entries,%u bytes).", reportData.size(), capacity);
-        capacity = MO_MAX_JSON_CAPACITY;
+    JsonObject variableCharacteristics = reportData.createNestedObject("variableCharacteristics");
+
+    const char *dataTypeCstr = "";
+    switch (variable.getVariableDataType()) {
+        case VariableCharacteristics::DataType::string:
+            dataTypeCstr = "string";
+            break;
+        case VariableCharacteristics::DataType::decimal:
+            dataTypeCstr = "decimal";
+            break;
+        case VariableCharacteristics::DataType::integer:
+            dataTypeCstr = "integer";
+            break;
+        case VariableCharacteristics::DataType::dateTime:
+            dataTypeCstr = "dateTime";
+            break;
+        case VariableCharacteristics::DataType::boolean:
+            dataTypeCstr = "boolean";
+            break;
+        case VariableCharacteristics::DataType::OptionList:
+            dataTypeCstr = "OptionList";
+            break;
+        case VariableCharacteristics::DataType::SequenceList:
+            dataTypeCstr = "SequenceList";
+            break;
+        case VariableCharacteristics::DataType::MemberList:
+            dataTypeCstr = "MemberList";
+            break;
+        default:
+            MO_DBG_ERR("internal error");
+            break; 
     }
-    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(capacity));
+    variableCharacteristics["dataType"] = dataTypeCstr;
 
-    JsonObject payload = doc->to<JsonObject>();
-    payload["requestId"] = requestId;
+    variableCharacteristics["supportsMonitoring"] = variable.getSupportsMonitoring();
+}
 
-    char generatedAtCstr [JSONDATE_LENGTH + 1];
-    generatedAt.toJsonString(generatedAtCstr, sizeof(generatedAtCstr));
-    payload["generatedAt"] = generatedAtCstr;
+} //end namespace NotifyReportUtils
+} //end namespace Ocpp201
+} //end namespace MicroOcpp
 
-    if (tbc) {
-        payload["tbc"] = true;
-    }
+using namespace MicroOcpp::Ocpp201::NotifyReportUtils;
 
-    payload["seqNo"] = seqNo;
+NotifyReport::NotifyReport(Model& model, VariableService& variableService, int requestId, const Timestamp& generatedAt, int seqNo, const VariableCursor& begin)
+        : model(model), variableService(variableService), requestId(requestId), generatedAt(generatedAt), seqNo(seqNo), begin(begin), end(begin) {
 
-    JsonArray reportDataJsonArray = payload.createNestedArray("reportData");
+}
 
-    for (auto variable : reportData) {
-        JsonObject reportDataJson = reportDataJsonArray.createNestedObject();
+const char* NotifyReport::getOperationType() {
+    return "NotifyReport";
+}
 
-        reportDataJson["component"]["name"] = (char*) variable->getComponentId().name; // force copy-mode
-        if(variable->getComponentId().instance){
-            reportDataJson["component"]["instance"] = (char*) variable->getComponentId().instance; // force copy-mode
-        }
+std::unique_ptr<DynamicJsonDocument> NotifyReport::createReq() {
 
-        if (variable->getComponentId().evse.id >= 0) {
-            reportDataJson["component"]["evse"]["id"] = variable->getComponentId().evse.id;
+    //serialize each reportData entry once and take as many entries as fit into the page. The serialized page is
+    //embedded into the payload as raw JSON, so the entries aren't serialized again when the request is sent
+    reportDataJson.clear();
+    reportDataJson += '[';
+    size_t nItems = 0;
+    end = begin;
+    tbc = false;
+
+    std::string itemJson;
+
+    VariableCursor cursor = begin;
+    while (auto variable = variableService.nextReportVariable(cursor)) {
+        DynamicJsonDocument item (getReportDataCapacity(*variable));
+        writeReportData(*variable, item.to<JsonObject>());
+        if (item.overflowed()) {
+            MO_DBG_ERR("reportData exceeds capacity");
         }
 
-        if (variable->getComponentId().evse.connectorId >= 0) {
-            reportDataJson["component"]["evse"]["connectorId"] = variable->getComponentId().evse.connectorId;
-        }
+        itemJson.clear();
+        serializeJson(item, itemJson);
 
-        reportDataJson["variable"]["name"] = (char*) variable->getName(); // force copy-mode
-        if(variable->getInstance()){
-            reportDataJson["variable"]["instance"] = (char*) variable->getInstance(); // force copy-mode
+        if (nItems > 0 && reportDataJson.size() + itemJson.size() + 1 > MO_REPORT_PAGE_SIZE) { //plus separator
+            //continue on next page
+            tbc = true;
+            break;
         }
-        JsonArray variableAttribute = reportDataJson.createNestedArray("variableAttribute");
 
-        for (auto attributeType : enumerateAttributeTypes) {
-            if (!variable->hasAttribute(attributeType)) {
-                continue;
-            }
+        if (nItems > 0) {
+            reportDataJson += ',';
+        }
+        reportDataJson += itemJson;
+        nItems++;
+        end = cursor;
+    }
 
-            JsonObject attribute = variableAttribute.createNestedObject();
+    reportDataJson += ']';
 
-            const char *attributeTypeCstr = nullptr;
-            switch (attributeType) {
-                case Variable::AttributeType::Actual:
-                    // leave blank when Actual
-                    break;
-                case Variable::AttributeType::Target:
-                    attributeTypeCstr = "Target";
-                    break;
-                case Variable::AttributeType::MinSet:
-                    attributeTypeCstr = "MinSet";
-                    break;
-                case Variable::AttributeType::MaxSet:
-                    attributeTypeCstr = "MaxSet";
-                    break;
-                default:
-                    MO_DBG_ERR("internal error");
-                    break;
-            }
-            if (attributeTypeCstr) {
-                attribute["type"] = attributeTypeCstr;
-            }
-
-            if (variable->getMutability() != Variable::Mutability::WriteOnly) {
-                switch (variable->getInternalDataType()) {
-                    case Variable::InternalDataType::Int: {
-                        char valbuf [VALUE_BUFSIZE];
-                        auto ret = snprintf(valbuf, VALUE_BUFSIZE, "%i", variable->getInt());
-                        if (ret < 0 || ret >= VALUE_BUFSIZE) {
-                            break;
-                        }
-                        attribute["value"] = valbuf;
-                        break;
-                    }
-                    case Variable::InternalDataType::Bool:
-                        attribute["value"] = variable->getBool() ? "true" : "false";
-                        break;
-                    case Variable::InternalDataType::String:
-                        attribute["value"] = (char*) variable->getString(); // force zero-copy mode
-                        break;
-                    default:
-                        MO_DBG_ERR("internal error");
-                        break;
-                }
-            }
+    size_t capacity =
+            JSON_OBJECT_SIZE(5) + //total of 5 fields
+            JSONDATE_LENGTH + 1; //timestamp string
 
-            const char *mutabilityCstr = nullptr;
-            switch (variable->getMutability()) {
-                case Variable::Mutability::ReadOnly:
-                    mutabilityCstr = "ReadOnly";
-                    break;
-                case Variable::Mutability::WriteOnly:
-                    mutabilityCstr = "WriteOnly";
-                    break;
-                case Variable::Mutability::ReadWrite:
-                    // leave blank when ReadWrite
-                    break;
-                default:
-                    MO_DBG_ERR("internal error");
-                    break;
-            }
-            if (mutabilityCstr) {
-                attribute["mutability"] = mutabilityCstr;
-            }
+    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(capacity));
 
-            if (variable->isPersistent()) {
-                attribute["persistent"] = true;
-            }
+    JsonObject payload = doc->to<JsonObject>();
+    payload["requestId"] = requestId;
 
-            if (variable->isConstant()) {
-                attribute["constant"] = true;
-            }
-        }
+    char generatedAtCstr [JSONDATE_LENGTH + 1];
+    generatedAt.toJsonString(generatedAtCstr, sizeof(generatedAtCstr));
+    payload["generatedAt"] = generatedAtCstr;
 
-        JsonObject variableCharacteristics = reportDataJson.createNestedObject("variableCharacteristics");
+    if (tbc) {
+        payload["tbc"] = true;
+    }
 
-        const char *dataTypeCstr = "";
-        switch (variable->getVariableDataType()) {
-            case VariableCharacteristics::DataType::string:
-                dataTypeCstr = "string";
-                break;
-            case VariableCharacteristics::DataType::decimal:
-                dataTypeCstr = "decimal";
-                break;
-            case VariableCharacteristics::DataType::integer:
-                dataTypeCstr = "integer";
-                break;
-            case VariableCharacteristics::DataType::dateTime:
-                dataTypeCstr = "dateTime";
-                break;
-            case VariableCharacteristics::DataType::boolean:
-                dataTypeCstr = "boolean";
-                break;
-            case VariableCharacteristics::DataType::OptionList:
-                dataTypeCstr = "OptionList";
-                break;
-            case VariableCharacteristics::DataType::SequenceList:
-                dataTypeCstr = "SequenceList";
-                break;
-            case VariableCharacteristics::DataType::MemberList:
-                dataTypeCstr = "MemberList";
-                break;
-            default:
-                MO_DBG_ERR("internal error");
-                break; 
-        }
-        variableCharacteristics["dataType"] = dataTypeCstr;
+    payload["seqNo"] = seqNo;
 
-        variableCharacteristics["supportsMonitoring"] = variable->getSupportsMonitoring();
-    }
+    payload["reportData"] = serialized(reportDataJson.c_str(), reportDataJson.size()); //zero-copy, reportDataJson outlives the request payload
 
     return doc;
 }
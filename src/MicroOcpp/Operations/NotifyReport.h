@@ -2,8 +2,8 @@
 // Copyright Matthias Akstaller 2019 - 2024
 // MIT License
 
-#ifndef MO_TRANSACTIONEVENT_H
-#define MO_TRANSACTIONEVENT_H
+#ifndef MO_NOTIFYREPORT_H
+#define MO_NOTIFYREPORT_H
 
 #include <MicroOcpp/Version.h>
 
@@ -11,34 +11,44 @@
 
 #include <MicroOcpp/Core/Operation.h>
 #include <MicroOcpp/Core/Time.h>
+#include <MicroOcpp/Model/Variables/VariableService.h>
 
-#include <vector>
+#include <string>
 
 namespace MicroOcpp {
 
 class Model;
-class Variable;
 
 namespace Ocpp201 {
 
+/*
+ * One page of a base report. The page begins at the cursor position and takes as many variables as fit into
+ * MO_REPORT_PAGE_SIZE bytes of serialized reportData
+ */
 class NotifyReport : public Operation {
 private:
     Model& model;
+    VariableService& variableService;
 
     int requestId;
     Timestamp generatedAt;
-    bool tbc;
     int seqNo;
-    std::vector<Variable*> reportData;
+    VariableCursor begin;
+    VariableCursor end;
+    bool tbc = false;
+    std::string reportDataJson; //serialized reportData of this page, embedded into the payload of createReq()
 public:
 
-    NotifyReport(Model& model, int requestId, const Timestamp& generatedAt, bool tbc, int seqNo, const std::vector<Variable*>& reportData);
+    NotifyReport(Model& model, VariableService& variableService, int requestId, const Timestamp& generatedAt, int seqNo, const VariableCursor& begin);
 
     const char* getOperationType() override;
 
     std::unique_ptr<DynamicJsonDocument> createReq() override;
 
     void processConf(JsonObject payload) override;
+
+    const VariableCursor& getEnd() {return end;} //begin of the next page. Valid after createReq()
+    bool isTbc() {return tbc;} //if further pages follow. Valid after createReq()
 };
 
 } //end namespace Ocpp201
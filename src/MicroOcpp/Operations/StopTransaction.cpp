@@ -67,20 +67,9 @@ std::unique_ptr<DynamicJsonDocument> StopTransaction::createReq() {
         }
     }
 
-    std::vector<std::unique_ptr<DynamicJsonDocument>> txDataJson;
-    size_t txDataJson_size = 0;
+    size_t txDataCapacity = JSON_ARRAY_SIZE(transactionData.size());
     for (auto mv = transactionData.begin(); mv != transactionData.end(); mv++) {
-        auto mvJson = (*mv)->toJson();
-        if (!mvJson) {
-            return nullptr;
-        }
-        txDataJson_size += mvJson->capacity();
-        txDataJson.emplace_back(std::move(mvJson));
-    }
-
-    DynamicJsonDocument txDataDoc = DynamicJsonDocument(JSON_ARRAY_SIZE(txDataJson.size()) + txDataJson_size);
-    for (auto mvJson = txDataJson.begin(); mvJson != txDataJson.end(); mvJson++) {
-        txDataDoc.add(**mvJson);
+        txDataCapacity += (*mv)->getJsonCapacity();
     }
 
     auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(
@@ -88,7 +77,7 @@ std::unique_ptr<DynamicJsonDocument> StopTransaction::createReq() {
                 (IDTAG_LEN_MAX + 1) + //stop idTag
                 (JSONDATE_LENGTH + 1) + //timestamp string
                 (REASON_LEN_MAX + 1) + //reason string
-                txDataDoc.capacity()));
+                txDataCapacity));
     JsonObject payload = doc->to<JsonObject>();
 
     if (transaction->getStopIdTag() && *transaction->getStopIdTag()) {
@@ -108,7 +97,12 @@ std::unique_ptr<DynamicJsonDocument> StopTransaction::createReq() {
     }
 
     if (!transactionData.empty()) {
-        payload["transactionData"] = txDataDoc;
+        auto txDataJson = payload.createNestedArray("transactionData");
+        for (auto mv = transactionData.begin(); mv != transactionData.end(); mv++) {
+            if (!(*mv)->toJson(txDataJson.createNestedObject())) {
+                return nullptr;
+            }
+        }
     }
 
     return doc;
@@ -13,10 +13,12 @@
 #include <MicroOcpp/Debug.h>
 #include <MicroOcpp/Model/Authorization/AuthorizationService.h>
 #include <MicroOcpp/Model/Metering/MeteringService.h>
+#include <MicroOcpp/Model/Metering/MeterValue.h>
 #include <MicroOcpp/Model/Transactions/TransactionStore.h>
 
 using MicroOcpp::Ocpp201::TransactionEvent;
 using namespace MicroOcpp::Ocpp201;
+using MicroOcpp::MeterValue;
 
 TransactionEvent::TransactionEvent(Model& model, std::shared_ptr<TransactionEventData> txEvent)
         : model(model), txEvent(txEvent) {
@@ -44,7 +46,11 @@ TransactionEvent::TransactionEvent(Model& model, std::shared_ptr<Transaction> tr
                     txEvent->meterValue.push_back(std::move(meterValue[0]));
                 }
             }else{
-                txEvent->meterValue = std::move(meterValue);
+                auto chunks = splitMeterValue(std::move(meterValue));
+                if (!chunks.empty()) {
+                    //the leading chunks have been sent in Updated events when the tx ended
+                    txEvent->meterValue = std::move(chunks.back());
+                }
             }
         }
     }
@@ -58,13 +64,23 @@ const char* TransactionEvent::getOperationType() {
 }
 
 std::unique_ptr<DynamicJsonDocument> TransactionEvent::createReq() {
+    size_t meterValueCapacity = 0;
+    if (!txEvent->meterValue.empty()) {
+        meterValueCapacity += JSON_ARRAY_SIZE(txEvent->meterValue.size());
+        for (auto mv = txEvent->meterValue.begin(); mv != txEvent->meterValue.end(); mv++) {
+            meterValueCapacity += (*mv)->getJsonCapacity(VER_2_0_1);
+        }
+    }
+
     auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(
                 JSON_OBJECT_SIZE(12) + //total of 12 fields
                 JSONDATE_LENGTH + 1 + //timestamp string
-                JSON_OBJECT_SIZE(5) + //transactionInfo
+                JSON_OBJECT_SIZE(4) + //transactionInfo
                     MO_TXID_LEN_MAX + 1 + //transactionId
-                MO_IDTOKEN_LEN_MAX + 1 //idToken
-                + 512));//meterValue // todo
+                JSON_OBJECT_SIZE(2) + //idToken
+                    MO_IDTOKEN_LEN_MAX + 1 + //idToken string
+                JSON_OBJECT_SIZE(2) + //evse
+                meterValueCapacity));
     JsonObject payload = doc->to<JsonObject>();
 
     const char *eventType = "";
@@ -335,19 +351,13 @@ std::unique_ptr<DynamicJsonDocument> TransactionEvent::createReq() {
         }
     }
     if(txEvent->meterValue.size()){
-        std::vector<std::unique_ptr<DynamicJsonDocument>> entries;
+        auto meterValueJson = payload.createNestedArray("meterValue");
         for (auto value = txEvent->meterValue.begin(); value != txEvent->meterValue.end(); value++) {
-            auto entry = (*value)->toJson(VER_2_0_1);
-            if (entry) {
-                entries.push_back(std::move(entry));
-            } else {
+            if (!(*value)->toJson(meterValueJson.createNestedObject(), VER_2_0_1)) {
                 MO_DBG_ERR("Energy meter reading not convertible to JSON");
+                meterValueJson.remove(meterValueJson.size() - 1);
             }
         }
-        auto meterValueJson = payload.createNestedArray("meterValue");
-        for (auto entry = entries.begin(); entry != entries.end(); entry++) {
-            meterValueJson.add(**entry);
-        }
     }
 
     return doc;
@@ -402,4 +412,42 @@ std::unique_ptr<DynamicJsonDocument> TransactionEvent::createConf() {
     return createEmptyDocument();
 }
 
+std::vector<std::vector<std::unique_ptr<MeterValue>>> TransactionEvent::splitMeterValue(std::vector<std::unique_ptr<MeterValue>>&& meterValue, size_t maxSize) {
+    std::vector<std::vector<std::unique_ptr<MeterValue>>> chunks;
+    std::vector<std::unique_ptr<MeterValue>> chunk;
+    size_t chunkSize = 2; //brackets of the meterValue array
+
+    for (auto& mv : meterValue) {
+        while (mv) {
+            size_t mvSize = mv->getJsonSize(VER_2_0_1) + 1; //plus separator
+            if (!chunk.empty() && chunkSize + mvSize > maxSize) {
+                chunks.push_back(std::move(chunk));
+                chunk.clear();
+                chunkSize = 2;
+            }
+
+            if (chunkSize + mvSize > maxSize && mv->getSampledValueCount() > 1) {
+                //MeterValue exceeds maxSize alone. Send its leading sampledValues in a chunk of their own
+                chunk.push_back(mv->splitFront(maxSize - chunkSize - 1, VER_2_0_1));
+                chunks.push_back(std::move(chunk));
+                chunk.clear();
+                chunkSize = 2;
+                if (mv->getSampledValueCount() == 0) {
+                    mv.reset();
+                }
+                continue;
+            }
+
+            chunkSize += mvSize;
+            chunk.push_back(std::move(mv));
+        }
+    }
+
+    if (!chunk.empty()) {
+        chunks.push_back(std::move(chunk));
+    }
+
+    return chunks;
+}
+
 #endif // MO_ENABLE_V201
@@ -10,10 +10,23 @@
 #if MO_ENABLE_V201
 
 #include <MicroOcpp/Core/Operation.h>
+#include <MicroOcpp/Platform.h>
+
+#include <memory>
+#include <vector>
+
+#ifndef MO_TXEVENT_METERVALUE_SIZE
+#if MO_PLATFORM == MO_PLATFORM_UNIX
+#define MO_TXEVENT_METERVALUE_SIZE 8192 //max serialized size of the meterValue array of one TransactionEvent
+#else
+#define MO_TXEVENT_METERVALUE_SIZE 2048
+#endif
+#endif
 
 namespace MicroOcpp {
 
 class Model;
+class MeterValue;
 
 namespace Ocpp201 {
 
@@ -44,6 +57,13 @@ public:
     void processReq(JsonObject payload) override;
 
     std::unique_ptr<DynamicJsonDocument> createConf() override;
+
+    /*
+     * Splits meterValue into chunks of at most maxSize serialized bytes, keeping the order. A MeterValue which exceeds
+     * maxSize alone is split into several MeterValues with the same timestamp. The split is deterministic, so an Ended
+     * event which is restored after a reboot can pick the same last chunk
+     */
+    static std::vector<std::vector<std::unique_ptr<MeterValue>>> splitMeterValue(std::vector<std::unique_ptr<MeterValue>>&& meterValue, size_t maxSize = MO_TXEVENT_METERVALUE_SIZE);
 };
 
 } //end namespace Ocpp201
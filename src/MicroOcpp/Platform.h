@@ -95,6 +95,14 @@ extern "C" unsigned long mocpp_tick_ms_unix();
 #endif
 #endif
 
+/*
+ * Upper limit for the time which mocpp_next_wakeup_ms() reports. The host may sleep at most this
+ * long even if MicroOcpp has no pending deadline
+ */
+#ifndef MO_WAKEUP_MAX_MS
+#define MO_WAKEUP_MAX_MS 60000UL
+#endif
+
 #ifndef MO_MAX_JSON_CAPACITY
 #if MO_PLATFORM == MO_PLATFORM_UNIX
 #define MO_MAX_JSON_CAPACITY 16384
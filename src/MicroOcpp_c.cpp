@@ -40,6 +40,16 @@ void ocpp_loop()
     mocpp_loop();
 }
 
+unsigned long ocpp_next_wakeup_ms()
+{
+    return mocpp_next_wakeup_ms();
+}
+
+unsigned long ocpp_next_deadline_ms()
+{
+    return mocpp_next_deadline_ms();
+}
+
 /*
  * Helper functions for transforming callback functions from C-style to C++style
  */
@@ -415,6 +425,14 @@ bool ocpp_isOperative_m(unsigned int connectorId)
 {
     return isOperative(connectorId);
 }
+ConnectivityState ocpp_getConnectivityState()
+{
+    return getConnectivityState();
+}
+bool ocpp_setDrainRateLimit(const char *operationTypes, unsigned int burst, unsigned long refillIntervalMs)
+{
+    return setDrainRateLimit(operationTypes, burst, refillIntervalMs);
+}
 void ocpp_setOnResetNotify(bool (*onResetNotify)(bool))
 {
     setOnResetNotify([onResetNotify](bool isHard)
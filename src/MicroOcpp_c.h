@@ -8,6 +8,7 @@
 #include <stddef.h>
 
 #include <MicroOcpp/Core/ConfigurationOptions.h>
+#include <MicroOcpp/Core/ConnectivityState.h>
 #include <MicroOcpp/Model/ConnectorBase/ChargePointStatus.h>
 #include <MicroOcpp/Model/ConnectorBase/Notification.h>
 #include <MicroOcpp/Model/ConnectorBase/UnlockConnectorResult.h>
@@ -91,6 +92,9 @@ void ocpp_deinitialize();
 
 void ocpp_loop();
 
+unsigned long ocpp_next_wakeup_ms(); //see mocpp_next_wakeup_ms() in MicroOcpp.h
+unsigned long ocpp_next_deadline_ms(); //see mocpp_next_deadline_ms() in MicroOcpp.h
+
 /*
  * Charging session management
  */
@@ -188,6 +192,10 @@ void ocpp_setOnUnlockConnectorInOut_m(unsigned int connectorId, PollUnlockResult
 bool ocpp_isOperative();
 bool ocpp_isOperative_m(unsigned int connectorId);
 
+ConnectivityState ocpp_getConnectivityState();
+
+bool ocpp_setDrainRateLimit(const char *operationTypes, unsigned int burst, unsigned long refillIntervalMs);
+
 void ocpp_setOnResetNotify(bool (*onResetNotify)(bool));
 
 void ocpp_setOnResetExecute(void (*onResetExecute)(bool));
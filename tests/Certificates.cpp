@@ -160,6 +160,73 @@ TEST_CASE( "M - Certificates" ) {
         REQUIRE(filesystem->stat(fn, &msize) != 0);
     }
 
+    SECTION("Cert hash index") {
+        auto ret1 = certs->installCertificate(InstallCertificateType_CSMSRootCertificate, root_cert);
+        REQUIRE(ret1 == InstallCertificateStatus_Accepted);
+
+        char fn [MO_MAX_PATH_SIZE];
+        snprintf(fn, sizeof(fn), MO_FILENAME_PREFIX MO_CERT_FN_PREFIX "index.jsn");
+
+        //tamper with the index. The CRC check on load must detect the stale entry and rebuild it
+        auto index = FilesystemUtils::loadJson(filesystem, fn);
+        REQUIRE(index);
+        JsonObject entry = (*index)["certs"][0];
+        REQUIRE(entry["crc"].as<uint32_t>() != 0);
+        entry["crc"] = 0;
+        entry["hashes"][0]["name"] = "0000000000000000000000000000000000000000000000000000000000000000";
+        REQUIRE(FilesystemUtils::storeJson(filesystem, fn, *index));
+
+        for (int i = 0; i < 2; i++) {
+            //first iteration rebuilds the index, the second one only loads it
+            auto reloaded = makeCertificateStoreMbedTLS(filesystem);
+            REQUIRE(reloaded);
+
+            std::vector<CertificateChainHash> chain;
+            auto ret2 = reloaded->getCertificateIds({GetCertificateIdType_CSMSRootCertificate}, chain);
+            REQUIRE(ret2 == GetInstalledCertificateStatus_Accepted);
+            REQUIRE(chain.size() == 1);
+
+            char buf [MO_CERT_HASH_ISSUER_NAME_KEY_SIZE];
+            ocpp_cert_print_issuerNameHash(&chain.front().certificateHashData, buf, sizeof(buf));
+            REQUIRE(!strcmp(buf, root_cert_hash_issuer_name));
+
+            ocpp_cert_print_serialNumber(&chain.front().certificateHashData, buf, sizeof(buf));
+            REQUIRE(!strcmp(buf, root_cert_hash_serial_number));
+        }
+
+        //duplicate installs are detected from the index
+        auto ret3 = certs->installCertificate(InstallCertificateType_CSMSRootCertificate, root_cert);
+        REQUIRE(ret3 == InstallCertificateStatus_Accepted);
+
+        std::vector<CertificateChainHash> chain;
+        certs->getCertificateIds({GetCertificateIdType_CSMSRootCertificate}, chain);
+        REQUIRE(chain.size() == 1);
+    }
+
+    SECTION("Unparseable cert file") {
+        char fn [MO_MAX_PATH_SIZE];
+        printCertFn(MO_CERT_FN_CSMS_ROOT, 0, fn, MO_MAX_PATH_SIZE);
+        auto file = filesystem->open(fn, "w");
+        REQUIRE(file);
+        const char *garbage = "-----BEGIN CERTIFICATE-----\ngarbage\n-----END CERTIFICATE-----\n";
+        REQUIRE(file->write(garbage, strlen(garbage)) == strlen(garbage));
+        file.reset();
+
+        //the occupied slot is skipped
+        auto ret1 = certs->installCertificate(InstallCertificateType_CSMSRootCertificate, root_cert);
+        REQUIRE(ret1 == InstallCertificateStatus_Accepted);
+
+        std::vector<CertificateChainHash> chain;
+        auto ret2 = certs->getCertificateIds({GetCertificateIdType_CSMSRootCertificate}, chain);
+        REQUIRE(ret2 == GetInstalledCertificateStatus_Accepted);
+        REQUIRE(chain.size() == 1);
+
+        size_t msize;
+        REQUIRE(filesystem->stat(fn, &msize) == 0);
+        printCertFn(MO_CERT_FN_CSMS_ROOT, 1, fn, MO_MAX_PATH_SIZE);
+        REQUIRE(filesystem->stat(fn, &msize) == 0);
+    }
+
     SECTION("M05 InstallCertificate operation") {
 
         bool checkProcessed = false;
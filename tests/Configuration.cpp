@@ -21,6 +21,10 @@
 #include <MicroOcpp/Core/Request.h>
 #include <MicroOcpp/Debug.h>
 
+#include <chrono>
+#include <string>
+#include <vector>
+
 using namespace MicroOcpp;
 
 #define GET_CONFIG_ALL "[2,\"test-msg\",\"GetConfiguration\",{}]"
@@ -222,6 +226,57 @@ TEST_CASE( "Configuration" ) {
         configuration_deinit();
     }
 
+    SECTION("Key index") {
+
+        class NonIndexableContainer : public ConfigurationContainerVolatile {
+        public:
+            NonIndexableContainer(const char *filename) : ConfigurationContainerVolatile(filename, true) { }
+            bool isIndexable() override {return false;}
+        };
+
+        REQUIRE( configuration_init(filesystem) );
+
+        std::shared_ptr<ConfigurationContainerVolatile> container = makeConfigurationContainerVolatile(CONFIGURATION_VOLATILE "/index1", true);
+        auto nonIndexable = std::make_shared<NonIndexableContainer>(CONFIGURATION_VOLATILE "/index2");
+        std::shared_ptr<ConfigurationContainerVolatile> container2 = makeConfigurationContainerVolatile(CONFIGURATION_VOLATILE "/index3", true);
+        addConfigurationContainer(container);
+        addConfigurationContainer(nonIndexable);
+        addConfigurationContainer(container2);
+
+        //remove followed by add keeps the number of configs, but invalidates the index
+        auto cA = container->createConfiguration(TConfig::Int, "cIndexA");
+        REQUIRE( getConfigurationPublic("cIndexA") == cA.get() );
+
+        container->remove(cA.get());
+        std::shared_ptr<Configuration> cB = makeConfiguration(TConfig::Int, "cIndexB");
+        container->add(cB);
+        REQUIRE( getConfigurationPublic("cIndexA") == nullptr );
+        REQUIRE( getConfigurationPublic("cIndexB") == cB.get() );
+
+        //the first container in the order of registration wins, regardless of whether it is indexable
+        auto cShared1 = nonIndexable->createConfiguration(TConfig::Int, "cShared1");
+        auto cShared1b = container2->createConfiguration(TConfig::Int, "cShared1");
+        REQUIRE( getConfigurationPublic("cShared1") == cShared1.get() );
+
+        auto cShared2 = container->createConfiguration(TConfig::Int, "cShared2");
+        auto cShared2b = nonIndexable->createConfiguration(TConfig::Int, "cShared2");
+        REQUIRE( getConfigurationPublic("cShared2") == cShared2.get() );
+
+        //declared config after index update
+        auto cDeclared = declareConfiguration<int>("cDeclared", 42, CONFIGURATION_VOLATILE "/index3");
+        REQUIRE( getConfigurationPublic("cDeclared") == cDeclared.get() );
+
+        //validators apply to configs which have been loaded without being declared
+        registerConfigurationValidator("cLoaded", [] (const char*) {return false;});
+        container2->createConfiguration(TConfig::Int, "cLoaded");
+        REQUIRE( getConfigurationPublic("cLoaded") != nullptr );
+        auto validator = getConfigurationValidator("cLoaded");
+        REQUIRE( validator != nullptr );
+        REQUIRE( !(*validator)("1") );
+
+        configuration_deinit();
+    }
+
     SECTION("ContainerFlash memory optimization") {
 
         //key storage optimization: the static key provided by declareConfiguration is preferred. If
@@ -364,6 +419,50 @@ TEST_CASE( "Configuration" ) {
         REQUIRE(checkProcessed);
 
         mocpp_deinitialize();
+
+        //many keys: the response is streamed entry by entry into the outgoing message. The incoming message buffer of
+        //MO is capped at MO_MAX_JSON_CAPACITY, so the response is taken from the connection and parsed here
+        class RecordingConnection : public LoopbackConnection {
+        public:
+            std::string lastSent;
+            bool sendTXT(const char *msg, size_t length) override {
+                lastSent.assign(msg, length);
+                return LoopbackConnection::sendTXT(msg, length);
+            }
+        };
+        RecordingConnection recording;
+
+        mocpp_initialize(recording, ChargerCredentials("test-runner1234"));
+        loop();
+
+        //more keys than a JSON document of MO_MAX_JSON_CAPACITY could hold
+        const size_t NUM_KEYS = MO_MAX_JSON_CAPACITY / (JSON_ARRAY_SIZE(1) + JSON_OBJECT_SIZE(3)) + 1;
+        std::vector<std::string> keys; //configs don't copy the key
+        for (size_t i = 0; i < NUM_KEYS; i++) {
+            keys.push_back(std::string("StreamedKey") + std::to_string(i));
+        }
+        for (auto& key : keys) {
+            declareConfiguration<const char*>(key.c_str(), "\"quoted\" value", CONFIGURATION_VOLATILE);
+        }
+
+        recording.sendTXT(GET_CONFIG_ALL, strlen(GET_CONFIG_ALL));
+        loop();
+
+        DynamicJsonDocument conf {4 * MO_MAX_JSON_CAPACITY};
+        REQUIRE( !deserializeJson(conf, recording.lastSent) );
+        REQUIRE( (conf[0] | -1) == MESSAGE_TYPE_CALLRESULT );
+        REQUIRE( !strcmp(conf[1] | "_Undefined", "test-msg") );
+
+        size_t nStreamedKeys = 0;
+        for (JsonObject keyvalue : conf[2]["configurationKey"].as<JsonArray>()) {
+            if (!strncmp(keyvalue["key"] | "_Undefined", "StreamedKey", strlen("StreamedKey"))) {
+                REQUIRE( !strcmp(keyvalue["value"] | "_Undefined", "\"quoted\" value") );
+                nStreamedKeys++;
+            }
+        }
+        REQUIRE( nStreamedKeys == NUM_KEYS );
+
+        mocpp_deinitialize();
     }
 
     SECTION("ChangeConfiguration") {
@@ -607,3 +706,59 @@ TEST_CASE( "Configuration" ) {
     }
 
 }
+
+TEST_CASE( "Configuration boot benchmark", "[.][benchmark]" ) {
+    printf("\nRun %s\n",  "Configuration boot benchmark");
+
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    const size_t N_KEYS = 300;
+    const size_t N_FILES = 6; //config files hold up to 50 entries
+
+    //keys and filenames need to outlive the registry
+    std::vector<std::string> keys, filenames;
+    for (size_t i = 0; i < N_KEYS; i++) {
+        keys.push_back(std::string("ConfigurationKey") + std::to_string(i));
+    }
+    for (size_t i = 0; i < N_FILES; i++) {
+        filenames.push_back(std::string(MO_FILENAME_PREFIX "bench-config-") + std::to_string(i) + ".jsn");
+    }
+
+    //first boot: populate the config files
+    configuration_init(filesystem);
+    for (size_t i = 0; i < N_KEYS; i++) {
+        declareConfiguration<int>(keys[i].c_str(), (int) i, filenames[i % N_FILES].c_str());
+    }
+    REQUIRE( configuration_load() );
+    REQUIRE( configuration_save() );
+    configuration_deinit();
+
+    //measured boot: declare all keys, then load the stored values
+    auto t_start = std::chrono::steady_clock::now();
+    configuration_init(filesystem);
+    for (size_t i = 0; i < N_KEYS; i++) {
+        declareConfiguration<int>(keys[i].c_str(), -1, filenames[i % N_FILES].c_str());
+    }
+    auto t_declared = std::chrono::steady_clock::now();
+    REQUIRE( configuration_load() );
+    auto t_loaded = std::chrono::steady_clock::now();
+
+    //GetConfiguration with the full key list
+    for (size_t i = 0; i < N_KEYS; i++) {
+        auto config = getConfigurationPublic(keys[i].c_str());
+        REQUIRE( config != nullptr );
+        REQUIRE( config->getInt() == (int) i );
+    }
+    auto t_end = std::chrono::steady_clock::now();
+
+    printf("[benchmark] boot with %zu config keys: declare %lld us, load %lld us, %zu lookups %lld us\n",
+            N_KEYS,
+            (long long) std::chrono::duration_cast<std::chrono::microseconds>(t_declared - t_start).count(),
+            (long long) std::chrono::duration_cast<std::chrono::microseconds>(t_loaded - t_declared).count(),
+            N_KEYS,
+            (long long) std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_loaded).count());
+
+    configuration_deinit();
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+}
@@ -0,0 +1,172 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp.h>
+#include <MicroOcpp_c.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Operations/CustomOperation.h>
+#include "./catch2/catch.hpp"
+#include "./helpers/testHelper.h"
+
+using namespace MicroOcpp;
+
+TEST_CASE( "Connectivity" ) {
+    printf("\nRun %s\n",  "Connectivity");
+
+    //initialize Context with dummy socket
+    LoopbackConnection loopback;
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"));
+
+    mocpp_set_timer(custom_timer_cb);
+
+    unsigned int nReceived = 0;
+    setRequestHandler("DataTransfer", [&nReceived] (JsonObject) {nReceived++;}, [] () {return createEmptyDocument();});
+
+    unsigned int nTimedOut = 0;
+    auto sendDataTransfer = [&nTimedOut] (unsigned long timeout, bool freezable) {
+        auto request = makeRequest(new Ocpp16::CustomOperation("DataTransfer",
+            [] () {
+                auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(JSON_OBJECT_SIZE(1)));
+                (*doc)["vendorId"] = "mVendorId";
+                return doc;
+            },
+            [] (JsonObject) {}));
+        request->setTimeout(timeout);
+        request->setTimeoutFreezable(freezable);
+        request->setOnTimeoutListener([&nTimedOut] () {nTimedOut++;});
+        getOcppContext()->initiateRequest(std::move(request));
+    };
+
+    loop();
+    REQUIRE( getConnectivityState() == ConnectivityState_Online );
+
+    SECTION("Request timeouts frozen while offline") {
+
+        loopback.setConnected(false);
+        loop();
+        REQUIRE( getConnectivityState() == ConnectivityState_Offline );
+        REQUIRE( ocpp_getConnectivityState() == ConnectivityState_Offline );
+
+        sendDataTransfer(10000, true);
+
+        mtime += 60000;
+        loop();
+        REQUIRE( nTimedOut == 0 );
+        REQUIRE( nReceived == 0 );
+
+        //timeout elapses also offline if the request opts out
+        sendDataTransfer(10000, false);
+
+        mtime += 10000;
+        loop();
+        REQUIRE( nTimedOut == 1 );
+
+        loopback.setConnected(true);
+        mtime += MO_RECONNECT_BACKOFF_BASE_MS;
+        loop();
+        REQUIRE( nReceived == 1 );
+        REQUIRE( nTimedOut == 1 );
+        REQUIRE( getConnectivityState() == ConnectivityState_Online );
+    }
+
+    SECTION("Reconnect backoff") {
+
+        loopback.setConnected(false);
+        loop();
+
+        sendDataTransfer(0, true);
+
+        loopback.setConnected(true);
+        mocpp_loop();
+
+        //first reconnect: backoff window is MO_RECONNECT_BACKOFF_BASE_MS
+        REQUIRE( mocpp_next_wakeup_ms() <= MO_RECONNECT_BACKOFF_BASE_MS );
+        if (getConnectivityState() == ConnectivityState_Backoff) {
+            mocpp_loop();
+            REQUIRE( nReceived == 0 );
+        }
+
+        mtime += MO_RECONNECT_BACKOFF_BASE_MS;
+        mocpp_loop();
+        mocpp_loop();
+        REQUIRE( nReceived == 1 );
+
+        //the connection drops repeatedly. Backoff window grows up to MO_RECONNECT_BACKOFF_MAX_MS
+        for (unsigned int i = 0; i < 10; i++) {
+            loopback.setConnected(false);
+            mocpp_loop();
+            REQUIRE( getConnectivityState() == ConnectivityState_Offline );
+            mtime += 1000;
+            loopback.setConnected(true);
+            mocpp_loop();
+            REQUIRE( mocpp_next_wakeup_ms() <= MO_RECONNECT_BACKOFF_MAX_MS );
+        }
+
+        mtime += MO_RECONNECT_BACKOFF_MAX_MS;
+        loop();
+        REQUIRE( getConnectivityState() == ConnectivityState_Online );
+
+        //stable connection resets the backoff window
+        mtime += MO_RECONNECT_STABLE_MS;
+        loopback.setConnected(false);
+        mocpp_loop();
+        loopback.setConnected(true);
+        mocpp_loop();
+        REQUIRE( mocpp_next_wakeup_ms() <= MO_RECONNECT_BACKOFF_BASE_MS );
+    }
+
+    SECTION("Rate-limited drain") {
+
+        REQUIRE( setDrainRateLimit("Heartbeat,DataTransfer", 2, 1000) );
+
+        loopback.setConnected(false);
+        loop();
+
+        for (unsigned int i = 0; i < 5; i++) {
+            sendDataTransfer(0, true);
+        }
+
+        //requests of the default class are queued behind the DataTransfers
+        unsigned int nStatus = 0;
+        setRequestHandler("FirmwareStatusNotification", [&nStatus] (JsonObject) {nStatus++;}, [] () {return createEmptyDocument();});
+        for (unsigned int i = 0; i < 3; i++) {
+            getOcppContext()->initiateRequest(makeRequest(new Ocpp16::CustomOperation("FirmwareStatusNotification",
+                [] () {
+                    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(JSON_OBJECT_SIZE(1)));
+                    (*doc)["status"] = "Idle";
+                    return doc;
+                },
+                [] (JsonObject) {})));
+        }
+
+        loopback.setConnected(true);
+        mocpp_loop();
+        mtime += MO_RECONNECT_BACKOFF_BASE_MS;
+        for (unsigned int i = 0; i < 20; i++) {
+            mocpp_loop();
+        }
+
+        //burst. The exhausted DataTransfer class doesn't hold back the default class
+        REQUIRE( getConnectivityState() == ConnectivityState_Draining );
+        REQUIRE( nReceived == 2 );
+        REQUIRE( nStatus == 3 );
+        REQUIRE( mocpp_next_wakeup_ms() > 0 );
+        REQUIRE( mocpp_next_wakeup_ms() <= 1000 );
+
+        //one token per refill interval
+        for (unsigned int n = 3; n <= 5; n++) {
+            mtime += 1000;
+            for (unsigned int i = 0; i < 10; i++) {
+                mocpp_loop();
+            }
+            REQUIRE( nReceived == n );
+        }
+
+        REQUIRE( getConnectivityState() == ConnectivityState_Online );
+    }
+
+    mocpp_deinitialize();
+}
@@ -0,0 +1,99 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Model/Diagnostics/DiagnosticsStreamer.h>
+#include <MicroOcpp/Debug.h>
+#include "./catch2/catch.hpp"
+#include "./helpers/testHelper.h"
+
+#include <string>
+
+using namespace MicroOcpp;
+
+TEST_CASE( "Diagnostics" ) {
+    printf("\nRun %s\n",  "Diagnostics");
+
+    //clean state
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    LoopbackConnection loopback;
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"), filesystem);
+
+    mocpp_set_timer(custom_timer_cb);
+
+    loop();
+
+    SECTION("Stream report") {
+
+        //store files which together exceed the former fixed-size report buffers
+        const size_t nFiles = 10;
+        const size_t fileSize = 500;
+        for (size_t i = 0; i < nFiles; i++) {
+            char fn [MO_MAX_PATH_SIZE];
+            snprintf(fn, sizeof(fn), MO_FILENAME_PREFIX "diag-%zu.jsn", i);
+            auto file = filesystem->open(fn, "w");
+            REQUIRE( file );
+            std::string content (fileSize, (char) ('a' + i));
+            REQUIRE( file->write(content.c_str(), content.size()) == content.size() );
+        }
+
+        unsigned int readerCalls = 0;
+        auto reader = [&readerCalls] (char *buf, size_t size) -> size_t {
+            if (readerCalls >= 3) {
+                return 0;
+            }
+            readerCalls++;
+            int ret = snprintf(buf, size, "\ncustom_line=%u", readerCalls);
+            return ret > 0 && (size_t)ret < size ? (size_t)ret : 0;
+        };
+
+        DiagnosticsStreamer streamer {*getOcppContext(), filesystem, reader};
+
+        auto readAll = [&streamer, &readerCalls] (size_t chunkSize) {
+            std::string report;
+            std::vector<unsigned char> buf (chunkSize);
+            readerCalls = 0;
+            streamer.begin();
+            while (auto len = streamer.read(buf.data(), buf.size())) {
+                REQUIRE( len <= chunkSize );
+                report.append((const char*)buf.data(), len);
+            }
+            REQUIRE( streamer.isDone() );
+            return report;
+        };
+
+        auto report = readAll(4096);
+
+        REQUIRE( report.size() > nFiles * fileSize );
+        REQUIRE( report.find("### ") == 0 );
+        REQUIRE( report.find("Hardware Diagnostics") != std::string::npos );
+        REQUIRE( report.find("\n# OCPP") != std::string::npos );
+        REQUIRE( report.find("\nocpp_status_cId1=") != std::string::npos );
+        REQUIRE( report.find("\n# Configuration") != std::string::npos );
+        REQUIRE( report.find("\nHeartbeatInterval=") != std::string::npos );
+        REQUIRE( report.find("\n# Filesystem\n") != std::string::npos );
+        REQUIRE( report.find("[Diagnostics cut]") == std::string::npos );
+        REQUIRE( report.find("\ncustom_line=3") != std::string::npos );
+
+        for (size_t i = 0; i < nFiles; i++) {
+            char heading [MO_MAX_PATH_SIZE + 30];
+            snprintf(heading, sizeof(heading), "\n\n# File diag-%zu.jsn:\n", i);
+            auto pos = report.find(heading);
+            REQUIRE( pos != std::string::npos );
+            REQUIRE( report.compare(pos + strlen(heading), fileSize, std::string(fileSize, (char) ('a' + i))) == 0 );
+        }
+
+        //the report doesn't depend on the chunk size of the FTP client
+        REQUIRE( readAll(7) == report );
+        REQUIRE( readAll(1) == report );
+    }
+
+    mocpp_deinitialize();
+}
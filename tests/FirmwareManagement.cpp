@@ -17,12 +17,120 @@
 
 #include <MicroOcpp/Model/FirmwareManagement/FirmwareService.h>
 
+#include <chrono>
+#include <limits>
+
+#if MO_ENABLE_MBEDTLS
+#include <mbedtls/md.h>
+#endif
+
 #define BASE_TIME     "2023-01-01T00:00:00.000Z"
 #define BASE_TIME_1H  "2023-01-01T01:00:00.000Z"
 #define FTP_URL       "ftps://localhost/firmware.bin"
 
 using namespace MicroOcpp;
 
+//local stand-in for an FTP server. Serves one chunk per loop call and drops the connection once at dropAt
+class FtpStandInDownload : public FtpDownload {
+private:
+    const std::vector<unsigned char>& image;
+    size_t pos;
+    size_t dropAt;
+    std::function<size_t(unsigned char *data, size_t len)> fileWriter;
+    std::function<void(MO_FtpCloseReason reason)> onClose;
+    bool active = true;
+    unsigned char buf [4096];
+public:
+    FtpStandInDownload(const std::vector<unsigned char>& image, size_t offset, size_t dropAt,
+                std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+                std::function<void(MO_FtpCloseReason reason)> onClose) :
+            image(image), pos(offset), dropAt(dropAt), fileWriter(fileWriter), onClose(onClose) { }
+
+    void loop() override {
+        if (!active) {
+            return;
+        }
+
+        if (pos >= dropAt) {
+            active = false;
+            onClose(MO_FtpCloseReason_Failure);
+            return;
+        }
+
+        if (pos >= image.size()) {
+            active = false;
+            onClose(MO_FtpCloseReason_Success);
+            return;
+        }
+
+        size_t len = std::min(sizeof(buf), std::min(image.size() - pos, dropAt - pos));
+        memcpy(buf, image.data() + pos, len);
+
+        size_t ret = fileWriter(buf, len);
+        if (ret == 0) {
+            active = false;
+            onClose(MO_FtpCloseReason_Failure);
+            return;
+        }
+        pos += ret;
+    }
+
+    bool isActive() override {
+        return active;
+    }
+};
+
+class FtpStandIn : public FtpClient {
+public:
+    std::vector<unsigned char> image;
+    size_t dropAt = std::numeric_limits<size_t>::max();
+    unsigned int nDownloads = 0;
+    size_t lastOffset = 0;
+    std::chrono::steady_clock::time_point t_start;
+
+    std::unique_ptr<FtpDownload> getFile(const char *ftp_url,
+                std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+                std::function<void(MO_FtpCloseReason reason)> onClose,
+                const char *ca_cert = nullptr) override {
+        t_start = std::chrono::steady_clock::now();
+        return getFileFromOffset(ftp_url, 0, fileWriter, onClose, ca_cert);
+    }
+
+    std::unique_ptr<FtpDownload> getFileFromOffset(const char *ftp_url, size_t offset,
+                std::function<size_t(unsigned char *data, size_t len)> fileWriter,
+                std::function<void(MO_FtpCloseReason reason)> onClose,
+                const char *ca_cert = nullptr) override {
+        nDownloads++;
+        lastOffset = offset;
+        auto download = std::unique_ptr<FtpDownload>(new FtpStandInDownload(image, offset, dropAt, fileWriter, onClose));
+        dropAt = std::numeric_limits<size_t>::max(); //drop only once
+        return download;
+    }
+
+    std::unique_ptr<FtpUpload> postFile(const char*,
+                std::function<size_t(unsigned char *out, size_t buffsize)>,
+                std::function<void(MO_FtpCloseReason reason)>,
+                const char* = nullptr) override {
+        return nullptr;
+    }
+};
+
+void sendUpdateFirmware(const char *location = FTP_URL) {
+    getOcppContext()->initiateRequest(makeRequest(new Ocpp16::CustomOperation(
+            "UpdateFirmware",
+            [location] () {
+                //create req
+                auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(JSON_OBJECT_SIZE(4)));
+                auto payload = doc->to<JsonObject>();
+                payload["location"] = location;
+                payload["retries"] = 1;
+                payload["retrieveDate"] = BASE_TIME;
+                payload["retryInterval"] = 1;
+                return doc;},
+            [] (JsonObject) { } //ignore conf
+    )));
+}
+
 TEST_CASE( "FirmwareManagement" ) {
     printf("\nRun %s\n",  "FirmwareManagement");
 
@@ -592,6 +700,198 @@ TEST_CASE( "FirmwareManagement" ) {
         REQUIRE( checkProcessedOnInstallStatus == 2 );
     }
 
+    SECTION("FTP download with resume") {
+
+        auto ftpStandIn = new FtpStandIn();
+        getOcppContext()->setFtpClient(std::unique_ptr<FtpClient>(ftpStandIn));
+
+        const size_t imageSize = 100000;
+        for (size_t i = 0; i < imageSize; i++) {
+            ftpStandIn->image.push_back((unsigned char) ((i * 7919) >> 3));
+        }
+        ftpStandIn->dropAt = 41000; //not aligned with chunks
+
+        std::vector<unsigned char> flash;
+        MO_FtpCloseReason closeReason = MO_FtpCloseReason_Undefined;
+
+        fwService->setDownloadFileWriter(
+            [&flash] (const unsigned char *data, size_t size) -> size_t {
+                size_t page = std::min(size, (size_t) 1000); //firmware writer only accepts one page per call
+                flash.insert(flash.end(), data, data + page);
+                return page;
+            },
+            [&closeReason] (MO_FtpCloseReason reason) {
+                closeReason = reason;
+            });
+
+        bool checkIntegrity = false;
+        fwService->setDownloadIntegrityCheck([&checkIntegrity, ftpStandIn] (FirmwareDownload& download) {
+            checkIntegrity = true;
+            REQUIRE( download.getOffset() == ftpStandIn->image.size() );
+            REQUIRE( !download.verifySha256("0000000000000000000000000000000000000000000000000000000000000000") );
+#if MO_ENABLE_MBEDTLS
+            unsigned char expected [MO_FW_SHA256_SIZE], digest [MO_FW_SHA256_SIZE];
+            REQUIRE( !mbedtls_md(mbedtls_md_info_from_type(MBEDTLS_MD_SHA256), ftpStandIn->image.data(), ftpStandIn->image.size(), expected) );
+            REQUIRE( download.getSha256(digest) );
+            REQUIRE( !memcmp(digest, expected, sizeof(digest)) );
+#endif
+            return true;
+        });
+
+        sendUpdateFirmware();
+
+        for (unsigned int i = 0; i < 100 && closeReason == MO_FtpCloseReason_Undefined; i++) {
+            loop();
+            mtime += 100;
+        }
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( checkIntegrity );
+        REQUIRE( ftpStandIn->nDownloads == 2 );
+        REQUIRE( ftpStandIn->lastOffset == 41000 );
+        REQUIRE( flash == ftpStandIn->image );
+        REQUIRE( fwService->getFirmwareDownload() == nullptr );
+    }
+
+    SECTION("FTP download rejected by integrity check") {
+
+        auto ftpStandIn = new FtpStandIn();
+        getOcppContext()->setFtpClient(std::unique_ptr<FtpClient>(ftpStandIn));
+        ftpStandIn->image.resize(10000, 0xAB);
+
+        MO_FtpCloseReason closeReason = MO_FtpCloseReason_Undefined;
+
+        fwService->setDownloadFileWriter(
+            [] (const unsigned char*, size_t size) -> size_t {
+                return size;
+            },
+            [&closeReason] (MO_FtpCloseReason reason) {
+                closeReason = reason;
+            });
+
+        fwService->setDownloadIntegrityCheck([] (FirmwareDownload&) {
+            return false;
+        });
+
+        sendUpdateFirmware();
+
+        for (unsigned int i = 0; i < 100 && closeReason == MO_FtpCloseReason_Undefined; i++) {
+            loop();
+            mtime += 100;
+        }
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Failure );
+    }
+
+    SECTION("HTTP download dispatched by URL scheme") {
+
+        auto ftpStandIn = new FtpStandIn();
+        getOcppContext()->setFtpClient(std::unique_ptr<FtpClient>(ftpStandIn));
+
+        //without HTTP client, http(s) URLs go to the FTP client
+        getOcppContext()->setHttpClient(nullptr);
+        REQUIRE( getOcppContext()->getTransferClient("https://example.com/fw.bin") == ftpStandIn );
+
+        auto httpStandIn = new FtpStandIn();
+        getOcppContext()->setHttpClient(std::unique_ptr<FtpClient>(httpStandIn));
+        httpStandIn->image.resize(10000, 0xAB);
+
+        REQUIRE( getOcppContext()->getTransferClient("ftp://example.com/fw.bin") == ftpStandIn );
+        REQUIRE( getOcppContext()->getTransferClient("HTTPS://example.com/fw.bin") == httpStandIn );
+        REQUIRE( getOcppContext()->getTransferClient("httpx://example.com/fw.bin") == ftpStandIn );
+
+        std::vector<unsigned char> flash;
+        MO_FtpCloseReason closeReason = MO_FtpCloseReason_Undefined;
+
+        fwService->setDownloadFileWriter(
+            [&flash] (const unsigned char *data, size_t size) -> size_t {
+                flash.insert(flash.end(), data, data + size);
+                return size;
+            },
+            [&closeReason] (MO_FtpCloseReason reason) {
+                closeReason = reason;
+            });
+
+        sendUpdateFirmware("https://example.com/fw/firmware.bin");
+
+        for (unsigned int i = 0; i < 100 && closeReason == MO_FtpCloseReason_Undefined; i++) {
+            loop();
+            mtime += 100;
+        }
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( httpStandIn->nDownloads == 1 );
+        REQUIRE( ftpStandIn->nDownloads == 0 );
+        REQUIRE( flash == httpStandIn->image );
+    }
+
     mocpp_deinitialize();
 
 }
+
+TEST_CASE( "FirmwareDownload benchmark", "[.][benchmark]" ) {
+    printf("\nRun %s\n",  "FirmwareDownload benchmark");
+
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    LoopbackConnection loopback;
+    mocpp_set_timer(custom_timer_cb);
+    mocpp_initialize(loopback, ChargerCredentials("test-runner"));
+    getOcppContext()->getModel().getClock().setTime(BASE_TIME);
+
+    const size_t imageSize = 4 * 1024 * 1024;
+
+    for (bool drop : {false, true}) {
+        auto ftpStandIn = new FtpStandIn();
+        getOcppContext()->setFtpClient(std::unique_ptr<FtpClient>(ftpStandIn));
+
+        for (size_t i = 0; i < imageSize; i++) {
+            ftpStandIn->image.push_back((unsigned char) ((i * 7919) >> 3));
+        }
+        if (drop) {
+            ftpStandIn->dropAt = imageSize / 2 + 1;
+        }
+
+        std::vector<unsigned char> flash;
+        flash.reserve(imageSize);
+        MO_FtpCloseReason closeReason = MO_FtpCloseReason_Undefined;
+
+        getFirmwareService()->setDownloadFileWriter(
+            [&flash] (const unsigned char *data, size_t size) -> size_t {
+                flash.insert(flash.end(), data, data + size);
+                return size;
+            },
+            [&closeReason] (MO_FtpCloseReason reason) {
+                closeReason = reason;
+            });
+
+        sendUpdateFirmware();
+
+        while (closeReason == MO_FtpCloseReason_Undefined) {
+            loop();
+            mtime += 10;
+        }
+        auto t_end = std::chrono::steady_clock::now();
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( flash == ftpStandIn->image );
+
+        auto t_total = std::chrono::duration_cast<std::chrono::microseconds>(t_end - ftpStandIn->t_start).count();
+        printf("download %zu kB (%s): %lld us, %.1f MB/s, resumed at %zu, image %s\n",
+                imageSize / 1024,
+                drop ? "connection dropped once" : "no drop",
+                (long long) t_total,
+                t_total > 0 ? (double) imageSize / (double) t_total : 0.,
+                ftpStandIn->lastOffset,
+                flash == ftpStandIn->image ? "intact" : "corrupt");
+
+        //let the update routine finish before the next run
+        for (unsigned int i = 0; i < 100; i++) {
+            loop();
+            mtime += 1000;
+        }
+    }
+
+    mocpp_deinitialize();
+}
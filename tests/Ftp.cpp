@@ -0,0 +1,364 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Platform.h>
+
+#if MO_ENABLE_MBEDTLS
+
+#include <MicroOcpp/Core/FtpMbedTLS.h>
+#include <MicroOcpp/Debug.h>
+#include "./catch2/catch.hpp"
+#include "./helpers/testHelper.h"
+
+#include <string>
+#include <vector>
+#include <chrono>
+#include <thread>
+#include <limits>
+#include <string.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define FTP_FNAME "firmware.bin"
+
+using namespace MicroOcpp;
+
+//local stand-in for an FTP server (plain FTP, passive mode, RETR only). Single-threaded, driven by loop()
+class FtpStandInServer {
+private:
+    int listen_fd = -1;
+    int ctrl_fd = -1;
+    int pasv_fd = -1;
+    int data_fd = -1;
+    std::string ctrl_in;
+    size_t data_pos = 0;
+    size_t rest = 0;
+    bool sending = false;
+
+    static int listenLocal(uint16_t& port) {
+        int fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) {
+            return -1;
+        }
+        int one = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0; //any free port
+        socklen_t len = sizeof(addr);
+        if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(fd, 1) ||
+                getsockname(fd, (struct sockaddr*)&addr, &len)) {
+            close(fd);
+            return -1;
+        }
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+        port = ntohs(addr.sin_port);
+        return fd;
+    }
+
+    static void closeFd(int& fd, bool reset = false) {
+        if (fd < 0) {
+            return;
+        }
+        if (reset) {
+            struct linger lin = {1, 0}; //abort with RST instead of regular EOF
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+        }
+        close(fd);
+        fd = -1;
+    }
+
+    void reply(const char *msg) {
+        if (ctrl_fd >= 0) {
+            send(ctrl_fd, msg, strlen(msg), MSG_NOSIGNAL);
+        }
+    }
+
+    void processCmd(const std::string& cmd) {
+        if (!cmd.compare(0, 4, "USER")) {
+            reply("331 Password required\r\n");
+        } else if (!cmd.compare(0, 4, "PASS")) {
+            reply("230 Logged in\r\n");
+        } else if (!cmd.compare(0, 3, "CWD")) {
+            reply("250 Directory changed\r\n");
+        } else if (!cmd.compare(0, 4, "PASV")) {
+            closeFd(pasv_fd);
+            uint16_t pasv_port = 0;
+            pasv_fd = listenLocal(pasv_port);
+            char buf [64];
+            snprintf(buf, sizeof(buf), "227 Entering Passive Mode (127,0,0,1,%u,%u)\r\n", pasv_port / 256U, pasv_port % 256U);
+            reply(buf);
+        } else if (!cmd.compare(0, 4, "REST")) {
+            rest = (size_t) strtoul(cmd.c_str() + 4, nullptr, 10);
+            reply("350 Restarting\r\n");
+        } else if (!cmd.compare(0, 4, "RETR")) {
+            data_pos = rest;
+            sending = true;
+            reply("150 Opening data connection\r\n");
+        } else if (!cmd.compare(0, 4, "QUIT")) {
+            reply("221 Goodbye\r\n");
+            closeFd(ctrl_fd);
+        } else {
+            reply("502 Not implemented\r\n");
+        }
+    }
+
+public:
+    std::vector<unsigned char> file;
+    size_t dropAt = std::numeric_limits<size_t>::max(); //abort data connection once at this offset
+    bool dropReset = true; //abort with RST. Otherwise, the data connection ends regularly and only the ctrl reply tells the abort
+    uint16_t port = 0;
+
+    FtpStandInServer() {
+        listen_fd = listenLocal(port);
+    }
+
+    ~FtpStandInServer() {
+        closeFd(data_fd);
+        closeFd(pasv_fd);
+        closeFd(ctrl_fd);
+        closeFd(listen_fd);
+    }
+
+    bool isListening() {return listen_fd >= 0;}
+
+    std::string getUrl() {
+        return std::string("ftp://127.0.0.1:") + std::to_string(port) + "/fw/" FTP_FNAME;
+    }
+
+    void loop() {
+        if (ctrl_fd < 0) {
+            ctrl_fd = accept(listen_fd, nullptr, nullptr);
+            if (ctrl_fd >= 0) {
+                fcntl(ctrl_fd, F_SETFL, fcntl(ctrl_fd, F_GETFL, 0) | O_NONBLOCK);
+                int one = 1;
+                setsockopt(ctrl_fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one)); //replies like 150 and 226 follow each other closely. Don't let Nagle hold back the second
+                reply("220-MicroOcpp FTP stand-in\r\n220 Ready\r\n"); //multi-line reply
+                rest = 0;
+            }
+        }
+
+        if (ctrl_fd >= 0) {
+            char buf [256];
+            auto len = recv(ctrl_fd, buf, sizeof(buf), 0);
+            if (len > 0) {
+                ctrl_in.append(buf, (size_t) len);
+            } else if (len == 0) {
+                closeFd(ctrl_fd);
+            }
+
+            size_t eol;
+            while ((eol = ctrl_in.find("\r\n")) != std::string::npos) {
+                auto cmd = ctrl_in.substr(0, eol);
+                ctrl_in.erase(0, eol + 2);
+                processCmd(cmd);
+            }
+        }
+
+        if (pasv_fd >= 0 && data_fd < 0) {
+            data_fd = accept(pasv_fd, nullptr, nullptr);
+            if (data_fd >= 0) {
+                fcntl(data_fd, F_SETFL, fcntl(data_fd, F_GETFL, 0) | O_NONBLOCK);
+            }
+        }
+
+        if (sending && data_fd >= 0) {
+            //send as much as the socket accepts
+            while (data_pos < file.size() && data_pos < dropAt) {
+                auto len = send(data_fd, file.data() + data_pos, std::min(file.size(), dropAt) - data_pos, MSG_NOSIGNAL);
+                if (len <= 0) {
+                    break;
+                }
+                data_pos += (size_t) len;
+            }
+
+            if (data_pos >= dropAt) {
+                dropAt = std::numeric_limits<size_t>::max();
+                sending = false;
+                closeFd(data_fd, dropReset);
+                closeFd(pasv_fd);
+                reply("426 Connection closed; transfer aborted\r\n");
+            } else if (data_pos >= file.size()) {
+                sending = false;
+                closeFd(data_fd);
+                closeFd(pasv_fd);
+                reply("226 Transfer complete\r\n");
+            }
+        }
+    }
+};
+
+void fillImage(std::vector<unsigned char>& image, size_t size) {
+    image.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        image[i] = (unsigned char) ((i * 7919) >> 3);
+    }
+}
+
+TEST_CASE( "FTP" ) {
+    printf("\nRun %s\n",  "FTP");
+
+    mocpp_set_timer(custom_timer_cb);
+
+    FtpStandInServer server;
+    REQUIRE( server.isListening() );
+    fillImage(server.file, 1000000);
+
+    auto ftpClient = makeFtpClientMbedTLS();
+
+    std::vector<unsigned char> received;
+    MO_FtpCloseReason closeReason = MO_FtpCloseReason_Undefined;
+
+    auto fileWriter = [&received] (unsigned char *data, size_t len) -> size_t {
+        received.insert(received.end(), data, data + len);
+        return len;
+    };
+    auto onClose = [&closeReason] (MO_FtpCloseReason reason) {
+        closeReason = reason;
+    };
+
+    auto run = [&server] (FtpDownload& download) {
+        for (unsigned int i = 0; i < 100000 && download.isActive(); i++) {
+            server.loop();
+            download.loop();
+        }
+    };
+
+    SECTION("Download") {
+        auto download = ftpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+
+        run(*download);
+
+        REQUIRE( !download->isActive() );
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( received == server.file );
+    }
+
+    SECTION("Truncated download") {
+        server.dropAt = 300000;
+        server.dropReset = false;
+
+        auto download = ftpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        //data connection ended regularly, but the server replied 426
+        REQUIRE( !download->isActive() );
+        REQUIRE( closeReason == MO_FtpCloseReason_Failure );
+        REQUIRE( received.size() <= 300000 );
+    }
+
+    SECTION("Resume download") {
+        server.dropAt = 300000;
+
+        auto download = ftpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Failure );
+        REQUIRE( received.size() > 0 );
+        REQUIRE( received.size() <= 300000 );
+
+        closeReason = MO_FtpCloseReason_Undefined;
+        download = ftpClient->getFileFromOffset(server.getUrl().c_str(), received.size(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( received == server.file );
+    }
+
+    SECTION("Resume download after regular close") {
+        server.dropAt = 300000;
+        server.dropReset = false;
+
+        auto download = ftpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Failure );
+        REQUIRE( received.size() > 0 );
+        REQUIRE( received.size() <= 300000 );
+
+        closeReason = MO_FtpCloseReason_Undefined;
+        download = ftpClient->getFileFromOffset(server.getUrl().c_str(), received.size(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( received == server.file );
+    }
+}
+
+unsigned long steady_clock_ms() {
+    return (unsigned long) std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+TEST_CASE( "FTP benchmark", "[.][benchmark]" ) {
+    printf("\nRun %s\n",  "FTP benchmark");
+
+    mocpp_set_timer(steady_clock_ms); //the loop budget of the FTP client needs the real time
+
+    FtpStandInServer server;
+    REQUIRE( server.isListening() );
+    fillImage(server.file, 4 * 1024 * 1024);
+
+    auto ftpClient = makeFtpClientMbedTLS();
+
+    for (unsigned int loopHz : {10, 100, 1000, 0}) { //0: loop as fast as possible
+
+        size_t received = 0;
+        MO_FtpCloseReason closeReason = MO_FtpCloseReason_Undefined;
+
+        auto download = ftpClient->getFile(server.getUrl().c_str(),
+            [&received] (unsigned char*, size_t len) -> size_t {
+                received += len;
+                return len;
+            },
+            [&closeReason] (MO_FtpCloseReason reason) {
+                closeReason = reason;
+            });
+        REQUIRE( download );
+
+        auto t_start = std::chrono::steady_clock::now();
+        unsigned long nLoops = 0;
+
+        while (download->isActive()) {
+            server.loop();
+            download->loop();
+            nLoops++;
+            if (loopHz > 0) {
+                std::this_thread::sleep_for(std::chrono::microseconds(1000000 / loopHz)); //rest of the main loop
+            }
+        }
+
+        auto t_end = std::chrono::steady_clock::now();
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( received == server.file.size() );
+
+        auto t_total = std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count();
+        printf("loop %5s Hz: %zu kB in %lld ms, %lu loop calls, %.2f MB/s (MO_FTP_LOOP_BUDGET_MS=%i, MO_FTP_DATA_BUFSIZE=%i)\n",
+                loopHz > 0 ? std::to_string(loopHz).c_str() : "max",
+                received / 1024,
+                (long long) t_total / 1000,
+                nLoops,
+                t_total > 0 ? (double) received / (double) t_total : 0.,
+                MO_FTP_LOOP_BUDGET_MS,
+                MO_FTP_DATA_BUFSIZE);
+    }
+
+    mocpp_set_timer(custom_timer_cb);
+}
+
+#endif //MO_ENABLE_MBEDTLS
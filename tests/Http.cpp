@@ -0,0 +1,417 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp/Platform.h>
+
+#if MO_ENABLE_MBEDTLS
+
+#include <MicroOcpp/Core/HttpMbedTLS.h>
+#include <MicroOcpp/Debug.h>
+#include "./catch2/catch.hpp"
+#include "./helpers/testHelper.h"
+
+#include <string>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <string.h>
+#include <signal.h>
+
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace MicroOcpp;
+
+//local stand-in for an HTTP/1.1 server (plain HTTP, GET with Range, chunked POST). Single-threaded, driven by loop()
+class HttpStandInServer {
+private:
+    int listen_fd = -1;
+    int conn_fd = -1;
+    std::string in;
+    std::string out;
+    size_t out_pos = 0;
+    bool closeAfterSend = false;
+    bool dropAfterSend = false;
+
+    //request in progress
+    bool posting = false;
+    std::string postBody;
+
+    static void closeFd(int& fd, bool reset = false) {
+        if (fd < 0) {
+            return;
+        }
+        if (reset) {
+            struct linger lin = {1, 0}; //abort with RST instead of regular EOF
+            setsockopt(fd, SOL_SOCKET, SO_LINGER, &lin, sizeof(lin));
+        }
+        close(fd);
+        fd = -1;
+    }
+
+    void respondGet(const std::string& header) {
+        size_t from = 0;
+        auto range = header.find("Range: bytes=");
+        if (range != std::string::npos) {
+            from = (size_t) strtoul(header.c_str() + range + strlen("Range: bytes="), nullptr, 10);
+            nRangeRequests++;
+        }
+        from = std::min(from, file.size());
+
+        size_t to = std::min(file.size(), dropAt);
+        dropAfterSend = to < file.size();
+        dropAt = std::numeric_limits<size_t>::max();
+
+        if (from > to) {
+            from = to;
+        }
+
+        char buf [128];
+        if (chunkedMode) {
+            snprintf(buf, sizeof(buf), "HTTP/1.1 %s\r\nTransfer-Encoding: chunked\r\n\r\n", from > 0 ? "206 Partial Content" : "200 OK");
+            out.append(buf);
+            for (size_t pos = from; pos < to; pos += 1000) {
+                size_t len = std::min((size_t) 1000, to - pos);
+                snprintf(buf, sizeof(buf), "%zx;ext=1\r\n", len); //chunk extensions are ignored by the client
+                out.append(buf);
+                out.append((const char*) file.data() + pos, len);
+                out.append("\r\n");
+            }
+            if (!dropAfterSend) {
+                out.append("0\r\nX-Trailer: 1\r\n\r\n");
+            }
+        } else {
+            snprintf(buf, sizeof(buf), "HTTP/1.1 %s\r\nContent-Length: %zu\r\n\r\n", from > 0 ? "206 Partial Content" : "200 OK", file.size() - from);
+            out.append(buf);
+            out.append((const char*) file.data() + from, to - from);
+        }
+    }
+
+    void processRequest() {
+        auto eoh = in.find("\r\n\r\n");
+        if (eoh == std::string::npos) {
+            return;
+        }
+        std::string header = in.substr(0, eoh + 4);
+        in.erase(0, eoh + 4);
+
+        nRequests++;
+
+        if (!header.compare(0, 13, "GET /missing ")) {
+            out.append("HTTP/1.1 404 Not Found\r\nContent-Length: 9\r\n\r\nNot Found");
+        } else if (!header.compare(0, 4, "GET ")) {
+            respondGet(header);
+            closeAfterSend = closeIdle;
+        } else if (!header.compare(0, 5, "POST ")) {
+            posting = header.find("Transfer-Encoding: chunked") != std::string::npos;
+            postBody.clear();
+            if (!posting) {
+                out.append("HTTP/1.1 411 Length Required\r\nContent-Length: 0\r\n\r\n");
+            }
+        } else {
+            out.append("HTTP/1.1 405 Method Not Allowed\r\nContent-Length: 0\r\n\r\n");
+        }
+    }
+
+    void processPostBody() {
+        while (true) {
+            auto eol = in.find("\r\n");
+            if (eol == std::string::npos) {
+                return;
+            }
+            size_t len = (size_t) strtoul(in.c_str(), nullptr, 16);
+            if (len == 0) {
+                if (in.size() < eol + 4) {
+                    return; //wait for the final CRLF
+                }
+                in.erase(0, eol + 4);
+                uploaded = postBody;
+                posting = false;
+                out.append("HTTP/1.1 201 Created\r\nContent-Length: 2\r\n\r\nOK");
+                return;
+            }
+            if (in.size() < eol + 2 + len + 2) {
+                return; //wait for the whole chunk
+            }
+            postBody.append(in, eol + 2, len);
+            in.erase(0, eol + 2 + len + 2);
+        }
+    }
+
+public:
+    std::vector<unsigned char> file;
+    std::string uploaded;
+    bool chunkedMode = false; //serve GET with Transfer-Encoding: chunked
+    bool closeIdle = false; //close the connection after each GET response without announcing it
+    size_t dropAt = std::numeric_limits<size_t>::max(); //drop connection once at this file offset
+    bool dropReset = true; //drop with RST, otherwise with regular EOF
+    unsigned int nAccepted = 0;
+    unsigned int nRequests = 0;
+    unsigned int nRangeRequests = 0;
+    uint16_t port = 0;
+
+    HttpStandInServer() {
+        listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (listen_fd < 0) {
+            return;
+        }
+        int one = 1;
+        setsockopt(listen_fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+        struct sockaddr_in addr = {};
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0; //any free port
+        socklen_t len = sizeof(addr);
+        if (bind(listen_fd, (struct sockaddr*)&addr, sizeof(addr)) || listen(listen_fd, 4) ||
+                getsockname(listen_fd, (struct sockaddr*)&addr, &len)) {
+            closeFd(listen_fd);
+            return;
+        }
+        fcntl(listen_fd, F_SETFL, fcntl(listen_fd, F_GETFL, 0) | O_NONBLOCK);
+        port = ntohs(addr.sin_port);
+    }
+
+    ~HttpStandInServer() {
+        closeFd(conn_fd);
+        closeFd(listen_fd);
+    }
+
+    bool isListening() {return listen_fd >= 0;}
+
+    std::string getUrl(const char *path = "/fw/firmware.bin") {
+        return std::string("http://127.0.0.1:") + std::to_string(port) + path;
+    }
+
+    void loop() {
+        int fd = accept(listen_fd, nullptr, nullptr);
+        if (fd >= 0) {
+            closeFd(conn_fd);
+            conn_fd = fd;
+            fcntl(conn_fd, F_SETFL, fcntl(conn_fd, F_GETFL, 0) | O_NONBLOCK);
+            nAccepted++;
+            in.clear();
+            out.clear();
+            out_pos = 0;
+            posting = false;
+        }
+
+        if (conn_fd < 0) {
+            return;
+        }
+
+        char buf [4096];
+        ssize_t len;
+        while ((len = recv(conn_fd, buf, sizeof(buf), 0)) > 0) {
+            in.append(buf, (size_t) len);
+        }
+        if (len == 0) {
+            closeFd(conn_fd);
+            return;
+        }
+
+        if (posting) {
+            processPostBody();
+        } else if (out_pos >= out.size()) {
+            processRequest();
+        }
+
+        //send as much as the socket accepts
+        while (out_pos < out.size()) {
+            auto len = send(conn_fd, out.data() + out_pos, out.size() - out_pos, MSG_NOSIGNAL);
+            if (len <= 0) {
+                break;
+            }
+            out_pos += (size_t) len;
+        }
+
+        if (out_pos > 0 && out_pos >= out.size()) {
+            out.clear();
+            out_pos = 0;
+            if (dropAfterSend) {
+                dropAfterSend = false;
+                closeFd(conn_fd, dropReset);
+            } else if (closeAfterSend) {
+                closeAfterSend = false;
+                closeFd(conn_fd);
+            }
+        }
+    }
+};
+
+static void fillHttpImage(std::vector<unsigned char>& image, size_t size) {
+    image.resize(size);
+    for (size_t i = 0; i < size; i++) {
+        image[i] = (unsigned char) ((i * 7919) >> 3);
+    }
+}
+
+TEST_CASE( "HTTP" ) {
+    printf("\nRun %s\n",  "HTTP");
+
+    mocpp_set_timer(custom_timer_cb);
+
+    signal(SIGPIPE, SIG_IGN); //the stand-in server closes connections abruptly
+
+    HttpStandInServer server;
+    REQUIRE( server.isListening() );
+    fillHttpImage(server.file, 1000000);
+
+    auto httpClient = makeHttpClientMbedTLS();
+
+    std::vector<unsigned char> received;
+    MO_FtpCloseReason closeReason = MO_FtpCloseReason_Undefined;
+
+    auto fileWriter = [&received] (unsigned char *data, size_t len) -> size_t {
+        received.insert(received.end(), data, data + len);
+        return len;
+    };
+    auto onClose = [&closeReason] (MO_FtpCloseReason reason) {
+        closeReason = reason;
+    };
+
+    auto run = [&server] (FtpDownload& download) {
+        for (unsigned int i = 0; i < 100000 && download.isActive(); i++) {
+            server.loop();
+            download.loop();
+        }
+    };
+
+    SECTION("Download") {
+        auto download = httpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+
+        run(*download);
+
+        REQUIRE( !download->isActive() );
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( received == server.file );
+    }
+
+    SECTION("Chunked download") {
+        server.chunkedMode = true;
+
+        auto download = httpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( received == server.file );
+    }
+
+    SECTION("Keep-alive") {
+        for (unsigned int i = 0; i < 3; i++) {
+            received.clear();
+            closeReason = MO_FtpCloseReason_Undefined;
+
+            auto download = httpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+            REQUIRE( download );
+            run(*download);
+
+            REQUIRE( closeReason == MO_FtpCloseReason_Success );
+            REQUIRE( received == server.file );
+        }
+
+        REQUIRE( server.nRequests == 3 );
+        REQUIRE( server.nAccepted == 1 );
+    }
+
+    SECTION("Keep-alive connection closed by server") {
+        server.closeIdle = true;
+
+        for (unsigned int i = 0; i < 2; i++) {
+            received.clear();
+            closeReason = MO_FtpCloseReason_Undefined;
+
+            auto download = httpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+            REQUIRE( download );
+            run(*download);
+
+            REQUIRE( closeReason == MO_FtpCloseReason_Success );
+            REQUIRE( received == server.file );
+
+            for (unsigned int j = 0; j < 10; j++) {
+                server.loop();
+            }
+        }
+
+        REQUIRE( server.nAccepted == 2 );
+    }
+
+    SECTION("Resume download") {
+        server.chunkedMode = true;
+        server.dropAt = 300000;
+
+        auto download = httpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Failure );
+        REQUIRE( received.size() > 0 );
+        REQUIRE( received.size() <= 300000 );
+
+        closeReason = MO_FtpCloseReason_Undefined;
+        download = httpClient->getFileFromOffset(server.getUrl().c_str(), received.size(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( server.nRangeRequests == 1 );
+        REQUIRE( received == server.file );
+    }
+
+    SECTION("Truncated download") {
+        server.dropAt = 300000;
+        server.dropReset = false;
+
+        auto download = httpClient->getFile(server.getUrl().c_str(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Failure );
+        REQUIRE( received.size() == 300000 );
+    }
+
+    SECTION("Chunked upload") {
+        std::string report;
+        for (unsigned int i = 0; report.size() < 100000; i++) {
+            report += "line " + std::to_string(i) + "\n";
+        }
+        size_t readPos = 0;
+
+        auto upload = httpClient->postFile(server.getUrl("/diagnostics").c_str(),
+            [&report, &readPos] (unsigned char *buf, size_t size) -> size_t {
+                size_t len = std::min(size, report.size() - readPos);
+                memcpy(buf, report.data() + readPos, len);
+                readPos += len;
+                return len;
+            }, onClose);
+        REQUIRE( upload );
+
+        for (unsigned int i = 0; i < 100000 && upload->isActive(); i++) {
+            server.loop();
+            upload->loop();
+        }
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Success );
+        REQUIRE( server.uploaded == report );
+    }
+
+    SECTION("HTTP failure status") {
+        auto download = httpClient->getFile(server.getUrl("/missing").c_str(), fileWriter, onClose);
+        REQUIRE( download );
+        run(*download);
+
+        REQUIRE( closeReason == MO_FtpCloseReason_Failure );
+        REQUIRE( received.empty() );
+
+        REQUIRE( !httpClient->getFile("ftp://127.0.0.1/fw/firmware.bin", fileWriter, onClose) ); //scheme not supported by the HTTP client
+    }
+}
+
+#endif //MO_ENABLE_MBEDTLS
@@ -19,6 +19,10 @@
 #include <MicroOcpp/Core/FilesystemUtils.h>
 #include <MicroOcpp/Core/Configuration.h>
 #include <MicroOcpp/Model/Authorization/AuthorizationService.h>
+#include <MicroOcpp/Model/Authorization/AuthorizationListPaged.h>
+#include <MicroOcpp/Model/Authorization/AuthorizationCache.h>
+
+#include <chrono>
 
 
 #define BASE_TIME "2023-01-01T00:00:00.000Z"
@@ -928,4 +932,455 @@ TEST_CASE( "LocalAuth" ) {
     mocpp_deinitialize();
 }
 
+TEST_CASE( "LocalAuth paged list" ) {
+    printf("\nRun %s\n",  "LocalAuth paged list");
+
+    //clean state
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    const size_t LIST_MAX_SIZE = 10 * MO_LocalAuthListPageSize;
+
+    AuthorizationListPaged authList {filesystem, LIST_MAX_SIZE};
+    authList.load();
+
+    REQUIRE( authList.size() == 0 );
+    REQUIRE( authList.getListVersion() == 0 );
+
+    //full update with multiple pages
+    const size_t LIST_SIZE = 3 * MO_LocalAuthListPageSize + 1;
+    DynamicJsonDocument fullList (LIST_SIZE * 256);
+    generateAuthList(fullList.to<JsonArray>(), LIST_SIZE, false);
+
+    REQUIRE( authList.readJson(fullList.as<JsonArray>(), 1, false) );
+    REQUIRE( authList.size() == LIST_SIZE );
+    REQUIRE( authList.getListVersion() == 1 );
+
+    for (size_t i = 0; i < LIST_SIZE; i++) {
+        char idTag [IDTAG_LEN_MAX + 1];
+        sprintf(idTag, "mIdTag%zu", i);
+        auto authData = authList.get(idTag);
+        REQUIRE( authData != nullptr );
+        REQUIRE( !strcmp(authData->getIdTag(), idTag) );
+        REQUIRE( authData->getAuthorizationStatus() == AuthorizationStatus::Accepted );
+    }
+
+    REQUIRE( authList.get("MIDTAG1") != nullptr ); //case-insensitive
+    REQUIRE( authList.get("mIdTag") == nullptr );
+    REQUIRE( authList.get("unknownIdTag") == nullptr );
+
+    SECTION("Differential update") {
+
+        //insert enough entries behind mIdTag1 to overflow its page, update and remove some
+        const size_t N_INSERT = 2 * MO_LocalAuthListPageSize;
+        DynamicJsonDocument diffList ((N_INSERT + 3) * 192);
+        for (size_t i = 0; i < N_INSERT; i++) {
+            char idTag [IDTAG_LEN_MAX + 1];
+            sprintf(idTag, "mIdTag1x%zu", i);
+            diffList[i]["idTag"] = idTag;
+            diffList[i]["idTagInfo"]["status"] = "Accepted";
+        }
+        diffList[N_INSERT]["idTag"] = "mIdTag2";
+        diffList[N_INSERT]["idTagInfo"]["status"] = "Blocked";
+        diffList[N_INSERT]["idTagInfo"]["parentIdTag"] = "mParentIdTag";
+        diffList[N_INSERT]["idTagInfo"]["expiryDate"] = BASE_TIME;
+        diffList[N_INSERT + 1]["idTag"] = "mIdTag3"; //remove
+        diffList[N_INSERT + 2]["idTag"] = "notExisting"; //remove, ignored
+
+        REQUIRE( authList.readJson(diffList.as<JsonArray>(), 2, true) );
+        REQUIRE( authList.size() == LIST_SIZE + N_INSERT - 1 );
+        REQUIRE( authList.getListVersion() == 2 );
+
+        char lastInserted [IDTAG_LEN_MAX + 1];
+        sprintf(lastInserted, "mIdTag1x%zu", N_INSERT - 1);
+
+        REQUIRE( authList.get("mIdTag1x0") != nullptr );
+        REQUIRE( authList.get(lastInserted) != nullptr );
+        REQUIRE( authList.get("mIdTag3") == nullptr );
+        REQUIRE( authList.get("mIdTag4") != nullptr );
+
+        auto authData = authList.get("mIdTag2");
+        REQUIRE( authData != nullptr );
+        REQUIRE( authData->getAuthorizationStatus() == AuthorizationStatus::Blocked );
+        REQUIRE( authData->getParentIdTag() != nullptr );
+        REQUIRE( !strcmp(authData->getParentIdTag(), "mParentIdTag") );
+        Timestamp expiryDate;
+        expiryDate.setTime(BASE_TIME);
+        REQUIRE( authData->getExpiryDate() != nullptr );
+        REQUIRE( *authData->getExpiryDate() == expiryDate );
+
+        //restore from flash
+        AuthorizationListPaged authList2 {filesystem, LIST_MAX_SIZE};
+        REQUIRE( authList2.load() );
+        REQUIRE( authList2.size() == authList.size() );
+        REQUIRE( authList2.getListVersion() == 2 );
+        REQUIRE( authList2.get(lastInserted) != nullptr );
+        REQUIRE( authList2.get("mIdTag2")->getAuthorizationStatus() == AuthorizationStatus::Blocked );
+        REQUIRE( authList2.get("mIdTag3") == nullptr );
+
+        //remove all entries
+        DynamicJsonDocument removeList (JSON_ARRAY_SIZE(LIST_SIZE) + LIST_SIZE * (JSON_OBJECT_SIZE(1) + IDTAG_LEN_MAX + 1));
+        for (size_t i = 0; i < LIST_SIZE; i++) {
+            char idTag [IDTAG_LEN_MAX + 1];
+            sprintf(idTag, "mIdTag%zu", i);
+            removeList[i]["idTag"] = idTag;
+        }
+        REQUIRE( authList.readJson(removeList.as<JsonArray>(), 3, true) );
+        REQUIRE( authList.size() == N_INSERT );
+
+        DynamicJsonDocument emptyList (JSON_ARRAY_SIZE(0));
+        REQUIRE( authList.readJson(emptyList.to<JsonArray>(), 4, false) );
+        REQUIRE( authList.size() == 0 );
+        REQUIRE( authList.getListVersion() == 0 );
+        REQUIRE( authList.get("mIdTag1x0") == nullptr );
+    }
+
+    SECTION("Capacity exceeded") {
+
+        DynamicJsonDocument tooLong ((LIST_MAX_SIZE + 1) * 256);
+        generateAuthList(tooLong.to<JsonArray>(), LIST_MAX_SIZE + 1, false);
+
+        REQUIRE( !authList.readJson(tooLong.as<JsonArray>(), 2, false) );
+
+        //list unchanged
+        REQUIRE( authList.size() == LIST_SIZE );
+        REQUIRE( authList.getListVersion() == 1 );
+        REQUIRE( authList.get("mIdTag0") != nullptr );
+    }
+
+    SECTION("Interrupted update") {
+
+        //missing index file invalidates the list
+        FilesystemUtils::remove_if(filesystem, [] (const char *fname) {return !strcmp(fname, "la-idx.bin");});
+
+        AuthorizationListPaged authList2 {filesystem, LIST_MAX_SIZE};
+        authList2.load();
+        REQUIRE( authList2.size() == 0 );
+        REQUIRE( authList2.getListVersion() == 0 );
+    }
+}
+
+#if MO_ENABLE_LOCAL_AUTH_PAGED
+
+TEST_CASE( "LocalAuth paged SendLocalList" ) {
+    printf("\nRun %s\n",  "LocalAuth paged SendLocalList");
+
+    //clean state
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    LoopbackConnection loopback;
+
+    mocpp_set_timer(custom_timer_cb);
+
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"));
+    auto authService = getOcppContext()->getModel().getAuthorizationService();
+
+    loop();
+
+    //the update messages are limited by SendLocalListMaxLength, the list by LocalAuthListMaxLength
+    const size_t updateSize = (size_t) declareConfiguration<int>("SendLocalListMaxLength", -1)->getInt();
+    const size_t listMaxSize = (size_t) declareConfiguration<int>("LocalAuthListMaxLength", -1)->getInt();
+    REQUIRE( listMaxSize > MO_LocalAuthListPageSize ); //test requires multiple pages
+    REQUIRE( listMaxSize <= 2 * updateSize );
+
+    auto sendLocalList = [] (int listVersion, const char *updateType, size_t offset, size_t size) {
+        bool checkAccepted = false;
+        getOcppContext()->initiateRequest(makeRequest(
+            new Ocpp16::CustomOperation("SendLocalList",
+                [listVersion, updateType, offset, size] () {
+                    //create req
+                    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(
+                            JSON_OBJECT_SIZE(3) + JSON_ARRAY_SIZE(size) + size * (2 * JSON_OBJECT_SIZE(2) + IDTAG_LEN_MAX + 1)));
+                    auto payload = doc->to<JsonObject>();
+                    payload["listVersion"] = listVersion;
+                    auto list = payload.createNestedArray("localAuthorizationList");
+                    for (size_t i = offset; i < offset + size; i++) {
+                        char idTag [IDTAG_LEN_MAX + 1];
+                        sprintf(idTag, "mIdTag%zu", i);
+                        list[i - offset]["idTag"] = idTag;
+                        list[i - offset]["idTagInfo"]["status"] = "Accepted";
+                    }
+                    payload["updateType"] = updateType;
+                    return doc;
+                },
+                [&checkAccepted] (JsonObject payload) {
+                    //process conf
+                    checkAccepted = !strcmp(payload["status"] | "_Undefined", "Accepted");
+                })));
+        loop();
+        return checkAccepted;
+    };
+
+    auto checkLookups = [&authService] (size_t size) {
+        //alternate between the first and the last pages, so that the page cache can't serve all lookups
+        for (size_t k = 0; k < size; k++) {
+            size_t i = (k % 2) ? size - 1 - k / 2 : k / 2;
+            char idTag [IDTAG_LEN_MAX + 1];
+            sprintf(idTag, "mIdTag%zu", i);
+            auto authData = authService->getLocalAuthorization(idTag);
+            if (!authData || strcmp(authData->getIdTag(), idTag)) {
+                return false;
+            }
+        }
+        return true;
+    };
+
+    //full update
+    REQUIRE( sendLocalList(1, "Full", 0, updateSize) );
+    REQUIRE( authService->getLocalListVersion() == 1 );
+    REQUIRE( authService->getLocalListSize() == updateSize );
+    REQUIRE( checkLookups(updateSize) );
+
+    //differential update fills up the list and splits the pages
+    REQUIRE( sendLocalList(2, "Differential", updateSize, listMaxSize - updateSize) );
+    REQUIRE( authService->getLocalListVersion() == 2 );
+    REQUIRE( authService->getLocalListSize() == listMaxSize );
+    REQUIRE( checkLookups(listMaxSize) );
+    REQUIRE( authService->getLocalAuthorization("mIdTag") == nullptr );
+
+    //list is full
+    REQUIRE( !sendLocalList(3, "Differential", listMaxSize, 1) );
+    REQUIRE( authService->getLocalListVersion() == 2 );
+    REQUIRE( authService->getLocalListSize() == listMaxSize );
+
+    //restore page index from flash
+    mocpp_deinitialize();
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"));
+    authService = getOcppContext()->getModel().getAuthorizationService();
+
+    REQUIRE( authService->getLocalListVersion() == 2 );
+    REQUIRE( authService->getLocalListSize() == listMaxSize );
+    REQUIRE( checkLookups(listMaxSize) );
+
+    //full update replaces all pages
+    REQUIRE( sendLocalList(4, "Full", 0, 1) );
+    REQUIRE( authService->getLocalListSize() == 1 );
+    REQUIRE( authService->getLocalAuthorization("mIdTag0") != nullptr );
+    REQUIRE( authService->getLocalAuthorization("mIdTag1") == nullptr );
+
+    mocpp_deinitialize();
+}
+
+#endif //MO_ENABLE_LOCAL_AUTH_PAGED
+
+class FailingWritesFilesystemAdapter : public FilesystemAdapter {
+private:
+    std::shared_ptr<FilesystemAdapter> filesystem;
+public:
+    bool failWrites = false;
+
+    FailingWritesFilesystemAdapter(std::shared_ptr<FilesystemAdapter> filesystem) : filesystem(filesystem) { }
+
+    int stat(const char *path, size_t *size) override {return filesystem->stat(path, size);}
+    std::unique_ptr<FileAdapter> open(const char *fn, const char *mode) override {
+        if (failWrites && strchr(mode, 'w')) {
+            return nullptr;
+        }
+        return filesystem->open(fn, mode);
+    }
+    bool remove(const char *fn) override {return filesystem->remove(fn);}
+    int ftw_root(std::function<int(const char *fpath)> fn) override {return filesystem->ftw_root(fn);}
+};
+
+TEST_CASE( "LocalAuth cache" ) {
+    printf("\nRun %s\n",  "LocalAuth cache");
+
+    //clean state
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    const size_t CACHE_SIZE = 3 * MO_LocalAuthCacheFileSlots;
+
+    Timestamp now;
+    now.setTime(BASE_TIME);
+
+    DynamicJsonDocument doc (JSON_OBJECT_SIZE(2) + JSON_OBJECT_SIZE(1) + JSON_OBJECT_SIZE(2));
+    JsonObject accepted = doc.createNestedObject("accepted");
+    accepted["status"] = "Accepted";
+    JsonObject expired = doc.createNestedObject("expired");
+    expired["status"] = "Accepted";
+    expired["expiryDate"] = "2022-01-01T00:00:00.000Z";
+
+    AuthorizationCache cache {filesystem, CACHE_SIZE};
+    REQUIRE( cache.load() );
+    REQUIRE( cache.size() == 0 );
+    REQUIRE( cache.getWriteBehindMs() == MO_WAKEUP_MAX_MS );
+
+    for (size_t i = 0; i < CACHE_SIZE; i++) {
+        char idTag [IDTAG_LEN_MAX + 1];
+        sprintf(idTag, "mIdTag%zu", i);
+        REQUIRE( cache.add(idTag, accepted, now) );
+    }
+    REQUIRE( cache.size() == CACHE_SIZE );
+    REQUIRE( cache.get("MIDTAG0") != nullptr ); //case-insensitive; mIdTag0 becomes most recently used
+    REQUIRE( cache.getWriteBehindMs() <= MO_LocalAuthCacheWriteDelay );
+
+    SECTION("LRU eviction") {
+        REQUIRE( cache.add("mIdTagNew", accepted, now) );
+        REQUIRE( cache.size() == CACHE_SIZE );
+        REQUIRE( cache.get("mIdTagNew") != nullptr );
+        REQUIRE( cache.get("mIdTag0") != nullptr );
+        REQUIRE( cache.get("mIdTag1") == nullptr ); //least recently used
+        REQUIRE( cache.get("mIdTag2") != nullptr );
+    }
+
+    SECTION("Evict expired first") {
+        AuthorizationCache smallCache {nullptr, 4};
+        REQUIRE( smallCache.add("mIdTag0", accepted, now) ); //least recently used
+        REQUIRE( smallCache.add("mIdTag1", expired, now) );
+        REQUIRE( smallCache.add("mIdTag2", accepted, now) );
+        REQUIRE( smallCache.add("mIdTag3", accepted, now) );
+
+        REQUIRE( smallCache.add("mIdTagNew", accepted, now) );
+        REQUIRE( smallCache.size() == 4 );
+        REQUIRE( smallCache.get("mIdTag0") != nullptr );
+        REQUIRE( smallCache.get("mIdTag1") == nullptr );
+    }
+
+    SECTION("Write-behind") {
+        //nothing written before flush
+        AuthorizationCache cache2 {filesystem, CACHE_SIZE};
+        REQUIRE( cache2.load() );
+        REQUIRE( cache2.size() == 0 );
+
+        REQUIRE( cache.flush() );
+        REQUIRE( cache.getWriteBehindMs() == MO_WAKEUP_MAX_MS );
+
+        AuthorizationCache cache3 {filesystem, CACHE_SIZE};
+        REQUIRE( cache3.load() );
+        REQUIRE( cache3.size() == CACHE_SIZE );
+        REQUIRE( cache3.get("mIdTag5") != nullptr );
+        REQUIRE( cache3.get("mIdTag5")->getAuthorizationStatus() == AuthorizationStatus::Accepted );
+
+        //LRU order restored: mIdTag0 was added first
+        REQUIRE( cache3.add("mIdTagNew", accepted, now) );
+        REQUIRE( cache3.get("mIdTag0") == nullptr );
+
+        cache.clear();
+        REQUIRE( cache.size() == 0 );
+
+        AuthorizationCache cache4 {filesystem, CACHE_SIZE};
+        REQUIRE( cache4.load() );
+        REQUIRE( cache4.size() == 0 );
+    }
+
+    SECTION("Retry failed write-behind") {
+        auto failingFilesystem = std::make_shared<FailingWritesFilesystemAdapter>(filesystem);
+
+        mocpp_set_timer(custom_timer_cb);
+
+        AuthorizationCache cache2 {failingFilesystem, CACHE_SIZE};
+        REQUIRE( cache2.add("mIdTag0", accepted, now) );
+
+        mtime += MO_LocalAuthCacheWriteDelay;
+        REQUIRE( cache2.getWriteBehindMs() == 0 );
+
+        failingFilesystem->failWrites = true;
+        REQUIRE( !cache2.flush() );
+        REQUIRE( cache2.getWriteBehindMs() < MO_WAKEUP_MAX_MS ); //still dirty
+        REQUIRE( cache2.getWriteBehindMs() == std::min((unsigned long)MO_LocalAuthCacheWriteDelay, (unsigned long)MO_WAKEUP_MAX_MS) ); //retry after the write delay
+
+        failingFilesystem->failWrites = false;
+        REQUIRE( cache2.flush() );
+        REQUIRE( cache2.getWriteBehindMs() == MO_WAKEUP_MAX_MS );
+
+        AuthorizationCache cache3 {filesystem, CACHE_SIZE};
+        REQUIRE( cache3.load() );
+        REQUIRE( cache3.size() == 1 );
+        REQUIRE( cache3.get("mIdTag0") != nullptr );
+    }
+}
+
+TEST_CASE( "LocalAuth paged list benchmark", "[.][benchmark]" ) {
+    printf("\nRun %s\n",  "LocalAuth paged list benchmark");
+
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+
+    const size_t N_LOOKUPS = 10000;
+
+    for (size_t listSize : {1000, 10000, 100000}) {
+        FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+        AuthorizationListPaged authList {filesystem, listSize};
+
+        DynamicJsonDocument fullList (listSize * 256);
+        generateAuthList(fullList.to<JsonArray>(), listSize, false);
+
+        auto t_start = std::chrono::steady_clock::now();
+        REQUIRE( authList.readJson(fullList.as<JsonArray>(), 1, false) );
+        auto t_update = std::chrono::steady_clock::now();
+
+        size_t hits = 0;
+        for (size_t i = 0; i < N_LOOKUPS; i++) {
+            char idTag [IDTAG_LEN_MAX + 1];
+            sprintf(idTag, "mIdTag%zu", (i * 7919) % listSize); //scattered access pattern
+            if (authList.get(idTag)) {
+                hits++;
+            }
+        }
+        auto t_end = std::chrono::steady_clock::now();
+
+        REQUIRE( hits == N_LOOKUPS );
+
+        printf("[benchmark] paged local list with %zu entries: full update %lld ms, lookup %.2f us avg, RAM %zu bytes (in-RAM list: ~%zu bytes)\n",
+                listSize,
+                (long long) std::chrono::duration_cast<std::chrono::milliseconds>(t_update - t_start).count(),
+                (double) std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_update).count() / (double) N_LOOKUPS,
+                authList.getMemoryUsage(),
+                listSize * sizeof(AuthorizationData));
+    }
+
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+}
+
+TEST_CASE( "LocalAuth list merge benchmark", "[.][benchmark]" ) {
+    printf("\nRun %s\n",  "LocalAuth list merge benchmark");
+
+    const size_t LIST_SIZE = 10000;
+    const size_t BATCH_SIZE = 500;
+    const size_t N_BATCHES = 20;
+
+    AuthorizationList authList {2 * LIST_SIZE};
+
+    DynamicJsonDocument fullList (LIST_SIZE * 256);
+    generateAuthList(fullList.to<JsonArray>(), LIST_SIZE, false);
+    REQUIRE( authList.readJson(fullList.as<JsonArray>(), 1, false) );
+
+    long long duration_us = 0;
+    size_t expectedSize = LIST_SIZE;
+
+    for (size_t batch = 0; batch < N_BATCHES; batch++) {
+
+        //every batch updates 250 entries, inserts 200 and removes 50. Unordered and spread across the whole list
+        DynamicJsonDocument diffList (BATCH_SIZE * 192);
+        for (size_t i = 0; i < BATCH_SIZE; i++) {
+            char idTag [IDTAG_LEN_MAX + 1];
+            if (i < 250) {
+                sprintf(idTag, "mIdTag%zu", (i * 7919 + batch) % (LIST_SIZE / 2));
+            } else if (i < 450) {
+                sprintf(idTag, "mIdTag%zu", LIST_SIZE + batch * BATCH_SIZE + i);
+            } else {
+                sprintf(idTag, "mIdTag%zu", LIST_SIZE - 1 - (batch * 50 + i - 450));
+            }
+            diffList[i]["idTag"] = idTag;
+            if (i < 450) {
+                diffList[i]["idTagInfo"]["status"] = "Blocked";
+            }
+        }
+
+        auto t_start = std::chrono::steady_clock::now();
+        REQUIRE( authList.readJson(diffList.as<JsonArray>(), (int) batch + 2, true) );
+        auto t_end = std::chrono::steady_clock::now();
+
+        duration_us += std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count();
+        expectedSize += 150;
+    }
+
+    REQUIRE( authList.size() == expectedSize );
+
+    printf("[benchmark] %zu differential updates of %zu entries into a list of %zu entries: %lld us avg\n",
+            N_BATCHES, BATCH_SIZE, LIST_SIZE, duration_us / (long long) N_BATCHES);
+}
+
 #endif //MO_ENABLE_LOCAL_AUTH
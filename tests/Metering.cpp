@@ -7,9 +7,13 @@
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
 #include <MicroOcpp/Core/Configuration.h>
+#include <MicroOcpp/Model/Metering/MeterValue.h>
+#include <MicroOcpp/Operations/MeterValues.h>
 #include "./catch2/catch.hpp"
 #include "./helpers/testHelper.h"
 
+#include <chrono>
+
 #define BASE_TIME "2023-01-01T00:00:00.000Z"
 
 using namespace MicroOcpp;
@@ -374,5 +378,125 @@ TEST_CASE("Metering") {
         REQUIRE(checkProcessed);
     }
 
+    SECTION("Batch MeterValues while offline") {
+
+        Timestamp base;
+        base.setTime(BASE_TIME);
+
+        addMeterValueInput([base] () {
+            //simulate 3600W consumption
+            return getOcppContext()->getModel().getClock().now() - base;
+        }, "Energy.Active.Import.Register");
+
+        auto MeterValuesSampledDataString = declareConfiguration<const char*>("MeterValuesSampledData","", CONFIGURATION_FN);
+        MeterValuesSampledDataString->setString("Energy.Active.Import.Register");
+
+        auto MeterValueSampleIntervalInt = declareConfiguration<int>("MeterValueSampleInterval",0, CONFIGURATION_FN);
+        MeterValueSampleIntervalInt->setInt(10);
+
+        auto MeterValueCacheSizeInt = declareConfiguration<int>(MO_CONFIG_EXT_PREFIX "MeterValueCacheSize", 0, CONFIGURATION_FN);
+        MeterValueCacheSizeInt->setInt(1);
+
+        auto MeterValuesBatchMaxSizeInt = declareConfiguration<int>(MO_CONFIG_EXT_PREFIX "MeterValuesBatchMaxSize", 0, CONFIGURATION_FN);
+        MeterValuesBatchMaxSizeInt->setInt(4096);
+
+        unsigned int nMsgs = 0;
+        size_t nMeterValue = 0;
+
+        setOnReceiveRequest("MeterValues", [&nMsgs, &nMeterValue] (JsonObject payload) {
+            nMsgs++;
+            nMeterValue += payload["meterValue"].as<JsonArray>().size();
+
+            //properties with OCPP default values are omitted
+            REQUIRE(!payload["meterValue"][0]["sampledValue"][0].containsKey("measurand"));
+            REQUIRE(!payload["meterValue"][0]["sampledValue"][0].containsKey("context"));
+            REQUIRE(payload["meterValue"][0]["sampledValue"][0].containsKey("value"));
+        });
+
+        loop();
+
+        beginTransaction_authorized("mIdTag");
+
+        loop();
+
+        loopback.setConnected(false);
+
+        auto trackMtime = mtime;
+
+        for (unsigned int i = 1; i <= 5; i++) {
+            mtime = trackMtime + i * 10 * 1000;
+            loop();
+        }
+
+        REQUIRE(nMsgs == 0);
+
+        loopback.setConnected(true);
+
+        loop();
+
+        REQUIRE(nMsgs == 1);
+        REQUIRE(nMeterValue == 5);
+
+        endTransaction();
+
+        loop();
+
+        MeterValuesBatchMaxSizeInt->setInt(0);
+    }
+
     mocpp_deinitialize();
 }
+
+TEST_CASE("MeterValues serialization benchmark", "[.][benchmark]") {
+    printf("\nRun %s\n",  "MeterValues serialization benchmark");
+
+    const size_t N_METERVALUES = 1000;
+    const size_t N_MEASURANDS = 12;
+
+    const char *measurands [N_MEASURANDS] = {
+        "Energy.Active.Import.Register", "Energy.Reactive.Import.Register", "Power.Active.Import", "Power.Reactive.Import",
+        "Current.Import", "Current.Offered", "Voltage", "Frequency",
+        "Power.Offered", "SoC", "Temperature", "Power.Factor"};
+
+    std::vector<std::unique_ptr<SampledValueSampler>> samplers;
+    for (size_t i = 0; i < N_MEASURANDS; i++) {
+        SampledValueProperties properties;
+        properties.setMeasurand(measurands[i]);
+        properties.setUnit("W");
+        samplers.emplace_back(new SampledValueSamplerConcrete<float, SampledValueDeSerializer<float>>(
+                properties,
+                [i] (ReadingContext) {return 1234.5678f * (float) (i + 1);}));
+    }
+
+    Timestamp timestamp;
+    timestamp.setTime(BASE_TIME);
+
+    std::vector<std::unique_ptr<MeterValue>> meterValue;
+    for (size_t i = 0; i < N_METERVALUES; i++) {
+        auto mv = std::unique_ptr<MeterValue>(new MeterValue(timestamp + (int) i));
+        for (auto& sampler : samplers) {
+            mv->addSampledValue(sampler->takeValue(ReadingContext::SamplePeriodic));
+        }
+        meterValue.push_back(std::move(mv));
+    }
+
+    Ocpp16::MeterValues meterValues {std::move(meterValue), 1};
+
+    auto t_start = std::chrono::steady_clock::now();
+
+    auto doc = meterValues.createReq();
+
+    std::string out;
+    serializeJson(*doc, out);
+
+    auto t_end = std::chrono::steady_clock::now();
+
+    printf("[benchmark] serialized %zu MeterValues with %zu measurands each: %zu bytes, JSON capacity %zu bytes, %lld us\n",
+            N_METERVALUES, N_MEASURANDS, out.length(), doc->capacity(),
+            (long long) std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count());
+
+    REQUIRE(!doc->overflowed());
+    REQUIRE((*doc)["meterValue"].as<JsonArray>().size() == N_METERVALUES);
+    REQUIRE((*doc)["meterValue"][N_METERVALUES - 1]["sampledValue"].as<JsonArray>().size() == N_MEASURANDS);
+    REQUIRE(!strcmp((*doc)["meterValue"][0]["sampledValue"][0]["value"] | "", "1234.57"));
+}
@@ -0,0 +1,229 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Configuration.h>
+#include <MicroOcpp/Core/FilesystemAdapter.h>
+#include <MicroOcpp/Core/FilesystemUtils.h>
+#include <MicroOcpp/Model/Model.h>
+#include <MicroOcpp/Model/SmartCharging/SmartChargingService.h>
+#include "./catch2/catch.hpp"
+#include "./helpers/testHelper.h"
+#include "./helpers/simHelper.h"
+
+#include <chrono>
+#include <vector>
+
+#define BASE_TIME "2023-01-01T00:00:00.000Z"
+
+#define SIM_MINUTE (60UL * 1000UL)
+#define SIM_HOUR (60UL * SIM_MINUTE)
+#define SIM_DAY (24UL * SIM_HOUR)
+
+#define SCPROFILE_RECURRING_DAY_2H_16A_20A "{\"connectorId\":0,\"csChargingProfiles\":{\"chargingProfileId\":7,\"stackLevel\":0,\"chargingProfilePurpose\":\"ChargePointMaxProfile\",\"chargingProfileKind\":\"Recurring\",\"recurrencyKind\":\"Daily\", \"chargingSchedule\":{\"duration\":7200,\"startSchedule\":\"2023-01-01T00:00:00.000Z\",\"chargingRateUnit\":\"A\",\"chargingSchedulePeriod\":[{\"startPeriod\":0,\"limit\":16,\"numberPhases\":3},{\"startPeriod\":3600,\"limit\":20,\"numberPhases\":3}]}}}"
+
+using namespace MicroOcpp;
+
+namespace {
+
+void configureMetering() {
+    declareConfiguration<const char*>("MeterValuesSampledData", "")->setString("Energy.Active.Import.Register");
+    declareConfiguration<int>("MeterValueSampleInterval", 60)->setInt(60);
+    declareConfiguration<int>("ClockAlignedDataInterval", 0)->setInt(0);
+    declareConfiguration<int>(MO_CONFIG_EXT_PREFIX "MeterValueCacheSize", 1)->setInt(1);
+    declareConfiguration<int>(MO_CONFIG_EXT_PREFIX "MeterValuesBatchMaxSize", 0)->setInt(0);
+    configuration_save();
+}
+
+} //end anonymous namespace
+
+TEST_CASE( "Simulation" ) {
+    printf("\nRun %s\n",  "Simulation");
+
+    //clean state
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    SimCsms csms;
+    mocpp_initialize(csms, ChargerCredentials("test-runner1234"));
+
+    mocpp_set_timer(custom_timer_cb);
+
+    getOcppContext()->getModel().getClock().setTime(BASE_TIME);
+
+    configureMetering();
+
+    Simulation sim;
+    sim.runFor(10000);
+    REQUIRE( csms.getRequestCount("BootNotification") == 1 );
+
+    SECTION("Charging session over a day") {
+
+        bool plugged = false;
+        int energy = 0;
+        setConnectorPluggedInput([&plugged] () {return plugged;});
+        setEnergyMeterInput([&energy] () {return energy;});
+
+        sim.scheduleIn(SIM_MINUTE / 2, [&plugged] () {
+            plugged = true;
+            beginTransaction_authorized("mIdTag");
+        });
+        sim.scheduleIn(SIM_MINUTE / 2 + SIM_DAY, [&plugged] () {
+            endTransaction();
+            plugged = false;
+        });
+
+        //energy increases in 10 minute steps. The charger only sees it when it samples
+        for (unsigned long t = 10 * SIM_MINUTE; t < SIM_DAY; t += 10 * SIM_MINUTE) {
+            sim.scheduleIn(t, [&energy] () {energy += 1000;});
+        }
+
+        unsigned long loopsBefore = sim.getLoopCount();
+
+        sim.runFor(SIM_DAY + SIM_HOUR);
+
+        REQUIRE( csms.getRequestCount("StartTransaction") == 1 );
+        REQUIRE( csms.getRequestCount("StopTransaction") == 1 );
+        REQUIRE( csms.getRequestCount("MeterValues") >= 24 * 60 - 1 );
+        REQUIRE( csms.getRequestCount("MeterValues") <= 24 * 60 + 1 );
+        REQUIRE( !isTransactionRunning() );
+
+        //advancing in fixed steps of 100 ms would take 900000 loop calls
+        REQUIRE( sim.getLoopCount() - loopsBefore < 20000 );
+    }
+
+    SECTION("Recurring charging profile over a week") {
+
+        struct LimitChange {
+            unsigned long t;
+            float current;
+        };
+        std::vector<LimitChange> changes;
+
+        setSmartChargingOutput([&changes] (float, float current, int) {
+            if (changes.empty() && current < 0.f) {
+                return; //no limit before the profile arrives
+            }
+            if (changes.empty() || changes.back().current != current) {
+                changes.push_back({mtime, current});
+            }
+        });
+
+        getOcppContext()->getModel().getSmartChargingService()->clearChargingProfile([] (int, int, ChargingProfilePurposeType, int) {
+            return true;
+        });
+
+        unsigned long t_base = mtime; //BASE_TIME was set 10s ago. The schedule starts at 00:00:00 of each day
+        t_base -= 10000;
+
+        csms.sendCall("SetChargingProfile", SCPROFILE_RECURRING_DAY_2H_16A_20A);
+
+        sim.runFor(7 * SIM_DAY - 20000);
+
+        REQUIRE( csms.getResponseCount() == 1 );
+
+        //per day: 16A at 00:00, 20A at 01:00 and no limit from 02:00
+        std::vector<LimitChange> expected;
+        expected.push_back({0, 16.f});
+        for (unsigned long day = 0; day < 7; day++) {
+            if (day > 0) {
+                expected.push_back({day * SIM_DAY, 16.f});
+            }
+            expected.push_back({day * SIM_DAY + SIM_HOUR, 20.f});
+            expected.push_back({day * SIM_DAY + 2 * SIM_HOUR, -1.f});
+        }
+
+        REQUIRE( changes.size() == expected.size() );
+        for (size_t i = 0; i < changes.size(); i++) {
+            if (i > 0) {
+                //first limit is applied when the profile arrives
+                REQUIRE( changes[i].t - t_base >= expected[i].t );
+                REQUIRE( changes[i].t - t_base < expected[i].t + 1000 );
+            }
+            if (expected[i].current < 0.f) {
+                REQUIRE( changes[i].current < 0.f );
+            } else {
+                REQUIRE( changes[i].current > expected[i].current - 0.01f );
+                REQUIRE( changes[i].current < expected[i].current + 0.01f );
+            }
+        }
+
+        //MO wakes up at least every MO_WAKEUP_MAX_MS. Advancing in fixed steps of 100 ms would take 6048000 loop calls
+        REQUIRE( sim.getLoopCount() < 7 * 24 * 60 * 4 );
+    }
+
+    mocpp_deinitialize();
+}
+
+TEST_CASE( "Simulation benchmark", "[.][benchmark]" ) {
+    printf("\nRun %s\n",  "Simulation benchmark");
+
+    const unsigned int N_SESSIONS = 2000; //per connector
+    const unsigned long SESSION_DURATION = 30 * SIM_MINUTE;
+    const unsigned long SESSION_GAP = 5 * SIM_MINUTE;
+    const unsigned int N_CONNECTORS = MO_NUMCONNECTORS - 1;
+
+    auto filesystem = makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail);
+    FilesystemUtils::remove_if(filesystem, [] (const char*) {return true;});
+
+    SimCsms csms (50);
+    mocpp_initialize(csms, ChargerCredentials("test-runner1234"));
+
+    mocpp_set_timer(custom_timer_cb);
+
+    getOcppContext()->getModel().getClock().setTime(BASE_TIME);
+
+    configureMetering();
+
+    Simulation sim;
+    sim.runFor(10000);
+
+    bool plugged [MO_NUMCONNECTORS] = {false};
+    int energy [MO_NUMCONNECTORS] = {0};
+
+    for (unsigned int connectorId = 1; connectorId <= N_CONNECTORS; connectorId++) {
+        setConnectorPluggedInput([&plugged, connectorId] () {return plugged[connectorId];}, connectorId);
+        setEnergyMeterInput([&energy, connectorId] () {return energy[connectorId];}, connectorId);
+
+        for (unsigned int i = 0; i < N_SESSIONS; i++) {
+            //shift the sessions of the connectors against each other
+            unsigned long t_begin = i * (SESSION_DURATION + SESSION_GAP) + connectorId * 7 * SIM_MINUTE;
+            sim.scheduleIn(t_begin, [&plugged, connectorId] () {
+                plugged[connectorId] = true;
+                beginTransaction_authorized("mIdTag", nullptr, connectorId);
+            });
+            sim.scheduleIn(t_begin + SESSION_DURATION / 2, [&energy, connectorId] () {
+                energy[connectorId] += 5000;
+            });
+            sim.scheduleIn(t_begin + SESSION_DURATION, [&plugged, &energy, connectorId] () {
+                energy[connectorId] += 5000;
+                endTransaction(nullptr, nullptr, connectorId);
+                plugged[connectorId] = false;
+            });
+        }
+    }
+
+    unsigned long simDuration = N_SESSIONS * (SESSION_DURATION + SESSION_GAP) + SIM_HOUR;
+
+    auto t_start = std::chrono::steady_clock::now();
+    sim.runFor(simDuration);
+    auto t_end = std::chrono::steady_clock::now();
+
+    REQUIRE( csms.getRequestCount("StartTransaction") == N_SESSIONS * N_CONNECTORS );
+    REQUIRE( csms.getRequestCount("StopTransaction") == N_SESSIONS * N_CONNECTORS );
+
+    auto us = (long long) std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count();
+
+    printf("[benchmark] %u sessions on %u connectors over %lu simulated days: %lld ms, %lld sessions/s, %lu loop calls, %u MeterValues\n",
+            N_SESSIONS * N_CONNECTORS,
+            N_CONNECTORS,
+            simDuration / SIM_DAY,
+            us / 1000,
+            us > 0 ? (long long) N_SESSIONS * N_CONNECTORS * 1000000LL / us : 0LL,
+            sim.getLoopCount(),
+            csms.getRequestCount("MeterValues"));
+
+    mocpp_deinitialize();
+}
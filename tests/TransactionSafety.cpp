@@ -6,6 +6,7 @@
 #include <MicroOcpp/Core/Connection.h>
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
+#include <MicroOcpp/Model/Transactions/TransactionStore.h>
 #include <MicroOcpp/Core/Configuration.h>
 #include <MicroOcpp/Operations/BootNotification.h>
 #include <MicroOcpp/Operations/StatusNotification.h>
@@ -13,8 +14,22 @@
 #include "./catch2/catch.hpp"
 #include "./helpers/testHelper.h"
 
+#include <chrono>
+#include <vector>
+
 using namespace MicroOcpp;
 
+namespace MicroOcpp {
+
+class TransactionStoreInspector {
+public:
+    static size_t getPoolFallbackCount(TransactionStore& txStore, unsigned int connectorId) {
+        return txStore.getConnectorStore(connectorId)->getPool().getFallbackCount();
+    }
+};
+
+} //end namespace MicroOcpp
+
 
 TEST_CASE( "Transaction safety" ) {
     printf("\nRun %s\n",  "Transaction safety");
@@ -96,4 +111,117 @@ TEST_CASE( "Transaction safety" ) {
         mocpp_deinitialize();
     }
 
+    SECTION("Transaction index") {
+        loop();
+        startTransaction("mIdTag");
+        loop();
+        REQUIRE(getTransaction());
+        auto txNr = getTransaction()->getTxNr();
+        stopTransaction();
+        loop();
+
+        uint8_t txState = 0;
+        REQUIRE(getOcppContext()->getModel().getTransactionStore()->getTransactionState(1, txNr, txState));
+        REQUIRE((txState & TransactionIndexEntry::Completed));
+        REQUIRE(!(txState & TransactionIndexEntry::Silent));
+
+        //index is restored after reboot
+        mocpp_deinitialize();
+        mocpp_initialize(loopback);
+        txState = 0;
+        REQUIRE(getOcppContext()->getModel().getTransactionStore()->getTransactionState(1, txNr, txState));
+        REQUIRE((txState & TransactionIndexEntry::Completed));
+
+        //removed tx is not indexed anymore
+        REQUIRE(getOcppContext()->getModel().getTransactionStore()->remove(1, txNr));
+        REQUIRE(!getOcppContext()->getModel().getTransactionStore()->getTransactionState(1, txNr, txState));
+
+        mocpp_deinitialize();
+    }
+
+}
+
+TEST_CASE( "Transaction pool" ) {
+    printf("\nRun %s\n",  "Transaction pool");
+
+    //tx objects only, without filesystem
+    TransactionStore txStore {2, nullptr};
+
+    //fill the pool
+    std::vector<std::shared_ptr<ITransaction>> txs;
+    for (unsigned int txNr = 0; txNr < MO_TX_POOL_SIZE; txNr++) {
+        txs.push_back(txStore.createTransaction(1, txNr));
+        REQUIRE( txs.back() != nullptr );
+    }
+    REQUIRE( TransactionStoreInspector::getPoolFallbackCount(txStore, 1) == 0 );
+
+    for (unsigned int txNr = 0; txNr < MO_TX_POOL_SIZE; txNr++) {
+        REQUIRE( txStore.getTransaction(1, txNr) == txs[txNr] );
+    }
+
+    //pool exhausted: the next tx is allocated on the heap
+    auto overflow = txStore.createTransaction(1, MO_TX_POOL_SIZE);
+    REQUIRE( overflow != nullptr );
+    REQUIRE( TransactionStoreInspector::getPoolFallbackCount(txStore, 1) == 1 );
+    REQUIRE( txStore.getTransaction(1, MO_TX_POOL_SIZE) == overflow );
+
+    //release all txs. Their slots are reused, even though the cache still references them
+    txs.clear();
+    overflow.reset();
+
+    for (unsigned int txNr = 100; txNr < 100 + MO_TX_POOL_SIZE; txNr++) {
+        txs.push_back(txStore.createTransaction(1, txNr));
+        REQUIRE( txs.back() != nullptr );
+    }
+    REQUIRE( TransactionStoreInspector::getPoolFallbackCount(txStore, 1) == 1 );
+
+    //released txs are evicted from the cache. Without filesystem, they cannot be reloaded
+    REQUIRE( txStore.getTransaction(1, 0) == nullptr );
+    REQUIRE( txStore.getTransaction(1, MO_TX_POOL_SIZE) == nullptr );
+    for (unsigned int i = 0; i < MO_TX_POOL_SIZE; i++) {
+        REQUIRE( txStore.getTransaction(1, 100 + i) == txs[i] );
+        REQUIRE( txs[i]->getTxNr() == 100 + i );
+    }
+
+    //each connector has its own pool
+    auto txConnector0 = txStore.createTransaction(0, 0);
+    REQUIRE( txConnector0 != nullptr );
+    REQUIRE( TransactionStoreInspector::getPoolFallbackCount(txStore, 0) == 0 );
+    REQUIRE( txStore.getTransaction(1, 0) == nullptr );
+}
+
+TEST_CASE( "Transaction pool benchmark", "[.][benchmark]" ) {
+    printf("\nRun %s\n",  "Transaction pool benchmark");
+
+    //tx objects only, without filesystem
+    TransactionStore txStore {2, nullptr};
+
+    const unsigned int N_SESSIONS = 10000;
+
+    std::shared_ptr<ITransaction> front; //previous tx, e.g. waiting for the StopTx confirmation
+
+    auto t_start = std::chrono::steady_clock::now();
+
+    for (unsigned int txNr = 0; txNr < N_SESSIONS; txNr++) {
+        auto tx = txStore.createTransaction(1, txNr);
+        REQUIRE( tx != nullptr );
+
+        //Connector and operations look up the tx several times during a session
+        for (int i = 0; i < 5; i++) {
+            REQUIRE( txStore.getTransaction(1, txNr) == tx );
+        }
+
+        front = std::move(tx);
+    }
+
+    auto t_end = std::chrono::steady_clock::now();
+
+    printf("[benchmark] %u tx sessions: %lld us, %zu of %u tx allocations outside of the pool (pool size %u)\n",
+            N_SESSIONS,
+            (long long) std::chrono::duration_cast<std::chrono::microseconds>(t_end - t_start).count(),
+            TransactionStoreInspector::getPoolFallbackCount(txStore, 1),
+            N_SESSIONS,
+            (unsigned int) MO_TX_POOL_SIZE);
+
+    REQUIRE( TransactionStoreInspector::getPoolFallbackCount(txStore, 1) == 0 );
 }
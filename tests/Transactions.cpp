@@ -11,6 +11,8 @@
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Model/Model.h>
 #include <MicroOcpp/Model/Transactions/TransactionService.h>
+#include <MicroOcpp/Model/Metering/MeterValue.h>
+#include <MicroOcpp/Operations/TransactionEvent.h>
 #include <MicroOcpp/Operations/CustomOperation.h>
 #include <MicroOcpp/Debug.h>
 #include "./catch2/catch.hpp"
@@ -101,6 +103,201 @@ TEST_CASE( "Transactions" ) {
                   context->getModel().getTransactionService()->getEvse(1)->getTransaction()->stopped));
     }
 
+    SECTION("TransactionEvent queue") {
+
+        setConnectorPluggedInput([] () {return true;});
+        context->getModel().getTransactionService()->getEvse(1)->beginAuthorization("mIdToken");
+        setEvReadyInput([] () {return true;});
+        bool evseReady = true;
+        setEvseReadyInput([&evseReady] () {return evseReady;});
+
+        loop();
+
+        REQUIRE( context->getModel().getTransactionService()->getEvse(1)->getTransaction()->getStartSync().isConfirmed() );
+
+        //create Updated events while offline
+        loopback.setOnline(false);
+
+        const size_t nEvents = 6;
+        for (size_t i = 0; i < nEvents; i++) {
+            evseReady = !evseReady; //ChargingStateChanged
+            loop();
+        }
+
+        size_t queued = context->getModel().getTransactionService()->getEvse(1)->getTransactionEventQueue()->size();
+        REQUIRE( queued >= nEvents );
+
+        //reboot and replay
+        mocpp_deinitialize();
+
+        mocpp_initialize(loopback,
+                ChargerCredentials("test-runner1234"),
+                makeDefaultFilesystemAdapter(FilesystemOpt::Use_Mount_FormatOnFail),
+                false,
+                VER_2_0_1);
+        mocpp_set_timer(custom_timer_cb);
+
+        REQUIRE( getOcppContext()->getModel().getTransactionService()->getEvse(1)->getTransactionEventQueue()->size() == queued );
+
+        std::vector<unsigned int> seqNos;
+        getOcppContext()->getOperationRegistry().setOnRequest("TransactionEvent", [&seqNos] (JsonObject payload) {
+            if (!strcmp(payload["eventType"] | "", "Updated")) {
+                seqNos.push_back(payload["seqNo"] | 0U);
+            }
+        });
+
+        loopback.setOnline(true);
+
+        for (size_t i = 0; i < 5; i++) {
+            mtime += 3600 * 1000; //pass retry interval
+            loop();
+        }
+
+        REQUIRE( getOcppContext()->getModel().getTransactionService()->getEvse(1)->getTransactionEventQueue()->size() == 0 );
+
+        //all events arrived in seqNo order without gaps
+        REQUIRE( seqNos.size() >= queued );
+        for (size_t i = 1; i < seqNos.size(); i++) {
+            REQUIRE( seqNos[i] == seqNos[i - 1] + 1 );
+        }
+
+        context = getOcppContext();
+    }
+
+    SECTION("TransactionEvent queue full") {
+
+        setConnectorPluggedInput([] () {return true;});
+        context->getModel().getTransactionService()->getEvse(1)->beginAuthorization("mIdToken");
+        setEvReadyInput([] () {return true;});
+        bool evseReady = true;
+        setEvseReadyInput([&evseReady] () {return evseReady;});
+
+        loop();
+
+        REQUIRE( context->getModel().getTransactionService()->getEvse(1)->getTransaction()->getStartSync().isConfirmed() );
+
+        std::vector<unsigned int> seqNos;
+        checkMsg.setOnRequest("TransactionEvent", [&seqNos] (JsonObject payload) {
+            if (!strcmp(payload["eventType"] | "", "Updated")) {
+                seqNos.push_back(payload["seqNo"] | 0U);
+            }
+        });
+
+        //exceed the queue capacity while offline
+        loopback.setOnline(false);
+
+        for (size_t i = 0; i < MO_TXEVENTRECORD_SIZE + 3; i++) {
+            evseReady = !evseReady; //ChargingStateChanged
+            loop();
+        }
+
+        auto txEventQueue = context->getModel().getTransactionService()->getEvse(1)->getTransactionEventQueue();
+        REQUIRE( txEventQueue->size() == MO_TXEVENTRECORD_SIZE );
+
+        //queued events are kept and the held back change is sent after them
+        loopback.setOnline(true);
+
+        for (size_t i = 0; i < 5; i++) {
+            mtime += 3600 * 1000; //pass retry interval
+            loop();
+        }
+
+        REQUIRE( txEventQueue->size() == 0 );
+
+        REQUIRE( seqNos.size() > MO_TXEVENTRECORD_SIZE );
+        for (size_t i = 1; i < seqNos.size(); i++) {
+            REQUIRE( seqNos[i] == seqNos[i - 1] + 1 );
+        }
+    }
+
+    SECTION("TransactionEvent with large meter data") {
+
+        setConnectorPluggedInput([] () {return true;});
+        context->getModel().getTransactionService()->getEvse(1)->beginAuthorization("mIdToken");
+        setEvReadyInput([] () {return true;});
+        setEvseReadyInput([] () {return true;});
+
+        loop();
+
+        auto transaction = std::static_pointer_cast<Ocpp201::Transaction>(context->getModel().getTransactionService()->getEvse(1)->getTransaction());
+        REQUIRE( transaction );
+
+        SampledValueProperties properties;
+        properties.setMeasurand("Energy.Active.Import.Register");
+        properties.setUnit("Wh");
+
+        Timestamp timestamp;
+        timestamp.setTime(BASE_TIME);
+
+        int32_t nextValue = 0;
+        auto makeMeterValue = [&properties, &timestamp, &nextValue] (size_t nSamples) {
+            auto mv = std::unique_ptr<MeterValue>(new MeterValue(timestamp));
+            for (size_t i = 0; i < nSamples; i++) {
+                mv->addSampledValue(std::unique_ptr<SampledValue>(new SampledValueConcrete<int32_t, SampledValueDeSerializer<int32_t>>(
+                        properties, ReadingContext::SamplePeriodic, std::move(nextValue++))));
+            }
+            return mv;
+        };
+
+        //exactly sized payload with 100+ sampled values
+        const size_t nMeterValues = 120;
+
+        auto txEvent = std::make_shared<Ocpp201::TransactionEventData>(transaction, 1);
+        txEvent->eventType = Ocpp201::TransactionEventData::Type::Updated;
+        txEvent->triggerReason = Ocpp201::TransactionEventTriggerReason::MeterValuePeriodic;
+        for (size_t i = 0; i < nMeterValues; i++) {
+            txEvent->meterValue.push_back(makeMeterValue(1));
+        }
+        txEvent->meterValue.push_back(makeMeterValue(nMeterValues));
+
+        Ocpp201::TransactionEvent txEventOp {context->getModel(), txEvent};
+        auto req = txEventOp.createReq();
+        REQUIRE( req );
+        REQUIRE( !req->overflowed() );
+
+        JsonArray meterValueJson = (*req)["meterValue"];
+        REQUIRE( meterValueJson.size() == nMeterValues + 1 );
+        REQUIRE( meterValueJson[nMeterValues]["sampledValue"].size() == nMeterValues );
+        REQUIRE( meterValueJson[nMeterValues]["sampledValue"][nMeterValues - 1]["value"] == nextValue - 1 );
+
+        //split into chunks which fit into the frame limit and keep the order
+        const size_t maxSize = 1024;
+
+        nextValue = 0;
+        std::vector<std::unique_ptr<MeterValue>> meterValue;
+        for (size_t i = 0; i < nMeterValues; i++) {
+            meterValue.push_back(makeMeterValue(1));
+        }
+        meterValue.push_back(makeMeterValue(nMeterValues));
+
+        auto chunks = Ocpp201::TransactionEvent::splitMeterValue(std::move(meterValue), maxSize);
+        REQUIRE( chunks.size() > 1 );
+
+        int32_t expectedValue = 0;
+        for (auto& chunk : chunks) {
+            REQUIRE( !chunk.empty() );
+
+            size_t capacity = JSON_ARRAY_SIZE(chunk.size());
+            for (auto& mv : chunk) {
+                capacity += mv->getJsonCapacity(VER_2_0_1);
+            }
+            DynamicJsonDocument chunkJson {capacity};
+            JsonArray chunkArray = chunkJson.to<JsonArray>();
+            for (auto& mv : chunk) {
+                REQUIRE( mv->toJson(chunkArray.createNestedObject(), VER_2_0_1) );
+            }
+            REQUIRE( measureJson(chunkJson) <= maxSize );
+
+            for (JsonObject mv : chunkArray) {
+                for (JsonObject sample : mv["sampledValue"].as<JsonArray>()) {
+                    REQUIRE( sample["value"] == expectedValue );
+                    expectedValue++;
+                }
+            }
+        }
+        REQUIRE( expectedValue == nextValue );
+    }
+
     mocpp_deinitialize();
 }
 
@@ -17,6 +17,7 @@
 
 #include <MicroOcpp/Core/Context.h>
 #include <MicroOcpp/Operations/CustomOperation.h>
+#include <MicroOcpp/Core/Request.h>
 
 using namespace MicroOcpp;
 
@@ -263,6 +264,139 @@ TEST_CASE( "Variable" ) {
     }
 #endif
 
+    SECTION("Variable pool") {
+
+        auto pool = std::make_shared<VariablePool>(256);
+        auto container = makeVariableContainerVolatile(MO_VARIABLE_VOLATILE "/pooled", true, pool);
+
+        //more variables than fit into the pool. The remaining ones are allocated on the heap
+        std::vector<std::shared_ptr<Variable>> variables;
+        for (int i = 0; i < 10; i++) {
+            auto variable = container->createVariable(Variable::InternalDataType::String, Variable::AttributeTypeSet());
+            REQUIRE( variable != nullptr );
+            variable->setString("mValue");
+            variables.push_back(variable);
+        }
+
+        REQUIRE( pool->getUsed() > 0 );
+        REQUIRE( pool->getUsed() <= pool->getCapacity() );
+        REQUIRE( pool->contains(variables.front().get()) );
+        REQUIRE( !pool->contains(variables.back().get()) );
+
+        //pool stays valid as long as a Variable in it lives
+        container.reset();
+        pool.reset();
+        REQUIRE( !strcmp(variables.front()->getString(), "mValue") );
+    }
+
+    SECTION("Indexed lookup") {
+
+        mocpp_initialize(loopback, ChargerCredentials("test-runner1234"), filesystem, false, VER_2_0_1);
+        auto vs = getOcppContext()->getModel().getVariableService();
+
+        auto cPlain = vs->declareVariable<int>("mComponent", "cInt", 1, MO_VARIABLE_VOLATILE);
+        auto cInstance = vs->declareVariable<int>("mComponent", "cInt", 2, MO_VARIABLE_VOLATILE, Variable::Mutability::ReadWrite, "mInstance");
+        auto cEvse = vs->declareVariable<int>(ComponentId("mComponent", EvseId(1)), "cInt", 3, MO_VARIABLE_VOLATILE);
+
+        Variable *result = nullptr;
+        REQUIRE( vs->getVariable(Variable::AttributeType::Actual, "mComponent", "cInt", nullptr, &result) == GetVariableStatus::Accepted );
+        REQUIRE( result == cPlain.get() );
+        REQUIRE( vs->getVariable(Variable::AttributeType::Actual, "mComponent", "cInt", "mInstance", &result) == GetVariableStatus::Accepted );
+        REQUIRE( result == cInstance.get() );
+        REQUIRE( vs->getVariable(Variable::AttributeType::Actual, ComponentId("mComponent", EvseId(1)), "cInt", nullptr, &result) == GetVariableStatus::Accepted );
+        REQUIRE( result == cEvse.get() );
+        REQUIRE( vs->getVariable(Variable::AttributeType::Actual, "mComponent", "cUnknown", nullptr, &result) == GetVariableStatus::UnknownVariable );
+        REQUIRE( vs->getVariable(Variable::AttributeType::Actual, "mUnknown", "cInt", nullptr, &result) == GetVariableStatus::UnknownComponent );
+
+        REQUIRE( vs->setVariable(Variable::AttributeType::Actual, "5", "mComponent", "cInt", "mInstance") == SetVariableStatus::Accepted );
+        REQUIRE( cInstance->getInt() == 5 );
+        REQUIRE( cPlain->getInt() == 1 );
+
+        //validators apply to all instances, also when registered after the declaration
+        vs->registerValidator<int>("mComponent", "cInt", [] (int v) {return v < 10;});
+        REQUIRE( vs->setVariable(Variable::AttributeType::Actual, "50", "mComponent", "cInt", "mInstance") == SetVariableStatus::Rejected );
+        REQUIRE( vs->setVariable(Variable::AttributeType::Actual, "7", "mComponent", "cInt", nullptr) == SetVariableStatus::Accepted );
+        REQUIRE( cPlain->getInt() == 7 );
+
+        vs->registerValidator<int>("mComponent", "cLate", [] (int v) {return v > 10;});
+        vs->declareVariable<int>("mComponent", "cLate", 11, MO_VARIABLE_VOLATILE);
+        REQUIRE( vs->setVariable(Variable::AttributeType::Actual, "7", "mComponent", "cLate", nullptr) == SetVariableStatus::Rejected );
+
+        mocpp_deinitialize();
+    }
+
+    SECTION("GetBaseReport pagination") {
+
+        mocpp_initialize(loopback, ChargerCredentials("test-runner1234"), filesystem, false, VER_2_0_1);
+        auto vs = getOcppContext()->getModel().getVariableService();
+
+        //enough variables for several pages
+        const size_t N_VARS = 200;
+        std::vector<std::string> names; //names need to outlive the VariableService
+        names.reserve(N_VARS);
+        std::string value (100, 'x');
+        for (size_t i = 0; i < N_VARS; i++) {
+            names.push_back(std::string("cVar") + std::to_string(i));
+            vs->declareVariable<const char*>("mComponent", names.back().c_str(), value.c_str(), MO_VARIABLE_VOLATILE "/report");
+        }
+
+        size_t nPages = 0;
+        size_t nReported = 0;
+        bool tbc = true;
+        bool seqNoValid = true;
+
+        getOcppContext()->getOperationRegistry().registerOperation("NotifyReport", [&] () {
+            return new Ocpp16::CustomOperation("NotifyReport",
+                [&] (JsonObject payload) {
+                    //process req
+                    if ((payload["seqNo"] | -1) != (int) nPages || !tbc) {
+                        seqNoValid = false;
+                    }
+                    REQUIRE( (payload["requestId"] | -1) == 1 );
+                    REQUIRE( measureJson(payload["reportData"]) <= MO_REPORT_PAGE_SIZE + 2 );
+                    nPages++;
+                    tbc = payload["tbc"] | false;
+                    for (JsonObject reportData : payload["reportData"].as<JsonArray>()) {
+                        if (!strcmp(reportData["component"]["name"] | "_Undefined", "mComponent")) {
+                            nReported++;
+                        }
+                    }
+                },
+                [] () {
+                    //create conf
+                    return createEmptyDocument();
+                });});
+
+        std::string status;
+
+        getOcppContext()->initiateRequest(makeRequest(new Ocpp16::CustomOperation(
+                "GetBaseReport",
+                [] () {
+                    //create req
+                    auto doc = std::unique_ptr<DynamicJsonDocument>(new DynamicJsonDocument(JSON_OBJECT_SIZE(2)));
+                    auto payload = doc->to<JsonObject>();
+                    payload["requestId"] = 1;
+                    payload["reportBase"] = "FullInventory";
+                    return doc;},
+                [&status] (JsonObject payload) {
+                    //receive conf
+                    status = payload["status"] | "_Undefined";
+                }
+        )));
+
+        for (size_t i = 0; i < 100 && tbc; i++) {
+            loop();
+        }
+
+        REQUIRE( status == "Accepted" );
+        REQUIRE( !tbc );
+        REQUIRE( seqNoValid );
+        REQUIRE( nPages > 1 );
+        REQUIRE( nReported == N_VARS );
+
+        mocpp_deinitialize();
+    }
+
 #if 0
     SECTION("GetVariables") {
 
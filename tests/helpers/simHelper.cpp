@@ -0,0 +1,180 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#include "simHelper.h"
+#include "testHelper.h"
+
+#include <MicroOcpp.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Model/Model.h>
+#include <MicroOcpp/Debug.h>
+
+#include <algorithm>
+
+using namespace MicroOcpp;
+
+SimCsms::SimCsms(unsigned long latencyMs) : latencyMs(latencyMs) {
+
+}
+
+void SimCsms::loop() {
+    while (!outbox.empty() && mocpp_tick_ms() - outbox.front().sent >= latencyMs) {
+        auto txt = std::move(outbox.front().txt);
+        outbox.pop_front();
+        if (receiveTXT) {
+            receiveTXT(txt.c_str(), txt.length());
+        }
+    }
+}
+
+bool SimCsms::sendTXT(const char *msg, size_t length) {
+    if (!connected) {
+        return false;
+    }
+
+    DynamicJsonDocument doc {2048};
+    auto err = deserializeJson(doc, msg, length);
+    if (err) {
+        MO_DBG_ERR("invalid msg: %s", err.c_str());
+        return false;
+    }
+
+    int messageTypeId = doc[0] | -1;
+    if (messageTypeId == MESSAGE_TYPE_CALL) {
+        respond(doc.as<JsonArray>());
+    } else if (messageTypeId == MESSAGE_TYPE_CALLRESULT || messageTypeId == MESSAGE_TYPE_CALLERROR) {
+        nResponses++;
+    }
+    return true;
+}
+
+void SimCsms::respond(JsonArray call) {
+    const char *operationType = call[2] | "";
+    nRequests[operationType]++;
+
+    DynamicJsonDocument doc {1024};
+    doc.add(MESSAGE_TYPE_CALLRESULT);
+    doc.add(call[1].as<const char*>());
+    JsonObject response = doc.createNestedObject();
+
+    auto handler = handlers.find(operationType);
+    if (handler != handlers.end()) {
+        handler->second(call[3].as<JsonObject>(), response);
+    } else if (!strcmp(operationType, "BootNotification") || !strcmp(operationType, "Heartbeat")) {
+        char currentTime [JSONDATE_LENGTH + 1];
+        getOcppContext()->getModel().getClock().now().toJsonString(currentTime, sizeof(currentTime));
+        response["currentTime"] = currentTime; //copy
+        if (!strcmp(operationType, "BootNotification")) {
+            response["status"] = "Accepted";
+            response["interval"] = 86400;
+        }
+    } else if (!strcmp(operationType, "Authorize")) {
+        response["idTagInfo"]["status"] = "Accepted";
+    } else if (!strcmp(operationType, "StartTransaction")) {
+        response["idTagInfo"]["status"] = "Accepted";
+        response["transactionId"] = nextTransactionId++;
+    }
+
+    std::string out;
+    serializeJson(doc, out);
+    push(out);
+}
+
+void SimCsms::push(const std::string& txt) {
+    outbox.push_back({mocpp_tick_ms(), txt});
+}
+
+void SimCsms::setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) {
+    this->receiveTXT = receiveTXT;
+}
+
+unsigned long SimCsms::getNextWakeupMs() {
+    if (outbox.empty()) {
+        return MO_WAKEUP_MAX_MS;
+    }
+    unsigned long elapsed = mocpp_tick_ms() - outbox.front().sent;
+    if (elapsed >= latencyMs) {
+        return 0;
+    }
+    return std::min(latencyMs - elapsed, (unsigned long) MO_WAKEUP_MAX_MS);
+}
+
+void SimCsms::setConnected(bool connected) {
+    if (connected && !this->connected) {
+        lastConnected = mocpp_tick_ms();
+    }
+    if (!connected) {
+        outbox.clear();
+    }
+    this->connected = connected;
+}
+
+void SimCsms::setResponseHandler(const char *operationType, ResponseHandler handler) {
+    handlers[operationType] = handler;
+}
+
+void SimCsms::sendCall(const char *operationType, const char *payloadJson) {
+    std::string call = "[2,\"sim-" + std::to_string(nextMessageId++) + "\",\"" + operationType + "\"," + payloadJson + "]";
+    push(call);
+}
+
+unsigned int SimCsms::getRequestCount(const char *operationType) {
+    auto count = nRequests.find(operationType);
+    return count != nRequests.end() ? count->second : 0;
+}
+
+bool Simulation::isLater(const Event& a, const Event& b) {
+    return a.t > b.t || (a.t == b.t && a.seq > b.seq);
+}
+
+void Simulation::schedule(unsigned long t, std::function<void ()> fn) {
+    events.push_back({t, nextSeq++, std::move(fn)});
+    std::push_heap(events.begin(), events.end(), isLater);
+}
+
+void Simulation::scheduleIn(unsigned long delayMs, std::function<void ()> fn) {
+    schedule(mtime + delayMs, std::move(fn));
+}
+
+unsigned long Simulation::settle() {
+    unsigned long wait = 0;
+    for (unsigned int i = 0; i < SIM_SETTLE_LOOPS_MAX && wait == 0; i++) {
+        mocpp_loop();
+        nLoops++;
+        wait = mocpp_next_deadline_ms();
+    }
+    return wait ? wait : SIM_BUSY_STEP_MS;
+}
+
+void Simulation::runUntil(unsigned long t) {
+    while (true) {
+        while (!events.empty() && events.front().t <= mtime) {
+            std::pop_heap(events.begin(), events.end(), isLater);
+            auto fn = std::move(events.back().fn);
+            events.pop_back();
+            fn();
+        }
+
+        unsigned long wait = settle();
+
+        if (mtime >= t) {
+            break;
+        }
+
+        unsigned long next = mtime + wait;
+        if (!events.empty() && events.front().t < next) {
+            next = std::max(mtime, events.front().t);
+        }
+        if (next > t) {
+            next = t;
+        }
+        mtime = next;
+        nSteps++;
+    }
+}
+
+void Simulation::runFor(unsigned long durationMs) {
+    runUntil(mtime + durationMs);
+}
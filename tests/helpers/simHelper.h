@@ -0,0 +1,123 @@
+// matth-x/MicroOcpp
+// Copyright Matthias Akstaller 2019 - 2024
+// MIT License
+
+#ifndef MO_SIMHELPER_H
+#define MO_SIMHELPER_H
+
+/*
+ * Discrete-event simulation for tests and benchmarks
+ *
+ * Simulation drives the simulated clock mtime. Instead of advancing it in fixed steps, it jumps straight to the next
+ * event, which is either a scripted event (e.g. plugging in an EV) or the next deadline of MO (mocpp_next_deadline_ms).
+ * A charging session of a day with MeterValues each minute takes a few thousand loop calls instead of a million.
+ *
+ * SimCsms is a scripted CSMS stand-in. It answers the requests of the charger after a fixed latency with responses
+ * which are generated per operation type.
+ *
+ * Usage:
+ *
+ *     SimCsms csms;
+ *     mocpp_initialize(csms, ChargerCredentials());
+ *     mocpp_set_timer(custom_timer_cb);
+ *
+ *     Simulation sim;
+ *     sim.schedule(mtime + 60000, [] () {beginTransaction_authorized("mIdTag");});
+ *     sim.runFor(24UL * 3600UL * 1000UL);
+ */
+
+#include <MicroOcpp/Core/Connection.h>
+
+#include <ArduinoJson.h>
+#include <deque>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef SIM_SETTLE_LOOPS_MAX
+#define SIM_SETTLE_LOOPS_MAX 20 //max. loop calls at the same point of time until MO has no immediate work left
+#endif
+
+#ifndef SIM_BUSY_STEP_MS
+#define SIM_BUSY_STEP_MS 100 //time step if MO is still busy after SIM_SETTLE_LOOPS_MAX loop calls (e.g. polling an input)
+#endif
+
+namespace MicroOcpp {
+
+class SimCsms : public Connection {
+public:
+    using ResponseHandler = std::function<void (JsonObject request, JsonObject response)>;
+private:
+    struct Message {
+        unsigned long sent;
+        std::string txt;
+    };
+    std::deque<Message> outbox; //to the charger. Constant latency keeps it sorted by due time
+
+    ReceiveTXTcallback receiveTXT;
+    unsigned long latencyMs = 0;
+    bool connected = true;
+    unsigned long lastConnected = 0;
+
+    std::map<std::string, ResponseHandler> handlers;
+    std::map<std::string, unsigned int> nRequests;
+    unsigned int nResponses = 0; //responses of the charger to sendCall()
+    int nextTransactionId = 1;
+    unsigned int nextMessageId = 1;
+
+    void respond(JsonArray call);
+    void push(const std::string& txt);
+public:
+    SimCsms(unsigned long latencyMs = 0);
+
+    void loop() override; //delivers the messages which are due
+    bool sendTXT(const char *msg, size_t length) override;
+    void setReceiveTXTcallback(ReceiveTXTcallback &receiveTXT) override;
+    unsigned long getLastConnected() override {return lastConnected;}
+    bool isConnected() override {return connected;}
+    unsigned long getNextWakeupMs() override; //time until the next message is due
+
+    void setConnected(bool connected); //messages in flight are lost when the connection drops
+
+    /*
+     * Custom response for operationType. The handler fills the response payload. Replaces the default response, which
+     * is Accepted for BootNotification, Authorize and StartTransaction and empty for the other operations
+     */
+    void setResponseHandler(const char *operationType, ResponseHandler handler);
+
+    void sendCall(const char *operationType, const char *payloadJson); //server-initiated request, e.g. SetChargingProfile
+
+    unsigned int getRequestCount(const char *operationType); //requests of the charger which the CSMS has received
+    unsigned int getResponseCount() {return nResponses;}
+};
+
+class Simulation {
+private:
+    struct Event {
+        unsigned long t;
+        unsigned long seq; //events at the same time run in the order in which they have been scheduled
+        std::function<void ()> fn;
+    };
+    std::vector<Event> events; //min-heap
+
+    unsigned long nextSeq = 0;
+    unsigned long nLoops = 0;
+    unsigned long nSteps = 0;
+
+    static bool isLater(const Event& a, const Event& b);
+    unsigned long settle(); //loop until MO has no immediate work left. Returns the time until the next deadline
+public:
+    void schedule(unsigned long t, std::function<void ()> fn); //t is absolute mtime
+    void scheduleIn(unsigned long delayMs, std::function<void ()> fn);
+
+    void runUntil(unsigned long t); //fires the scripted events and runs MO until mtime reaches t
+    void runFor(unsigned long durationMs);
+
+    unsigned long getLoopCount() {return nLoops;} //mocpp_loop() calls so far
+    unsigned long getStepCount() {return nSteps;} //time jumps so far
+};
+
+} //end namespace MicroOcpp
+
+#endif
@@ -4,6 +4,11 @@
 
 #include <MicroOcpp.h>
 #include <MicroOcpp/Core/Connection.h>
+#include <MicroOcpp/Core/Context.h>
+#include <MicroOcpp/Core/Request.h>
+#include <MicroOcpp/Core/RequestQueue.h>
+#include <MicroOcpp/Core/Configuration.h>
+#include <MicroOcpp/Model/Model.h>
 #include "./catch2/catch.hpp"
 #include "./helpers/testHelper.h"
 
@@ -24,3 +29,189 @@ TEST_CASE( "Context lifecycle" ) {
         REQUIRE( !( getOcppContext() ) );
     }
 }
+
+TEST_CASE( "Next wakeup" ) {
+    printf("\nRun %s\n",  "Next wakeup");
+
+    //initialize Context with dummy socket
+    MicroOcpp::LoopbackConnection loopback;
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"));
+
+    mocpp_set_timer(custom_timer_cb);
+
+    getOcppContext()->getModel().getClock().setTime("2023-01-01T00:00:00.000Z");
+
+    loop();
+
+    //set after the BootNotification, which applies the interval of the server
+    auto heartbeatIntervalInt = MicroOcpp::declareConfiguration<int>("HeartbeatInterval", 86400);
+    heartbeatIntervalInt->setInt(20);
+
+    SECTION("Sleep until Heartbeat") {
+
+        unsigned long wakeup = mocpp_next_wakeup_ms();
+        REQUIRE( wakeup > 0 );
+        REQUIRE( wakeup <= 20000 );
+
+        bool checkHeartbeat = false;
+        setOnReceiveRequest("Heartbeat", [&checkHeartbeat] (JsonObject) {
+            checkHeartbeat = true;
+        });
+
+        mtime += wakeup;
+        loop();
+
+        REQUIRE( checkHeartbeat );
+        REQUIRE( mocpp_next_wakeup_ms() > 0 );
+    }
+
+    SECTION("Busy during transaction") {
+
+        beginTransaction("mIdTag");
+        REQUIRE( mocpp_next_wakeup_ms() == 0 );
+
+        endTransaction();
+        loop();
+        REQUIRE( mocpp_next_wakeup_ms() > 0 );
+    }
+
+    SECTION("Pending message") {
+
+        loopback.setConnected(false);
+
+        mtime += mocpp_next_wakeup_ms();
+        mocpp_loop();
+
+        //Heartbeat can't be sent while offline, but has a timeout
+        REQUIRE( mocpp_next_wakeup_ms() > 0 );
+
+        loopback.setConnected(true);
+        REQUIRE( mocpp_next_wakeup_ms() == 0 );
+
+        loop();
+        REQUIRE( mocpp_next_wakeup_ms() > 0 );
+    }
+
+    mocpp_deinitialize();
+}
+
+TEST_CASE( "Request queues" ) {
+    printf("\nRun %s\n",  "Request queues");
+
+    class EmptyRequestEmitter : public MicroOcpp::RequestEmitter {
+    public:
+        unsigned int getFrontRequestOpNr() override {return NoOperation;}
+        std::unique_ptr<MicroOcpp::Request> fetchFrontRequest() override {return nullptr;}
+    };
+    EmptyRequestEmitter emitters [MO_NUM_REQUEST_QUEUES]; //must outlive the Context
+
+    //initialize Context with dummy socket
+    MicroOcpp::LoopbackConnection loopback;
+    mocpp_initialize(loopback, ChargerCredentials("test-runner1234"));
+
+    mocpp_set_timer(custom_timer_cb);
+
+    loop();
+
+    //each connector has a queue, including the last one
+    unsigned int nStartTx [MO_NUMCONNECTORS] = {0};
+    setOnReceiveRequest("StartTransaction", [&nStartTx] (JsonObject request) {
+        int connectorId = request["connectorId"] | -1;
+        if (connectorId > 0 && connectorId < MO_NUMCONNECTORS) {
+            nStartTx[connectorId]++;
+        }
+    });
+
+    for (unsigned int connectorId = 1; connectorId < MO_NUMCONNECTORS; connectorId++) {
+        beginTransaction_authorized("mIdTag", nullptr, connectorId);
+    }
+    loop();
+
+    for (unsigned int connectorId = 1; connectorId < MO_NUMCONNECTORS; connectorId++) {
+        REQUIRE( nStartTx[connectorId] == 1 );
+        endTransaction(nullptr, nullptr, connectorId);
+    }
+    loop();
+
+    //queues beyond MO_NUM_REQUEST_QUEUES are rejected
+    bool rejected = false;
+    for (auto& emitter : emitters) {
+        if (!getOcppContext()->getRequestQueue().addSendQueue(&emitter)) {
+            rejected = true;
+            break;
+        }
+    }
+    REQUIRE( rejected );
+
+    mocpp_deinitialize();
+}
+
+TEST_CASE( "Multiple instances" ) {
+    printf("\nRun %s\n",  "Multiple instances");
+
+    MicroOcpp::LoopbackConnection loopback1, loopback2;
+
+    auto cp1 = mocpp_instance_create(loopback1, ChargerCredentials("test-runner1234"), "cp1-");
+    REQUIRE( cp1 );
+    REQUIRE( mocpp_instance_get_selected() == cp1 );
+    auto context1 = getOcppContext();
+    auto heartbeatInterval1 = MicroOcpp::declareConfiguration<int>("HeartbeatInterval", 86400);
+    heartbeatInterval1->setInt(10);
+
+    auto cp2 = mocpp_instance_create(loopback2, ChargerCredentials("test-runner1234"), "cp2-");
+    REQUIRE( cp2 );
+    REQUIRE( mocpp_instance_get_selected() == cp2 );
+    auto context2 = getOcppContext();
+    REQUIRE( context2 != context1 );
+
+    SECTION("Separate Configurations") {
+        auto heartbeatInterval2 = MicroOcpp::declareConfiguration<int>("HeartbeatInterval", 86400);
+        REQUIRE( heartbeatInterval2 != heartbeatInterval1 );
+        REQUIRE( heartbeatInterval2->getInt() != 10 );
+
+        mocpp_instance_select(cp1);
+        REQUIRE( getOcppContext() == context1 );
+        REQUIRE( MicroOcpp::declareConfiguration<int>("HeartbeatInterval", 86400)->getInt() == 10 );
+    }
+
+    SECTION("Separate transactions") {
+        mocpp_instance_select(cp1);
+        beginTransaction("mIdTag");
+        REQUIRE( isTransactionActive() );
+
+        mocpp_instance_select(cp2);
+        REQUIRE( !isTransactionActive() );
+
+        for (int i = 0; i < 10; i++) {
+            mocpp_instance_loop(cp1);
+            mocpp_instance_loop(cp2);
+        }
+
+        mocpp_instance_select(cp1);
+        endTransaction();
+        REQUIRE( !isTransactionActive() );
+    }
+
+    SECTION("Default instance unaffected") {
+        mocpp_instance_select(nullptr);
+        REQUIRE( !getOcppContext() );
+    }
+
+    SECTION("Free non-selected instance") {
+        mocpp_instance_select(cp1);
+        mocpp_instance_free(cp2);
+        cp2 = nullptr;
+
+        REQUIRE( mocpp_instance_get_selected() == cp1 );
+        REQUIRE( getOcppContext() == context1 );
+        REQUIRE( MicroOcpp::declareConfiguration<int>("HeartbeatInterval", 86400)->getInt() == 10 );
+    }
+
+    mocpp_instance_free(cp1);
+    if (cp2) {
+        mocpp_instance_free(cp2);
+    }
+
+    REQUIRE( mocpp_instance_get_selected() == nullptr );
+    REQUIRE( !getOcppContext() );
+}